@@ -4,6 +4,15 @@
 //------------------------------------------------------------------------------
 
 #include "UIEditor.h"
+#include "EditorUndoJournal.h"
+#include "LevelValidationThread.h"
+#include "WallSegmentManager.h"
+#include "barrier.h"
+#include "flagItem.h"
+#include "gameType.h"
+#include "gridDB.h"
+#include "LineItem.h"
+#include "Spawn.h"
 
 #include "TestUtils.h"
 #include "gtest/gtest.h"
@@ -77,4 +86,352 @@ TEST(EditorTest, panZoom)
    ASSERT_FLOAT_EQ( 900, r.max.y);
 }   
 
+
+static void addSquareSegment(WallSegmentManager &wsm, F32 x, F32 y, F32 size, S32 owner)
+{
+   Vector<Point> points;
+   points.push_back(Point(x, y));
+   points.push_back(Point(x + size, y));
+   points.push_back(Point(x + size, y + size));
+   points.push_back(Point(x, y + size));
+
+   new WallSegment(wsm.getWallSegmentDatabase(), points, owner);     // Adds itself to the database
+}
+
+
+// Edges built a few walls at a time should be the same as edges built from all walls at once
+static void checkWallEdges(WallSegmentManager &wsm)
+{
+   Vector<Point> expected;
+   wsm.clipAllWallEdges(wsm.getWallSegmentDatabase()->findObjects_fast(), expected);
+
+   const Vector<Point> &actual = *wsm.getWallEdgePoints();
+   ASSERT_EQ(expected.size(), actual.size());
+   EXPECT_EQ(expected.size() / 2, wsm.getWallEdgeDatabase()->getObjectCount());
+
+   for(S32 i = 0; i < expected.size(); i += 2)
+   {
+      bool found = false;
+      for(S32 j = 0; j < actual.size() && !found; j += 2)
+         found = (expected[i] == actual[j] && expected[i + 1] == actual[j + 1]);
+
+      EXPECT_TRUE(found) << "Missing edge " << expected[i].toString() << " - " << expected[i + 1].toString();
+   }
+}
+
+
+TEST(EditorTest, incrementalWallEdges)
+{
+   WallSegmentManager wsm;
+
+   addSquareSegment(wsm, 0, 0, 10, 1);
+   addSquareSegment(wsm, 5, 5, 10, 2);       // Overlaps the first
+   addSquareSegment(wsm, 100, 100, 10, 3);   // Off by itself
+
+   wsm.rebuildEdges();
+   checkWallEdges(wsm);
+   EXPECT_EQ(12, wsm.getWallEdgeDatabase()->getObjectCount());    // 8 for the merged pair, 4 for the loner
+
+   Vector<DatabaseObject *> farEdges;
+   wsm.getWallEdgeDatabase()->findObjects(farEdges);
+   for(S32 i = 0; i < farEdges.size(); i++)
+      if(farEdges[i]->getExtent().min.x < 50)
+         farEdges.erase(i--);
+   ASSERT_EQ(4, farEdges.size());
+
+   // Split the pair; the loner's edges are left alone
+   wsm.deleteSegments(2);
+   wsm.rebuildEdges();
+   checkWallEdges(wsm);
+   EXPECT_EQ(8, wsm.getWallEdgeDatabase()->getObjectCount());
+
+   const Vector<DatabaseObject *> *edges = wsm.getWallEdgeDatabase()->findObjects_fast();
+   for(S32 i = 0; i < farEdges.size(); i++)
+      EXPECT_TRUE(edges->contains(farEdges[i]));
+
+   // Join two clusters with a new wall
+   addSquareSegment(wsm, 8, 8, 95, 4);
+   wsm.rebuildEdges();
+   checkWallEdges(wsm);
+
+   // Nothing changed, nothing to do
+   wsm.rebuildEdges();
+   checkWallEdges(wsm);
+
+   wsm.clear();
+   wsm.rebuildEdges();
+   EXPECT_EQ(0, wsm.getWallEdgePoints()->size());
+   EXPECT_EQ(0, wsm.getWallEdgeDatabase()->getObjectCount());
+}
+
+
+static BfObject *findSerialNumber(const GridDatabase &database, S32 serialNumber)
+{
+   const Vector<DatabaseObject *> *objects = database.findObjects_fast();
+
+   for(S32 i = 0; i < objects->size(); i++)
+      if(static_cast<BfObject *>(objects->get(i))->getSerialNumber() == serialNumber)
+         return static_cast<BfObject *>(objects->get(i));
+
+   return NULL;
+}
+
+
+// Undo steps should hold only the objects that changed, and still take us back and forth between states
+TEST(EditorTest, undoJournal)
+{
+   GridDatabase database;
+   EditorUndoJournal journal(4);
+
+   Vector<DatabaseObject *> spawns;
+   for(S32 i = 0; i < 10; i++)
+      spawns.push_back(new Spawn(Point(i * 100, 0)));
+   database.addToDatabase(spawns);
+
+   S32 moved   = static_cast<BfObject *>(spawns[0])->getSerialNumber();
+   S32 deleted = static_cast<BfObject *>(spawns[1])->getSerialNumber();
+
+   journal.saveState(&database, 1, 0);
+   EXPECT_EQ(0, journal.getChangeCount());
+
+   // Move one, delete one, add one
+   findSerialNumber(database, moved)->setPos(Point(0, 500));
+   database.removeFromDatabase(findSerialNumber(database, deleted), true);
+
+   Spawn *added = new Spawn(Point(500, 500));
+   S32 addedSerialNumber = added->getSerialNumber();
+   Vector<DatabaseObject *> addedObjects;
+   addedObjects.push_back(added);
+   database.addToDatabase(addedObjects);
+
+   journal.saveState(&database, 2, 0);
+   EXPECT_EQ(3, journal.getChangeCount());
+
+   journal.restoreState(&database, 1);
+   EXPECT_EQ(10, database.getObjectCount());
+   EXPECT_EQ(Point(0, 0), findSerialNumber(database, moved)->getPos());
+   EXPECT_TRUE(findSerialNumber(database, deleted) != NULL);
+   EXPECT_TRUE(findSerialNumber(database, addedSerialNumber) == NULL);
+
+   journal.restoreState(&database, 2);
+   EXPECT_EQ(10, database.getObjectCount());
+   EXPECT_EQ(Point(0, 500), findSerialNumber(database, moved)->getPos());
+   EXPECT_TRUE(findSerialNumber(database, deleted) == NULL);
+   EXPECT_TRUE(findSerialNumber(database, addedSerialNumber) != NULL);
+
+   // Go back and do something else; the old step 1 -> 2 is replaced
+   journal.restoreState(&database, 1);
+   findSerialNumber(database, deleted)->setPos(Point(100, 100));
+   journal.saveState(&database, 2, 0);
+   EXPECT_EQ(1, journal.getChangeCount());
+
+   journal.restoreState(&database, 1);
+   EXPECT_EQ(Point(100, 0), findSerialNumber(database, deleted)->getPos());
+   EXPECT_EQ(Point(0, 0), findSerialNumber(database, moved)->getPos());
+}
+
+
+// Validation works from a snapshot taken when the check is created; later changes to the level don't affect it
+TEST(EditorTest, levelValidation)
+{
+   GridDatabase database;
+   GameType gameType;      // Bitmatch -- no flags
+
+   Vector<DatabaseObject *> objects;
+   Spawn *spawn = new Spawn(Point(0, 0));
+   spawn->setTeam(0);
+   objects.push_back(spawn);
+   objects.push_back(new FlagItem(Point(100, 100), Point(0, 0)));
+   database.addToDatabase(objects);
+
+   LevelValidationThread validation(NULL, 0, &gameType, 2, &database);
+
+   database.removeFromDatabase(spawn, true);
+
+   validation.run();
+   validation.finish();    // No game, so nobody to tell
+
+   ASSERT_EQ(1, validation.getErrors().size());
+   EXPECT_EQ("ERROR: Need spawn point for team 2", validation.getErrors()[0]);
+   ASSERT_EQ(1, validation.getWarnings().size());
+   EXPECT_EQ("WARNING: This game type does not use flags.", validation.getWarnings()[0]);
+}
+
+
+// Full-scan versions of the editor's snapping and selection searches, to check the bucket-based ones against
+static void snapToAnyVert(const Point &p, const GridDatabase &database, F32 &minDist, Point &snapPoint)
+{
+   const Vector<DatabaseObject *> *objects = database.findObjects_fast();
+
+   for(S32 i = 0; i < objects->size(); i++)
+   {
+      BfObject *obj = static_cast<BfObject *>(objects->get(i));
+
+      if(obj->isSelected() || obj->anyVertsSelected())
+         continue;
+
+      for(S32 j = 0; j < obj->getVertCount(); j++)
+         if(obj->getVert(j).distSquared(p) < minDist)
+         {
+            minDist = obj->getVert(j).distSquared(p);
+            snapPoint = obj->getVert(j);
+         }
+   }
+}
+
+
+// The old corner search took the first corner closer than minDist; the new one takes the nearest, so that's what we compare to
+static void snapToAnyCorner(const Point &p, const GridDatabase &wallEdgeDatabase, F32 &minDist, Point &snapPoint)
+{
+   const Vector<DatabaseObject *> *edges = wallEdgeDatabase.findObjects_fast();
+
+   for(S32 i = 0; i < edges->size(); i++)
+   {
+      const Point &corner = *static_cast<WallEdge *>(edges->get(i))->getStart();
+
+      if(corner.distSquared(p) < minDist)
+      {
+         minDist = corner.distSquared(p);
+         snapPoint = corner;
+      }
+   }
+}
+
+
+static void findAnyInsideRect(const GridDatabase &database, const Rect &rect, Vector<DatabaseObject *> &fillVector)
+{
+   const Vector<DatabaseObject *> *objects = database.findObjects_fast();
+
+   for(S32 i = 0; i < objects->size(); i++)
+   {
+      BfObject *obj = static_cast<BfObject *>(objects->get(i));
+
+      bool inside = true;
+      for(S32 j = 0; j < obj->getVertCount(); j++)
+         inside = inside && rect.contains(obj->getVert(j));
+
+      if(inside)
+         fillVector.push_back(obj);
+   }
+}
+
+
+// Spawns scattered over a few buckets, a few lines that cross bucket edges, and one selected spawn that should be ignored
+static void addSnapTargets(GridDatabase &database)
+{
+   Vector<DatabaseObject *> objects;
+
+   for(S32 i = 0; i < 200; i++)
+      objects.push_back(new Spawn(Point((i * 137) % 1000, (i * 251) % 800)));
+
+   for(S32 i = 0; i < 5; i++)
+   {
+      LineItem *line = new LineItem();
+      line->addVert(Point(i * 200 + 10, 30));
+      line->addVert(Point(i * 200 + 290, 410));
+      line->addVert(Point(i * 200 + 50, 770));
+      line->setExtent(line->calcExtents());
+      objects.push_back(line);
+   }
+
+   Spawn *selected = new Spawn(Point(501, 501));
+   selected->setSelected(true);
+   objects.push_back(selected);
+
+   database.addToDatabase(objects);
+}
+
+
+TEST(EditorTest, snapToVertex)
+{
+   GridDatabase database;
+   addSnapTargets(database);
+
+   const F32 radii[] = { 5, 40, 255 };
+
+   for(U32 r = 0; r < ARRAYSIZE(radii); r++)
+      for(S32 x = -100; x <= 1100; x += 23)
+         for(S32 y = -100; y <= 900; y += 19)
+         {
+            Point p(x + 0.37f, y + 0.61f);    // Off the integer grid, so no two vertices are the same distance away
+
+            F32 minDist = radii[r] * radii[r], expectedMinDist = minDist;
+            Point snapPoint(p), expectedSnapPoint(p);
+
+            bool found = EditorUserInterface::checkVertsForSnap(p, &database, minDist, snapPoint);
+            snapToAnyVert(p, database, expectedMinDist, expectedSnapPoint);
+
+            EXPECT_EQ(expectedSnapPoint, snapPoint) << "Snapping " << p.toString();
+            EXPECT_EQ(expectedMinDist, minDist);
+            EXPECT_EQ(expectedMinDist < radii[r] * radii[r], found);
+         }
+
+   // Never snap to the selected spawn, even right on top of it
+   F32 minDist = 100;
+   Point snapPoint(501, 502);
+   EditorUserInterface::checkVertsForSnap(Point(501, 502), &database, minDist, snapPoint);
+   EXPECT_NE(Point(501, 501), snapPoint);
+}
+
+
+TEST(EditorTest, snapToCorner)
+{
+   WallSegmentManager wsm;
+
+   addSquareSegment(wsm, 0, 0, 100, 1);
+   addSquareSegment(wsm, 50, 50, 100, 2);       // Overlaps the first, so we get corners where they cross
+   addSquareSegment(wsm, 300, 260, 40, 3);
+   addSquareSegment(wsm, 1000, 1000, 300, 4);   // Crosses bucket edges
+   wsm.rebuildEdges();
+
+   const GridDatabase *edges = wsm.getWallEdgeDatabase();
+
+   const F32 radii[] = { 5, 40, 255 };
+
+   for(U32 r = 0; r < ARRAYSIZE(radii); r++)
+      for(S32 x = -100; x <= 1400; x += 17)
+         for(S32 y = -100; y <= 1400; y += 29)
+         {
+            Point p(x + 0.37f, y + 0.61f);    // Off the integer grid, so no two vertices are the same distance away
+
+            F32 minDist = radii[r] * radii[r], expectedMinDist = minDist;
+            Point snapPoint(p), expectedSnapPoint(p);
+
+            bool found = EditorUserInterface::checkCornersForSnap(p, edges, minDist, snapPoint);
+            snapToAnyCorner(p, *edges, expectedMinDist, expectedSnapPoint);
+
+            EXPECT_EQ(expectedSnapPoint, snapPoint) << "Snapping " << p.toString();
+            EXPECT_EQ(expectedMinDist, minDist);
+            EXPECT_EQ(expectedMinDist < radii[r] * radii[r], found);
+         }
+}
+
+
+TEST(EditorTest, marqueeSelection)
+{
+   GridDatabase database;
+   addSnapTargets(database);
+
+   const Rect rects[] = {
+      Rect(Point(0, 0), Point(1000, 800)),         // Everything
+      Rect(Point(100, 100), Point(400, 300)),
+      Rect(Point(0, 0), Point(300, 800)),          // Only the first line
+      Rect(Point(250, 600), Point(251, 601)),      // Nothing
+      Rect(Point(-500, -500), Point(-400, -400)),  // Nothing, off the level
+   };
+
+   for(U32 i = 0; i < ARRAYSIZE(rects); i++)
+   {
+      Vector<DatabaseObject *> found, expected;
+
+      EditorUserInterface::findObjectsInsideRect(&database, rects[i], found);
+      findAnyInsideRect(database, rects[i], expected);
+
+      ASSERT_EQ(expected.size(), found.size()) << "Selecting " << rects[i].toString();
+
+      for(S32 j = 0; j < expected.size(); j++)
+         EXPECT_TRUE(found.contains(expected[j]));
+   }
+}
+
 };
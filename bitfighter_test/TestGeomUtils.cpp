@@ -5,8 +5,13 @@
 
 #include "../zap/GeomUtils.h"
 #include "../zap/MathUtils.h"
+#include "../zap/stringUtils.h"
+#include "../zap/WorkerPool.h"
 #include "gtest/gtest.h"
 #include <tnl.h>
+#include <tnlLog.h>
+#include <tnlPlatform.h>
+#include <tnlRandom.h>
 #include <map>
 #include <stdarg.h>
 
@@ -428,5 +433,343 @@ TEST(GeomUtilsTest, pointInHexagon)
 }
 
 
+// Random polygon for comparing the SSE2 and plain versions of the polygon tests.  Half are snapped to a coarse grid,
+// so we get plenty of collinear edges, shared vertices, and ties.
+static void makeRandomPoly(S32 vertexCount, Vector<Point> &result)
+{
+	bool snap = Random::readB();
+	result.clear();
+
+	for(S32 i = 0; i < vertexCount; i++)
+	{
+		F32 theta = FloatTau * (i + Random::readF() * 0.5f) / vertexCount;
+		F32 radius = 20 + Random::readF() * 80;
+		Point p(cos(theta) * radius, sin(theta) * radius);
+
+		if(Random::readF() < 0.2f)    // Occasionally throw in something that isn't star-shaped
+			p.set(Random::readF() * 200 - 100, Random::readF() * 200 - 100);
+
+		if(snap)
+			p.set(floor(p.x / 10) * 10, floor(p.y / 10) * 10);
+
+		result.push_back(p);
+	}
+}
+
+
+static Point randomPoint(F32 range)
+{
+	return Point(Random::readF() * 2 * range - range, Random::readF() * 2 * range - range);
+}
+
+
+TEST(GeomUtilsTest, simdMatchesScalar)
+{
+	Vector<Point> poly, other;
+
+	for(S32 trial = 0; trial < 5000; trial++)
+	{
+		makeRandomPoly(3 + trial % 18, poly);
+		makeRandomPoly(3 + trial % 7, other);
+
+		Point p = randomPoint(120);
+		Point q = randomPoint(120);
+		F32 radius = Random::readF() * 40;
+
+		EXPECT_EQ(polygonContainsPointScalar(poly.address(), poly.size(), p),
+		          polygonContainsPoint(poly.address(), poly.size(), p));
+
+		// Circles, with and without velocity filtering
+		Point outScalar, outSimd;
+		EXPECT_EQ(polygonCircleIntersectScalar(poly.address(), poly.size(), p, radius * radius, outScalar),
+		          polygonCircleIntersect(poly.address(), poly.size(), p, radius * radius, outSimd));
+		EXPECT_EQ(outScalar, outSimd);
+
+		Point velocity = q - p;
+		EXPECT_EQ(polygonCircleIntersectScalar(poly.address(), poly.size(), p, radius * radius, outScalar, &velocity),
+		          polygonCircleIntersect(poly.address(), poly.size(), p, radius * radius, outSimd, &velocity));
+		EXPECT_EQ(outScalar, outSimd);
+
+		// Swept circles
+		F32 fractionScalar = -1, fractionSimd = -1;
+		EXPECT_EQ(PolygonSweptCircleIntersectScalar(poly.address(), poly.size(), p, velocity, radius, outScalar, fractionScalar),
+		          PolygonSweptCircleIntersect(poly.address(), poly.size(), p, velocity, radius, outSimd, fractionSimd));
+		EXPECT_EQ(outScalar, outSimd);
+		EXPECT_EQ(fractionScalar, fractionSimd);
+
+		// Segments and polygons
+		EXPECT_EQ(polygonIntersectsSegmentScalar(poly, p, q), polygonIntersectsSegment(poly, p, q));
+		EXPECT_EQ(polygonsIntersectScalar(poly, other), polygonsIntersect(poly, other));
+
+		// Ray casts, in both polygon and segment-list formats
+		for(S32 format = 0; format < 2; format++)
+		{
+			F32 timeScalar = -1, timeSimd = -1;
+			Point normalScalar, normalSimd;
+			EXPECT_EQ(polygonIntersectsSegmentDetailedScalar(poly.address(), poly.size(), format == 1, p, q, timeScalar, normalScalar),
+			          polygonIntersectsSegmentDetailed(poly.address(), poly.size(), format == 1, p, q, timeSimd, normalSimd));
+			EXPECT_EQ(timeScalar, timeSimd);
+			EXPECT_EQ(normalScalar, normalSimd);
+		}
+	}
+}
+
+
+// Not run by default; use --gtest_also_run_disabled_tests to see timings
+TEST(GeomUtilsTest, DISABLED_simdBenchmark)
+{
+	const S32 PolyCount = 1000;
+	const S32 Passes = 200;
+
+	Vector<Vector<Point> > polys(PolyCount);
+	Vector<Point> starts(PolyCount), ends(PolyCount);
+
+	for(S32 i = 0; i < PolyCount; i++)
+	{
+		polys.push_back(Vector<Point>());
+		makeRandomPoly(4 + i % 12, polys.last());
+		starts.push_back(randomPoint(120));
+		ends.push_back(randomPoint(120));
+	}
+
+	Point out, normal;
+	F32 fraction;
+	S32 hits = 0;
+
+	TIME_BLOCK(PolygonSweptCircleIntersectScalar,
+		for(S32 pass = 0; pass < Passes; pass++)
+			for(S32 i = 0; i < PolyCount; i++)
+				hits += PolygonSweptCircleIntersectScalar(polys[i].address(), polys[i].size(), starts[i], ends[i] - starts[i], 10, out, fraction);
+	)
+	TIME_BLOCK(PolygonSweptCircleIntersect,
+		for(S32 pass = 0; pass < Passes; pass++)
+			for(S32 i = 0; i < PolyCount; i++)
+				hits -= PolygonSweptCircleIntersect(polys[i].address(), polys[i].size(), starts[i], ends[i] - starts[i], 10, out, fraction);
+	)
+
+	TIME_BLOCK(polygonIntersectsSegmentDetailedScalar,
+		for(S32 pass = 0; pass < Passes; pass++)
+			for(S32 i = 0; i < PolyCount; i++)
+				hits += polygonIntersectsSegmentDetailedScalar(polys[i].address(), polys[i].size(), true, starts[i], ends[i], fraction, normal);
+	)
+	TIME_BLOCK(polygonIntersectsSegmentDetailed,
+		for(S32 pass = 0; pass < Passes; pass++)
+			for(S32 i = 0; i < PolyCount; i++)
+				hits -= polygonIntersectsSegmentDetailed(polys[i].address(), polys[i].size(), true, starts[i], ends[i], fraction, normal);
+	)
+
+	TIME_BLOCK(polygonsIntersectScalar,
+		for(S32 pass = 0; pass < Passes; pass++)
+			for(S32 i = 0; i < PolyCount; i++)
+				hits += polygonsIntersectScalar(polys[i], polys[(i + 1) % PolyCount]);
+	)
+	TIME_BLOCK(polygonsIntersect,
+		for(S32 pass = 0; pass < Passes; pass++)
+			for(S32 i = 0; i < PolyCount; i++)
+				hits -= polygonsIntersect(polys[i], polys[(i + 1) % PolyCount]);
+	)
+
+	EXPECT_EQ(0, hits);
+}
+
+
+static F32 totalArea(const Vector<Vector<Point> > &polys)
+{
+	F32 total = 0;
+	for(S32 i = 0; i < polys.size(); i++)
+		total += fabs(area(polys[i]));
+
+	return total;
+}
+
+
+TEST(GeomUtilsTest, batchMatchesSerial)
+{
+	// Four clusters of three overlapping squares, far enough apart that the clusters don't touch
+	Vector<Vector<Point> > squares;
+	for(S32 i = 0; i < 4; i++)
+		for(S32 j = 0; j < 3; j++)
+			squares.push_back(createPolygon(Point(i * 1000 + j * 50, i * 500), 50, 4, FloatPi / 4));
+
+	Vector<const Vector<Point> *> input;
+	for(S32 i = 0; i < squares.size(); i++)
+		input.push_back(&squares[i]);
+
+	Vector<Vector<const Vector<Point> *> > groups;
+	partitionPolygons(input, groups);
+
+	ASSERT_EQ(4, groups.size());
+	for(S32 i = 0; i < groups.size(); i++)
+	{
+		ASSERT_EQ(3, groups[i].size());
+		EXPECT_EQ(&squares[i * 3], groups[i][0]);    // Groups and their members keep their input order
+	}
+
+	Vector<Vector<Point> > serial, grouped;
+	EXPECT_TRUE(mergePolys(input, serial));
+	EXPECT_TRUE(mergePolysInGroups(input, grouped));
+
+	EXPECT_EQ(4, serial.size());
+	EXPECT_EQ(serial.size(), grouped.size());
+	EXPECT_FLOAT_EQ(totalArea(serial), totalArea(grouped));
+
+	// Each group triangulates the same in a batch as it does alone
+	Vector<Vector<Vector<Point> > > triangleGroups;
+	Vector<Vector<Vector<Point> > > groupPolys;
+	for(S32 i = 0; i < groups.size(); i++)
+	{
+		groupPolys.push_back(Vector<Vector<Point> >());
+		for(S32 j = 0; j < groups[i].size(); j++)
+			groupPolys.last().push_back(*groups[i][j]);
+	}
+
+	EXPECT_TRUE(triangulateBatch(groupPolys, triangleGroups));
+	ASSERT_EQ(groupPolys.size(), triangleGroups.size());
+
+	for(S32 i = 0; i < groupPolys.size(); i++)
+	{
+		Vector<Vector<Point> > triangles;
+		EXPECT_TRUE(triangulate(groupPolys[i], triangles));
+
+		ASSERT_EQ(triangles.size(), triangleGroups[i].size());
+		for(S32 j = 0; j < triangles.size(); j++)
+			EXPECT_TRUE(triangles[j].getStlVector() == triangleGroups[i][j].getStlVector());
+	}
+}
+
+
+// Reads the walls from a level file into polygons, the same way barriers build their outlines
+static void loadLevelWalls(const string &filename, Vector<Vector<Point> > &walls)
+{
+	Vector<string> lines;
+	parseString(readFile(filename), lines, '\n');
+
+	F32 gridSize = 255;
+
+	for(S32 i = 0; i < lines.size(); i++)
+	{
+		Vector<string> words = parseString(lines[i]);
+
+		if(words.size() == 2 && words[0] == "GridSize")
+			gridSize = (F32)atof(words[1].c_str());
+
+		else if(words.size() >= 6 && (words[0] == "BarrierMaker" || words[0] == "PolyWall"))
+		{
+			bool isPolyWall = (words[0] == "PolyWall");
+			S32 first = isPolyWall ? 1 : 2;
+
+			Vector<Point> points;
+			for(S32 j = first; j + 1 < words.size(); j += 2)
+				points.push_back(Point(atof(words[j].c_str()) * gridSize, atof(words[j + 1].c_str()) * gridSize));
+
+			if(isPolyWall)
+			{
+				walls.push_back(points);
+				continue;
+			}
+
+			F32 width = (F32)atof(words[1].c_str());
+
+			Vector<Vector<Point> > segmentData;
+			barrierLineToSegmentData(points, segmentData);
+
+			for(S32 j = 0; j < segmentData.size(); j++)
+			{
+				walls.push_back(Vector<Point>());
+				constructBarrierPolygon(segmentData[j][1], segmentData[j][2], segmentData[j][0], segmentData[j][3], width, walls.last());
+			}
+		}
+	}
+}
+
+
+// Not run by default; use --gtest_also_run_disabled_tests to see timings.  Runs the polygon work behind bot zone
+// generation on the largest levels we ship, with the WorkerPool on and off.
+TEST(GeomUtilsTest, DISABLED_batchBenchmark)
+{
+	const char *levels[] = { "levels/zc.level", "levels/retrieve.level", "levels/core.level", "levels/htf.level" };
+	const S32 Passes = 10;
+	const F32 BufferRadius = 24;     // Ship::CollisionRadius
+
+	WorkerPool *pool = WorkerPool::get();
+	logprintf("Worker threads: %d", pool->getThreadCount());
+
+	for(S32 i = 0; i < ARRAYSIZE(levels); i++)
+	{
+		Vector<Vector<Point> > walls;
+		loadLevelWalls(levels[i], walls);
+
+		Vector<const Vector<Point> *> input;
+		for(S32 j = 0; j < walls.size(); j++)
+			input.push_back(&walls[j]);
+
+		Vector<Vector<const Vector<Point> *> > groups;
+		partitionPolygons(input, groups);
+
+		logprintf("%s: %d wall polygons in %d groups", levels[i], walls.size(), groups.size());
+
+		Vector<Vector<Point> > merged;
+		Vector<Vector<Vector<Point> > > mergedGroups, offsetGroups;
+
+		TIME_BLOCK(mergePolys,
+			for(S32 pass = 0; pass < Passes; pass++)
+				mergePolys(input, merged);
+		)
+
+		pool->setEnabled(false);
+		TIME_BLOCK(mergePolysInGroupsOneThread,
+			for(S32 pass = 0; pass < Passes; pass++)
+				mergePolysInGroups(input, merged);
+		)
+		pool->setEnabled(true);
+
+		TIME_BLOCK(mergePolysInGroups,
+			for(S32 pass = 0; pass < Passes; pass++)
+				mergePolysInGroups(input, merged);
+		)
+
+		Vector<Vector<Point> > offset;
+		TIME_BLOCK(offsetPolygons,
+			for(S32 pass = 0; pass < Passes; pass++)
+				offsetPolygons(merged, offset, BufferRadius);
+		)
+
+		mergePolysBatch(groups, mergedGroups);
+		TIME_BLOCK(offsetPolygonsBatch,
+			for(S32 pass = 0; pass < Passes; pass++)
+				offsetPolygonsBatch(mergedGroups, offsetGroups, BufferRadius);
+		)
+
+		Rect bounds(walls[0]);
+		for(S32 j = 1; j < walls.size(); j++)
+			bounds.unionRect(Rect(walls[j]));
+		bounds.expand(Point(50, 50));
+
+		PolyTree tree;
+		mergePolysToPolyTree(offset, tree);
+
+		Vector<Point> triangles;
+
+		pool->setEnabled(false);
+		TIME_BLOCK(processComplexOneThread,
+			for(S32 pass = 0; pass < Passes; pass++)
+			{
+				triangles.clear();
+				Triangulate::processComplex(triangles, bounds, tree, true, false);
+			}
+		)
+		pool->setEnabled(true);
+
+		TIME_BLOCK(processComplex,
+			for(S32 pass = 0; pass < Passes; pass++)
+			{
+				triangles.clear();
+				Triangulate::processComplex(triangles, bounds, tree, true, false);
+			}
+		)
+	}
+}
+
+
 
-};
\ No newline at end of file
+};
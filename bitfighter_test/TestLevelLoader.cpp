@@ -4,12 +4,22 @@
 //------------------------------------------------------------------------------
 
 #include "barrier.h"
+#include "BinaryLevel.h"
 #include "gameLoader.h"
 #include "gameType.h"
+#include "LevelIndex.h"
+#include "LevelTemplateCache.h"
 #include "ServerGame.h"
+#include "stringUtils.h"
+
+#include "tnlPlatform.h"
+#include "tnlLog.h"
 
 #include "gtest/gtest.h"
 
+#include <sstream>
+#include <stdio.h>
+
 namespace Zap
 {
 
@@ -50,5 +60,589 @@ TEST_F(LevelLoaderTest, longLine)
    EXPECT_EQ(TEST_POINTS - 1, objects->size());
 }
 
+
+TEST_F(LevelLoaderTest, hashWhileLoading)
+{
+   Address addr;
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+
+   // Loading from a file gives the same objects as loading its contents, and the same hash as reading it separately
+   const string filename = "levels/zc.level";
+
+   ServerGame fileGame(addr, settings, LevelSourcePtr(new StringLevelSource("")), false, false);
+   string hash;
+   ASSERT_TRUE(fileGame.loadLevelFromFile(filename, fileGame.getGameObjDatabase(), &hash));
+   EXPECT_EQ(Game::md5.getHashFromFile(filename), hash);
+
+   ServerGame stringGame(addr, settings, LevelSourcePtr(new StringLevelSource("")), false, false);
+   stringGame.loadLevelFromString(readFile(filename), stringGame.getGameObjDatabase());
+   EXPECT_EQ(stringGame.getGameObjDatabase()->getObjectCount(), fileGame.getGameObjDatabase()->getObjectCount());
+   EXPECT_LT(0, fileGame.getGameObjDatabase()->getObjectCount());
+
+   // Every byte gets hashed, even without a trailing newline
+   string code = "GameType 10 8\r\nLevelName Hash Test\r\n\nGridSize 255\nTeam Blue 0 0 1";
+
+   ServerGame bufferGame(addr, settings, LevelSourcePtr(new StringLevelSource("")), false, false);
+   md5stream stream;
+   bufferGame.loadLevelFromBuffer(code.data(), (U32)code.size(), bufferGame.getGameObjDatabase(), "", &stream);
+   EXPECT_EQ(Game::md5.getHashFromString(code), stream.getHash());
+   EXPECT_EQ(1, bufferGame.getTeamCount());
+}
+
+
+// The tokenizer should split lines exactly the way parseString() does
+TEST_F(LevelLoaderTest, tokenizer)
+{
+   const char *lines[] = {
+      "BarrierMaker 50 1 2 3 4",
+      "  \tLeadingAndTrailing\t spaces   \r",
+      "Turret!12 0 4.5 -2",
+      "LevelName \"Quoted level name\" after",
+      "LevelDescription \"unterminated quote goes to the end",
+      "Single \"word\" \"\" \"\"\"",
+      "Word\"with\"quotes \"tight\"after",
+      "",
+      "   ",
+   };
+
+   string code;
+   for(S32 i = 0; i < ARRAYSIZE(lines); i++)
+      code += string(lines[i]) + "\n";
+
+   LevelTokenizer tokenizer(code.data(), (U32)code.size());
+
+   for(S32 i = 0; i < ARRAYSIZE(lines); i++)
+   {
+      ASSERT_TRUE(tokenizer.nextLine());
+      EXPECT_EQ(i + 1, tokenizer.getLineNum());
+      EXPECT_EQ(string(lines[i]), string(tokenizer.getLine(), tokenizer.getLineLength()));
+
+      Vector<string> expected = parseString(string(lines[i]));
+      S32 expectedId = 0;
+      if(expected.size() > 0 && expected[0].find("!") != string::npos)
+      {
+         expectedId = atoi(expected[0].substr(expected[0].find("!") + 1).c_str());
+         expected[0] = expected[0].substr(0, expected[0].find("!"));
+      }
+
+      ASSERT_EQ(expected.size(), tokenizer.getArgc()) << lines[i];
+      for(S32 j = 0; j < expected.size(); j++)
+         EXPECT_EQ(expected[j], tokenizer.getArgv()[j]) << lines[i];
+
+      EXPECT_EQ(expectedId, tokenizer.getId());
+   }
+
+   EXPECT_FALSE(tokenizer.nextLine());
+
+   // Last line doesn't need a newline
+   string noNewline = "GridSize 255";
+   LevelTokenizer lastLine(noNewline.data(), (U32)noNewline.size());
+   ASSERT_TRUE(lastLine.nextLine());
+   EXPECT_EQ(noNewline.size(), lastLine.getLineBytes());
+   EXPECT_EQ(2, lastLine.getArgc());
+   EXPECT_FALSE(lastLine.nextLine());
+}
+
+
+// Not run by default; use --gtest_also_run_disabled_tests to see timings
+TEST_F(LevelLoaderTest, DISABLED_parseBenchmark)
+{
+   const S32 Passes = 20;
+
+   const string extensions[] = { "level" };
+   Vector<string> files;
+   getFilesFromFolder("levels", files, extensions, ARRAYSIZE(extensions));
+
+   Vector<string> levels;
+   U32 bytes = 0;
+   for(S32 i = 0; i < files.size(); i++)
+   {
+      levels.push_back(readFile("levels/" + files[i]));
+      bytes += (U32)levels.last().size();
+   }
+
+   logprintf("%d levels, %d bytes", levels.size(), bytes);
+
+   S32 words = 0;
+
+   // How we used to split up levels
+   TIME_BLOCK(getlineAndParseString,
+      for(S32 pass = 0; pass < Passes; pass++)
+         for(S32 i = 0; i < levels.size(); i++)
+         {
+            istringstream iss(levels[i]);
+            string line;
+            while(std::getline(iss, line))
+            {
+               Vector<string> args = parseString(line);
+               const char **argv = new const char *[args.size()];
+               for(S32 j = 0; j < args.size(); j++)
+                  argv[j] = args[j].c_str();
+               words += args.size();
+               delete[] argv;
+            }
+         }
+   )
+
+   TIME_BLOCK(LevelTokenizer,
+      for(S32 pass = 0; pass < Passes; pass++)
+         for(S32 i = 0; i < levels.size(); i++)
+         {
+            LevelTokenizer tokenizer(levels[i].data(), (U32)levels[i].size());
+            while(tokenizer.nextLine())
+               words -= tokenizer.getArgc();
+         }
+   )
+
+   EXPECT_EQ(0, words);
+
+   // And the whole load, for comparison
+   Address addr;
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+
+   TIME_BLOCK(loadLevelFromString,
+      for(S32 i = 0; i < levels.size(); i++)
+      {
+         ServerGame game(addr, settings, LevelSourcePtr(new StringLevelSource("")), false, false);
+         game.loadLevelFromString(levels[i], game.getGameObjDatabase());
+      }
+   )
+
+   Vector<string> binaryLevels(levels.size());
+   for(S32 i = 0; i < levels.size(); i++)
+   {
+      binaryLevels.push_back("");
+      BinaryLevel::encode(levels[i].data(), (U32)levels[i].size(), NULL, 0, binaryLevels.last());
+   }
+
+   TIME_BLOCK(loadBinaryLevel,
+      for(S32 i = 0; i < binaryLevels.size(); i++)
+      {
+         ServerGame game(addr, settings, LevelSourcePtr(new StringLevelSource("")), false, false);
+         game.loadBinaryLevel(binaryLevels[i].data(), (U32)binaryLevels[i].size(), game.getGameObjDatabase(), "", NULL);
+      }
+   )
+}
+
+
+// Binary levels must turn back into exactly the text they came from, and give processLevelLoadLine the same words
+TEST_F(LevelLoaderTest, binaryLevelRoundTrip)
+{
+   const char *lines[] = {
+      "LevelFormat 2",
+      "GameType 10 8",
+      "LevelName \"Quoted level name\" after",
+      "  \tLeadingAndTrailing\t spaces   ",
+      "Turret!12 0 4.5 -2",
+      "BarrierMaker 50 -0 007 1.50 -0.25 .5 5. 1e5 123456789012345678901 0.1234567890123456 0",
+      "Team Blue 0 0 1",
+      "Unicode \xc3\xa9t\xc3\xa9",
+      "#comment",
+      "",
+   };
+
+   string code;
+   for(S32 i = 0; i < ARRAYSIZE(lines); i++)
+      code += string(lines[i]) + (i % 2 == 0 ? "\n" : "\r\n");
+   code += "NoNewline 1";
+
+   string binary;
+   BinaryLevel::encode(code.data(), (U32)code.size(), NULL, 0, binary);
+   ASSERT_TRUE(BinaryLevel::isBinaryLevel(binary.data(), (U32)binary.size()));
+   EXPECT_FALSE(BinaryLevel::isBinaryLevel(code.data(), (U32)code.size()));
+
+   string text;
+   EXPECT_TRUE(BinaryLevel::decode(binary.data(), (U32)binary.size(), text));
+   EXPECT_EQ(code, text);
+
+   LevelTokenizer tokenizer(code.data(), (U32)code.size());
+   BinaryLevelReader reader(binary.data(), (U32)binary.size());
+   EXPECT_EQ(Game::md5.getHashFromString(code), reader.getHash());
+
+   while(tokenizer.nextLine())
+   {
+      ASSERT_TRUE(reader.nextLine());
+      EXPECT_EQ(tokenizer.getLineNum(), reader.getLineNum());
+      EXPECT_EQ(tokenizer.getId(), reader.getId());
+
+      ASSERT_EQ(tokenizer.getArgc(), reader.getArgc());
+      for(U32 i = 0; i < tokenizer.getArgc(); i++)
+         EXPECT_STREQ(tokenizer.getArgv()[i], reader.getArgv()[i]);
+   }
+
+   EXPECT_FALSE(reader.nextLine());
+   EXPECT_TRUE(reader.isValid());
+
+   // Cutting the data short anywhere must be noticed, not crash
+   for(U32 size = 0; size < binary.size(); size++)
+      EXPECT_FALSE(BinaryLevel::decode(binary.data(), size, text));
+
+   // All the shipped levels round-trip, and their binary headers hold the same LevelInfo we'd find in the text
+   const string extensions[] = { "level" };
+   Vector<string> files;
+   getFilesFromFolder("levels", files, extensions, ARRAYSIZE(extensions));
+   ASSERT_LT(0, files.size());
+
+   size_t textBytes = 0, binaryBytes = 0;
+
+   for(S32 i = 0; i < files.size(); i++)
+   {
+      string level = readFile("levels/" + files[i]);
+      BinaryLevel::encode(level.data(), (U32)level.size(), NULL, 0, binary);
+
+      textBytes += level.size();
+      binaryBytes += binary.size();
+
+      EXPECT_TRUE(BinaryLevel::decode(binary.data(), (U32)binary.size(), text));
+      EXPECT_EQ(level, text) << files[i];
+
+      LevelInfo textInfo, binaryInfo;
+      LevelSource::getLevelInfoFromCodeChunk(&level[0], (S32)level.size(), textInfo);
+      LevelSource::getLevelInfoFromCodeChunk(&binary[0], (S32)min(binary.size(), (size_t)1024 * 4), binaryInfo);
+
+      EXPECT_EQ(string(textInfo.mLevelName.getString()), string(binaryInfo.mLevelName.getString())) << files[i];
+      EXPECT_EQ(textInfo.mLevelType, binaryInfo.mLevelType) << files[i];
+      EXPECT_EQ(textInfo.minRecPlayers, binaryInfo.minRecPlayers) << files[i];
+      EXPECT_EQ(textInfo.maxRecPlayers, binaryInfo.maxRecPlayers) << files[i];
+      EXPECT_EQ(textInfo.mScriptFileName, binaryInfo.mScriptFileName) << files[i];
+   }
+
+   EXPECT_LT(binaryBytes, textBytes);     // Tiny levels can grow a little, what with the header, but not overall
+}
+
+
+static string makeVarU64(U64 value)
+{
+   string out;
+   for(; value >= 0x80; value >>= 7)
+      out += char(value | 0x80);
+   return out + char(value);
+}
+
+
+// Put value in place of the single-byte number 7 on the last line of a level
+static string replaceNumber(const string &binary, U64 value)
+{
+   size_t pos = binary.rfind("\x01\x0e");     // NumberWord with no decimals, then 7 zigzagged
+   return binary.substr(0, pos + 1) + makeVarU64(value) + binary.substr(pos + 2);
+}
+
+
+// The writer never stores more than 18 digits, so a bigger number means the file is damaged
+TEST_F(LevelLoaderTest, binaryLevelNumberLimits)
+{
+   string code = "GameType 10 8\nNumber 7";
+   string binary;
+   BinaryLevel::encode(code.data(), (U32)code.size(), NULL, 0, binary);
+
+   const U64 maxMagnitude = 999999999999999999ull;
+
+   {
+      string largest = replaceNumber(binary, maxMagnitude * 2);
+      BinaryLevelReader reader(largest.data(), (U32)largest.size());
+      ASSERT_TRUE(reader.nextLine());
+      ASSERT_TRUE(reader.nextLine());
+      EXPECT_STREQ("999999999999999999", reader.getArgv()[1]);
+      EXPECT_TRUE(reader.isValid());
+   }
+
+   {
+      string smallest = replaceNumber(binary, maxMagnitude * 2 - 1);
+      BinaryLevelReader reader(smallest.data(), (U32)smallest.size());
+      ASSERT_TRUE(reader.nextLine());
+      ASSERT_TRUE(reader.nextLine());
+      EXPECT_STREQ("-999999999999999999", reader.getArgv()[1]);
+   }
+
+   const U64 tooBig[] = { (maxMagnitude + 1) * 2, maxMagnitude * 2 + 1, U64_MAX - 1, U64_MAX };
+
+   for(S32 i = 0; i < ARRAYSIZE(tooBig); i++)
+   {
+      string corrupt = replaceNumber(binary, tooBig[i]);
+      BinaryLevelReader reader(corrupt.data(), (U32)corrupt.size());
+      ASSERT_TRUE(reader.nextLine());
+      EXPECT_FALSE(reader.nextLine()) << i;
+      EXPECT_FALSE(reader.isValid()) << i;
+   }
+}
+
+
+// A converted level loads the same objects with the same hash, and brings its merged walls with it
+TEST_F(LevelLoaderTest, binaryLevelLoading)
+{
+   const string textFile = "levels/zc.level";
+   const string binaryFile = "levels/binaryLevelLoading.tmp";
+
+   Vector<Vector<Point> > textWalls;
+   S32 textObjectCount;
+   {
+      ServerGame game(Address(), GameSettingsPtr(new GameSettings()), LevelSourcePtr(new StringLevelSource("")), false, false);
+      ASSERT_TRUE(game.loadLevelFromFile(textFile, game.getGameObjDatabase()));
+      EXPECT_EQ(NULL, game.getPremergedWalls());
+
+      Vector<DatabaseObject *> barriers;
+      game.getGameObjDatabase()->findObjects(BarrierTypeNumber, barriers);
+      ASSERT_TRUE(Barrier::unionBarriers(barriers, textWalls));
+      textObjectCount = game.getGameObjDatabase()->getObjectCount();
+   }
+
+   ASSERT_TRUE(convertLevelFile(textFile, binaryFile));
+
+   ServerGame game(Address(), GameSettingsPtr(new GameSettings()), LevelSourcePtr(new StringLevelSource("")), false, false);
+   string hash;
+   ASSERT_TRUE(game.loadLevelFromFile(binaryFile, game.getGameObjDatabase(), &hash));
+   remove(binaryFile.c_str());
+
+   EXPECT_EQ(Game::md5.getHashFromFile(textFile), hash);
+   EXPECT_EQ(textObjectCount, game.getGameObjDatabase()->getObjectCount());
+
+   const Vector<Vector<Point> > *walls = game.getPremergedWalls();
+   ASSERT_TRUE(walls != NULL);
+   ASSERT_EQ(textWalls.size(), walls->size());
+   for(S32 i = 0; i < textWalls.size(); i++)
+   {
+      ASSERT_EQ(textWalls[i].size(), walls->get(i).size());
+      for(S32 j = 0; j < textWalls[i].size(); j++)
+         EXPECT_EQ(textWalls[i][j], walls->get(i)[j]);
+   }
+
+   // Once the walls change, the merged ones are no good
+   game.loadLevelFromString("BarrierMaker 40 0 0 1 0", game.getGameObjDatabase());
+   EXPECT_EQ(NULL, game.getPremergedWalls());
+}
+
+
+// The index reads each level once, remembers it across runs, and notices when a file changes
+TEST_F(LevelLoaderTest, levelIndex)
+{
+   const string indexFile = "levels/levelIndex.tmp";
+   const string level1 = "levels/levelIndex1.tmp";
+   const string level2 = "levels/levelIndex2.tmp";
+
+   writeFile(level1, readFile("levels/zc.level"));
+   writeFile(level2, "GameType 10 8\nLevelName First Name\nMinPlayers 2\nMaxPlayers 6\n");
+   remove(indexFile.c_str());
+
+   Vector<string> files;
+   files.push_back(level1);
+   files.push_back(level2);
+   files.push_back("levels/levelIndexMissing.tmp");
+
+   Vector<LevelHeader> headers;
+   Vector<U8> found;
+   {
+      LevelIndex index(indexFile);
+      index.getLevelHeaders(files, headers, found);
+
+      EXPECT_EQ(2, index.getScanCount());
+      ASSERT_EQ(3, found.size());
+      EXPECT_TRUE(found[0] && found[1] && !found[2]);
+      EXPECT_EQ(Game::md5.getHashFromFile(level1), index.getHash(level1));
+
+      // Same as reading the start of the file ourselves
+      string code = readFile(level1).substr(0, 1024 * 4);
+      LevelHeader header;
+      LevelSource::readLevelHeader(code.c_str(), (S32)code.size(), header);
+      EXPECT_EQ(header.levelName, headers[0].levelName);
+      EXPECT_EQ(header.gameTypeName, headers[0].gameTypeName);
+
+      EXPECT_EQ("First Name", headers[1].levelName);
+      EXPECT_EQ(2, headers[1].minPlayers);
+      EXPECT_EQ(6, headers[1].maxPlayers);
+
+      ASSERT_TRUE(index.save());
+   }
+
+   // Nothing has changed, so a new index shouldn't need to read anything
+   {
+      LevelIndex index(indexFile);
+      index.getLevelHeaders(files, headers, found);
+
+      EXPECT_EQ(0, index.getScanCount());
+      EXPECT_EQ(Game::md5.getHashFromFile(level1), index.getHash(level1));
+      EXPECT_EQ("First Name", headers[1].levelName);
+      EXPECT_EQ(6, headers[1].maxPlayers);
+
+      // Change one of the levels
+      writeFile(level2, "GameType 10 8\nLevelName A Different Name\nMinPlayers 2\nMaxPlayers 6\n");
+      index.getLevelHeaders(files, headers, found);
+
+      EXPECT_EQ(1, index.getScanCount());
+      EXPECT_EQ("A Different Name", headers[1].levelName);
+   }
+
+   remove(level1.c_str());
+   remove(level2.c_str());
+   remove(indexFile.c_str());
+}
+
+// Scanning a folder in parallel gives the same answers, in the same order, as reading each level in turn
+TEST_F(LevelLoaderTest, levelHeaderScan)
+{
+   Vector<string> levels = LevelSource::findAllLevelFilesInFolder("levels");
+   ASSERT_LT(1, levels.size());
+
+   for(S32 i = 1; i < levels.size(); i++)
+      EXPECT_TRUE(alphaSort(levels[i - 1], levels[i])) << levels[i - 1] << " / " << levels[i];
+
+   Vector<string> files;
+   for(S32 i = 0; i < levels.size(); i++)
+      files.push_back(joindir("levels", levels[i]));
+   files.push_back("levels/levelHeaderScanMissing.level");
+
+   Vector<LevelHeader> headers;
+   Vector<U8> found;
+   Vector<string> hashes;
+   LevelSource::readLevelHeaders(files, headers, found, hashes);
+
+   ASSERT_EQ(files.size(), headers.size());
+   EXPECT_FALSE(found.last());
+
+   for(S32 i = 0; i < levels.size(); i++)
+   {
+      ASSERT_TRUE(found[i]) << files[i];
+
+      string code = readFile(files[i]).substr(0, 1024 * 4);
+      LevelHeader header;
+      LevelSource::readLevelHeader(code.c_str(), (S32)code.size(), header);
+
+      EXPECT_EQ(header.levelName, headers[i].levelName) << files[i];
+      EXPECT_EQ(header.gameTypeName, headers[i].gameTypeName) << files[i];
+      EXPECT_EQ(header.maxPlayers, headers[i].maxPlayers) << files[i];
+      EXPECT_EQ(Game::md5.getHashFromFile(files[i]), hashes[i]) << files[i];
+   }
+}
+
+
+// A level that has been converted only shows up once, as the binary version
+TEST_F(LevelLoaderTest, convertedLevelListedOnce)
+{
+   writeFile("levels/convertedLevelListedOnce.level", "GameType 10 8\n");
+   writeFile("levels/convertedLevelListedOnce.blevel", "GameType 10 8\n");
+
+   Vector<string> levels = LevelSource::findAllLevelFilesInFolder("levels");
+
+   EXPECT_TRUE(levels.contains("convertedLevelListedOnce.blevel"));
+   EXPECT_FALSE(levels.contains("convertedLevelListedOnce.level"));
+   EXPECT_TRUE(levels.contains("zc.level"));
+
+   remove("levels/convertedLevelListedOnce.level");
+   remove("levels/convertedLevelListedOnce.blevel");
+}
+
+
+static void getBarrierOutlines(ServerGame &game, Vector<Vector<Point> > &outlines)
+{
+   Vector<DatabaseObject *> barriers;
+   game.getGameObjDatabase()->findObjects(BarrierTypeNumber, barriers);
+
+   outlines.clear();
+   for(S32 i = 0; i < barriers.size(); i++)
+      outlines.push_back(*static_cast<Barrier *>(barriers[i])->getCollisionPoly());
+}
+
+
+// Playing a level again builds it from the walls and zones we kept, and comes out the same as the first time
+TEST_F(LevelLoaderTest, levelTemplateCache)
+{
+   string code = "GameType 10 8\n"
+                 "Team Bluey 0 0 1\n"
+                 "BarrierMaker 40 -10 -10 10 -10 10 10\n"
+                 "BarrierMaker 40 -10 20 -10 30\n"
+                 "PolyWall 20 20 30 20 30 30 20 30\n"
+                 "Turret 0 -10 -9\n"
+                 "TestItem 5 5\n";
+
+   ServerGame game(Address(), GameSettingsPtr(new GameSettings()), LevelSourcePtr(new StringLevelSource(code)), false, false);
+   LevelTemplateCache *cache = game.getLevelTemplateCache();
+
+   game.cycleLevel(FIRST_LEVEL);
+   EXPECT_EQ(1, cache->getTemplateCount());
+
+   S32 objectCount = game.getGameObjDatabase()->getObjectCount();
+   S32 wallCount = game.getGameType()->getBarrierList()->size();
+   S32 zoneCount = game.getBotZones()->size();
+   Vector<Vector<Point> > outlines;
+   getBarrierOutlines(game, outlines);
+
+   ASSERT_EQ(3, wallCount);
+   ASSERT_LT(0, outlines.size());
+   ASSERT_LT(0, zoneCount);
+
+   Vector<DatabaseObject *> turrets;
+   game.getGameObjDatabase()->findObjects(TurretTypeNumber, turrets);
+   ASSERT_EQ(1, turrets.size());
+   Point turretPos = static_cast<BfObject *>(turrets[0])->getPos();
+
+   game.cycleLevel(FIRST_LEVEL);
+   EXPECT_EQ(1, cache->getTemplateCount());
+
+   EXPECT_EQ(objectCount, game.getGameObjDatabase()->getObjectCount());
+   EXPECT_EQ(wallCount, game.getGameType()->getBarrierList()->size());
+   EXPECT_EQ(zoneCount, game.getBotZones()->size());
+   EXPECT_EQ(zoneCount, game.getBotZoneDatabase()->getObjectCount());
+
+   Vector<Vector<Point> > cachedOutlines;
+   getBarrierOutlines(game, cachedOutlines);
+   ASSERT_EQ(outlines.size(), cachedOutlines.size());
+   for(S32 i = 0; i < outlines.size(); i++)
+   {
+      ASSERT_EQ(outlines[i].size(), cachedOutlines[i].size());
+      for(S32 j = 0; j < outlines[i].size(); j++)
+         EXPECT_EQ(outlines[i][j], cachedOutlines[i][j]);
+   }
+
+   // Turret should have found the same wall to mount on
+   turrets.clear();
+   game.getGameObjDatabase()->findObjects(TurretTypeNumber, turrets);
+   ASSERT_EQ(1, turrets.size());
+   EXPECT_EQ(turretPos, static_cast<BfObject *>(turrets[0])->getPos());
+
+   // No room means nothing is kept
+   cache->setBudget(0);
+   EXPECT_EQ(0, cache->getTemplateCount());
+   EXPECT_EQ(0, cache->getSize());
+
+   game.cycleLevel(FIRST_LEVEL);
+   EXPECT_EQ(0, cache->getTemplateCount());
+   EXPECT_EQ(wallCount, game.getGameType()->getBarrierList()->size());
+}
+
+
+// 4096 MB is more bytes than fit in a U32; that used to wrap around to a cache with no room at all
+TEST_F(LevelLoaderTest, levelTemplateCacheLargeSetting)
+{
+   GameSettingsPtr settings(new GameSettings());
+   settings->getIniSettings()->levelCacheSize = 4096;
+
+   ServerGame game(Address(), settings, LevelSourcePtr(new StringLevelSource("GameType 10 8\n"
+                                                                             "Team Bluey 0 0 1\n"
+                                                                             "BarrierMaker 40 -10 -10 10 -10\n")),
+                   false, false);
+
+   game.cycleLevel(FIRST_LEVEL);
+   EXPECT_EQ(1, game.getLevelTemplateCache()->getTemplateCount());
+}
+
+
+// Least recently used levels are dropped first when the cache is over budget
+TEST_F(LevelLoaderTest, levelTemplateCacheBudget)
+{
+   LevelTemplateCache cache(1024 * 1024);
+
+   cache.add("a", new LevelTemplate());
+   cache.add("b", new LevelTemplate());
+   cache.add("", new LevelTemplate());       // No hash, no entry
+   EXPECT_EQ(2, cache.getTemplateCount());
+
+   EXPECT_TRUE(cache.find("a") != NULL);     // Now b is the oldest
+
+   cache.setBudget(cache.getSize() - 1);
+   EXPECT_EQ(1, cache.getTemplateCount());
+   EXPECT_TRUE(cache.find("a") != NULL);
+   EXPECT_TRUE(cache.find("b") == NULL);
+}
+
+
 };
 
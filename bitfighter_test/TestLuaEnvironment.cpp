@@ -7,8 +7,10 @@
 #include "../zap/ServerGame.h"
 #include "../zap/gameType.h"
 #include "../zap/luaLevelGenerator.h"
+#include "../zap/LuaProfiler.h"
 #include "../zap/SystemFunctions.h"
 #include "../zap/robot.h"
+#include "../zap/Zone.h"
 #include "gtest/gtest.h"
 
 namespace Zap
@@ -127,6 +129,16 @@ TEST_F(LuaEnvironmentTest, scriptIsolation)
    EXPECT_TRUE(levelgen->runString("assert(BfObject == nil)"));
    EXPECT_TRUE(levelgen2.runString("assert(BfObject ~= nil)"));
 
+   // Names shadowed and then cleared stay cleared, rather than falling back on the shared base environment
+   EXPECT_TRUE(levelgen->runString("Ship = 1; Ship = nil"));
+   EXPECT_TRUE(levelgen->runString("assert(Ship == nil)"));
+   EXPECT_TRUE(levelgen2.runString("assert(Ship ~= nil)"));
+
+   // _G is the script's own environment; writing through it does not leak into other scripts
+   EXPECT_TRUE(levelgen->runString("_G.foo = 'test'"));
+   EXPECT_TRUE(levelgen->runString("assert(foo == 'test')"));
+   EXPECT_TRUE(levelgen2.runString("assert(foo == nil)"));
+
    /* A true deep copy is needed before these will pass
    EXPECT_TRUE(levelgen->runString("Timer.foo = 'test'"));
    EXPECT_TRUE(levelgen->runString("assert(Timer.foo == 'test')"));
@@ -176,6 +188,80 @@ TEST_F(LuaEnvironmentTest, accessGlobalScriptVar)
 }
 
 
+// Scripts implementing onEvents() rather than a specific handler get events in one batch per tick
+TEST_F(LuaEnvironmentTest, batchedEvents)
+{
+   Robot *bot = new Robot();
+   bot->prepareEnvironment();
+   serverGame->addBot(bot);
+
+   ASSERT_TRUE(levelgen->runString("calls = 0; count = 0; function onEvents(eventType, events) "
+                                   "calls = calls + 1; count = count + #events; lastType = eventType; lastArg = events[1][1] end"));
+   ASSERT_TRUE(levelgen->runString("levelgen:subscribe(Event.ShipSpawned)"));
+   ASSERT_TRUE(levelgen->runString("levelgen:subscribe(Event.NexusOpened)"));
+   EventManager::get()->update();
+
+   // Coalesced events: the same ship spawning twice in a tick is reported once
+   EventManager::get()->fireEvent(EventManager::ShipSpawnedEvent, bot);
+   EventManager::get()->fireEvent(EventManager::ShipSpawnedEvent, bot);
+   EXPECT_EQ(0, levelgen->getLuaGlobalVar<S32>("calls"));      // Nothing delivered until the end of the tick
+
+   EventManager::get()->fireBatchedEvents();
+   EXPECT_EQ(1, levelgen->getLuaGlobalVar<S32>("calls"));
+   EXPECT_EQ(1, levelgen->getLuaGlobalVar<S32>("count"));
+   EXPECT_EQ(EventManager::ShipSpawnedEvent, levelgen->getLuaGlobalVar<S32>("lastType"));
+   EXPECT_TRUE(levelgen->runString("assert(lastArg:getId() ~= nil)"));
+
+   // Nothing queued, nothing delivered
+   EventManager::get()->fireBatchedEvents();
+   EXPECT_EQ(1, levelgen->getLuaGlobalVar<S32>("calls"));
+
+   EventManager::get()->fireEvent(EventManager::NexusOpenedEvent);
+   EventManager::get()->fireBatchedEvents();
+   EXPECT_EQ(2, levelgen->getLuaGlobalVar<S32>("calls"));
+   EXPECT_EQ(EventManager::NexusOpenedEvent, levelgen->getLuaGlobalVar<S32>("lastType"));
+
+   // Zone events aren't coalesced: a ship can leave and come back in a single tick, and scripts need to see both
+   Zone *zone = new Zone();
+   zone->addToGame(serverGame, serverGame->getGameObjDatabase());
+
+   ASSERT_TRUE(levelgen->runString("levelgen:subscribe(Event.ShipEnteredZone)"));
+   ASSERT_TRUE(levelgen->runString("levelgen:subscribe(Event.ShipLeftZone)"));
+   ASSERT_TRUE(levelgen->runString("calls = 0; count = 0"));
+   EventManager::get()->update();
+
+   EventManager::get()->fireEvent(EventManager::ShipEnteredZoneEvent, bot, zone);
+   EventManager::get()->fireEvent(EventManager::ShipLeftZoneEvent,    bot, zone);
+   EventManager::get()->fireEvent(EventManager::ShipEnteredZoneEvent, bot, zone);
+   EventManager::get()->fireBatchedEvents();
+   EXPECT_EQ(2, levelgen->getLuaGlobalVar<S32>("calls"));    // One call per event type...
+   EXPECT_EQ(3, levelgen->getLuaGlobalVar<S32>("count"));    // ...but every event is in there
+
+   ASSERT_EQ(0, lua_gettop(L));
+}
+
+
+TEST_F(LuaEnvironmentTest, profiler)
+{
+   LuaProfiler *profiler = LuaProfiler::get();
+   ASSERT_TRUE(levelgen->runString("function spin() local x = 0; for i = 1, 100000 do x = x + i end; return x end"));
+
+   // Nothing is recorded unless profiling is turned on
+   EXPECT_FALSE(levelgen->runCmd("spin", 0, 0));
+   EXPECT_EQ(0, profiler->getStackCount());
+
+   profiler->toggle(L, "all");
+   EXPECT_FALSE(levelgen->runCmd("spin", 0, 0));
+   profiler->stopAll(L);
+
+   // Script total, plus at least one sampled stack through spin()
+   EXPECT_LE(2, profiler->getStackCount());
+
+   profiler->clear();
+   ASSERT_EQ(0, lua_gettop(L));
+}
+
+
 // Test levelgen - bot communication
 TEST_F(LuaEnvironmentTest, scriptCommunication)
 {
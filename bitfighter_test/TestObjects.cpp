@@ -24,6 +24,8 @@
 #include "RenderUtils.h"
 
 #include "luaLevelGenerator.h"
+#include "ObjectPool.h"
+#include "projectile.h"
 
 
 #include "TestUtils.h"
@@ -317,5 +319,47 @@ TEST_F(ObjectTest, CreateObjectsFromLua)
 }
 
 
+TEST_F(ObjectTest, PooledAllocation)
+{
+   ObjectPoolStats *pool = ObjectPoolStats::findPool("Projectile");
+   ASSERT_TRUE(pool != NULL);
+
+   // Warm up, so the slots we need already exist
+   Vector<Projectile *> projectiles;
+   for(S32 i = 0; i < 10; i++)
+      projectiles.push_back(new Projectile());
+   projectiles.deleteAndClear();
+
+   U32 liveCount = pool->getLiveCount();
+   U32 allocCount = pool->getAllocCount();
+   U32 slotCount = pool->getNewSlotCount();
+
+   // Freed slots get reused, so churning through projectiles never needs new memory
+   for(S32 i = 0; i < 100; i++)
+   {
+      projectiles.push_back(new Projectile());
+
+      if(projectiles.size() == 10)
+         projectiles.deleteAndClear();
+   }
+
+   EXPECT_EQ(liveCount, pool->getLiveCount());
+   EXPECT_EQ(allocCount + 100, pool->getAllocCount());
+   EXPECT_EQ(slotCount, pool->getNewSlotCount());
+
+   // SpyBugs inherit Burst's allocator, but don't fit in its pool
+   ObjectPoolStats *burstPool = ObjectPoolStats::findPool("Burst");
+   ASSERT_TRUE(burstPool != NULL);
+
+   U32 heapAllocCount = burstPool->getHeapAllocCount();
+   U32 burstLiveCount = burstPool->getLiveCount();
+
+   delete new SpyBug();
+
+   EXPECT_EQ(heapAllocCount + 1, burstPool->getHeapAllocCount());
+   EXPECT_EQ(burstLiveCount, burstPool->getLiveCount());
+}
+
+
    
 }; // namespace Zap
@@ -4,8 +4,10 @@
 //------------------------------------------------------------------------------
 
 #include "TestUtils.h"
+#include "LevelFilesForTesting.h"
 #include "../zap/ClientGame.h"
 #include "../zap/ServerGame.h"
+#include "../zap/BotVisibilityCache.h"
 #include "../zap/gameType.h"
 #include "../zap/luaLevelGenerator.h"
 #include "gtest/gtest.h"
@@ -62,6 +64,76 @@ TEST(RobotTest, luaRobotNew)
 }
 
 
+TEST(RobotTest, visibilityCache)
+{
+	GamePair gamePair(getLevelCode1());      // Has a vertical wall at x = -255, running from y = -255 to 255
+	ServerGame *serverGame = gamePair.server;
+	BotVisibilityCache *cache = serverGame->getBotVisibilityCache();
+
+	Point left(-500, 0), right(0, 0);
+	Point farLeft(-500, -1000), farRight(0, -1000);
+
+	EXPECT_FALSE(cache->canSeePoint(left, right, 24));
+	EXPECT_TRUE (cache->canSeePoint(farLeft, farRight, 24));
+
+	// Asking again is answered from the cache, and so is asking from nearby
+	U32 misses = cache->getMissCount();
+	EXPECT_FALSE(cache->canSeePoint(left, right, 24));
+	EXPECT_TRUE (cache->canSeePoint(farLeft + Point(1, 1), farRight, 24));
+	EXPECT_EQ(misses, cache->getMissCount());
+
+	// Near the end of the wall, points in the same cells can get different answers; we must always get the right one
+	GridDatabase *database = serverGame->getGameObjDatabase();
+
+	for(S32 y = -340; y <= -240; y++)
+	{
+		Point from(-500, (F32)y), to(0, (F32)y);
+		EXPECT_EQ(BotVisibilityCache::isSweptPathClear(database, (TestFunc)isWallType, from, to, 24),
+		          cache->canSeePoint(from, to, 24)) << "y = " << y;
+	}
+
+	// Removing the wall should invalidate the cache
+	Vector<DatabaseObject *> walls;
+	serverGame->getGameObjDatabase()->findObjects((TestFunc)isWallType, walls);
+	ASSERT_TRUE(walls.size() > 0);
+
+	for(S32 i = 0; i < walls.size(); i++)
+		serverGame->getGameObjDatabase()->removeFromDatabase(walls[i], true);
+
+	EXPECT_TRUE(cache->canSeePoint(left, right, 24));
+}
+
+
+TEST(RobotTest, zoneVisibility)
+{
+	GamePair gamePair(getLevelCode1());
+	const Vector<BotNavMeshZone *> *zones = gamePair.server->getBotZones();
+
+	ASSERT_TRUE(zones->size() > 0);
+
+	GridDatabase *gameObjDatabase = gamePair.server->getGameObjDatabase();
+
+	// Visibility goes both ways, and when a zone claims a clear view of another, a ship really can fly between them.
+	// Corners are where a hull that wasn't widened enough would let us down, so check from every corner to every corner.
+	for(S32 i = 0; i < zones->size(); i++)
+		for(S32 j = 0; j < zones->size(); j++)
+		{
+			EXPECT_EQ(zones->get(i)->canSeeZone(j), zones->get(j)->canSeeZone(i));
+
+			if(!zones->get(i)->canSeeZone(j))
+				continue;
+
+			const Vector<Point> *outline1 = zones->get(i)->getOutline();
+			const Vector<Point> *outline2 = zones->get(j)->getOutline();
+
+			for(S32 k = 0; k < outline1->size(); k++)
+				for(S32 m = 0; m < outline2->size(); m++)
+					EXPECT_TRUE(BotVisibilityCache::isSweptPathClear(gameObjDatabase, (TestFunc)isWallType,
+					            outline1->get(k), outline2->get(m), Ship::CollisionRadius));
+		}
+}
+
+
 /** onShipSpawned doesn't fire?
 
 TEST(RobotTest, RemoveFromGameDuringInitialOnShipSpawn)
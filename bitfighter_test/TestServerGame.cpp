@@ -6,6 +6,15 @@
 #include "gameType.h"
 #include "ServerGame.h"
 #include "EngineeredItem.h"
+#include "ExplosionResolver.h"
+#include "TargetIndex.h"
+#include "TurretTargeting.h"
+#include "moveObject.h"
+#include "Zone.h"
+
+#include "tnlRandom.h"
+
+#include "../bitfighter_test/LevelFilesForTesting.h"
 
 #include "TestUtils.h"
 
@@ -165,4 +174,349 @@ TEST(ServerGameTest, LoadoutManagementTests)
 }
 
 
+// Plain wrapper around isWallType, so findObjectLOS() won't recognize it and will search for walls the old way
+static bool isWallTypeUnindexed(U8 x)
+{
+   return isWallType(x);
+}
+
+
+TEST(ServerGameTest, WallEdgeIndex)
+{
+   GamePair gamePair(
+      "GameType 10 8\n"
+      "GridSize 255\n"
+      "Team Bluey 0 0 1\n"
+      "BarrierMaker 40 -1 -1 -1 1\n"
+      "BarrierMaker 20 1 -1 2 0 3 1 1 2\n"
+      "PolyWall -3 -3 -2 -3 -2 -2\n"
+      "Spawn 0 -0.6 0\n");
+
+   GridDatabase *database = gamePair.server->getGameObjDatabase();
+
+   // Wall-only searches go through the index, and must find the same things the regular search does
+   for(S32 i = 0; i < 2000; i++)
+   {
+      Point start(Random::readF() * 1600 - 800, Random::readF() * 1600 - 800);
+      Point end(Random::readF() * 1600 - 800, Random::readF() * 1600 - 800);
+
+      F32 indexedTime, plainTime;
+      Point indexedNormal, plainNormal;
+
+      DatabaseObject *indexed = database->findObjectLOS((TestFunc)isWallType, ActualState, start, end, indexedTime, indexedNormal);
+      DatabaseObject *plain   = database->findObjectLOS(isWallTypeUnindexed,  ActualState, start, end, plainTime,   plainNormal);
+
+      ASSERT_EQ(plain == NULL, indexed == NULL);
+      EXPECT_EQ(plainTime, indexedTime);
+   }
+
+   // Other objects moving around mustn't make the index rebuild
+   U32 version = database->getGeometryVersion();
+   const Vector<DatabaseObject *> *objects = database->findObjects_fast();
+
+   for(S32 i = 0; i < objects->size(); i++)
+      if(!isWallType(objects->get(i)->getObjectTypeNumber()))
+         objects->get(i)->setExtent(objects->get(i)->getExtent());
+
+   EXPECT_EQ(version, database->getGeometryVersion());
+
+   // Index must notice when walls go away
+   Point left(-500, 0), right(0, 0);     // Blocked by the first barrier, at x = -255
+   EXPECT_FALSE(database->pointCanSeePoint(left, right));
+
+   Vector<DatabaseObject *> walls;
+   database->findObjects((TestFunc)isWallType, walls);
+
+   for(S32 i = 0; i < walls.size(); i++)
+      database->removeFromDatabase(walls[i], true);
+
+   EXPECT_TRUE(database->pointCanSeePoint(left, right));
+}
+
+
+TEST(ServerGameTest, FindAllObjectsLOS)
+{
+   GamePair gamePair(getLevelCode1());    // Has a vertical wall at x = -255, and a TestItem at (255, 255)
+   GridDatabase *database = gamePair.server->getGameObjDatabase();
+
+   // Passes through the wall on its way to the center of the TestItem
+   Point start(-500, 0), end(255, 255);
+
+   Vector<LOSHit> hits;
+   database->findAllObjectsLOS((TestFunc)isWeaponCollideableType, ActualState, start, end, hits);
+   ASSERT_EQ(2, hits.size());
+
+   // Hits come back in order, starting with the one findObjectLOS() would have found
+   for(S32 i = 1; i < hits.size(); i++)
+      EXPECT_LE(hits[i - 1].collisionTime, hits[i].collisionTime);
+
+   F32 collisionTime;
+   Point normal;
+   EXPECT_EQ(database->findObjectLOS((TestFunc)isWeaponCollideableType, ActualState, start, end, collisionTime, normal),
+             hits[0].object);
+   EXPECT_EQ(collisionTime, hits[0].collisionTime);
+   EXPECT_TRUE(isWallType(hits[0].object->getObjectTypeNumber()));
+   EXPECT_EQ(TestItemTypeNumber, hits[1].object->getObjectTypeNumber());
+}
+
+
+TEST(ServerGameTest, ExplosionResolver)
+{
+   // A vertical wall at x = -255, with one TestItem behind it and two in front
+   GamePair gamePair(
+      "GameType 10 8\n"
+      "LevelName Explosion Test\n"
+      "GridSize 255\n"
+      "Team Bluey 0 0 1\n"
+      "BarrierMaker 40 -1 -1 -1 1\n"
+      "TestItem -1.6 0\n"
+      "TestItem -0.6 0\n"
+      "TestItem -0.2 0\n");
+
+   ServerGame *game = gamePair.server;
+
+   Vector<DatabaseObject *> items;
+   game->getGameObjDatabase()->findObjects(TestItemTypeNumber, items);
+   ASSERT_EQ(3, items.size());
+
+   TestItem *hidden = NULL, *exploder = NULL, *victim = NULL;
+   for(S32 i = 0; i < items.size(); i++)
+   {
+      TestItem *item = static_cast<TestItem *>(items[i]);
+      item->setActualVel(Point(0, 0));
+
+      if(item->getPos().x < -255)
+         hidden = item;
+      else if(item->getPos().x < -100)
+         exploder = item;
+      else
+         victim = item;
+   }
+
+   ASSERT_TRUE(hidden && exploder && victim);
+
+   DamageInfo info;
+   info.collisionPoint = exploder->getPos();
+   info.damagingObject = exploder;
+   info.damageAmount   = 1;
+   info.damageType     = DamageTypeArea;
+
+   ExplosionResolver *resolver = game->getExplosionResolver();
+   U32 explosionCount = resolver->getExplosionCount();
+
+   // Nothing happens until the batch is resolved
+   resolver->beginBatch();
+   exploder->radiusDamage(exploder->getPos(), 100, 300, (TestFunc)isRadiusDamageAffectableType, info);
+   EXPECT_EQ(0, victim->getActualVel().len());
+
+   resolver->endBatch();
+   EXPECT_EQ(explosionCount + 1, resolver->getExplosionCount());
+
+   EXPECT_GT(victim->getActualVel().x, 0);              // Blown away from the explosion...
+   EXPECT_EQ(0, hidden->getActualVel().len());          // ...but not through the wall
+   EXPECT_EQ(0, exploder->getActualVel().len());        // No object damages itself
+
+   // Outside of a batch, explosions take effect right away
+   victim->setActualVel(Point(0, 0));
+   exploder->radiusDamage(exploder->getPos(), 100, 300, (TestFunc)isRadiusDamageAffectableType, info);
+   EXPECT_GT(victim->getActualVel().x, 0);
+   EXPECT_EQ(0, hidden->getActualVel().len());
+}
+
+
+// Counts the zone events checkForZones() generates
+class ZoneCountingItem : public TestItem
+{
+public:
+   S32 entered;
+   S32 left;
+
+   ZoneCountingItem() { entered = 0; left = 0; }
+
+protected:
+   void onEnteredZone(Zone *zone) { entered++; }
+   void onLeftZone(Zone *zone)    { left++; }
+};
+
+
+TEST(ServerGameTest, ZoneChecks)
+{
+   // A single zone from (0, 0) to (255, 255)
+   GamePair gamePair(
+      "GameType 10 8\n"
+      "LevelName Zone Test\n"
+      "GridSize 255\n"
+      "Team Bluey 0 0 1\n"
+      "Zone 0 0 1 0 1 1 0 1\n");
+
+   ServerGame *game = gamePair.server;
+   GridDatabase *database = game->getGameObjDatabase();
+
+   ZoneCountingItem *item = new ZoneCountingItem();
+   item->setActualPos(Point(-500, -500));
+   item->addToGame(game, database);
+
+   item->checkForZones();
+   EXPECT_EQ(0, item->entered);
+
+   // Small moves well away from the zone are skipped, but we must still see it when we cross into it
+   for(S32 i = 0; i < 50; i++)
+   {
+      item->setActualPos(Point(-500 + i * 12, -500 + i * 12));
+      item->checkForZones();
+   }
+
+   EXPECT_EQ(1, item->entered);
+   EXPECT_EQ(0, item->left);
+
+   // Wandering around inside doesn't generate any more events
+   item->setActualPos(Point(120, 130));
+   item->checkForZones();
+   EXPECT_EQ(1, item->entered);
+
+   // One big jump out
+   item->setActualPos(Point(1000, 1000));
+   item->checkForZones();
+   EXPECT_EQ(1, item->left);
+
+   // Standing still while the zone comes to us
+   Vector<DatabaseObject *> zones;
+   database->findObjects(ZoneTypeNumber, zones);
+   ASSERT_EQ(1, zones.size());
+
+   U32 zoneVersion = database->getZoneVersion();
+
+   Vector<Point> geom;
+   geom.push_back(Point(900, 900));
+   geom.push_back(Point(1100, 900));
+   geom.push_back(Point(1100, 1100));
+   geom.push_back(Point(900, 1100));
+   BfObject *zone = static_cast<BfObject *>(zones[0]);
+   zone->GeomObject::setGeom(geom);
+   zone->onGeomChanged();
+
+   EXPECT_NE(zoneVersion, database->getZoneVersion());
+
+   item->checkForZones();
+   EXPECT_EQ(2, item->entered);
+}
+
+
+TEST(ServerGameTest, TurretTargeting)
+{
+   ServerGame *serverGame = newServerGame();
+   GridDatabase *database = serverGame->getGameObjDatabase();
+
+   GameType *gt = new GameType();    // Will be deleted in serverGame destructor
+   gt->addToGame(serverGame, database);
+
+   // Two turrets side by side, and one far away, all pointing up at a TestItem above the first two
+   Turret *t1 = new Turret(2, Point(0, 0), Point(0, -1));
+   Turret *t2 = new Turret(2, Point(100, 0), Point(0, -1));
+   Turret *t3 = new Turret(2, Point(5000, 0), Point(0, -1));
+   t1->addToGame(serverGame, database);
+   t2->addToGame(serverGame, database);
+   t3->addToGame(serverGame, database);
+
+   TestItem *item = new TestItem();
+   item->setActualPos(Point(50, -300));
+   item->addToGame(serverGame, database);
+
+   TurretTargeting *targeting = serverGame->getTurretTargeting();
+   targeting->beginTick();
+   U32 queryCount = targeting->getQueryCount();
+
+   Vector<DatabaseObject *> targets;
+   targeting->findPotentialTargets(t1, targets);
+   ASSERT_EQ(1, targets.size());
+   EXPECT_EQ(item, targets[0]);
+
+   targets.clear();
+   targeting->findPotentialTargets(t2, targets);
+   ASSERT_EQ(1, targets.size());
+   EXPECT_EQ(item, targets[0]);
+
+   targets.clear();
+   targeting->findPotentialTargets(t3, targets);
+   EXPECT_EQ(0, targets.size());
+
+   // One search for the pair, and one for the loner
+   EXPECT_EQ(queryCount + 2, targeting->getQueryCount());
+
+   delete serverGame;
+}
+
+
+TEST(ServerGameTest, TargetIndex)
+{
+   ServerGame *serverGame = newServerGame();
+   GridDatabase *database = serverGame->getGameObjDatabase();
+
+   GameType *gt = new GameType();    // Will be deleted in serverGame destructor
+   gt->addToGame(serverGame, database);
+
+   Point shipPos[] = { Point(300, 0), Point(-200, 0), Point(0, 150) };
+   Ship *ships[3];
+
+   for(S32 i = 0; i < 3; i++)
+   {
+      ships[i] = new Ship();
+      ships[i]->setActualPos(shipPos[i], true);
+      ships[i]->addToGame(serverGame, database);
+   }
+
+   TestItem *item = new TestItem();
+   item->setActualPos(Point(100, 0));
+   item->addToGame(serverGame, database);
+
+   TargetIndex *index = serverGame->getTargetIndex();
+   index->beginTick();
+   EXPECT_EQ(4, index->getTargetCount());
+
+   // Ships only, closest first
+   Vector<BfObject *> targets;
+   index->findClosest(Point(0, 0), Point(1000, 1000), TargetIndex::ShipFlag, 0, FloatTau, targets);
+   ASSERT_EQ(3, targets.size());
+   EXPECT_EQ(ships[2], targets[0]);
+   EXPECT_EQ(ships[1], targets[1]);
+   EXPECT_EQ(ships[0], targets[2]);
+
+   // Only the ship to the right is within a 90 degree cone facing right
+   targets.clear();
+   index->findClosest(Point(0, 0), Point(1000, 1000), TargetIndex::ShipFlag, 0, FloatHalfPi, targets);
+   ASSERT_EQ(1, targets.size());
+   EXPECT_EQ(ships[0], targets[0]);
+
+   // Nothing out here
+   targets.clear();
+   index->findClosest(Point(5000, 5000), Point(1000, 1000), TargetIndex::ShipFlag, 0, FloatTau, targets);
+   EXPECT_EQ(0, targets.size());
+
+   // Everything
+   targets.clear();
+   index->findClosest(Point(0, 0), Point(1000, 1000), 0, 0, FloatTau, targets);
+   ASSERT_EQ(4, targets.size());
+   EXPECT_EQ(item, targets[0]);
+
+   // The index is built once per tick, no matter how many times it's used
+   EXPECT_EQ(1, index->getBuildCount());
+
+   // A ship that spawns during the tick is found right away, and one that explodes is dropped right away
+   Ship *newShip = new Ship();
+   newShip->setActualPos(Point(50, 0), true);
+   newShip->addToGame(serverGame, database);
+
+   ships[2]->mHasExploded = true;
+
+   targets.clear();
+   index->findClosest(Point(0, 0), Point(1000, 1000), TargetIndex::ShipFlag | TargetIndex::AliveFlag, 0, FloatTau, targets);
+   ASSERT_EQ(3, targets.size());
+   EXPECT_EQ(newShip, targets[0]);
+   EXPECT_EQ(ships[1], targets[1]);
+   EXPECT_EQ(ships[0], targets[2]);
+
+   delete serverGame;
+}
+
+
 };
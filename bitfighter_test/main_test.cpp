@@ -9,6 +9,7 @@
 
 #include "DisplayManager.h"
 #include "FontManager.h"
+#include "WorkerPool.h"
 #include "tnlLog.h"
 
 #include "stringUtils.h"
@@ -63,7 +64,9 @@ int main(int argc, char **argv)
 
 
    DisplayManager::initialize();
+   WorkerPool::init();
    int returnvalue = RUN_ALL_TESTS();
+   WorkerPool::shutdown();
    FontManager::cleanup();
    DisplayManager::cleanup();
    return returnvalue;
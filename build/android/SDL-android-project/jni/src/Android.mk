@@ -21,7 +21,9 @@ SHARED_SOURCES := \
 $(ZAP_PATH)/BanList.cpp \
 $(ZAP_PATH)/barrier.cpp \
 $(ZAP_PATH)/BfObject.cpp \
+$(ZAP_PATH)/BinaryLevel.cpp \
 $(ZAP_PATH)/BotNavMeshZone.cpp \
+$(ZAP_PATH)/BotVisibilityCache.cpp \
 $(ZAP_PATH)/ChatCheck.cpp \
 $(ZAP_PATH)/ClientInfo.cpp \
 $(ZAP_PATH)/Color.cpp \
@@ -34,6 +36,7 @@ $(ZAP_PATH)/dataConnection.cpp \
 $(ZAP_PATH)/EditorPlugin.cpp \
 $(ZAP_PATH)/EngineeredItem.cpp \
 $(ZAP_PATH)/EventManager.cpp \
+$(ZAP_PATH)/ExplosionResolver.cpp \
 $(ZAP_PATH)/flagItem.cpp \
 $(ZAP_PATH)/game.cpp \
 $(ZAP_PATH)/gameConnection.cpp \
@@ -53,19 +56,24 @@ $(ZAP_PATH)/HttpRequest.cpp \
 $(ZAP_PATH)/IniFile.cpp \
 $(ZAP_PATH)/InputCode.cpp \
 $(ZAP_PATH)/item.cpp \
+$(ZAP_PATH)/LevelIndex.cpp \
+$(ZAP_PATH)/LevelTemplateCache.cpp \
 $(ZAP_PATH)/LineItem.cpp \
 $(ZAP_PATH)/LoadoutTracker.cpp \
 $(ZAP_PATH)/loadoutZone.cpp \
 $(ZAP_PATH)/LuaBase.cpp \
 $(ZAP_PATH)/luaGameInfo.cpp \
 $(ZAP_PATH)/luaLevelGenerator.cpp \
+$(ZAP_PATH)/LuaProfiler.cpp \
 $(ZAP_PATH)/LuaScriptRunner.cpp \
+$(ZAP_PATH)/MappedFile.cpp \
 $(ZAP_PATH)/masterConnection.cpp \
 $(ZAP_PATH)/MathUtils.cpp \
 $(ZAP_PATH)/md5wrapper.cpp \
 $(ZAP_PATH)/move.cpp \
 $(ZAP_PATH)/moveObject.cpp \
 $(ZAP_PATH)/NexusGame.cpp \
+$(ZAP_PATH)/ObjectPool.cpp \
 $(ZAP_PATH)/PickupItem.cpp \
 $(ZAP_PATH)/playerInfo.cpp \
 $(ZAP_PATH)/Point.cpp \
@@ -90,12 +98,16 @@ $(ZAP_PATH)/speedZone.cpp \
 $(ZAP_PATH)/statistics.cpp \
 $(ZAP_PATH)/stringUtils.cpp \
 $(ZAP_PATH)/SystemFunctions.cpp \
+$(ZAP_PATH)/TargetIndex.cpp \
 $(ZAP_PATH)/teamInfo.cpp \
 $(ZAP_PATH)/teleporter.cpp \
 $(ZAP_PATH)/textItem.cpp \
 $(ZAP_PATH)/Timer.cpp \
+$(ZAP_PATH)/TurretTargeting.cpp \
+$(ZAP_PATH)/WallEdgeIndex.cpp \
 $(ZAP_PATH)/WallSegmentManager.cpp \
 $(ZAP_PATH)/WeaponInfo.cpp \
+$(ZAP_PATH)/WorkerPool.cpp \
 $(ZAP_PATH)/Zone.cpp \
 $(ZAP_PATH)/zoneControlGame.cpp \
 $(ZAP_PATH)/../clipper/clipper.cpp \
@@ -119,6 +131,7 @@ $(ZAP_PATH)/ClientGame.cpp \
 $(ZAP_PATH)/Cursor.cpp \
 $(ZAP_PATH)/EditorAttributeMenuItemBuilder.cpp \
 $(ZAP_PATH)/EditorTeam.cpp \
+$(ZAP_PATH)/EditorUndoJournal.cpp \
 $(ZAP_PATH)/EnergyGaugeRenderer.cpp \
 $(ZAP_PATH)/engineerHelper.cpp \
 $(ZAP_PATH)/Event.cpp \
@@ -133,6 +146,7 @@ $(ZAP_PATH)/JoystickRender.cpp \
 $(ZAP_PATH)/LevelDatabaseDownloadThread.cpp \
 $(ZAP_PATH)/LevelDatabaseRateThread.cpp \
 $(ZAP_PATH)/LevelDatabaseUploadThread.cpp \
+$(ZAP_PATH)/LevelValidationThread.cpp \
 $(ZAP_PATH)/lineEditor.cpp \
 $(ZAP_PATH)/LoadoutIndicator.cpp \
 $(ZAP_PATH)/loadoutHelper.cpp \
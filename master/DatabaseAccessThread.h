@@ -32,6 +32,8 @@ private:
    bool mRunning;
    bool mThreadActive;
 
+   Semaphore mEntryAdded;     // One count per entry waiting to run, plus one to wake us up to quit
+
    static const U32 mEntrySize = 128;
 
    RefPtr<ThreadEntry> mEntry[mEntrySize];
@@ -48,7 +50,8 @@ public:
    }
 
 
-   void addEntry(ThreadEntry *entry)
+   // Returns false if the entry couldn't be queued; it will never run
+   bool addEntry(ThreadEntry *entry)
    {
       U32 entryEnd = mEntryEnd + 1;
 
@@ -58,33 +61,37 @@ public:
       if(entryEnd == mEntryStart)      // Too many entries
       {
          logprintf(LogConsumer::LogError, "Database thread overloaded - database access too slow?");
-         return;
+         return false;
       }
 
       mEntry[mEntryEnd] = entry;
       mEntryEnd = entryEnd;
+      mEntryAdded.increment();
+
       if(!mThreadActive)
       {
          mThreadActive = true;
          start();
       }
+
+      return true;
    }
 
 
    U32 run()
    {
       mThreadActive = true;
-      while(mRunning)
+      while(true)
       {
-         if(mEntryThread != mEntryEnd)
-         {
-            mEntry[mEntryThread]->run();
-            mEntryThread++;
-            if(mEntryThread >= mEntrySize)
-               mEntryThread = 0;
-         }
-         else
-            Platform::sleep(50);
+         mEntryAdded.wait();     // Sleep until there's something to do
+
+         if(!mRunning)
+            break;
+
+         mEntry[mEntryThread]->run();
+         mEntryThread++;
+         if(mEntryThread >= mEntrySize)
+            mEntryThread = 0;
       }
 
       mThreadActive = false;
@@ -109,6 +116,8 @@ public:
    void terminate()
    {
       mRunning = false;
+      mEntryAdded.increment();
+
       while(mThreadActive)
          Platform::sleep(50);
    }
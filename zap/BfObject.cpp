@@ -24,6 +24,7 @@
 #include "stringUtils.h"         // For itos()
 #include "gameType.h"
 #include "EventManager.h"        // For EventType enum
+#include "ExplosionResolver.h"
 
 using namespace TNL;
 
@@ -972,85 +973,30 @@ bool BfObject::objectIntersectsSegment(BfObject *object, const Point &rayStart,
 
 
 // Returns number of ships hit
-S32 BfObject::radiusDamage(Point pos, S32 innerRad, S32 outerRad, TestFunc objectTypeTest, DamageInfo &info, F32 force)
+// Blast everything within outerRad of pos.  Those within innerRad get full force of the damage; those within outerRad get
+// damage proportional to distance.  Nothing is damaged through walls.  On the server, damage is done when the tick's
+// explosions are resolved together; see ExplosionResolver.  If weaponType is not WeaponNone, ships hit are counted in
+// the statistics of our owner.
+void BfObject::radiusDamage(Point pos, S32 innerRad, S32 outerRad, TestFunc objectTypeTest, DamageInfo &info, F32 force,
+                            WeaponType weaponType)
 {
-   // Check for players within range.  If so, blast them to little tiny bits!
-   // Those within innerRad get full force of the damage.  Those within outerRad get damage proportional to distance.
-   Rect queryRect(pos, pos);
-   queryRect.expand(Point(outerRad, outerRad));
+   GridDatabase *database = getDatabase();
 
-   fillVector.clear();
-   findObjects(objectTypeTest, fillVector, queryRect);
-
-   // No damage calculated on the client
-   if(isClient())
-      info.damageAmount = 0;
-
-   S32 shipsHit = 0;
-
-   for(S32 i = 0; i < fillVector.size(); i++)
-   {
-      BfObject *foundObject = static_cast<BfObject *>(fillVector[i]);
-
-      // No object damages itself
-      if(foundObject == info.damagingObject)
-         continue;
-
-      // Check the actual distance against our outer radius.  Recall that we got a list of potential
-      // collision objects based on a square area, but actual collisions will be based on true distance.
-      Point objPos = foundObject->getPos();
-      Point delta = objPos - pos;
-
-      if(delta.lenSquared() > sq(outerRad))
-         continue;
-
-      // Check if this pair of objects can damage one another
-      if(!getGame()->objectCanDamageObject(info.damagingObject, foundObject))
-         continue;
-
-      // Do an LOS check...
-      F32 t;
-      Point n;
-
-      // No damage through walls or forcefields
-      if(findObjectLOS((TestFunc)isWallType, ActualState, pos, objPos, t, n))
-         continue;
-
-      // Figure the impulse and damage
-      DamageInfo localInfo = info;
-
-      // Figure collision forces...
-      localInfo.impulseVector  = delta;
-      localInfo.impulseVector.normalize();
-
-      //localInfo.collisionPoint  = objPos;
-      localInfo.collisionPoint -= info.impulseVector;
-
-      // Reuse t from above to represent interpolation based on distance
-      F32 dist = delta.len();
-      if(dist < innerRad)           // Inner radius gets full force of blast
-         t = 1.f;
-      else                          // But if we're further away, force is attenuated
-         t = 1.f - (dist - innerRad) / (outerRad - innerRad);
-
-      // Attenuate impulseVector and damageAmount
-      localInfo.impulseVector  *= force * t;
-      localInfo.damageAmount   *= t;
-
-      // Adjust for self-damage
-      ClientInfo *damagerOwner = info.damagingObject->getOwner();
-      ClientInfo *victimOwner = foundObject->getOwner();
+   if(!database)
+      return;
 
-      if(victimOwner && damagerOwner == victimOwner)
-         localInfo.damageAmount *= localInfo.damageSelfMultiplier;
+   ExplosionResolver::Explosion explosion;
 
-      if(isShipType(foundObject->getObjectTypeNumber()))
-         shipsHit++;
+   explosion.database       = database;
+   explosion.pos            = pos;
+   explosion.innerRad       = innerRad;
+   explosion.outerRad       = outerRad;
+   explosion.objectTypeTest = objectTypeTest;
+   explosion.info           = info;
+   explosion.force          = force;
+   explosion.weaponType     = weaponType;
 
-      foundObject->damageObject(&localInfo); 
-   }
-
-   return shipsHit;
+   getGame()->getExplosionResolver()->addExplosion(explosion);
 }
 
 
@@ -1100,6 +1046,18 @@ BfObject *BfObject::findObjectLOS(TestFunc objectTypeTest, U32 stateIndex, const
 }
 
 
+void BfObject::findAllObjectsLOS(TestFunc objectTypeTest, U32 stateIndex, const Point &rayStart, const Point &rayEnd,
+                                 Vector<LOSHit> &hits) const
+{
+   GridDatabase *gridDB = getDatabase();
+
+   if(gridDB)
+      gridDB->findAllObjectsLOS(objectTypeTest, stateIndex, rayStart, rayEnd, hits);
+   else
+      hits.clear();
+}
+
+
 void BfObject::onAddedToGame(Game *game)
 {
    game->mObjectsLoaded++;
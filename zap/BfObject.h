@@ -11,6 +11,7 @@
 #include "move.h"
 #include "LuaWrapper.h"
 #include "HelpItemManager.h"  // HelpItem enum
+#include "WeaponInfo.h"       // WeaponType enum
 
 #include "tnlNetObject.h"
 
@@ -274,6 +275,7 @@ public:
 
    BfObject *findObjectLOS(U8 typeNumber, U32 stateIndex, const Point &start, const Point &end, float &collisionTime, Point &normal) const;
    BfObject *findObjectLOS(TestFunc,      U32 stateIndex, const Point &start, const Point &end, float &collisionTime, Point &normal) const;
+   void findAllObjectsLOS(TestFunc,      U32 stateIndex, const Point &start, const Point &end, Vector<LOSHit> &hits) const;
 
    bool controllingClientIsValid();                   // Checks if controllingClient is valid
    SafePtr<GameConnection> getControllingClient();
@@ -332,7 +334,8 @@ public:
    // Gets location(s) where repair rays should be rendered while object is being repaired
    virtual Vector<Point> getRepairLocations(const Point &repairOrigin);    
    bool objectIntersectsSegment(BfObject *object, const Point &rayStart, const Point &rayEnd, F32 &fillCollisionTime);
-   S32 radiusDamage(Point pos, S32 innerRad, S32 outerRad, TestFunc objectTypeTest, DamageInfo &info, F32 force = 2000);
+   void radiusDamage(Point pos, S32 innerRad, S32 outerRad, TestFunc objectTypeTest, DamageInfo &info, F32 force = 2000,
+                     WeaponType weaponType = WeaponNone);
    virtual void damageObject(DamageInfo *damageInfo);
 
    void onGhostAddBeforeUpdate(GhostConnection *theConnection);
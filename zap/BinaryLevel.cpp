@@ -0,0 +1,904 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BinaryLevel.h"
+
+#include "LevelSource.h"
+#include "ServerGame.h"
+#include "barrier.h"
+#include "MappedFile.h"
+#include "md5wrapper.h"
+
+#include "stringUtils.h"
+
+#include "tnlLog.h"
+
+#include <map>
+#include <string.h>
+
+namespace Zap
+{
+
+static const char Magic[] = { 0, 'B', 'F', 'L' };
+static const U8 Version = 1;
+
+// Each line record starts with a flags byte: the line ending in the low bits, and whether the line is stored raw
+enum LineFlags {
+   NoLineEnding    = 0,
+   NewLine         = 1,      // \n
+   CarriageNewLine = 2,      // \r\n
+   LineEndingMask  = 3,
+   RawLine         = 4,      // Stored as a string, rather than broken into words
+   ExtraSpaces     = 8,      // Words are preceded by the number of leading spaces, and each is followed by its own count
+};
+
+// Each word starts with a tag byte: either StringWord, followed by an index into the string table, or NumberWord plus
+// the number of decimal places, followed by the digits (with the decimal point removed) as a zigzagged var integer
+static const U8 StringWord = 0;
+static const U8 NumberWord = 1;
+static const U32 MaxDecimals = 15;
+static const U32 MaxDigits = 18;                // Fits in an S64
+static const U64 MaxMagnitude = 999999999999999999ull;    // Largest value with MaxDigits digits
+static const U32 MaxNumberLength = MaxDigits + 3;    // Sign, decimal point, terminator
+
+const char *BinaryLevel::Extension = "blevel";
+
+
+static void writeVarU64(string &out, U64 value)
+{
+   while(value >= 0x80)
+   {
+      out += char((value & 0x7F) | 0x80);
+      value >>= 7;
+   }
+
+   out += char(value);
+}
+
+
+static void writeVarU32(string &out, U32 value)
+{
+   writeVarU64(out, value);
+}
+
+
+static void writeVarS32(string &out, S32 value)
+{
+   writeVarU32(out, (U32(value) << 1) ^ U32(value >> 31));
+}
+
+
+static void writeF32(string &out, F32 value)
+{
+   U32 bits;
+   memcpy(&bits, &value, sizeof(bits));
+
+   for(S32 i = 0; i < 4; i++)
+      out += char((bits >> (i * 8)) & 0xFF);
+}
+
+
+static void writeString(string &out, const char *str, U32 length)
+{
+   writeVarU32(out, length);
+   out.append(str, length);
+}
+
+
+static void writeString(string &out, const string &str)
+{
+   writeString(out, str.data(), (U32)str.size());
+}
+
+
+bool BinaryLevel::isBinaryLevel(const char *data, U32 size)
+{
+   return size >= sizeof(Magic) && memcmp(data, Magic, sizeof(Magic)) == 0;
+}
+
+
+// Only numbers we can write back exactly as they were count: no leading zeros, no "-0", no trailing "." and so on.
+// If word is one, fills digits with its value as an integer, and decimals with where the decimal point goes.
+static bool parseNumber(const char *word, U32 length, S64 &digits, U32 &decimals)
+{
+   const char *pos = word;
+   const char *end = word + length;
+
+   bool negative = (pos < end && *pos == '-');
+   if(negative)
+      pos++;
+
+   if(pos == end || *pos < '0' || *pos > '9' || (*pos == '0' && pos + 1 < end && pos[1] != '.'))
+      return false;
+
+   U64 value = 0;
+   U32 digitCount = 0;
+   decimals = 0;
+
+   bool seenPoint = false;
+
+   for(; pos < end; pos++)
+   {
+      if(*pos == '.')
+      {
+         if(seenPoint || pos + 1 == end)
+            return false;
+
+         seenPoint = true;
+         continue;
+      }
+
+      if(*pos < '0' || *pos > '9' || ++digitCount > MaxDigits)
+         return false;
+
+      value = value * 10 + U64(*pos - '0');
+
+      if(seenPoint)
+         decimals++;
+   }
+
+   if(decimals > MaxDecimals || (negative && value == 0))
+      return false;
+
+   digits = negative ? -S64(value) : S64(value);
+   return true;
+}
+
+
+// Writes a number as text into buffer, which needs room for MaxNumberLength chars; returns the length, not counting
+// the terminator
+static U32 formatNumber(S64 digits, U32 decimals, char *buffer)
+{
+   char reversed[MaxDigits + 2];
+   U32 count = 0;
+
+   U64 value = digits < 0 ? U64(-digits) : U64(digits);
+
+   do
+   {
+      reversed[count++] = char('0' + value % 10);
+      value /= 10;
+   } while(value > 0 && count < MaxDigits + 1);
+
+   while(count < decimals + 1)
+      reversed[count++] = '0';
+
+   U32 length = 0;
+
+   if(digits < 0)
+      buffer[length++] = '-';
+
+   while(count > 0)
+   {
+      if(count == decimals)
+         buffer[length++] = '.';
+
+      buffer[length++] = reversed[--count];
+   }
+
+   buffer[length] = '\0';
+   return length;
+}
+
+
+static bool isLineWhitespace(char c)
+{
+   return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+
+// A line can be stored as words if they are the same words LevelTokenizer would find, and we can put the line back
+// together from them: so nothing in quotes, and no whitespace other than spaces
+static bool canSplitLine(const char *line, U32 length)
+{
+   for(U32 i = 0; i < length; i++)
+      if(line[i] == '"' || (line[i] != ' ' && isLineWhitespace(line[i])))
+         return false;
+
+   return true;
+}
+
+
+// Most lines have exactly one space between words, and none at either end; the rest need their spaces counted
+static bool hasExtraSpaces(const char *line, U32 length)
+{
+   if(length > 0 && (line[0] == ' ' || line[length - 1] == ' '))
+      return true;
+
+   for(U32 i = 0; i + 1 < length; i++)
+      if(line[i] == ' ' && line[i + 1] == ' ')
+         return true;
+
+   return false;
+}
+
+
+static U32 countSpaces(const char *pos, const char *end)
+{
+   U32 count = 0;
+
+   while(pos + count < end && pos[count] == ' ')
+      count++;
+
+   return count;
+}
+
+
+typedef map<string, U32> StringTable;
+
+static void writeLine(string &out, const char *line, U32 length, U8 ending, StringTable &stringTable,
+                      Vector<const string *> &strings)
+{
+   if(!canSplitLine(line, length))
+   {
+      out += char(ending | RawLine);
+      writeString(out, line, length);
+      return;
+   }
+
+   bool extraSpaces = hasExtraSpaces(line, length);
+
+   out += char(ending | (extraSpaces ? ExtraSpaces : 0));
+
+   const char *end = line + length;
+
+   U32 wordCount = 0;
+   for(U32 i = 0; i < length; i++)
+      if(line[i] != ' ' && (i == 0 || line[i - 1] == ' '))
+         wordCount++;
+
+   writeVarU32(out, wordCount);
+
+   const char *word = line + countSpaces(line, end);
+
+   if(extraSpaces)
+      writeVarU32(out, U32(word - line));
+
+   while(word < end)
+   {
+      const char *wordEnd = (const char *)memchr(word, ' ', end - word);
+      if(!wordEnd)
+         wordEnd = end;
+
+      U32 wordLength = U32(wordEnd - word);
+
+      S64 digits;
+      U32 decimals;
+
+      if(parseNumber(word, wordLength, digits, decimals))
+      {
+         out += char(NumberWord + decimals);
+         writeVarU64(out, (U64(digits) << 1) ^ U64(digits >> 63));
+      }
+      else
+      {
+         pair<StringTable::iterator, bool> entry = stringTable.insert(StringTable::value_type(string(word, wordLength),
+                                                                                                 strings.size()));
+         if(entry.second)
+            strings.push_back(&entry.first->first);
+
+         out += char(StringWord);
+         writeVarU32(out, entry.first->second);
+      }
+
+      U32 spaces = countSpaces(wordEnd, end);
+
+      if(extraSpaces)
+         writeVarU32(out, spaces);
+
+      word = wordEnd + spaces;
+   }
+}
+
+
+void BinaryLevel::encode(const char *text, U32 size, const Vector<Vector<Point> > *mergedWalls, S32 barrierCount,
+                         string &out)
+{
+   out.clear();
+   out.append(Magic, sizeof(Magic));
+   out += char(Version);
+
+   // LevelInfo fields, found the same way LevelSource finds them in text levels, but from the whole file, not just the start
+   LevelHeader header;
+   LevelSource::readLevelHeader(text, (S32)size, header);
+
+   writeString(out, header.levelName);
+   writeString(out, header.gameTypeName);
+   writeVarS32(out, header.minPlayers);
+   writeVarS32(out, header.maxPlayers);
+   writeString(out, header.scriptFileName);
+
+   md5stream hash;
+   hash.process(text, size);
+   writeString(out, hash.getHash());
+
+   // Lines, which need to be written before we know what goes in the string table
+   StringTable stringTable;
+   Vector<const string *> strings;
+   string lines;
+   U32 lineCount = 0;
+
+   const char *pos = text;
+   const char *end = text + size;
+
+   while(pos < end)
+   {
+      const char *newline = (const char *)memchr(pos, '\n', end - pos);
+      const char *lineEnd = newline ? newline : end;
+      U8 ending = NoLineEnding;
+
+      if(newline)
+      {
+         ending = NewLine;
+
+         if(lineEnd > pos && lineEnd[-1] == '\r')
+         {
+            ending = CarriageNewLine;
+            lineEnd--;
+         }
+      }
+
+      writeLine(lines, pos, U32(lineEnd - pos), ending, stringTable, strings);
+      lineCount++;
+
+      pos = newline ? newline + 1 : end;
+   }
+
+   writeVarU32(out, lineCount);
+
+   if(mergedWalls)
+   {
+      writeVarU32(out, U32(barrierCount + 1));
+      writeVarU32(out, mergedWalls->size());
+
+      for(S32 i = 0; i < mergedWalls->size(); i++)
+      {
+         const Vector<Point> &poly = mergedWalls->get(i);
+
+         writeVarU32(out, poly.size());
+
+         for(S32 j = 0; j < poly.size(); j++)
+         {
+            writeF32(out, poly[j].x);
+            writeF32(out, poly[j].y);
+         }
+      }
+   }
+   else
+      writeVarU32(out, 0);
+
+   writeVarU32(out, strings.size());
+
+   for(S32 i = 0; i < strings.size(); i++)
+      writeString(out, *strings[i]);
+
+   out += lines;
+}
+
+
+bool BinaryLevel::decode(const char *data, U32 size, string &text)
+{
+   text.clear();
+
+   BinaryLevelReader reader(data, size);
+   string line;
+
+   while(reader.nextLine(line))
+      text += line;
+
+   return reader.isValid();
+}
+
+
+bool BinaryLevel::readLevelHeader(const char *data, U32 size, LevelHeader &header)
+{
+   BinaryLevelReader reader(data, size);
+
+   if(!reader.hasLevelHeader())
+      return false;
+
+   header = reader.getLevelHeader();
+   return true;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+BinaryLevelReader::BinaryLevelReader(const char *data, U32 size) : mRawTokenizer(NULL, 0)
+{
+   mPos = data;
+   mEnd = data + size;
+   mValid = false;
+
+   mHasLevelHeader = false;
+
+   mLineCount = 0;
+   mLineNum = 0;
+   mMergedWallBarrierCount = -1;
+   mId = 0;
+   mRaw = false;
+
+   mValid = readHeader();
+}
+
+
+U32 BinaryLevelReader::readVarU32()
+{
+   U64 value = readVarU64();
+
+   if(value > U32_MAX)
+   {
+      mValid = false;
+      return 0;
+   }
+
+   return U32(value);
+}
+
+
+// On running out of data, sets mValid to false and returns 0; callers check mValid when they're done reading
+U64 BinaryLevelReader::readVarU64()
+{
+   U64 value = 0;
+
+   for(U32 shift = 0; shift < 64 && mPos < mEnd; shift += 7)
+   {
+      U8 byte = (U8)*mPos++;
+      value |= U64(byte & 0x7F) << shift;
+
+      if(!(byte & 0x80))
+         return value;
+   }
+
+   mValid = false;
+   return 0;
+}
+
+
+S32 BinaryLevelReader::readVarS32()
+{
+   U32 value = readVarU32();
+   return S32(value >> 1) ^ -S32(value & 1);
+}
+
+
+F32 BinaryLevelReader::readF32()
+{
+   if(mEnd - mPos < 4)
+   {
+      mValid = false;
+      return 0;
+   }
+
+   U32 bits = 0;
+   for(S32 i = 0; i < 4; i++)
+      bits |= U32((U8)*mPos++) << (i * 8);
+
+   F32 value;
+   memcpy(&value, &bits, sizeof(value));
+
+   return value;
+}
+
+
+// Returns a pointer into the data, so no copying
+bool BinaryLevelReader::readString(const char *&str, U32 &length)
+{
+   length = readVarU32();
+
+   if(!mValid || length > U32(mEnd - mPos))
+   {
+      mValid = false;
+      return false;
+   }
+
+   str = mPos;
+   mPos += length;
+
+   return true;
+}
+
+
+bool BinaryLevelReader::readString(string &str)
+{
+   const char *data;
+   U32 length;
+
+   if(!readString(data, length))
+      return false;
+
+   str.assign(data, length);
+   return true;
+}
+
+
+bool BinaryLevelReader::readHeader()
+{
+   if(!BinaryLevel::isBinaryLevel(mPos, U32(mEnd - mPos)) || mEnd - mPos < (S32)sizeof(Magic) + 1)
+      return false;
+
+   mPos += sizeof(Magic);
+
+   if((U8)*mPos++ != Version)
+   {
+      logprintf(LogConsumer::LogWarning, "Binary level is version %d; we only know how to read version %d",
+                (U8)mPos[-1], Version);
+      return false;
+   }
+
+   mValid = true;
+
+   // The LevelInfo fields come first, so they can be read from the start of a file that's otherwise cut off
+   readString(mLevelHeader.levelName);
+   readString(mLevelHeader.gameTypeName);
+   mLevelHeader.minPlayers = readVarS32();
+   mLevelHeader.maxPlayers = readVarS32();
+   readString(mLevelHeader.scriptFileName);
+
+   if(!mValid)
+      return false;
+
+   mHasLevelHeader = true;
+
+   readString(mHash);
+   mLineCount = readVarU32();
+
+   mMergedWallBarrierCount = S32(readVarU32()) - 1;
+
+   if(mMergedWallBarrierCount >= 0)
+   {
+      U32 polyCount = readVarU32();
+
+      for(U32 i = 0; i < polyCount && mValid; i++)
+      {
+         U32 pointCount = readVarU32();
+
+         if(pointCount > U32(mEnd - mPos) / 8)     // Don't let garbage make us allocate a huge polygon
+         {
+            mValid = false;
+            break;
+         }
+
+         mMergedWalls.push_back(Vector<Point>(pointCount));
+         Vector<Point> &poly = mMergedWalls.last();
+
+         for(U32 j = 0; j < pointCount; j++)
+         {
+            F32 x = readF32();
+            F32 y = readF32();
+            poly.push_back(Point(x, y));
+         }
+      }
+   }
+
+   U32 stringCount = readVarU32();
+
+   if(stringCount > U32(mEnd - mPos))       // Every string takes at least a byte
+      return false;
+
+   mStrings.resize(stringCount);
+   mNames.resize(stringCount);
+   mIds.resize(stringCount);
+
+   for(U32 i = 0; i < stringCount; i++)
+   {
+      if(!readString(mStrings[i]))
+         return false;
+
+      // Split off any id now, the same way LevelTokenizer does, in case this is the first word on a line
+      size_t bang = mStrings[i].find('!');
+
+      mNames[i] = mStrings[i].substr(0, bang);
+      mIds[i] = bang == string::npos ? 0 : atoi(mStrings[i].c_str() + bang + 1);
+   }
+
+   return mValid;
+}
+
+
+static void appendSpaces(string *text, U32 count)
+{
+   if(text)
+      text->append(count, ' ');
+}
+
+
+// If text isn't NULL, also rebuilds the line as it was in the original level, line ending and all
+bool BinaryLevelReader::readLine(string *text)
+{
+   if(!mValid)
+      return false;
+
+   // Running out of data before we've seen every line means the file was cut off; anything left over means it's garbled
+   if(mLineNum == (S32)mLineCount || mPos >= mEnd)
+   {
+      if(mLineNum != (S32)mLineCount || mPos != mEnd)
+         mValid = false;
+
+      return false;
+   }
+
+   U8 flags = (U8)*mPos++;
+
+   mArgv.clear();
+   mId = 0;
+   mRaw = (flags & RawLine) != 0;
+
+   if(mRaw)
+   {
+      const char *line;
+      U32 length;
+
+      if(!readString(line, length))
+         return false;
+
+      mRawTokenizer = LevelTokenizer(line, length);
+      if(!mRawTokenizer.nextLine())
+         mRaw = false;           // Empty line, so no words; mArgv is already empty
+
+      if(text)
+         text->assign(line, length);
+   }
+   else
+   {
+      U32 wordCount = readVarU32();
+
+      if(!mValid || wordCount > U32(mEnd - mPos))    // Every word takes at least a byte
+      {
+         mValid = false;
+         return false;
+      }
+
+      // Make room for every word to be a number up front, so mArgv's pointers into the buffer stay put
+      mNumberBuffer.resize(max(wordCount, 1u) * MaxNumberLength);
+      char *number = mNumberBuffer.address();
+
+      bool extraSpaces = (flags & ExtraSpaces) != 0;
+
+      if(text)
+         text->clear();
+
+      if(extraSpaces)
+         appendSpaces(text, readVarU32());
+
+      for(U32 i = 0; i < wordCount; i++)
+      {
+         if(mPos >= mEnd)
+         {
+            mValid = false;
+            return false;
+         }
+
+         U8 tag = (U8)*mPos++;
+         const char *word;
+
+         if(tag == StringWord)
+         {
+            U32 index = readVarU32();
+
+            if(!mValid || index >= (U32)mStrings.size())
+            {
+               mValid = false;
+               return false;
+            }
+
+            if(i == 0)
+            {
+               word = mNames[index].c_str();
+               mId = mIds[index];
+            }
+            else
+               word = mStrings[index].c_str();
+
+            if(text)
+               *text += mStrings[index];
+         }
+         else if(tag >= NumberWord && tag <= NumberWord + MaxDecimals)
+         {
+            U64 value = readVarU64();
+
+            // The writer never stores more than MaxDigits digits; anything bigger would overrun our slot in mNumberBuffer
+            if((value >> 1) + (value & 1) > MaxMagnitude)
+            {
+               mValid = false;
+               return false;
+            }
+
+            S64 digits = S64(value >> 1) ^ -S64(value & 1);
+
+            word = number;
+            number += formatNumber(digits, tag - NumberWord, number) + 1;
+
+            if(text)
+               *text += word;
+         }
+         else
+         {
+            mValid = false;
+            return false;
+         }
+
+         if(!mValid)
+            return false;
+
+         mArgv.push_back(word);
+
+         if(extraSpaces)
+            appendSpaces(text, readVarU32());
+         else if(i + 1 < wordCount)
+            appendSpaces(text, 1);
+      }
+
+      if(!mValid)
+         return false;
+   }
+
+   U8 ending = flags & LineEndingMask;
+
+   if(text)
+   {
+      if(ending == NewLine)
+         *text += '\n';
+      else if(ending == CarriageNewLine)
+         *text += "\r\n";
+   }
+
+   mLineNum++;
+   return true;
+}
+
+
+bool BinaryLevelReader::isValid() const
+{
+   return mValid;
+}
+
+
+bool BinaryLevelReader::hasLevelHeader() const
+{
+   return mHasLevelHeader;
+}
+
+
+const LevelHeader &BinaryLevelReader::getLevelHeader() const
+{
+   return mLevelHeader;
+}
+
+
+const string &BinaryLevelReader::getHash() const
+{
+   return mHash;
+}
+
+
+U32 BinaryLevelReader::getLineCount() const
+{
+   return mLineCount;
+}
+
+
+const Vector<Vector<Point> > &BinaryLevelReader::getMergedWalls() const
+{
+   return mMergedWalls;
+}
+
+
+S32 BinaryLevelReader::getMergedWallBarrierCount() const
+{
+   return mMergedWallBarrierCount;
+}
+
+
+bool BinaryLevelReader::nextLine()
+{
+   return readLine(NULL);
+}
+
+
+bool BinaryLevelReader::nextLine(string &text)
+{
+   return readLine(&text);
+}
+
+
+S32 BinaryLevelReader::getLineNum() const
+{
+   return mLineNum;
+}
+
+
+U32 BinaryLevelReader::getArgc() const
+{
+   return mRaw ? mRawTokenizer.getArgc() : mArgv.size();
+}
+
+
+const char **BinaryLevelReader::getArgv()
+{
+   return mRaw ? mRawTokenizer.getArgv() : mArgv.address();
+}
+
+
+S32 BinaryLevelReader::getId() const
+{
+   return mRaw ? mRawTokenizer.getId() : mId;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Loads the level into a throwaway ServerGame, the same way the server will, and merges its barriers.  Returns the number
+// of barriers merged, or -1 if merging failed.
+static S32 mergeLevelWalls(const char *text, U32 size, Vector<Vector<Point> > &walls)
+{
+   Address address;
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+   LevelSourcePtr levelSource = LevelSourcePtr(new StringLevelSource(""));
+
+   ServerGame *game = new ServerGame(address, settings, levelSource, false, false);
+
+   game->resetLevelInfo();
+   game->loadLevelFromBuffer(text, size, game->getGameObjDatabase());
+
+   Vector<DatabaseObject *> barriers;
+   game->getGameObjDatabase()->findObjects(BarrierTypeNumber, barriers);
+
+   S32 barrierCount = barriers.size();
+
+   if(!Barrier::unionBarriers(barriers, walls))
+   {
+      walls.clear();
+      barrierCount = -1;
+   }
+
+   delete game;
+
+   return barrierCount;
+}
+
+
+bool convertLevelFile(const string &inputFile, const string &outputFile)
+{
+   MappedFile input(inputFile);
+
+   if(!input.isOpen())
+   {
+      logprintf(LogConsumer::LogError, "Could not open level file %s", inputFile.c_str());
+      return false;
+   }
+
+   string output;
+
+   if(BinaryLevel::isBinaryLevel(input.getData(), input.getSize()))
+   {
+      if(!BinaryLevel::decode(input.getData(), input.getSize(), output))
+      {
+         logprintf(LogConsumer::LogError, "%s is damaged, or is not a binary level", inputFile.c_str());
+         return false;
+      }
+   }
+   else
+   {
+      Vector<Vector<Point> > walls;
+      S32 barrierCount = mergeLevelWalls(input.getData(), input.getSize(), walls);
+
+      BinaryLevel::encode(input.getData(), input.getSize(), barrierCount >= 0 ? &walls : NULL, barrierCount, output);
+   }
+
+   if(!writeFile(outputFile, output))
+   {
+      logprintf(LogConsumer::LogError, "Could not write level file %s", outputFile.c_str());
+      return false;
+   }
+
+   return true;
+}
+
+
+};
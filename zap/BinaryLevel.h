@@ -0,0 +1,130 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _BINARY_LEVEL_H_
+#define _BINARY_LEVEL_H_
+
+#include "gameLoader.h"    // For LevelTokenizer
+#include "LevelSource.h"   // For LevelHeader
+#include "Point.h"
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+#include <string>
+
+using namespace std;
+using namespace TNL;
+
+namespace Zap
+{
+
+// Binary levels are an optional, compact form of a .level file, meant for servers that load a lot of levels.  Text
+// remains the canonical format (the editor and the level database only ever deal with text); a binary level is made
+// from a text level with the -convertlevel command, and can be turned back into exactly the same text the same way.
+//
+// Layout (integers are little-endian; "var" integers are 7 bits per byte, low bits first):
+//
+//    Magic              4 bytes, starting with a 0, so no text level can be mistaken for a binary one
+//    Version            1 byte
+//    LevelInfo          Level name, gametype name, min players, max players, script name (a LevelHeader), as
+//                       LevelSource would find them by scanning the text
+//    Hash               md5 of the original text, so we match the level database without rebuilding the text
+//    Line count         var
+//    Merged walls       Barrier count (var, plus one; zero means there are no walls stored), polygon count (var),
+//                       then each polygon as a point count (var) followed by F32 x/y pairs
+//    String table       Count (var), then each string; every word in the level that isn't a number is stored once here
+//    Lines              One record per line: a LineFlags byte, then either the line as a string, or a word count (var)
+//                       followed by the words; see BinaryLevel.cpp for how words are stored
+class BinaryLevel
+{
+public:
+   static const char *Extension;                      // Without the dot
+
+   static bool isBinaryLevel(const char *data, U32 size);
+
+   // Encode level text; mergedWalls may be NULL.  barrierCount is the number of barriers the walls were merged from.
+   static void encode(const char *text, U32 size, const Vector<Vector<Point> > *mergedWalls, S32 barrierCount,
+                      string &out);
+
+   static bool decode(const char *data, U32 size, string &text);     // Returns false if data is not a valid binary level
+
+   // Returns false if data is not a binary level, or is cut off before the end of the LevelInfo fields
+   static bool readLevelHeader(const char *data, U32 size, LevelHeader &header);
+};
+
+
+// Walks through the lines of a binary level, handing back each as the argc/argv/id that processLevelLoadLine wants,
+// like LevelTokenizer does for text.  Words come straight out of the string table, and nothing needs to be tokenized.
+class BinaryLevelReader
+{
+private:
+   const char *mPos;
+   const char *mEnd;
+   bool mValid;
+
+   bool mHasLevelHeader;
+   LevelHeader mLevelHeader;
+
+   string mHash;
+   U32 mLineCount;
+   S32 mLineNum;
+
+   S32 mMergedWallBarrierCount;
+   Vector<Vector<Point> > mMergedWalls;
+
+   Vector<string> mStrings;
+   Vector<string> mNames;           // mStrings with any "!id" removed, for the first word on a line
+   Vector<S32> mIds;
+
+   Vector<const char *> mArgv;
+   Vector<char> mNumberBuffer;      // Numbers are written here as text
+   S32 mId;
+   bool mRaw;                       // Lines we couldn't break into words are stored as text, and tokenized here...
+   LevelTokenizer mRawTokenizer;    // ...in which case argc, argv and id come from here
+
+   U32 readVarU32();
+   U64 readVarU64();
+   S32 readVarS32();
+   F32 readF32();
+   bool readString(const char *&str, U32 &length);
+   bool readString(string &str);
+
+   bool readHeader();
+   bool readLine(string *text);
+
+public:
+   BinaryLevelReader(const char *data, U32 size);     // Constructor
+
+   bool isValid() const;            // False if the data is not a binary level, or has been found to be cut off or garbled
+
+   // The LevelInfo fields come first, so they can be read even if the data is cut off later on
+   bool hasLevelHeader() const;
+   const LevelHeader &getLevelHeader() const;
+
+   const string &getHash() const;
+   U32 getLineCount() const;
+
+   // Walls merged ahead of time, and how many barriers they were made from; the count is -1 if none were stored
+   const Vector<Vector<Point> > &getMergedWalls() const;
+   S32 getMergedWallBarrierCount() const;
+
+   bool nextLine();                 // Returns false when there are no more lines, or the data runs out
+   bool nextLine(string &text);     // Also rebuilds the line's original text, with its line ending
+
+   S32 getLineNum() const;          // First line is 1
+   U32 getArgc() const;
+   const char **getArgv();
+   S32 getId() const;
+};
+
+
+// Converts a text level to binary, or a binary one back to text, depending on what inputFile holds
+bool convertLevelFile(const string &inputFile, const string &outputFile);
+
+
+};
+
+#endif
@@ -48,6 +48,9 @@ const S32 BotNavMeshZone::BufferRadius = Ship::CollisionRadius;  // Radius to bu
 const S32 BotNavMeshZone::LevelZoneBuffer = MAX(BufferRadius * 2, 50);
 const F32 BotNavMeshZone::CoreTraversalCost = 1000;
 
+static const S32 MAX_VISIBILITY_ZONES = 4000;                    // Visibility sets take zones^2 bits
+static const F32 MAX_VISIBILITY_DISTANCE = 1500;                 // Zones farther apart than this aren't checked for visibility
+
 // Constructor
 BotNavMeshZone::BotNavMeshZone(S32 id)
 {
@@ -66,6 +69,12 @@ BotNavMeshZone::~BotNavMeshZone()
 }
 
 
+BotNavMeshZone *BotNavMeshZone::clone() const
+{
+   return new BotNavMeshZone(*this);
+}
+
+
 // Return the center of this zone
 Point BotNavMeshZone::getCenter()
 {
@@ -124,6 +133,18 @@ S32 BotNavMeshZone::getNeighborIndex(S32 zoneID)
    return -1;
 }
 
+// Bits are set in buildVisibilitySets().  If that was skipped, we can't vouch for anything.
+bool BotNavMeshZone::canSeeZone(U16 zoneId) const
+{
+   if(mVisibleZones.size() == 0)
+      return false;
+
+   U32 word = zoneId >> 5;
+
+   return word < (U32)mVisibleZones.size() && (mVisibleZones[word] & (1 << (zoneId & 31))) != 0;
+}
+
+
 U16 BotNavMeshZone::getZoneId()
 {
    return mZoneId;
@@ -345,6 +366,168 @@ static BotNavMeshZone *findZoneTouchingCircle(const GridDatabase *botZoneDatabas
 #endif
 
 
+static bool pointIsLeftOf(const Point &a, const Point &b)
+{
+   return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+
+static F32 cross(const Point &o, const Point &a, const Point &b)
+{
+   return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+
+// Convex hull of the outlines of two zones, using Andrew's monotone chain
+static void getCombinedHull(const BotNavMeshZone *zone1, const BotNavMeshZone *zone2, Vector<Point> &hull)
+{
+   Vector<Point> points(*zone1->getOutline());
+
+   for(S32 i = 0; i < zone2->getOutline()->size(); i++)
+      points.push_back(zone2->getOutline()->get(i));
+
+   points.sort(pointIsLeftOf);
+
+   S32 count = points.size();
+   hull.resize(2 * count);
+   S32 k = 0;
+
+   for(S32 i = 0; i < count; i++)                       // Lower hull
+   {
+      while(k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0)
+         k--;
+      hull[k++] = points[i];
+   }
+
+   for(S32 i = count - 2, lower = k + 1; i >= 0; i--)   // Upper hull
+   {
+      while(k >= lower && cross(hull[k - 2], hull[k - 1], points[i]) <= 0)
+         k--;
+      hull[k++] = points[i];
+   }
+
+   hull.resize(k - 1);                                  // Last point is the same as the first
+}
+
+
+// Can a ship fly in a straight line from anywhere in one zone to anywhere in the other?  Any such path lies inside the
+// convex hull of the two zones, widened by the ship's radius, so if no wall touches that, the answer is yes.  Walls close
+// to the hull can make us say no when the real answer is yes, but never the other way around.  Zones are cut out of walls
+// buffered by exactly a ship's radius, so zones that hug a wall will generally come out as not visible; that is fine.
+static bool zonesHaveClearView(const GridDatabase *gameObjDatabase, BotNavMeshZone *zone1, BotNavMeshZone *zone2,
+                               Vector<DatabaseObject *> &walls)
+{
+   F32 time;
+   Point normal;
+
+   // Centers are in the hull, so this is a cheap way to rule out most pairs
+   if(gameObjDatabase->findObjectLOS((TestFunc)isWallType, ActualState, true, zone1->getCenter(), zone2->getCenter(),
+                                     time, normal))
+      return false;
+
+   Rect rect(zone1->getExtent());
+   rect.unionRect(zone2->getExtent());
+   rect.expand(Point(Ship::CollisionRadius + 1, Ship::CollisionRadius + 1));
+
+   walls.clear();
+   gameObjDatabase->findObjects((TestFunc)isWallType, walls, rect);
+
+   if(walls.size() == 0)
+      return true;
+
+   Vector<Point> hull, widenedHull;
+   getCombinedHull(zone1, zone2, hull);
+   offsetPolygon(&hull, widenedHull, F32(Ship::CollisionRadius + 1));   // Square joins cover the whole ship; +1 for rounding
+
+   if(widenedHull.size() < 3)       // Sliver zones can have a flat hull, which won't offset; don't vouch for them
+      return false;
+
+   for(S32 i = 0; i < walls.size(); i++)
+   {
+      const Vector<Point> *wallPoints = walls[i]->getCollisionPoly();
+      if(wallPoints && polygonsIntersect(widenedHull, *wallPoints))
+         return false;
+   }
+
+   return true;
+}
+
+
+// Compute a visibility set for each zone: a bitmap of the zones that a ship anywhere inside it can fly straight to, no
+// matter where in the other zone it is headed.  This is only ever used to skip a real line-of-sight test when the answer
+// is sure to be yes; a pair we leave out just means that test gets run.  Only walls block visibility.
+//
+// To keep this from being quadratic on big levels, we only look at pairs within MAX_VISIBILITY_DISTANCE of each other,
+// walking the zones in order of their left edges so we can stop as soon as we are too far to the right.
+static bool zoneIsLeftOf(const pair<F32, S32> &a, const pair<F32, S32> &b)
+{
+   return a.first < b.first;
+}
+
+
+void BotNavMeshZone::buildVisibilitySets(const Vector<BotNavMeshZone *> *allZones, const GridDatabase *gameObjDatabase)
+{
+   S32 zoneCount = allZones->size();
+
+   for(S32 i = 0; i < zoneCount; i++)
+      allZones->get(i)->mVisibleZones.clear();
+
+   if(zoneCount > MAX_VISIBILITY_ZONES)
+   {
+      logprintf(LogConsumer::LogLevelError, "Too many bot zones (%d) to compute zone visibility; bots will be slower", zoneCount);
+      return;
+   }
+
+   S32 words = (zoneCount + 31) >> 5;
+
+   for(S32 i = 0; i < zoneCount; i++)
+   {
+      BotNavMeshZone *zone = allZones->get(i);
+
+      zone->mVisibleZones.resize(words);
+      for(S32 j = 0; j < words; j++)
+         zone->mVisibleZones[j] = 0;
+   }
+
+   Vector<pair<F32, S32> > order;    // Left edge, index into allZones
+   order.resize(zoneCount);
+
+   for(S32 i = 0; i < zoneCount; i++)
+      order[i] = pair<F32, S32>(allZones->get(i)->getExtent().min.x, i);
+
+   order.sort(zoneIsLeftOf);
+
+   Vector<DatabaseObject *> walls;
+
+   for(S32 k = 0; k < zoneCount; k++)
+   {
+      S32 i = order[k].second;
+      BotNavMeshZone *zone = allZones->get(i);
+      Rect extent = zone->getExtent();
+
+      for(S32 m = k; m < zoneCount; m++)
+      {
+         if(order[m].first - extent.max.x > MAX_VISIBILITY_DISTANCE)
+            break;                             // This one and all the rest are too far to the right
+
+         S32 j = order[m].second;
+         BotNavMeshZone *other = allZones->get(j);
+         Rect otherExtent = other->getExtent();
+
+         if(otherExtent.min.y - extent.max.y > MAX_VISIBILITY_DISTANCE ||
+            extent.min.y - otherExtent.max.y > MAX_VISIBILITY_DISTANCE)
+            continue;
+
+         if(zonesHaveClearView(gameObjDatabase, zone, other, walls))
+         {
+            zone->mVisibleZones[j >> 5] |= 1 << (j & 31);
+            other->mVisibleZones[i >> 5] |= 1 << (i & 31);
+         }
+      }
+   }
+}
+
+
 // Populate allZones -- we'll use this for efficiency, saving us the trouble of repeating this operation in multiple places.  
 // We can retrieve them using BotNavMeshZone::getBotZones().
 void BotNavMeshZone::populateZoneList(GridDatabase *botZoneDatabase, Vector<BotNavMeshZone *> *allZones)
@@ -706,7 +889,8 @@ static bool meshArea(const PolyTree &polytree, const Rect &levelBounds,
 // Server only
 // Use the Triangle library to create zones.  Aggregate triangles with Recast
 bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDatabase *gameObjDatabase, Vector<BotNavMeshZone *> *allZones,
-                                       const Rect *worldExtents, bool triangulateZones)
+                                       const Rect *worldExtents, bool triangulateZones,
+                                       const Vector<Vector<Point> > *premergedWalls)
 {
    // Start by finding all objects that'll matter for meshing the level
 
@@ -778,8 +962,11 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDataba
    Vector<Vector<Point> > blockingPolygons;
 
 
-   // First merge all barrier polygons
-   if(barrierList.size() > 0)
+   // First merge all barrier polygons, unless a binary level did that for us already
+   if(premergedWalls)
+      offsetPolygons(*premergedWalls, blockingPolygons, BufferRadius);
+
+   else if(barrierList.size() > 0)
    {
       Vector<Vector<Point> > barrierInputPolygons;
       bool unionSucceeded = Barrier::unionBarriers(barrierList,  barrierInputPolygons);
@@ -1045,6 +1232,9 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDataba
             speedZoneList, speedZonePolygons, szBotZoneStartId);
    }
 
+   // Now that all the zones exist, figure out which can see each other
+   buildVisibilitySets(allZones, gameObjDatabase);
+
 #ifdef LOG_TIMER
    U32 done3 = Platform::getRealMilliseconds();  // Done
    logprintf("Built %d zones!", botZoneDatabase->getObjectCount());
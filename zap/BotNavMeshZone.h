@@ -51,12 +51,14 @@ class BotNavMeshZone : public DatabaseObject
 private:   
    U16 mZoneId;                              // Unique ID for each zone
    bool mWalkable;                           // Flag for if this zone can currently be traversed
+   Vector<U32> mVisibleZones;                // Zones with a clear view from all of this one, one bit each; empty if not computed
 
    static void populateZoneList(GridDatabase *mBotZoneDatabase, Vector<BotNavMeshZone *> *allZones);  // Populates allZones
 
 public:
    explicit BotNavMeshZone(S32 id = -1);     // Constructor
    virtual ~BotNavMeshZone();                // Destructor
+   BotNavMeshZone *clone() const;            // Copy keeps id, neighbors and visibility; it won't be in any database
    
    static const S32 BufferRadius;            // Radius to buffer objects when creating the holes for zones
    static const S32 LevelZoneBuffer;         // Extra padding around the game extents to allow outsize zones to be created
@@ -83,8 +85,13 @@ public:
    Vector<Border> mNeighborRenderPoints;     // Only populated on client
    S32 getNeighborIndex(S32 zone);           // Returns index of neighboring zone, or -1 if zone is not a neighbor
 
+   bool canSeeZone(U16 zoneId) const;        // Can a ship fly straight from anywhere in this zone to anywhere in that one?
+
    static bool buildBotMeshZones(GridDatabase *botZoneDatabase, GridDatabase *gameObjDatabase, Vector<BotNavMeshZone *> *allZones,
-                                 const Rect *worldExtents, bool triangulateZones);
+                                 const Rect *worldExtents, bool triangulateZones,
+                                 const Vector<Vector<Point> > *premergedWalls = NULL);
+
+   static void buildVisibilitySets(const Vector<BotNavMeshZone *> *allZones, const GridDatabase *gameObjDatabase);
 
    static bool buildConnectionsRecastStyle(const Vector<BotNavMeshZone *> *allZones,
          rcPolyMesh &mesh, const Vector<S32> &polyToZoneMap, S32 coreRecastPolyStartIdx,
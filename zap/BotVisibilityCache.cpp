@@ -0,0 +1,201 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BotVisibilityCache.h"
+
+#include "BotNavMeshZone.h"
+#include "BfObject.h"
+#include "moveObject.h"    // For ActualState
+#include "GeomUtils.h"
+
+#include <math.h>
+
+namespace Zap
+{
+
+// Constructor
+BotVisibilityCache::BotVisibilityCache(GridDatabase *gameObjDatabase)
+{
+   mGameObjDatabase = gameObjDatabase;
+   mGameObjVersion = gameObjDatabase->getGeometryVersion();
+
+   mHits = 0;
+   mMisses = 0;
+}
+
+
+// Destructor
+BotVisibilityCache::~BotVisibilityCache()
+{
+   // Do nothing
+}
+
+
+// Throw out everything we know if the walls have changed since we last looked
+void BotVisibilityCache::validate()
+{
+   if(mGameObjVersion == mGameObjDatabase->getGeometryVersion())
+      return;
+
+   clear();
+
+   mGameObjVersion = mGameObjDatabase->getGeometryVersion();
+}
+
+
+BotVisibilityCache::Cell BotVisibilityCache::getCell(const Point &p)
+{
+   return Cell((S32)floor(p.x / CellSize), (S32)floor(p.y / CellSize));
+}
+
+
+Point BotVisibilityCache::getCellCenter(const Cell &cell)
+{
+   return Point((cell.first + 0.5f) * CellSize, (cell.second + 0.5f) * CellSize);
+}
+
+
+bool BotVisibilityCache::canSeePoint(const Point &from, const Point &to, F32 radius)
+{
+   validate();
+
+   Cell fromCell = getCell(from);
+   Cell toCell = getCell(to);
+
+   if(fromCell == toCell)     // Too short to be worth remembering
+      return isSweptPathClear(mGameObjDatabase, (TestFunc)isWallType, from, to, radius);
+
+   pair<SegmentKey, F32> key(SegmentKey(fromCell, toCell), radius);
+   map<pair<SegmentKey, F32>, bool>::iterator it = mSweptVisibility.find(key);
+
+   bool cellsClear;
+
+   if(it != mSweptVisibility.end())
+   {
+      mHits++;
+      cellsClear = it->second;
+   }
+   else
+   {
+      mMisses++;
+
+      if(mSweptVisibility.size() >= (size_t)MaxEntries)
+         mSweptVisibility.clear();
+
+      // Every point in a cell is within halfDiagonal of its center, so every point on a path between the two cells is
+      // within halfDiagonal of the path between their centers.  Widening that path by halfDiagonal, and running it past
+      // each center by the full width so the ends are covered too, gives a path that holds every path between the cells.
+      F32 halfDiagonal = CellSize * FloatSqrtHalf;
+      F32 width = radius + halfDiagonal;
+
+      Point fromCenter = getCellCenter(fromCell);
+      Point toCenter = getCellCenter(toCell);
+
+      Point extension = toCenter - fromCenter;
+      extension.normalize(width);
+
+      cellsClear = isSweptPathClear(mGameObjDatabase, (TestFunc)isWallType, fromCenter - extension, toCenter + extension, width);
+      mSweptVisibility[key] = cellsClear;
+   }
+
+   if(cellsClear)
+      return true;
+
+   // Something is near the path between these cells, but it might not be in our way
+   return isSweptPathClear(mGameObjDatabase, (TestFunc)isWallType, from, to, radius);
+}
+
+
+// Sweep a ship-wide rectangle from one point to the other, and see if it hits anything that passes testFunc
+bool BotVisibilityCache::isSweptPathClear(GridDatabase *database, TestFunc testFunc, const Point &from, const Point &to,
+                                          F32 radius)
+{
+   Point difference = to - from;
+
+   Point crossVector(difference.y, -difference.x);  // Create a point whose vector from 0,0 is perpenticular to the original vector
+   crossVector.normalize(radius);                   // reduce point so the vector has length of ship radius
+
+   static Vector<Point> thisPoints;
+   thisPoints.clear();
+
+   thisPoints.push_back(from + crossVector);        // Edge points of ship
+   thisPoints.push_back(from - crossVector);
+   thisPoints.push_back(to - crossVector);          // Edge points of point
+   thisPoints.push_back(to + crossVector);
+
+   Rect queryRect(thisPoints);
+
+   static Vector<DatabaseObject *> objects;
+   objects.clear();
+   database->findObjects(testFunc, objects, queryRect);
+
+   for(S32 i = 0; i < objects.size(); i++)
+   {
+      const Vector<Point> *otherPoints = objects[i]->getCollisionPoly();
+      if(otherPoints && polygonsIntersect(thisPoints, *otherPoints))
+         return false;
+   }
+
+   return true;
+}
+
+
+U16 BotVisibilityCache::computeClosestZone(GridDatabase *gameObjDatabase, GridDatabase *botZoneDatabase,
+                                           const Point &point, const Point &worldCenter)
+{
+   // First, do a quick search for zone based on the buffer; should be 99% of the cases
+
+   // Search radius is just slightly larger than twice the zone buffers added to objects like barriers
+   S32 searchRadius = 2 * BotNavMeshZone::BufferRadius + 1;
+
+   static Vector<DatabaseObject *> objects;
+   objects.clear();
+
+   Rect rect = Rect(point.x + searchRadius, point.y + searchRadius, point.x - searchRadius, point.y - searchRadius);
+
+   botZoneDatabase->findObjects(BotNavMeshZoneTypeNumber, objects, rect);
+
+   for(S32 i = 0; i < objects.size(); i++)
+   {
+      BotNavMeshZone *zone = static_cast<BotNavMeshZone *>(objects[i]);
+      Point center = zone->getCenter();
+
+      if(gameObjDatabase->pointCanSeePoint(center, point))  // This is an expensive test
+         return zone->getZoneId();
+   }
+
+   // Target must be outside extents of the map, find nearest zone if a straight line was drawn
+   F32 collisionTimeIgnore;
+   Point surfaceNormalIgnore;
+
+   DatabaseObject *object = botZoneDatabase->findObjectLOS(BotNavMeshZoneTypeNumber,
+         ActualState, point, worldCenter, collisionTimeIgnore, surfaceNormalIgnore);
+
+   if(object)
+      return static_cast<BotNavMeshZone *>(object)->getZoneId();
+
+   return U16_MAX;
+}
+
+
+void BotVisibilityCache::clear()
+{
+   mSweptVisibility.clear();
+}
+
+
+U32 BotVisibilityCache::getHitCount() const
+{
+   return mHits;
+}
+
+
+U32 BotVisibilityCache::getMissCount() const
+{
+   return mMisses;
+}
+
+
+};
@@ -0,0 +1,76 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _BOT_VISIBILITY_CACHE_H_
+#define _BOT_VISIBILITY_CACHE_H_
+
+#include "gridDB.h"
+
+#include "tnlTypes.h"
+
+#include <map>
+
+using namespace std;
+using namespace TNL;
+
+namespace Zap
+{
+
+// Robots ask the same visibility questions over and over: every tick each bot checks whether it can see each remaining
+// waypoint in its flight plan.  The bot moves a little between ticks, so rather than remembering exact questions, we
+// divide the level into cells and remember whether a wide path between the centers of two cells is clear -- wide enough
+// to cover the path between any two points in those cells.  If it is, any question between those cells gets a yes
+// without looking at the walls.  If not, the caller might still have a clear path, so we ask the walls directly.
+// The answers only depend on the walls, which almost never change while a level is running; the whole cache is thrown
+// out whenever the wall geometry changes.
+//
+// Only wall-only queries are cached; anything that includes other objects must be asked directly.
+class BotVisibilityCache
+{
+private:
+   static const S32 MaxEntries = 65536;      // We'll start over if we grow past this
+   static const S32 CellSize = 16;
+
+   GridDatabase *mGameObjDatabase;
+
+   U32 mGameObjVersion;
+
+   typedef pair<S32, S32> Cell;
+   typedef pair<Cell, Cell> SegmentKey;
+
+   map<pair<SegmentKey, F32>, bool> mSweptVisibility;    // (from cell, to cell), radius => is a path between any points clear?
+
+   U32 mHits;
+   U32 mMisses;
+
+   void validate();
+   static Cell getCell(const Point &p);
+   static Point getCellCenter(const Cell &cell);
+
+public:
+   explicit BotVisibilityCache(GridDatabase *gameObjDatabase);    // Constructor
+   virtual ~BotVisibilityCache();                                // Destructor
+
+   // Can a ship of the specified radius travel in a straight line from one point to the other without hitting a wall?
+   bool canSeePoint(const Point &from, const Point &to, F32 radius);
+
+   // Uncached version of the above, for use by the cache and by callers who need to include other object types
+   static bool isSweptPathClear(GridDatabase *database, TestFunc testFunc, const Point &from, const Point &to, F32 radius);
+
+   // Returns the id of a zone whose center can see point, or failing that, the first zone hit by a ray from point to
+   // worldCenter.  Returns U16_MAX if there is no such zone.
+   static U16 computeClosestZone(GridDatabase *gameObjDatabase, GridDatabase *botZoneDatabase,
+                                 const Point &point, const Point &worldCenter);
+
+   void clear();
+
+   U32 getHitCount() const;
+   U32 getMissCount() const;
+};
+
+
+};
+
+#endif
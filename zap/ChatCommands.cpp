@@ -12,6 +12,7 @@
 #include "LevelDatabaseRateThread.h"
 #include "LevelSource.h"
 #include "LevelSpecifierEnum.h"
+#include "ObjectPool.h"
 
 #include "UIManager.h"
 #include "UIGame.h"
@@ -537,6 +538,21 @@ void maxFpsHandler(ClientGame *game, const Vector<string> &words)
 }
 
 
+// Shows counters for the pools short-lived objects like projectiles are allocated from.  Pools are shared by everything
+// in this process, so these include the local server if we're hosting.
+void poolStatsHandler(ClientGame *game, const Vector<string> &words)
+{
+   Vector<string> lines;
+   ObjectPoolStats::getStatLines(lines);
+
+   for(S32 i = 0; i < lines.size(); i++)
+   {
+      game->displayMessage(Colors::cyan, lines[i].c_str());
+      logprintf("%s", lines[i].c_str());
+   }
+}
+
+
 #define atof(x) ((F32)atof(x))   // It should be a float already, dammit... it's not called atod!
 
 void lagHandler(ClientGame *game, const Vector<string> &words)
@@ -914,6 +930,26 @@ void shuffleTeams(ClientGame *game, const Vector<string> &words)
 }
 
 
+// Profiling is done on the server, which will check permissions again
+void luaProfileHandler(ClientGame *game, const Vector<string> &words)
+{
+   if(game->hasAdmin("!!! Need admin permissions to profile scripts"))
+   {
+      if(words.size() < 2)
+      {
+         game->displayErrorMessage("!!! /luaprofile <script name|all|stop|write>");
+         return;
+      }
+
+      Vector<StringPtr> args;
+      for(S32 i = 1; i < words.size(); i++)
+         args.push_back(StringPtr(words[i]));
+
+      game->sendCommand(StringTableEntry(words[0], false), args);
+   }
+}
+
+
 void banPlayerHandler(ClientGame *game, const Vector<string> &words)
 {
    if(game->hasAdmin("!!! Need admin permissions to ban players"))
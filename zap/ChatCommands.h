@@ -103,6 +103,7 @@ void pmHandler                 (ClientGame *game, const Vector<string> &args);
 void muteHandler               (ClientGame *game, const Vector<string> &args);
 void voiceMuteHandler          (ClientGame *game, const Vector<string> &args);
 void maxFpsHandler             (ClientGame *game, const Vector<string> &args);
+void poolStatsHandler          (ClientGame *game, const Vector<string> &args);
 void lagHandler                (ClientGame *game, const Vector<string> &args);
 void clearCacheHandler         (ClientGame *game, const Vector<string> &args);
 void lineWidthHandler          (ClientGame *game, const Vector<string> &args);
@@ -125,6 +126,7 @@ void banIpHandler              (ClientGame *game, const Vector<string> &args);
 void renamePlayerHandler       (ClientGame *game, const Vector<string> &args);
 void globalMuteHandler         (ClientGame *game, const Vector<string> &args);
 void shuffleTeams              (ClientGame *game, const Vector<string> &args);
+void luaProfileHandler         (ClientGame *game, const Vector<string> &args);
 void downloadMapHandler        (ClientGame *game, const Vector<string> &args);
 void rateMapHandler            (ClientGame *game, const Vector<string> &args);
 void commentMapHandler         (ClientGame *game, const Vector<string> &args);
@@ -82,6 +82,7 @@ namespace Zap
    { "rename",             &ChatCommands::renamePlayerHandler,       { NAME, STR },  2, ADMIN_COMMANDS,  0,  1,  {"<from>","<to>"},       "Give a player a new name" },
    { "maxbots",            &ChatCommands::setMaxBotsHandler,         { xINT },       1, ADMIN_COMMANDS,  0,  1,  {"<count>"},             "Set the maximum bots allowed for this server" },
    { "shuffle",            &ChatCommands::shuffleTeams,              { },            0, ADMIN_COMMANDS,  0,  1,  { "" },                  "Randomly reshuffle teams" },
+   { "luaprofile",         &ChatCommands::luaProfileHandler,         { STR },        1, ADMIN_COMMANDS,  0,  1,  {"<script|all|stop|write>"}, "Toggle script profiling; results are saved in the log folder" },
 #ifdef TNL_DEBUG
    { "pause",              &ChatCommands::pauseHandler,              { },            0, ADMIN_COMMANDS,  0,  1,  { "" },                  "TODO: add 'PAUSED' display while paused" },
 #endif
@@ -101,6 +102,7 @@ namespace Zap
    { "maxfps",     &ChatCommands::maxFpsHandler,        { xINT },    1, DEBUG_COMMANDS, 1,  1, {"<number>"},  "Set maximum speed of game in frames per second" },
    { "lag",        &ChatCommands::lagHandler, {xINT,xINT,xINT,xINT}, 4, DEBUG_COMMANDS, 1,  2, {"<send lag>", "[% of send drop packets]", "[receive lag]", "[% of receive drop packets]" }, "Set additional lag and dropped packets for testing bad networks" },
    { "clearcache", &ChatCommands::clearCacheHandler,    {  },        0, DEBUG_COMMANDS, 1,  1, { },           "Clear any cached scripts, forcing them to be reloaded" },
+   { "poolstats",  &ChatCommands::poolStatsHandler,     {  },        0, DEBUG_COMMANDS, 1,  1, { },           "Show allocation counters for pooled objects like projectiles" },
 
    // The following are only available in debug builds!
 #ifdef TNL_DEBUG
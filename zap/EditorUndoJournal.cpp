@@ -0,0 +1,244 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "EditorUndoJournal.h"
+
+#include "BfObject.h"
+#include "gridDB.h"
+#include "WallSegmentManager.h"
+
+#include <set>
+
+namespace Zap
+{
+
+// Levelcode covers everything about an object that the user can change; selection is added so undo puts that back too
+static string getFingerprint(BfObject *obj)
+{
+   return obj->toLevelCode() + (obj->isSelected() ? " *" : "");
+}
+
+
+// Constructor
+EditorUndoJournal::EditorUndoJournal(U32 maxStates)
+{
+   mSteps.resize(maxStates);
+   mCurrentStateIndex = 0;
+   mHaveCurrentState = false;
+}
+
+
+// Destructor
+EditorUndoJournal::~EditorUndoJournal()
+{
+   // Do nothing
+}
+
+
+void EditorUndoJournal::clear()
+{
+   for(S32 i = 0; i < mSteps.size(); i++)
+      mSteps[i].clear();
+
+   mCurrentState.clear();
+   mCurrentStateIndex = 0;
+   mHaveCurrentState = false;
+}
+
+
+EditorUndoJournal::Step &EditorUndoJournal::getStep(U32 index)
+{
+   return mSteps[index % mSteps.size()];
+}
+
+
+void EditorUndoJournal::captureCurrentState(GridDatabase *database)
+{
+   mCurrentState.clear();
+
+   const Vector<DatabaseObject *> *objects = database->findObjects_fast();
+
+   for(S32 i = 0; i < objects->size(); i++)
+   {
+      BfObject *obj = static_cast<BfObject *>(objects->get(i));
+
+      Snapshot &snapshot = mCurrentState[obj->getSerialNumber()];
+      snapshot.object = shared_ptr<BfObject>(obj->clone());
+      snapshot.fingerprint = getFingerprint(obj);
+   }
+
+   mHaveCurrentState = true;
+}
+
+
+void EditorUndoJournal::saveState(GridDatabase *database, U32 index, U32 oldestIndex)
+{
+   // If the editor has gone back in its history since we last saved, the state before index is one we've already been through,
+   // and we can get back to it with the steps we already have.  The step leading to index will be recorded afresh below.
+   while(mHaveCurrentState && mCurrentStateIndex >= index && mCurrentStateIndex > oldestIndex + 1)
+   {
+      applyStep(getStep(mCurrentStateIndex - 1), false, NULL);
+      mCurrentStateIndex--;
+   }
+
+   // Nothing to step from; just remember how things are now
+   if(!mHaveCurrentState || mCurrentStateIndex + 1 != index || index <= oldestIndex + 1)
+   {
+      captureCurrentState(database);
+      mCurrentStateIndex = index;
+      return;
+   }
+
+   Step &step = getStep(index - 1);
+   step.clear();
+
+   const Vector<DatabaseObject *> *objects = database->findObjects_fast();
+   set<S32> found;
+
+   for(S32 i = 0; i < objects->size(); i++)
+   {
+      BfObject *obj = static_cast<BfObject *>(objects->get(i));
+      S32 serialNumber = obj->getSerialNumber();
+      string fingerprint = getFingerprint(obj);
+
+      found.insert(serialNumber);
+
+      SnapshotMap::iterator it = mCurrentState.find(serialNumber);
+
+      if(it != mCurrentState.end() && it->second.fingerprint == fingerprint)
+         continue;      // Unchanged
+
+      Change change;
+      change.serialNumber = serialNumber;
+      change.after = shared_ptr<BfObject>(obj->clone());
+
+      if(it != mCurrentState.end())
+         change.before = it->second.object;
+
+      step.push_back(change);
+
+      Snapshot &snapshot = mCurrentState[serialNumber];
+      snapshot.object = change.after;
+      snapshot.fingerprint = fingerprint;
+   }
+
+   // Anything we have that isn't in the database any more was deleted
+   for(SnapshotMap::iterator it = mCurrentState.begin(); it != mCurrentState.end(); )
+   {
+      if(found.count(it->first))
+      {
+         it++;
+         continue;
+      }
+
+      Change change;
+      change.serialNumber = it->first;
+      change.before = it->second.object;
+      step.push_back(change);
+
+      mCurrentState.erase(it++);
+   }
+
+   mCurrentStateIndex = index;
+}
+
+
+// Apply step to mCurrentState, and, if database is not NULL, to the objects in database as well.  Walls get new segments, but
+// it is up to the caller to rebuild the wall edges and remount any engineered items once all steps have been applied.
+void EditorUndoJournal::applyStep(const Step &step, bool forward, GridDatabase *database)
+{
+   map<S32, BfObject *> objectsBySerialNumber;
+   Vector<DatabaseObject *> addedObjects;
+
+   if(database)
+   {
+      const Vector<DatabaseObject *> *objects = database->findObjects_fast();
+
+      for(S32 i = 0; i < objects->size(); i++)
+      {
+         BfObject *obj = static_cast<BfObject *>(objects->get(i));
+         objectsBySerialNumber[obj->getSerialNumber()] = obj;
+      }
+   }
+
+   for(S32 i = 0; i < step.size(); i++)
+   {
+      const Change &change = step[i];
+      const shared_ptr<BfObject> &target = forward ? change.after : change.before;
+
+      if(target)
+      {
+         Snapshot &snapshot = mCurrentState[change.serialNumber];
+         snapshot.object = target;
+         snapshot.fingerprint = getFingerprint(target.get());
+      }
+      else
+         mCurrentState.erase(change.serialNumber);
+
+      if(!database)
+         continue;
+
+      map<S32, BfObject *>::iterator it = objectsBySerialNumber.find(change.serialNumber);
+
+      if(it != objectsBySerialNumber.end())
+      {
+         if(isWallType(it->second->getObjectTypeNumber()))
+            database->getWallSegmentManager()->deleteSegments(change.serialNumber);
+
+         database->removeFromDatabase(it->second, true);
+      }
+
+      if(target)
+         addedObjects.push_back(target->clone());     // Clone keeps the serial number
+   }
+
+   if(!database)
+      return;
+
+   database->addToDatabase(addedObjects);
+
+   for(S32 i = 0; i < addedObjects.size(); i++)
+   {
+      BfObject *obj = static_cast<BfObject *>(addedObjects[i]);
+
+      if(isWallType(obj->getObjectTypeNumber()))
+      {
+         database->getWallSegmentManager()->computeWallSegmentIntersections(database, obj);
+         database->getWallSegmentManager()->setSelected(obj->getSerialNumber(), obj->isSelected());
+      }
+   }
+}
+
+
+void EditorUndoJournal::restoreState(GridDatabase *database, U32 index)
+{
+   TNLAssert(mHaveCurrentState, "Nothing to restore!");
+
+   while(mCurrentStateIndex > index)
+   {
+      applyStep(getStep(mCurrentStateIndex - 1), false, database);
+      mCurrentStateIndex--;
+   }
+
+   while(mCurrentStateIndex < index)
+   {
+      applyStep(getStep(mCurrentStateIndex), true, database);
+      mCurrentStateIndex++;
+   }
+}
+
+
+U32 EditorUndoJournal::getChangeCount() const
+{
+   U32 count = 0;
+
+   for(S32 i = 0; i < mSteps.size(); i++)
+      count += mSteps[i].size();
+
+   return count;
+}
+
+
+};
@@ -0,0 +1,81 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _EDITOR_UNDO_JOURNAL_H_
+#define _EDITOR_UNDO_JOURNAL_H_
+
+#include "tnlVector.h"
+#include "tnlTypes.h"
+
+#include <map>
+#include <memory>
+#include <string>
+
+using namespace TNL;
+using namespace std;
+
+namespace Zap
+{
+
+class BfObject;
+class GridDatabase;
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Undo history for the editor.  Rather than copying the whole level every time the user does something, we keep one copy of
+// the level as it was at the most recent undo state, and for each step between states, a list of only the objects that were
+// added, removed, or modified.  States are numbered the same way the editor numbers its undo levels; the journal holds the
+// steps between the most recent maxStates of them.
+class EditorUndoJournal
+{
+private:
+   // One object's part in a step: before is NULL if the object was added, after is NULL if it was removed
+   struct Change
+   {
+      S32 serialNumber;
+      shared_ptr<BfObject> before;
+      shared_ptr<BfObject> after;
+   };
+
+   typedef Vector<Change> Step;
+
+   // Our copy of an object as it was at the current state, plus the levelcode we use to tell whether it has changed
+   struct Snapshot
+   {
+      shared_ptr<BfObject> object;
+      string fingerprint;
+   };
+
+   typedef map<S32, Snapshot> SnapshotMap;
+
+   Vector<Step> mSteps;          // Step i takes state i to state i + 1, stored at i % maxStates
+   SnapshotMap mCurrentState;    // By serial number
+   U32 mCurrentStateIndex;       // Which state mCurrentState represents
+   bool mHaveCurrentState;
+
+   Step &getStep(U32 index);
+   void captureCurrentState(GridDatabase *database);
+   void applyStep(const Step &step, bool forward, GridDatabase *database);
+
+public:
+   explicit EditorUndoJournal(U32 maxStates);   // Constructor
+   virtual ~EditorUndoJournal();                // Destructor
+
+   void clear();
+
+   // Record the contents of database as state index; oldestIndex is the oldest state still in the editor's history
+   void saveState(GridDatabase *database, U32 index, U32 oldestIndex);
+
+   // Bring database back to state index, which must have been saved and not since overwritten
+   void restoreState(GridDatabase *database, U32 index);
+
+   U32 getChangeCount() const;   // Number of object copies held by all steps, for testing
+};
+
+
+};
+
+#endif
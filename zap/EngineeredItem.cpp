@@ -14,6 +14,7 @@
 #include "projectile.h"
 
 #include "ServerGame.h"
+#include "TurretTargeting.h"
 
 #include "Colors.h"
 #include "stringUtils.h"
@@ -2184,6 +2185,46 @@ void Turret::unpackUpdate(GhostConnection *connection, BitStream *stream)
 }
 
 
+// Where our shots come from
+Point Turret::getAimPos() const
+{
+   return getPos() + mAnchorNormal * TURRET_OFFSET;
+}
+
+
+Rect Turret::getPerceptionRect() const
+{
+   Point aimPos = getAimPos();
+   Point cross(mAnchorNormal.y, -mAnchorNormal.x);
+
+   Rect queryRect(aimPos, aimPos);
+   queryRect.unionPoint(aimPos + cross * TurretPerceptionDistance);
+   queryRect.unionPoint(aimPos - cross * TurretPerceptionDistance);
+   queryRect.unionPoint(aimPos + mAnchorNormal * TurretPerceptionDistance);
+
+   return queryRect;
+}
+
+
+// Something a turret could shoot at, if nothing is in the way
+struct TurretCandidate
+{
+   BfObject *target;
+   Point delta;      // From our aim position to where we'd need to shoot to hit target
+   F32 dist;
+   S32 order;        // Position in the list of potential targets, to break ties the same way every time
+};
+
+
+static bool closestCandidateFirst(const TurretCandidate &a, const TurretCandidate &b)
+{
+   if(a.dist != b.dist)
+      return a.dist < b.dist;
+
+   return a.order < b.order;
+}
+
+
 // Choose target, aim, and, if possible, fire
 void Turret::idle(IdleCallPath path)
 {
@@ -2200,21 +2241,16 @@ void Turret::idle(IdleCallPath path)
    mFireTimer.update(mCurrentMove.time);
 
    // Choose best target:
-   Point aimPos = getPos() + mAnchorNormal * TURRET_OFFSET;
-   Point cross(mAnchorNormal.y, -mAnchorNormal.x);
+   Point aimPos = getAimPos();
 
-   Rect queryRect(aimPos, aimPos);
-   queryRect.unionPoint(aimPos + cross * TurretPerceptionDistance);
-   queryRect.unionPoint(aimPos - cross * TurretPerceptionDistance);
-   queryRect.unionPoint(aimPos + mAnchorNormal * TurretPerceptionDistance);
+   // Turrets near one another share a single search for potential targets
    fillVector.clear();
-   findObjects((TestFunc)isTurretTargetType, fillVector, queryRect);    // Get all potential targets
+   static_cast<ServerGame *>(getGame())->getTurretTargeting()->findPotentialTargets(this, fillVector);
 
    WeaponInfo weaponInfo = WeaponInfo::getWeaponInfo(mWeaponFireType);
 
-   BfObject *bestTarget = NULL;
-   F32 bestRange = F32_MAX;
-   Point bestDelta;
+   static Vector<TurretCandidate> candidates;
+   candidates.clear();
 
    Point delta;
    for(S32 i = 0; i < fillVector.size(); i++)
@@ -2259,7 +2295,29 @@ void Turret::idle(IdleCallPath path)
       if(angleCheck.dot(mAnchorNormal) <= -0.1f)
          continue;
 
+      TurretCandidate candidate;
+      candidate.target = potential;
+      candidate.delta = delta;
+      candidate.dist = delta.len();
+      candidate.order = candidates.size();
+
+      candidates.push_back(candidate);
+   }
+
+   // The line-of-sight checks are the expensive part, so try the closest targets first; the first one we can see and
+   // shoot without hitting a friend is the best one, and there's no need to look at the rest
+   candidates.sort(closestCandidateFirst);
+
+   BfObject *bestTarget = NULL;
+   Point bestDelta;
+
+   for(S32 i = 0; i < candidates.size(); i++)
+   {
+      BfObject *potential = candidates[i].target;
+      delta = candidates[i].delta;
+
       // See if we can see it...
+      F32 t;
       Point n;
       if(findObjectLOS((TestFunc)isWallType, ActualState, aimPos, potential->getPos(), t, n))
          continue;
@@ -2276,14 +2334,9 @@ void Turret::idle(IdleCallPath path)
         (hitObject->getPos() - aimPos).lenSquared() < delta.lenSquared())         
          continue;
 
-      F32 dist = delta.len();
-
-      if(dist < bestRange)
-      {
-         bestDelta  = delta;
-         bestRange  = dist;
-         bestTarget = potential;
-      }
+      bestDelta  = delta;
+      bestTarget = potential;
+      break;
    }
 
    if(!bestTarget)      // No target, nothing to do
@@ -345,6 +345,9 @@ public:
 
    F32 getEditorRadius(F32 currentScale);
 
+   Point getAimPos() const;               // Where our shots come from
+   Rect getPerceptionRect() const;        // Area we look for targets in
+
    void render();
    void idle(IdleCallPath path);
    void onAddedToGame(Game *theGame);
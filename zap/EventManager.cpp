@@ -17,6 +17,7 @@
 #endif
 
 #include <math.h>
+#include <set>
 
 
 #define hypot _hypot    // Kill some warnings
@@ -28,14 +29,29 @@ namespace Zap
 struct Subscription {
    LuaScriptRunner *subscriber;
    ScriptContext context;
+   bool batched;              // True if subscriber receives this event via onEvents() at the end of the tick
 };
 
 
+// An event waiting to be delivered to onEvents() handlers.  We hold SafePtrs because objects
+// can be deleted between the time the event is fired and the end of the tick.
+struct BatchedEvent {
+   SafePtr<BfObject> objects[3];
+};
+
+// Identifies a coalesced event by the serial numbers of its objects; unlike pointers, these are never reused
+typedef pair<S32, pair<S32, S32> > BatchedEventKey;
+
+static const char *BATCHED_EVENT_HANDLER = "onEvents";
+
+
 // Statics:
 bool EventManager::anyPending = false; 
 static Vector<Subscription>      subscriptions         [EventManager::EventTypes];
 static Vector<Subscription>      pendingSubscriptions  [EventManager::EventTypes];
 static Vector<LuaScriptRunner *> pendingUnsubscriptions[EventManager::EventTypes];
+static Vector<BatchedEvent>      batchedEvents         [EventManager::EventTypes];
+static set<BatchedEventKey>      coalescedEventKeys    [EventManager::EventTypes];
 
 bool EventManager::mConstructed = false;  // Prevent duplicate instantiation
 
@@ -43,13 +59,14 @@ bool EventManager::mConstructed = false;  // Prevent duplicate instantiation
 struct EventDef {
    const char *name;
    const char *function;
+   EventManager::BatchMode batchMode;
 };
 
 
 static const EventDef eventDefs[] = {
    // The following expands to a series of lines like this, based on values in EVENT_TABLE
-   //   { "Tick",  "onTick"  },
-#define EVENT(a, b, c, d) { b, c },
+   //   { "Tick",  "onTick", EventManager::Unbatched },
+#define EVENT(a, b, c, d, e) { b, c, EventManager::e },
    EVENT_TABLE
 #undef EVENT
 };
@@ -111,6 +128,14 @@ void EventManager::subscribe(LuaScriptRunner *subscriber, EventType eventType, S
 
    // Make sure the script has the proper event listener
    bool ok = LuaScriptRunner::loadFunction(L, subscriber->getScriptId(), eventDefs[eventType].function);     // -- function
+   bool batched = false;
+
+   // No specific listener -- if this event can be batched, the script may be handling it with onEvents() instead
+   if(!ok && eventDefs[eventType].batchMode != Unbatched)
+   {
+      ok = LuaScriptRunner::loadFunction(L, subscriber->getScriptId(), BATCHED_EVENT_HANDLER);               // -- function
+      batched = ok;
+   }
 
    if(!ok)
    {
@@ -127,6 +152,7 @@ void EventManager::subscribe(LuaScriptRunner *subscriber, EventType eventType, S
    Subscription s;
    s.subscriber = subscriber;
    s.context = context;
+   s.batched = batched;
 
    pendingSubscriptions[eventType].push_back(s);
    anyPending = true;
@@ -250,12 +276,17 @@ void EventManager::fireEvent(EventType eventType)
    if(suppressEvents(eventType))   
       return;
 
+   queueBatchedEvent(eventType);
+
    lua_State *L = LuaScriptRunner::getL();
 
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      if(subscriptions[eventType][i].batched)    // Will be delivered with fireBatchedEvents()
+         continue;
+
       bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 0, subscriptions[eventType][i].context);
          
       // If an error occurred, the subscriber is gone; subscriptions[eventType].size() is now smaller, and the
@@ -306,12 +337,17 @@ void EventManager::fireEvent(EventType eventType, CoreItem *core)
    if(suppressEvents(eventType))
       return;
 
+   queueBatchedEvent(eventType, core);
+
    lua_State *L = LuaScriptRunner::getL();
 
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      if(subscriptions[eventType][i].batched)    // Will be delivered with fireBatchedEvents()
+         continue;
+
       core->push(L);                // -- core
       bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 1, subscriptions[eventType][i].context);
          
@@ -333,12 +369,17 @@ void EventManager::fireEvent(EventType eventType, Ship *ship)
    if(suppressEvents(eventType))   
       return;
 
+   queueBatchedEvent(eventType, ship);
+
    lua_State *L = LuaScriptRunner::getL();
 
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      if(subscriptions[eventType][i].batched)    // Will be delivered with fireBatchedEvents()
+         continue;
+
       ship->push(L);                // -- ship
       bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 1, subscriptions[eventType][i].context);
          
@@ -360,12 +401,17 @@ void EventManager::fireEvent(EventType eventType, Ship *ship, BfObject *damaging
    if(suppressEvents(eventType))
       return;
 
+   queueBatchedEvent(eventType, ship, damagingObject, shooter);
+
    lua_State *L = LuaScriptRunner::getL();
 
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      if(subscriptions[eventType][i].batched)    // Will be delivered with fireBatchedEvents()
+         continue;
+
       ship->push(L);                // -- ship
 
       if(damagingObject)
@@ -520,12 +566,17 @@ void EventManager::fireEvent(EventType eventType, Ship *ship, Zone *zone)
    if(suppressEvents(eventType))   
       return;
 
+   queueBatchedEvent(eventType, ship, zone);
+
    lua_State *L = LuaScriptRunner::getL();
 
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      if(subscriptions[eventType][i].batched)    // Will be delivered with fireBatchedEvents()
+         continue;
+
       // Passing ship, zone, zoneType, zoneId
       ship->push(L);                                     // -- ship
       zone->push(L);                                     // -- ship, zone   
@@ -552,12 +603,17 @@ void EventManager::fireEvent(EventType eventType, MoveObject *object, Zone *zone
    if(suppressEvents(eventType))   
       return;
 
+   queueBatchedEvent(eventType, object, zone);
+
    lua_State *L = LuaScriptRunner::getL();
 
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
    for(S32 i = 0; i < subscriptions[eventType].size(); i++)
    {
+      if(subscriptions[eventType][i].batched)    // Will be delivered with fireBatchedEvents()
+         continue;
+
       // Passing object, zone, zoneType, zoneId
       object->push(L);                                   // -- object
       zone->push(L);                                     // -- object, zone   
@@ -621,6 +677,197 @@ bool EventManager::fire(lua_State *L, LuaScriptRunner *scriptRunner, const char
 }
 
 
+static bool hasBatchedSubscribers(EventManager::EventType eventType)
+{
+   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+      if(subscriptions[eventType][i].batched)
+         return true;
+
+   return false;
+}
+
+
+static S32 getSerialNumberOrNone(BfObject *obj)
+{
+   return obj ? obj->getSerialNumber() : -1;
+}
+
+
+// Save event for delivery to onEvents() handlers at the end of the tick.  Coalesced events that have already
+// been queued this tick are dropped.
+void EventManager::queueBatchedEvent(EventType eventType, BfObject *obj1, BfObject *obj2, BfObject *obj3)
+{
+   if(eventDefs[eventType].batchMode == Unbatched || !hasBatchedSubscribers(eventType))
+      return;
+
+   if(eventDefs[eventType].batchMode == Coalesced)
+   {
+      BatchedEventKey key(getSerialNumberOrNone(obj1),
+                          pair<S32, S32>(getSerialNumberOrNone(obj2), getSerialNumberOrNone(obj3)));
+
+      if(!coalescedEventKeys[eventType].insert(key).second)    // Already queued
+         return;
+   }
+
+   BatchedEvent event;
+   event.objects[0] = obj1;
+   event.objects[1] = obj2;
+   event.objects[2] = obj3;
+
+   batchedEvents[eventType].push_back(event);
+}
+
+
+static void pushObjectOrNil(lua_State *L, BfObject *obj)
+{
+   if(obj)
+      obj->push(L);
+   else
+      lua_pushnil(L);
+}
+
+
+// Build the table of queued events of eventType, with one array of handler args per event, and push it onto the
+// stack.  Events whose primary objects have since been deleted are skipped.  Returns false, leaving the stack
+// unchanged, if there is nothing left to deliver.
+bool EventManager::pushBatchedEvents(lua_State *L, EventType eventType)
+{
+   Vector<BatchedEvent> &events = batchedEvents[eventType];
+
+   lua_createtable(L, events.size(), 0);                       // -- events
+   S32 count = 0;
+
+   for(S32 i = 0; i < events.size(); i++)
+   {
+      BfObject *obj1 = events[i].objects[0].getPointer();
+      BfObject *obj2 = events[i].objects[1].getPointer();
+      BfObject *obj3 = events[i].objects[2].getPointer();
+
+      switch(eventType)
+      {
+         case NexusOpenedEvent:
+         case NexusClosedEvent:
+            lua_newtable(L);                                   // -- events, args
+            break;
+
+         case ShipSpawnedEvent:
+         case CoreDestroyedEvent:
+            if(!obj1)
+               continue;
+
+            lua_createtable(L, 1, 0);                          // -- events, args
+            obj1->push(L);                                     // -- events, args, obj
+            lua_rawseti(L, -2, 1);                             // -- events, args
+            break;
+
+         case ShipKilledEvent:
+            if(!obj1)
+               continue;
+
+            lua_createtable(L, 3, 0);                          // -- events, args
+            obj1->push(L);                                     // -- events, args, ship
+            lua_rawseti(L, -2, 1);                             // -- events, args
+            pushObjectOrNil(L, obj2);                          // -- events, args, damagingObject
+            lua_rawseti(L, -2, 2);                             // -- events, args
+            pushObjectOrNil(L, obj3);                          // -- events, args, shooter
+            lua_rawseti(L, -2, 3);                             // -- events, args
+            break;
+
+         case ShipEnteredZoneEvent:
+         case ShipLeftZoneEvent:
+         case ObjectEnteredZoneEvent:
+         case ObjectLeftZoneEvent:
+            if(!obj1 || !obj2)
+               continue;
+
+            // Same args as the unbatched handlers: object, zone, zoneType, zoneId
+            lua_createtable(L, 4, 0);                          // -- events, args
+            obj1->push(L);                                     // -- events, args, object
+            lua_rawseti(L, -2, 1);                             // -- events, args
+            obj2->push(L);                                     // -- events, args, zone
+            lua_rawseti(L, -2, 2);                             // -- events, args
+            lua_pushinteger(L, obj2->getObjectTypeNumber());   // -- events, args, zone->objTypeNumber
+            lua_rawseti(L, -2, 3);                             // -- events, args
+            lua_pushinteger(L, obj2->getUserAssignedId());     // -- events, args, zone->id
+            lua_rawseti(L, -2, 4);                             // -- events, args
+            break;
+
+         default:
+            TNLAssert(false, "Event type cannot be batched!");
+            continue;
+      }
+
+      count++;
+      lua_rawseti(L, -2, count);                               // -- events
+   }
+
+   if(count == 0)
+   {
+      lua_pop(L, 1);                                           // -- <<empty stack>>
+      return false;
+   }
+
+   return true;
+}
+
+
+// Deliver everything queued with queueBatchedEvent() this tick, making a single call to each subscriber's onEvents()
+// handler per event type.  All subscribers get the same table, so the cost of crossing into Lua no longer depends
+// on how many events were fired.
+void EventManager::fireBatchedEvents()
+{
+   for(S32 i = 0; i < EventTypes; i++)
+   {
+      if(batchedEvents[i].size() == 0)
+         continue;
+
+      EventType eventType = (EventType)i;
+
+      if(suppressEvents(eventType))
+      {
+         batchedEvents[i].clear();
+         coalescedEventKeys[i].clear();
+         continue;
+      }
+
+      lua_State *L = LuaScriptRunner::getL();
+
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
+      bool haveEvents = pushBatchedEvents(L, eventType);     // -- events
+
+      // Clear the queue before calling any handlers, so events they trigger will be delivered next tick
+      batchedEvents[i].clear();
+      coalescedEventKeys[i].clear();
+
+      if(!haveEvents)
+         continue;
+
+      S32 ref = luaL_ref(L, LUA_REGISTRYINDEX);                // -- <<empty stack>>
+
+      for(S32 j = 0; j < subscriptions[i].size(); j++)
+      {
+         if(!subscriptions[i][j].batched)
+            continue;
+
+         lua_pushinteger(L, eventType);                        // -- eventType
+         lua_rawgeti(L, LUA_REGISTRYINDEX, ref);               // -- eventType, events
+
+         bool error = fire(L, subscriptions[i][j].subscriber, BATCHED_EVENT_HANDLER, 2, subscriptions[i][j].context);
+
+         // If an error occurred, the subscriber is gone; see the comments in fireEvent() above
+         if(error)
+         {
+            clearStack(L);
+            j--;
+         }
+      }
+
+      luaL_unref(L, LUA_REGISTRYINDEX, ref);
+   }
+}
+
+
 //void EventManager::handleEventFiringError(lua_State *L, const Subscription &subscriber, EventType eventType, const char *errorMsg)
 //{
 //   if(subscriber.context == RobotContext)
@@ -17,6 +17,7 @@ using namespace TNL;
 namespace Zap
 {
 
+class BfObject;
 class CoreItem;
 class LuaPlayerInfo;
 class LuaScriptRunner;
@@ -37,39 +38,55 @@ class EventManager
  *
  * See the \e subscribe methods for \link Robot bots\endlink and \link LevelGenerator levelgens\endlink, and the 
  * @ref events "Subscribing to Events" page.  
+ *
+ * Some high-frequency events can also be received in batches.  If a script subscribes to one of these events without
+ * implementing its specific handler, but does implement `onEvents(Event eventType, table events)`, then all events of that
+ * type fired during a game tick are delivered together at the end of the tick.  `events` is an array with one entry per
+ * event, each entry being an array of the arguments the specific handler would have received.  Identical events (same
+ * type, same arguments) fired more than once in a tick are delivered only once for ShipSpawned, CoreDestroyed, NexusOpened,
+ * and NexusClosed.  Zone entered/left events are all delivered, in order, since a ship can leave and re-enter a zone in
+ * the same tick.  Batching is available for ShipSpawned, ShipKilled, NexusOpened, NexusClosed, ShipEnteredZone,
+ * ShipLeftZone, ObjectEnteredZone, ObjectLeftZone, and CoreDestroyed.
  */
 
 // See http://stackoverflow.com/questions/6635851/real-world-use-of-x-macros
-//          Enum                 Name                 Lua event handler      Lua event handler signature (documentation only)
+//          Enum                 Name                 Lua event handler      Lua event handler signature (documentation only)                                                      Batching
 #define EVENT_TABLE \
-   EVENT(TickEvent,              "Tick",              "onTick",              "Use with event handler: `onTick()`"                                                               ) \
-   EVENT(ShipSpawnedEvent,       "ShipSpawned",       "onShipSpawned",       "Use with event handler: `onShipSpawned(Ship ship)`"                                               ) \
-   EVENT(ShipKilledEvent,        "ShipKilled",        "onShipKilled",        "Use with event handler: `onShipKilled(Ship ship, BfObject damagingObject, BfObject shooter)`"     ) \
-   EVENT(PlayerJoinedEvent,      "PlayerJoined",      "onPlayerJoined",      "Use with event handler: `onPlayerJoined(PlayerInfo player)`"                                      ) \
-   EVENT(PlayerLeftEvent,        "PlayerLeft",        "onPlayerLeft",        "Use with event handler: `onPlayerLeft(PlayerInfo player)`"                                        ) \
-   EVENT(PlayerTeamChangedEvent, "PlayerTeamChanged", "onPlayerTeamChanged", "Use with event handler: `onPlayerTeamChanged(PlayerInfo player)`"                                 ) \
-   EVENT(MsgReceivedEvent,       "MsgReceived",       "onMsgReceived",       "Use with event handler: `onMsgReceived(string message, PlayerInfo sender, bool messageIsGlobal)`" ) \
-   EVENT(DataReceivedEvent,      "DataReceived",      "onDataReceived",      "Use with event handler: `onDataReceived(Any data)`"                                               ) \
-   EVENT(NexusOpenedEvent,       "NexusOpened",       "onNexusOpened",       "Use with event handler: `onNexusOpened()`"                                                        ) \
-   EVENT(NexusClosedEvent,       "NexusClosed",       "onNexusClosed",       "Use with event handler: `onNexusClosed()`"                                                        ) \
-   EVENT(ShipEnteredZoneEvent,   "ShipEnteredZone",   "onShipEnteredZone",   "Use with event handler: `onShipEnteredZone(Ship ship, Zone zone)`"                                ) \
-   EVENT(ShipLeftZoneEvent,      "ShipLeftZone",      "onShipLeftZone",      "Use with event handler: `onShipLeftZone(Ship ship, Zone zone)`"                                   ) \
-   EVENT(ObjectEnteredZoneEvent, "ObjectEnteredZone", "onObjectEnteredZone", "Use with event handler: `onObjectEnteredZone(MoveObject object, Zone zone)`"                      ) \
-   EVENT(ObjectLeftZoneEvent,    "ObjectLeftZone",    "onObjectLeftZone",    "Use with event handler: `onObjectLeftZone(MoveObject object, Zone zone)`"                         ) \
-   EVENT(ScoreChangedEvent,      "ScoreChanged",      "onScoreChanged",      "Use with event handler: `onScoreChanged(num scoreChange, num teamIndex, PlayerInfo player)`"      ) \
-   EVENT(GameOverEvent,          "GameOver",          "onGameOver",          "Use with event handler: `onGameOver()`"                                                           ) \
-   EVENT(CoreDestroyedEvent,     "CoreDestroyed",     "onCoreDestroyed",     "Use with event handler: `onCoreDestroyed(CoreItem core)`"                                         ) \
+   EVENT(TickEvent,              "Tick",              "onTick",              "Use with event handler: `onTick()`",                                                                  Unbatched ) \
+   EVENT(ShipSpawnedEvent,       "ShipSpawned",       "onShipSpawned",       "Use with event handler: `onShipSpawned(Ship ship)`",                                                  Coalesced ) \
+   EVENT(ShipKilledEvent,        "ShipKilled",        "onShipKilled",        "Use with event handler: `onShipKilled(Ship ship, BfObject damagingObject, BfObject shooter)`",        Batched   ) \
+   EVENT(PlayerJoinedEvent,      "PlayerJoined",      "onPlayerJoined",      "Use with event handler: `onPlayerJoined(PlayerInfo player)`",                                         Unbatched ) \
+   EVENT(PlayerLeftEvent,        "PlayerLeft",        "onPlayerLeft",        "Use with event handler: `onPlayerLeft(PlayerInfo player)`",                                           Unbatched ) \
+   EVENT(PlayerTeamChangedEvent, "PlayerTeamChanged", "onPlayerTeamChanged", "Use with event handler: `onPlayerTeamChanged(PlayerInfo player)`",                                    Unbatched ) \
+   EVENT(MsgReceivedEvent,       "MsgReceived",       "onMsgReceived",       "Use with event handler: `onMsgReceived(string message, PlayerInfo sender, bool messageIsGlobal)`",    Unbatched ) \
+   EVENT(DataReceivedEvent,      "DataReceived",      "onDataReceived",      "Use with event handler: `onDataReceived(Any data)`",                                                  Unbatched ) \
+   EVENT(NexusOpenedEvent,       "NexusOpened",       "onNexusOpened",       "Use with event handler: `onNexusOpened()`",                                                           Coalesced ) \
+   EVENT(NexusClosedEvent,       "NexusClosed",       "onNexusClosed",       "Use with event handler: `onNexusClosed()`",                                                           Coalesced ) \
+   EVENT(ShipEnteredZoneEvent,   "ShipEnteredZone",   "onShipEnteredZone",   "Use with event handler: `onShipEnteredZone(Ship ship, Zone zone)`",                                   Batched   ) \
+   EVENT(ShipLeftZoneEvent,      "ShipLeftZone",      "onShipLeftZone",      "Use with event handler: `onShipLeftZone(Ship ship, Zone zone)`",                                      Batched   ) \
+   EVENT(ObjectEnteredZoneEvent, "ObjectEnteredZone", "onObjectEnteredZone", "Use with event handler: `onObjectEnteredZone(MoveObject object, Zone zone)`",                         Batched   ) \
+   EVENT(ObjectLeftZoneEvent,    "ObjectLeftZone",    "onObjectLeftZone",    "Use with event handler: `onObjectLeftZone(MoveObject object, Zone zone)`",                            Batched   ) \
+   EVENT(ScoreChangedEvent,      "ScoreChanged",      "onScoreChanged",      "Use with event handler: `onScoreChanged(num scoreChange, num teamIndex, PlayerInfo player)`",         Unbatched ) \
+   EVENT(GameOverEvent,          "GameOver",          "onGameOver",          "Use with event handler: `onGameOver()`",                                                              Unbatched ) \
+   EVENT(CoreDestroyedEvent,     "CoreDestroyed",     "onCoreDestroyed",     "Use with event handler: `onCoreDestroyed(CoreItem core)`",                                            Coalesced ) \
 
 public:
 
 // Define an enum from the first values in EVENT_TABLE
 enum EventType {
-#define EVENT(a, b, c, d) a,
+#define EVENT(a, b, c, d, e) a,
     EVENT_TABLE
 #undef EVENT
     EventTypes
 };
 
+// How an event can be delivered to scripts implementing onEvents() rather than the event's own handler
+enum BatchMode {
+   Unbatched,     // Always delivered immediately
+   Batched,       // Can be queued and delivered in a per-tick batch
+   Coalesced,     // Batched, and identical events in the same tick are delivered only once
+};
+
 
 private:
    // Some helper functions
@@ -83,6 +100,10 @@ private:
 
    //void handleEventFiringError(lua_State *L, const Subscription &subscriber, EventType eventType, const char *errorMsg);
    bool fire(lua_State *L, LuaScriptRunner *scriptRunner, const char *function, S32 argCount, ScriptContext context);
+
+   // Queue an event for subscribers receiving it via onEvents(); returns immediately if there aren't any
+   void queueBatchedEvent(EventType eventType, BfObject *obj1 = NULL, BfObject *obj2 = NULL, BfObject *obj3 = NULL);
+   bool pushBatchedEvents(lua_State *L, EventType eventType);
       
    bool mIsPaused;
    S32 mStepCount;           // If running for a certain number of steps, this will be > 0, while mIsPaused will be true
@@ -109,6 +130,7 @@ public:
     // Used when bot dies, and we know there won't be subscription conflicts
    void unsubscribeImmediate(LuaScriptRunner *subscriber, EventType eventType); 
    void update();                                                      // Act on events sitting in the pending lists
+   void fireBatchedEvents();                                           // Deliver events queued this tick to onEvents() handlers
 
    // We'll have several different signatures for this one...
    void fireEvent(EventType eventType);
@@ -0,0 +1,305 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "ExplosionResolver.h"
+
+#include "game.h"
+#include "gridDB.h"
+#include "ClientInfo.h"
+#include "statistics.h"
+#include "GeomUtils.h"
+#include "MathUtils.h"     // For sq()
+
+namespace Zap
+{
+
+// Constructor
+ExplosionResolver::ExplosionResolver(Game *game)
+{
+   mGame = game;
+   mBatching = false;
+
+   mExplosionCount = 0;
+   mLosTestCount = 0;
+}
+
+
+// Destructor
+ExplosionResolver::~ExplosionResolver()
+{
+   // Do nothing
+}
+
+
+void ExplosionResolver::beginBatch()
+{
+   mBatching = true;
+}
+
+
+// Resolve everything that exploded since beginBatch(), including anything set off along the way
+void ExplosionResolver::endBatch()
+{
+   resolvePending();
+   mBatching = false;
+}
+
+
+bool ExplosionResolver::isBatching() const
+{
+   return mBatching;
+}
+
+
+void ExplosionResolver::addExplosion(const Explosion &explosion)
+{
+   mPending.push_back(explosion);
+
+   // Explosions set off while we're resolving others will be picked up by the loop in resolvePending()
+   if(!mBatching)
+   {
+      mBatching = true;
+      resolvePending();
+      mBatching = false;
+   }
+}
+
+
+static Rect getBlastRect(const ExplosionResolver::Explosion &explosion)
+{
+   Rect rect(explosion.pos, explosion.pos);
+   rect.expand(Point(explosion.outerRad, explosion.outerRad));
+
+   return rect;
+}
+
+
+// Returns the root of the group i belongs to, flattening the path as we go
+static S32 findGroup(Vector<S32> &parents, S32 i)
+{
+   while(parents[i] != i)
+   {
+      parents[i] = parents[parents[i]];
+      i = parents[i];
+   }
+
+   return i;
+}
+
+
+void ExplosionResolver::resolvePending()
+{
+   Vector<Explosion> explosions;
+   Vector<Victim> victims;
+
+   // Each round may set off more explosions, which will be handled in the next
+   while(mPending.size() > 0)
+   {
+      explosions = mPending;
+      mPending.clear();
+
+      mExplosionCount += explosions.size();
+
+      // Group explosions whose blast areas overlap; there are rarely more than a handful per tick
+      Vector<S32> parents;
+      parents.resize(explosions.size());
+      for(S32 i = 0; i < explosions.size(); i++)
+         parents[i] = i;
+
+      for(S32 i = 0; i < explosions.size(); i++)
+      {
+         Rect rect = getBlastRect(explosions[i]);
+
+         for(S32 j = i + 1; j < explosions.size(); j++)
+            if(explosions[i].database == explosions[j].database && rect.intersectsOrBorders(getBlastRect(explosions[j])))
+            {
+               // Lowest index becomes the root, so each group is found when we reach its first member below
+               S32 rootI = findGroup(parents, i);
+               S32 rootJ = findGroup(parents, j);
+               parents[max(rootI, rootJ)] = min(rootI, rootJ);
+            }
+      }
+
+      // Figure out who gets hit by what before damaging anyone
+      victims.clear();
+
+      Vector<S32> group;
+      for(S32 i = 0; i < explosions.size(); i++)
+      {
+         if(findGroup(parents, i) != i)
+            continue;
+
+         group.clear();
+         for(S32 j = i; j < explosions.size(); j++)
+            if(findGroup(parents, j) == i)
+               group.push_back(j);
+
+         findVictims(explosions, group, victims);
+      }
+
+      // Now blow them up, in explosion order
+      Vector<S32> shipsHit;
+      shipsHit.resize(explosions.size());
+      for(S32 i = 0; i < shipsHit.size(); i++)
+         shipsHit[i] = 0;
+
+      for(S32 i = 0; i < victims.size(); i++)
+      {
+         BfObject *object = victims[i].object.getPointer();
+
+         if(!object)    // Something earlier in the pass got rid of it
+            continue;
+
+         if(isShipType(object->getObjectTypeNumber()))
+            shipsHit[victims[i].explosion]++;
+
+         object->damageObject(&victims[i].info);
+      }
+
+      for(S32 i = 0; i < explosions.size(); i++)
+      {
+         if(explosions[i].weaponType == WeaponNone || shipsHit[i] == 0)
+            continue;
+
+         ClientInfo *owner = explosions[i].info.damagingObject->getOwner();
+
+         if(owner)
+            for(S32 j = 0; j < shipsHit[i]; j++)
+               owner->getStatistics()->countHit(explosions[i].weaponType);
+      }
+   }
+}
+
+
+// Find objects hit by each explosion in a group of nearby explosions, and the damage each should take.  The walls
+// around the group are looked up once and shared by everyone in it.
+void ExplosionResolver::findVictims(const Vector<Explosion> &explosions, const Vector<S32> &group, Vector<Victim> &victims)
+{
+   GridDatabase *database = explosions[group[0]].database;
+
+   Rect groupRect = getBlastRect(explosions[group[0]]);
+   for(S32 i = 1; i < group.size(); i++)
+      groupRect.unionRect(getBlastRect(explosions[group[i]]));
+
+   static Vector<DatabaseObject *> walls;
+   walls.clear();
+
+   static Vector<DatabaseObject *> candidates;
+   candidates.clear();
+
+   database->findObjects((TestFunc)isWallType, candidates, groupRect);
+
+   // No damage through walls
+   for(S32 i = 0; i < candidates.size(); i++)
+      if(candidates[i]->isCollisionEnabled())
+         walls.push_back(candidates[i]);
+
+   for(S32 i = 0; i < group.size(); i++)
+   {
+      const Explosion &explosion = explosions[group[i]];
+      const DamageInfo &info = explosion.info;
+
+      candidates.clear();
+      database->findObjects(explosion.objectTypeTest, candidates, getBlastRect(explosion));
+
+      for(S32 j = 0; j < candidates.size(); j++)
+      {
+         BfObject *foundObject = static_cast<BfObject *>(candidates[j]);
+
+         // No object damages itself
+         if(foundObject == info.damagingObject)
+            continue;
+
+         // Check the actual distance against our outer radius.  Recall that we got a list of potential
+         // collision objects based on a square area, but actual collisions will be based on true distance.
+         Point objPos = foundObject->getPos();
+         Point delta = objPos - explosion.pos;
+
+         if(delta.lenSquared() > sq(explosion.outerRad))
+            continue;
+
+         // Check if this pair of objects can damage one another
+         if(!mGame->objectCanDamageObject(info.damagingObject, foundObject))
+            continue;
+
+         // Do an LOS check against the walls we found above
+         Rect rayRect(explosion.pos, objPos);
+         bool blocked = false;
+
+         for(S32 k = 0; k < walls.size() && !blocked; k++)
+         {
+            if(!rayRect.intersectsOrBorders(walls[k]->getExtent()))
+               continue;
+
+            const Vector<Point> *poly = walls[k]->getCollisionPoly();
+
+            if(!poly || poly->size() == 0)
+               continue;
+
+            F32 t;
+            Point n;
+
+            mLosTestCount++;
+
+            blocked = polygonIntersectsSegmentDetailed(&poly->get(0), poly->size(), true, explosion.pos, objPos, t, n) &&
+                      t < 1;
+         }
+
+         if(blocked)
+            continue;
+
+         Victim victim;
+         victim.explosion = group[i];
+         victim.object = foundObject;
+         victim.info = info;
+
+         // No damage calculated on the client
+         if(!mGame->isServer())
+            victim.info.damageAmount = 0;
+
+         // Figure collision forces...
+         victim.info.impulseVector = delta;
+         victim.info.impulseVector.normalize();
+
+         victim.info.collisionPoint -= info.impulseVector;
+
+         // Figure interpolation based on distance
+         F32 dist = delta.len();
+         F32 t;
+         if(dist < explosion.innerRad)      // Inner radius gets full force of blast
+            t = 1.f;
+         else                               // But if we're further away, force is attenuated
+            t = 1.f - (dist - explosion.innerRad) / (explosion.outerRad - explosion.innerRad);
+
+         // Attenuate impulseVector and damageAmount
+         victim.info.impulseVector *= explosion.force * t;
+         victim.info.damageAmount  *= t;
+
+         // Adjust for self-damage
+         ClientInfo *damagerOwner = info.damagingObject->getOwner();
+         ClientInfo *victimOwner = foundObject->getOwner();
+
+         if(victimOwner && damagerOwner == victimOwner)
+            victim.info.damageAmount *= victim.info.damageSelfMultiplier;
+
+         victims.push_back(victim);
+      }
+   }
+}
+
+
+U32 ExplosionResolver::getExplosionCount() const
+{
+   return mExplosionCount;
+}
+
+
+U32 ExplosionResolver::getLosTestCount() const
+{
+   return mLosTestCount;
+}
+
+
+};
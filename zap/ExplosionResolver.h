@@ -0,0 +1,85 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _EXPLOSION_RESOLVER_H_
+#define _EXPLOSION_RESOLVER_H_
+
+#include "BfObject.h"      // For DamageInfo
+#include "WeaponInfo.h"
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+using namespace TNL;
+
+namespace Zap
+{
+
+class Game;
+class GridDatabase;
+
+// Applies area damage for explosions.  While a batch is open (the server opens one around each tick's object idle loop),
+// explosions are queued rather than handled on the spot, and resolved together when the batch ends:
+//
+//    - Explosions whose blast areas overlap are grouped, and each group fetches the walls around it once.  Every
+//      explosion in the group checks its line of sight to its victims against that shared list, and if there are no
+//      walls nearby at all, nobody has to check anything.
+//    - Victims for every explosion are worked out before any damage is done, then damage and impulses are applied in
+//      a single pass.
+//    - Things blown up by that damage (mines, other bursts) explode in a further round, until everything has settled.
+//
+// Outside of a batch, each explosion is resolved as soon as it is added.
+class ExplosionResolver
+{
+public:
+   struct Explosion
+   {
+      GridDatabase *database;
+      Point pos;
+      S32 innerRad;           // Objects within innerRad get the full force of the blast...
+      S32 outerRad;           // ...and those out to outerRad get an amount that falls off with distance
+      TestFunc objectTypeTest;
+      DamageInfo info;
+      F32 force;
+      WeaponType weaponType;  // If not WeaponNone, ships hit are credited to the owner of info.damagingObject
+   };
+
+private:
+   struct Victim
+   {
+      S32 explosion;
+      SafePtr<BfObject> object;
+      DamageInfo info;
+   };
+
+   Game *mGame;
+
+   Vector<Explosion> mPending;
+   bool mBatching;
+
+   U32 mExplosionCount;
+   U32 mLosTestCount;
+
+   void resolvePending();
+   void findVictims(const Vector<Explosion> &explosions, const Vector<S32> &group, Vector<Victim> &victims);
+
+public:
+   explicit ExplosionResolver(Game *game);   // Constructor
+   virtual ~ExplosionResolver();             // Destructor
+
+   void beginBatch();
+   void endBatch();
+   bool isBatching() const;
+
+   void addExplosion(const Explosion &explosion);
+
+   U32 getExplosionCount() const;            // Explosions resolved so far
+   U32 getLosTestCount() const;              // Line-of-sight checks that actually had to test a wall
+};
+
+
+};
+
+#endif
@@ -11,6 +11,7 @@
 #include "stringUtils.h"      // For itos
 #include "LuaWrapper.h"       // For printing Lua class hiearchy
 #include "LevelSource.h"
+#include "BinaryLevel.h"      // For convertLevelFile
 
 #include "tnlTypes.h"         // For TNL_OS_WIN32 def
 #include "tnlLog.h"           // For logprintf
@@ -134,6 +135,7 @@ DirectiveInfo directiveDefs[] = {
 { "sendres", FOUR_REQUIRED,  GET_RESOURCE,  5, GameSettings::sendRes,   "<server address> <admin password> <resource name> <LEVEL|LEVELGEN|BOT>", "Retrieve a resource from a remote server, with same requirements as -sendres.",                                                                                                                                                                "Usage: bitfighter sendres <server address> <admin password> <resource name> <LEVEL|LEVELGEN|BOT>" },
 
 // Other commands
+{ "convertlevel", TWO_REQUIRED, CONVERT_LEVEL, 6, GameSettings::convertLevel, "<input file> <output file>", "Convert a text level to the faster-loading binary format (use the .blevel extension), or a binary level back to text", "Usage: bitfighter -convertlevel <input file> <output file>" },
 { "rules",   NO_PARAMETERS,  SHOW_RULES,        6, GameSettings::showRules,      "",  "Print a list of \"rules of the game\" and other possibly useful data", "" },
 { "help",    NO_PARAMETERS,  HELP,              6, GameSettings::showHelp,       "",  "Display this message", "" },
 { "version", NO_PARAMETERS,  VERSION,           6, GameSettings::showVersion,    "",  "Print version information", "" },
@@ -1039,6 +1041,24 @@ void GameSettings::showRules(GameSettings *settings, const Vector<string> &words
 }
 
 
+////////////////////////////////////////
+////////////////////////////////////////
+// Convert levels with the -convertlevel option
+
+void GameSettings::convertLevel(GameSettings *settings, const Vector<string> &words)
+{
+   writeToConsole();
+
+   if(convertLevelFile(words[0], words[1]))
+   {
+      printf("Converted %s to %s\n", words[0].c_str(), words[1].c_str());
+      exitToOs(0);
+   }
+
+   exitToOs(1);
+}
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 // Print help message with -help
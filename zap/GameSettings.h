@@ -72,6 +72,7 @@ enum ParamId {
 
    SEND_RESOURCE,
    GET_RESOURCE,
+   CONVERT_LEVEL,
    SHOW_RULES,
    SHOW_LUA_CLASSES,
    HELP,
@@ -280,6 +281,7 @@ public:
 
    static void getRes(GameSettings *settings, const Vector<string> &words);
    static void sendRes(GameSettings *settings, const Vector<string> &words);
+   static void convertLevel(GameSettings *settings, const Vector<string> &words);
    static void showRules(GameSettings *settings, const Vector<string> &words);
    static void showHelp(GameSettings *settings, const Vector<string> &words);
    static void showVersion(GameSettings *settings, const Vector<string> &words);
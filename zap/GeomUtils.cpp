@@ -28,6 +28,7 @@
 #include "MathUtils.h"                    // For findLowestRootInInterval()
 #include "LuaModule.h"
 #include "LuaBase.h"
+#include "WorkerPool.h"
 
 
 #include "../recast/Recast.h"
@@ -42,6 +43,13 @@
 #include <math.h>
 #include <deque>
 
+// Use SSE2 to test four polygon edges at a time where we have it; it is part of the x86-64 baseline, so this covers
+// our desktop builds.  Everything else uses the plain versions, which are also exported for testing.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define BF_GEOM_SSE2
+#  include <emmintrin.h>
+#endif
+
 using namespace TNL;
 using namespace ClipperLib;
 
@@ -87,31 +95,141 @@ inline S32 isLeft(const Point &p1, const Point &p2, const Point &p )
     return S32( (p2.x - p1.x) * (p.y - p1.y) - (p.x -  p1.x) * (p2.y - p1.y) );
 }
 
+
+#ifdef BF_GEOM_SSE2
+
+// Helpers for processing polygon edges four at a time.  Point is just a pair of floats, so four consecutive vertices
+// can be fetched with two unaligned loads and then split into separate x and y registers.
+
+// Load vertices first .. first + 3
+static inline void loadVerts(const Point *verts, S32 first, __m128 &x, __m128 &y)
+{
+   __m128 a = _mm_loadu_ps(&verts[first].x);        // x0 y0 x1 y1
+   __m128 b = _mm_loadu_ps(&verts[first + 2].x);    // x2 y2 x3 y3
+
+   x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+   y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+
+// Load the vertex before each of vertices first .. first + 3, wrapping around to the end of the polygon
+static inline void loadPrevVerts(const Point *verts, S32 vertexCount, S32 first, __m128 &x, __m128 &y)
+{
+   if(first > 0)
+      loadVerts(verts, first - 1, x, y);
+   else
+   {
+      x = _mm_setr_ps(verts[vertexCount - 1].x, verts[0].x, verts[1].x, verts[2].x);
+      y = _mm_setr_ps(verts[vertexCount - 1].y, verts[0].y, verts[1].y, verts[2].y);
+   }
+}
+
+
+// Load the vertex after each of vertices first .. first + 3, wrapping around to the start of the polygon
+static inline void loadNextVerts(const Point *verts, S32 vertexCount, S32 first, __m128 &x, __m128 &y)
+{
+   if(first + 4 < vertexCount)
+      loadVerts(verts, first + 1, x, y);
+   else
+   {
+      S32 last = (first + 4) % vertexCount;
+      x = _mm_setr_ps(verts[first + 1].x, verts[first + 2].x, verts[first + 3].x, verts[last].x);
+      y = _mm_setr_ps(verts[first + 1].y, verts[first + 2].y, verts[first + 3].y, verts[last].y);
+   }
+}
+
+
+// Load four segments stored as A-B C-D E-F G-H, starting at vertex first
+static inline void loadSegmentPairs(const Point *verts, S32 first, __m128 &x1, __m128 &y1, __m128 &x2, __m128 &y2)
+{
+   __m128 xa, ya, xb, yb;
+   loadVerts(verts, first, xa, ya);
+   loadVerts(verts, first + 4, xb, yb);
+
+   x1 = _mm_shuffle_ps(xa, xb, _MM_SHUFFLE(2, 0, 2, 0));
+   y1 = _mm_shuffle_ps(ya, yb, _MM_SHUFFLE(2, 0, 2, 0));
+   x2 = _mm_shuffle_ps(xa, xb, _MM_SHUFFLE(3, 1, 3, 1));
+   y2 = _mm_shuffle_ps(ya, yb, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+#endif
+
+
+// Winding number contribution of the edge from v1 to v2
+static inline S32 windingNumberContribution(const Point &v1, const Point &v2, const Point &point)
+{
+   if (v1.y <= point.y)
+   {
+      if (v2.y  > point.y)                     // an upward crossing
+         if (isLeft(v1, v2, point) > 0)        // point left of edge
+            return 1;                          // have a valid up intersect
+   }
+   else
+   {
+      if (v2.y  <= point.y)                    // a downward crossing
+         if (isLeft(v1, v2, point) < 0)        // point right of edge
+            return -1;                         // have  a valid down intersect
+   }
+
+   return 0;
+}
+
+
 // Fast winding number test for finding if a point is in a polygon.  Adapted from:
 // http://geomalgorithms.com/a03-_inclusion.html#wn_PnPoly%28%29
 bool polygonContainsPoint(const Point *vertices, S32 vertexCount, const Point &point)
 {
    S32 counter = 0;    // Winding number counter
+   S32 i = 0;
 
-   // loop through all edges of the polygon
-   S32 nextIndex;
-   for (S32 i = 0; i < vertexCount; i++)
+#ifdef BF_GEOM_SSE2
+   const __m128 px = _mm_set1_ps(point.x);
+   const __m128 py = _mm_set1_ps(point.y);
+   const __m128i zero = _mm_setzero_si128();
+   __m128i counters = zero;
+
+   for(; i + 3 < vertexCount; i += 4)
    {
-      nextIndex = (i+1)%vertexCount;
-      if (vertices[i].y <= point.y)
-      {
-         if (vertices[nextIndex].y  > point.y)                        // an upward crossing
-            if (isLeft(vertices[i], vertices[nextIndex], point) > 0)  // point left of edge
-               ++counter;                                             // have a valid up intersect
-      }
-      else
-      {
-         if (vertices[nextIndex].y  <= point.y)                       // a downward crossing
-            if (isLeft(vertices[i], vertices[nextIndex], point) < 0)  // point right of edge
-               --counter;                                             // have  a valid down intersect
-      }
+      __m128 x1, y1, x2, y2;
+      loadVerts(vertices, i, x1, y1);
+      loadNextVerts(vertices, vertexCount, i, x2, y2);
+
+      // isLeft(), truncated to an int just like the scalar version
+      __m128i left = _mm_cvttps_epi32(_mm_sub_ps(_mm_mul_ps(_mm_sub_ps(x2, x1), _mm_sub_ps(py, y1)),
+                                                 _mm_mul_ps(_mm_sub_ps(px, x1), _mm_sub_ps(y2, y1))));
+
+      __m128 startsBelow = _mm_cmple_ps(y1, py);
+      __m128 up   = _mm_and_ps(startsBelow, _mm_and_ps(_mm_cmpgt_ps(y2, py),
+                                                       _mm_castsi128_ps(_mm_cmpgt_epi32(left, zero))));
+      __m128 down = _mm_andnot_ps(startsBelow, _mm_and_ps(_mm_cmple_ps(y2, py),
+                                                          _mm_castsi128_ps(_mm_cmplt_epi32(left, zero))));
+
+      // Masks are -1 in lanes where they are set
+      counters = _mm_sub_epi32(counters, _mm_castps_si128(up));
+      counters = _mm_add_epi32(counters, _mm_castps_si128(down));
    }
 
+   S32 lanes[4];
+   _mm_storeu_si128((__m128i *)lanes, counters);
+   counter = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+   // Remaining edges
+   for(; i < vertexCount; i++)
+      counter += windingNumberContribution(vertices[i], vertices[(i + 1) % vertexCount], point);
+
+   return counter != 0;   // Point is outside polygon only when counter is 0
+}
+
+
+bool polygonContainsPointScalar(const Point *vertices, S32 vertexCount, const Point &point)
+{
+   S32 counter = 0;    // Winding number counter
+
+   // loop through all edges of the polygon
+   for (S32 i = 0; i < vertexCount; i++)
+      counter += windingNumberContribution(vertices[i], vertices[(i + 1) % vertexCount], point);
+
    return counter != 0;   // Point is outside polygon only when counter is 0
 }
 
@@ -265,6 +383,49 @@ bool circleCircleIntersect(const Point &center1, F32 radius1, const Point &cente
 }
 
 
+// Find the point closest to center on the edge running from v1 toward v2.  Returns false if that point is beyond v2,
+// in which case it will be found when the next edge is examined.
+static inline bool closestPointOnEdge(const Point &v1, const Point &v2, const Point &center, Point &closest, F32 &distSq)
+{
+   // Get fraction where the closest point to this edge occurs
+   Point v1_v2 = v2 - v1;
+   Point v1_center = center - v1;
+   F32 fraction = v1_center.dot(v1_v2);
+   if (fraction < 0.0f)
+   {
+      // Closest point is v1
+      closest = v1;
+      distSq = v1_center.lenSquared();
+      return true;
+   }
+
+   F32 v1_v2_len_sq = v1_v2.lenSquared();
+   if (fraction <= v1_v2_len_sq)
+   {
+      // Closest point is on line segment
+      closest = v1 + v1_v2 * (fraction / v1_v2_len_sq);
+      distSq = (closest - center).lenSquared();
+      return true;
+   }
+
+   return false;
+}
+
+
+// Keep the closest point found so far that is within the circle, and (optionally) that we're moving towards
+static inline void checkCircleCandidate(const Point &closest, F32 distSq, const Point &center, const Point *ignoreVelocityEpsilon,
+                                        F32 &radiusSq, Point &outPoint, bool &collision)
+{
+   if (distSq <= radiusSq)
+      if(!ignoreVelocityEpsilon || ignoreVelocityEpsilon->dot(closest - center) > 0)
+      {
+         collision = true;
+         outPoint = closest;
+         radiusSq = distSq;
+      }
+}
+
+
 // Check if circle at inCenter with radius^2 = inRadiusSq intersects with a polygon.
 // Function returns true when it does and the intersection point is in outPoint
 // Works only for convex hulls.. maybe no longer true... may work for all polys now
@@ -277,51 +438,162 @@ bool polygonCircleIntersect(const Point *inVertices, int inNumVertices, const Po
       return true;
    }
 
+   // Loop through edges; edge i runs from vertex i to the vertex before it
+   bool collision = false;
+   Point closest;
+   F32 distSq;
+   S32 i = 0;
+
+#ifdef BF_GEOM_SSE2
+   const __m128 cx = _mm_set1_ps(inCenter.x);
+   const __m128 cy = _mm_set1_ps(inCenter.y);
+   const __m128 zero = _mm_setzero_ps();
+
+   for(; i + 3 < inNumVertices; i += 4)
+   {
+      __m128 x1, y1, x2, y2;
+      loadVerts(inVertices, i, x1, y1);
+      loadPrevVerts(inVertices, inNumVertices, i, x2, y2);
+
+      // Same arithmetic, in the same order, as closestPointOnEdge()
+      __m128 ex = _mm_sub_ps(x2, x1);
+      __m128 ey = _mm_sub_ps(y2, y1);
+      __m128 dx = _mm_sub_ps(cx, x1);
+      __m128 dy = _mm_sub_ps(cy, y1);
+
+      __m128 fraction = _mm_add_ps(_mm_mul_ps(dx, ex), _mm_mul_ps(dy, ey));
+      __m128 lenSq    = _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey));
+
+      __m128 atVertex = _mm_cmplt_ps(fraction, zero);
+      __m128 onEdge   = _mm_andnot_ps(atVertex, _mm_cmple_ps(fraction, lenSq));
+
+      __m128 scale = _mm_div_ps(fraction, lenSq);
+      __m128 px = _mm_add_ps(x1, _mm_mul_ps(ex, scale));
+      __m128 py = _mm_add_ps(y1, _mm_mul_ps(ey, scale));
+      __m128 pdx = _mm_sub_ps(px, cx);
+      __m128 pdy = _mm_sub_ps(py, cy);
+
+      __m128 vertexDistSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+      __m128 edgeDistSq   = _mm_add_ps(_mm_mul_ps(pdx, pdx), _mm_mul_ps(pdy, pdy));
+
+      px    = _mm_or_ps(_mm_and_ps(atVertex, x1), _mm_andnot_ps(atVertex, px));
+      py    = _mm_or_ps(_mm_and_ps(atVertex, y1), _mm_andnot_ps(atVertex, py));
+      __m128 dist = _mm_or_ps(_mm_and_ps(atVertex, vertexDistSq), _mm_andnot_ps(atVertex, edgeDistSq));
+
+      // The radius only shrinks as we go, so anything outside it now can be skipped
+      S32 candidates = _mm_movemask_ps(_mm_and_ps(_mm_or_ps(atVertex, onEdge),
+                                                  _mm_cmple_ps(dist, _mm_set1_ps(inRadiusSq))));
+      if(!candidates)
+         continue;
+
+      F32 closestX[4], closestY[4], dists[4];
+      _mm_storeu_ps(closestX, px);
+      _mm_storeu_ps(closestY, py);
+      _mm_storeu_ps(dists, dist);
+
+      // Pick the winner in edge order, so ties are resolved the same way as in the scalar version
+      for(S32 j = 0; j < 4; j++)
+         if(candidates & (1 << j))
+            checkCircleCandidate(Point(closestX[j], closestY[j]), dists[j], inCenter, ignoreVelocityEpsilon,
+                                 inRadiusSq, outPoint, collision);
+   }
+#endif
+
+   // Remaining edges
+   for(; i < inNumVertices; i++)
+      if(closestPointOnEdge(inVertices[i], inVertices[i == 0 ? inNumVertices - 1 : i - 1], inCenter, closest, distSq))
+         checkCircleCandidate(closest, distSq, inCenter, ignoreVelocityEpsilon, inRadiusSq, outPoint, collision);
+
+   return collision;
+}
+
+
+bool polygonCircleIntersectScalar(const Point *inVertices, int inNumVertices, const Point &inCenter, F32 inRadiusSq, Point &outPoint, Point *ignoreVelocityEpsilon)
+{
+   // Check if the center is inside the polygon  ==> now works for all polys
+   if(polygonContainsPointScalar(inVertices, inNumVertices, inCenter))
+   {
+      outPoint = inCenter;
+      return true;
+   }
+
    // Loop through edges
    bool collision = false;
+   Point closest;
+   F32 distSq;
+
    for (const Point *v1 = inVertices, *v2 = inVertices + inNumVertices - 1; v1 < inVertices + inNumVertices; v2 = v1, ++v1)
+      if(closestPointOnEdge(*v1, *v2, inCenter, closest, distSq))
+         checkCircleCandidate(closest, distSq, inCenter, ignoreVelocityEpsilon, inRadiusSq, outPoint, collision);
+
+   return collision;
+}
+
+
+// Returns true if segment p1-p2 crosses any edge of poly; same as calling segmentsIntersect() on each edge in turn
+static bool segmentIntersectsPolygonEdges(const Point &p1, const Point &p2, const Point *poly, S32 vertexCount)
+{
+   S32 i = 0;
+
+#ifdef BF_GEOM_SSE2
+   const __m128 p1x = _mm_set1_ps(p1.x);
+   const __m128 p1y = _mm_set1_ps(p1.y);
+   const __m128 p2p1x = _mm_set1_ps(p2.x - p1.x);
+   const __m128 p2p1y = _mm_set1_ps(p2.y - p1.y);
+   const __m128 zero = _mm_setzero_ps();
+   const __m128 one = _mm_set1_ps(1.0f);
+
+   for(; i + 3 < vertexCount; i += 4)
    {
-      // Get fraction where the closest point to this edge occurs
-      Point v1_v2 = *v2 - *v1;
-      Point v1_center = inCenter - *v1;
-      F32 fraction = v1_center.dot(v1_v2);
-      if (fraction < 0.0f)
-      {
-         // Closest point is v1
-         F32 dist_sq = v1_center.lenSquared();
-         if (dist_sq <= inRadiusSq)
-            if(!ignoreVelocityEpsilon || ignoreVelocityEpsilon->dot((*v1) - inCenter) > 0)
-            {
-               collision = true;
-               outPoint = *v1;
-               inRadiusSq = dist_sq;
-            }
-      }
-      else
-      {
-         F32 v1_v2_len_sq = v1_v2.lenSquared();
-         if (fraction <= v1_v2_len_sq)
-         {
-            // Closest point is on line segment
-            Point point = *v1 + v1_v2 * (fraction / v1_v2_len_sq);
-            F32 dist_sq = (point - inCenter).lenSquared();
-            if (dist_sq <= inRadiusSq)
-               if(!ignoreVelocityEpsilon || ignoreVelocityEpsilon->dot(point - inCenter) > 0)
-               {
-                  collision = true;
-                  outPoint = point;
-                  inRadiusSq = dist_sq;
-               }
-         }
-      }
+      // Edge i runs from p3 (the previous vertex) to p4 (vertex i)
+      __m128 x3, y3, x4, y4;
+      loadVerts(poly, i, x4, y4);
+      loadPrevVerts(poly, vertexCount, i, x3, y3);
+
+      // Same arithmetic, in the same order, as segmentsIntersect()
+      __m128 p4p3x = _mm_sub_ps(x4, x3);
+      __m128 p4p3y = _mm_sub_ps(y4, y3);
+      __m128 p1p3x = _mm_sub_ps(p1x, x3);
+      __m128 p1p3y = _mm_sub_ps(p1y, y3);
+
+      __m128 denom = _mm_sub_ps(_mm_mul_ps(p4p3y, p2p1x), _mm_mul_ps(p4p3x, p2p1y));
+      __m128 numerator1 = _mm_sub_ps(_mm_mul_ps(p4p3x, p1p3y), _mm_mul_ps(p4p3y, p1p3x));
+      __m128 numerator2 = _mm_sub_ps(_mm_mul_ps(p2p1x, p1p3y), _mm_mul_ps(p2p1y, p1p3x));
+
+      __m128 ua = _mm_div_ps(numerator1, denom);
+      __m128 ub = _mm_div_ps(numerator2, denom);
+
+      __m128 hit = _mm_and_ps(_mm_cmpneq_ps(denom, zero),
+                   _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(ua, zero), _mm_cmple_ps(ua, one)),
+                              _mm_and_ps(_mm_cmpge_ps(ub, zero), _mm_cmple_ps(ub, one))));
+
+      if(_mm_movemask_ps(hit))
+         return true;
    }
+#endif
 
-   return collision;
+   // Remaining edges
+   F32 ct;
+   for(; i < vertexCount; i++)
+      if(segmentsIntersect(p1, p2, poly[i == 0 ? vertexCount - 1 : i - 1], poly[i], ct))
+         return true;
+
+   return false;
 }
 
 
 // Returns true if polygon instersects or contains segment defined by start - end
 bool polygonIntersectsSegment(const Vector<Point> &points, const Point &start, const Point &end)
+{
+   if(segmentIntersectsPolygonEdges(start, end, points.address(), points.size()))
+      return true;
+
+   //  Entire line inside polygon?  If so, then the start will be within.
+   return polygonContainsPoint(points.address(), points.size(), start);
+}
+
+
+bool polygonIntersectsSegmentScalar(const Vector<Point> &points, const Point &start, const Point &end)
 {
    const Point *pointPrev = &points[points.size() - 1];
    F32 ct;
@@ -335,12 +607,30 @@ bool polygonIntersectsSegment(const Vector<Point> &points, const Point &start, c
    }
 
    //  Entire line inside polygon?  If so, then the start will be within.
-   return polygonContainsPoint(points.address(), points.size(), start);
+   return polygonContainsPointScalar(points.address(), points.size(), start);
 }
 
 
 // Returns true if polygons represented by p1 & p2 intersect or one contains the other
 bool polygonsIntersect(const Vector<Point> &p1, const Vector<Point> &p2)
+{
+   const Point *rp1 = &p1[p1.size() - 1];
+
+   for(S32 i = 0; i < p1.size(); i++)
+   {
+      const Point *rp2 = &p1[i];
+
+      if(segmentIntersectsPolygonEdges(*rp1, *rp2, p2.address(), p2.size()))
+         return true;
+
+      rp1 = rp2;
+   }
+   //  All points of polygon is inside the other polygon?  At this point, if any are, all are.
+   return polygonContainsPoint(p1.address(), p1.size(), p2[0]) || polygonContainsPoint(p2.address(), p2.size(), p1[0]);
+}
+
+
+bool polygonsIntersectScalar(const Vector<Point> &p1, const Vector<Point> &p2)
 {
    F32 ct;
    const Point *rp1 = &p1[p1.size() - 1];
@@ -361,7 +651,21 @@ bool polygonsIntersect(const Vector<Point> &p1, const Vector<Point> &p2)
       rp1 = rp2;
    }
    //  All points of polygon is inside the other polygon?  At this point, if any are, all are.
-   return polygonContainsPoint(p1.address(), p1.size(), p2[0]) || polygonContainsPoint(p2.address(), p2.size(), p1[0]);
+   return polygonContainsPointScalar(p1.address(), p1.size(), p2[0]) || polygonContainsPointScalar(p2.address(), p2.size(), p1[0]);
+}
+
+
+// Does the ray start -> start + dp cross the edge v1 -> v1 + dv?  If so, s is the fraction along the ray.
+static inline bool rayCrossesEdge(const Point &start, const Point &dp, const Point &v1, const Point &dv, F32 &s)
+{
+   F32 denom = dp.y * dv.x - dp.x * dv.y;
+   if(denom == 0)    // the lines are parallel
+      return false;
+
+   s = ( (start.x - v1.x) * dv.y + (v1.y - start.y) * dv.x ) / denom;
+   F32 t = ( (start.x - v1.x) * dp.y + (v1.y - start.y) * dp.x ) / denom;
+
+   return s >= 0 && s <= 1 && t >= 0 && t <= 1;
 }
 
 
@@ -369,6 +673,98 @@ bool polygonsIntersect(const Vector<Point> &p1, const Vector<Point> &p2)
 // Assumes a polygon in format A-B-C-D if format is true, A-B, C-D, E-F if format is false
 bool polygonIntersectsSegmentDetailed(const Point *poly, U32 vertexCount, bool format, const Point &start, const Point &end,
                                       F32 &collisionTime, Point &normal)
+{
+   Point dp = end - start;
+
+   U32 inc = format ? 1 : 2;
+   U32 i = 0;
+
+   F32 currentCollisionTime = 100;
+
+#ifdef BF_GEOM_SSE2
+   const __m128 startX = _mm_set1_ps(start.x);
+   const __m128 startY = _mm_set1_ps(start.y);
+   const __m128 dpx = _mm_set1_ps(dp.x);
+   const __m128 dpy = _mm_set1_ps(dp.y);
+   const __m128 zero = _mm_setzero_ps();
+   const __m128 one = _mm_set1_ps(1.0f);
+
+   // Four edges per pass; that's four vertices in A-B-C-D format, eight in A-B C-D format
+   for(; format ? i + 3 < vertexCount : i + 7 < vertexCount; i += 4 * inc)
+   {
+      __m128 x1, y1, x2, y2;
+
+      if(format)
+      {
+         loadVerts(poly, i, x2, y2);
+         loadPrevVerts(poly, vertexCount, i, x1, y1);
+      }
+      else
+         loadSegmentPairs(poly, i, x1, y1, x2, y2);
+
+      // Same arithmetic, in the same order, as rayCrossesEdge()
+      __m128 dvx = _mm_sub_ps(x2, x1);
+      __m128 dvy = _mm_sub_ps(y2, y1);
+      __m128 sx  = _mm_sub_ps(startX, x1);
+      __m128 sy  = _mm_sub_ps(y1, startY);
+
+      __m128 denom = _mm_sub_ps(_mm_mul_ps(dpy, dvx), _mm_mul_ps(dpx, dvy));
+      __m128 s = _mm_div_ps(_mm_add_ps(_mm_mul_ps(sx, dvy), _mm_mul_ps(sy, dvx)), denom);
+      __m128 t = _mm_div_ps(_mm_add_ps(_mm_mul_ps(sx, dpy), _mm_mul_ps(sy, dpx)), denom);
+
+      __m128 hit = _mm_and_ps(_mm_cmpneq_ps(denom, zero),
+                   _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(s, zero), _mm_cmple_ps(s, one)),
+                              _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmple_ps(t, one))));
+
+      S32 hits = _mm_movemask_ps(_mm_and_ps(hit, _mm_cmplt_ps(s, _mm_set1_ps(currentCollisionTime))));
+      if(!hits)
+         continue;
+
+      F32 times[4], dvxs[4], dvys[4];
+      _mm_storeu_ps(times, s);
+      _mm_storeu_ps(dvxs, dvx);
+      _mm_storeu_ps(dvys, dvy);
+
+      // Take the earliest hit in edge order, so ties are resolved the same way as in the scalar version
+      for(S32 j = 0; j < 4; j++)
+         if((hits & (1 << j)) && times[j] < currentCollisionTime)
+         {
+            normal.set(dvys[j], -dvxs[j]);
+            currentCollisionTime = times[j];
+         }
+   }
+#endif
+
+   // Remaining edges
+   for(; i < vertexCount - (inc - 1); i += inc)    // Count by 1s when format is true, 2 when false
+   {
+      // A-B-C-D format ==> examine every contiguous pair of vertices; A-B C-D format ==> don't examine segment B-C
+      const Point &v1 = format ? poly[i == 0 ? vertexCount - 1 : i - 1] : poly[i];
+      const Point &v2 = format ? poly[i] : poly[i + 1];
+
+      Point dv = v2 - v1;
+      F32 s;
+
+      if(rayCrossesEdge(start, dp, v1, dv, s) && s < currentCollisionTime)    // Found collision closer than others
+      {
+         normal.set(dv.y, -dv.x);
+         currentCollisionTime = s;
+      }
+   }
+
+   if(currentCollisionTime <= 1)    // Found intersection
+   {
+      collisionTime = currentCollisionTime;
+      return true;
+   }
+
+   // No intersection
+   return false;
+}
+
+
+bool polygonIntersectsSegmentDetailedScalar(const Point *poly, U32 vertexCount, bool format, const Point &start, const Point &end,
+                                            F32 &collisionTime, Point &normal)
 {
    Point v1 = poly[vertexCount - 1];
    Point v2, dv;
@@ -393,17 +789,11 @@ bool polygonIntersectsSegmentDetailed(const Point *poly, U32 vertexCount, bool f
 
       dv.set(v2 - v1);
 
-      F32 denom = dp.y * dv.x - dp.x * dv.y;
-      if(denom != 0) // otherwise, the lines are parallel
+      F32 s;
+      if(rayCrossesEdge(start, dp, v1, dv, s) && s < currentCollisionTime)    // Found collision closer than others
       {
-         F32 s = ( (start.x - v1.x) * dv.y + (v1.y - start.y) * dv.x ) / denom;
-         F32 t = ( (start.x - v1.x) * dp.y + (v1.y - start.y) * dp.x ) / denom;
-
-         if(s >= 0 && s <= 1 && t >= 0 && t <= 1 && s < currentCollisionTime)    // Found collision closer than others
-         {
-            normal.set(dv.y, -dv.x);
-            currentCollisionTime = s;
-         }
+         normal.set(dv.y, -dv.x);
+         currentCollisionTime = s;
       }
       v1.set(v2);    // No real effect if format == false
    }
@@ -418,6 +808,7 @@ bool polygonIntersectsSegmentDetailed(const Point *poly, U32 vertexCount, bool f
    return false;
 }
 
+
 bool circleIntersectsSegment(Point center, float radius, Point start, Point end, float &collisionTime)
 {
    // if the point is in the circle, it's a collision at the start
@@ -660,56 +1051,159 @@ bool zonesTouch(const Vector<Point> *zone1, const Vector<Point> *zone2, F32 scal
 }
 
 
-// Checks intersection between a polygon an moving circle at inBegin + t * inDelta with radius^2 = inA * t^2 + inB * t + inC, t in [0, 1]
-// Returns true when it does and returns the intersection position in outPoint and the intersection fraction (value for t) in outFraction
-bool SweptCircleEdgeVertexIntersect(const Point *inVertices, int inNumVertices, const Point &inBegin, const Point &inDelta, F32 inA, F32 inB, F32 inC, Point &outPoint, F32 &outFraction)
+// Vertex and edge tests for one edge of SweptCircleEdgeVertexIntersect(), given the coefficients of the two quadratics
+static inline void sweptCircleTestEdge(const Point &v1, const Point &v1v2, const Point &inBegin, const Point &inDelta,
+                                       F32 a1, F32 b1, F32 c1, F32 a2, F32 b2, F32 c2,
+                                       F32 v1v2_dot_delta, F32 v1v2_dot_bv1, F32 v1v2_len_sq,
+                                       F32 &upper_bound, Point &outPoint, bool &collision)
 {
-   // Loop through edges
-   F32 upper_bound = 1.0f;
-   bool collision = false;
-   for (const Point *v1 = inVertices, *v2 = inVertices + inNumVertices - 1; v1 < inVertices + inNumVertices; v2 = v1, ++v1)
-   {
-      F32 t;
+   F32 t;
+
+   // Check if circle hits the vertex
+   if (findLowestRootInInterval(a1, b1, c1, upper_bound, t))
+      if(inDelta.dot(v1 - inBegin) > 0)
+      {
+         // We have a collision
+         collision = true;
+         upper_bound = t;
+         outPoint = v1;
+      }
 
-      // Check if circle hits the vertex
-      Point bv1 = *v1 - inBegin;
-      F32 a1 = inA - inDelta.lenSquared();
-      F32 b1 = inB + 2.0f * inDelta.dot(bv1);
-      F32 c1 = inC - bv1.lenSquared();
-      if (findLowestRootInInterval(a1, b1, c1, upper_bound, t))
-         if(inDelta.dot((*v1) - inBegin) > 0)
+   // Check if circle hits the edge
+   if (findLowestRootInInterval(a2, b2, c2, upper_bound, t))
+   {
+      // Check if the intersection point is on the edge
+      F32 f = t * v1v2_dot_delta - v1v2_dot_bv1;
+      if (f >= 0.0f && f <= v1v2_len_sq)
+      {
+         Point p(v1 + v1v2 * (f / v1v2_len_sq));
+         if(inDelta.dot(p - inBegin) > 0)
          {
             // We have a collision
             collision = true;
             upper_bound = t;
-            outPoint = *v1;
+            outPoint = p;
          }
+      }
+   }
+}
 
-      // Check if circle hits the edge
-      Point v1v2 = *v2 - *v1;
-      F32 v1v2_dot_delta = v1v2.dot(inDelta);
-      F32 v1v2_dot_bv1 = v1v2.dot(bv1);
-      F32 v1v2_len_sq = v1v2.lenSquared();
-      F32 a2 = v1v2_len_sq * a1 + v1v2_dot_delta * v1v2_dot_delta;
-      F32 b2 = v1v2_len_sq * b1 - 2.0f * v1v2_dot_bv1 * v1v2_dot_delta;
-      F32 c2 = v1v2_len_sq * c1 + v1v2_dot_bv1 * v1v2_dot_bv1;
-      if (findLowestRootInInterval(a2, b2, c2, upper_bound, t))
-      {
-         // Check if the intersection point is on the edge
-         F32 f = t * v1v2_dot_delta - v1v2_dot_bv1;
-         if (f >= 0.0f && f <= v1v2_len_sq)
+
+static inline void sweptCircleEdgeVertexIntersectEdge(const Point &v1, const Point &v2, const Point &inBegin, const Point &inDelta,
+                                                      F32 inA, F32 inB, F32 inC, F32 &upper_bound, Point &outPoint, bool &collision)
+{
+   Point bv1 = v1 - inBegin;
+   F32 a1 = inA - inDelta.lenSquared();
+   F32 b1 = inB + 2.0f * inDelta.dot(bv1);
+   F32 c1 = inC - bv1.lenSquared();
+
+   Point v1v2 = v2 - v1;
+   F32 v1v2_dot_delta = v1v2.dot(inDelta);
+   F32 v1v2_dot_bv1 = v1v2.dot(bv1);
+   F32 v1v2_len_sq = v1v2.lenSquared();
+   F32 a2 = v1v2_len_sq * a1 + v1v2_dot_delta * v1v2_dot_delta;
+   F32 b2 = v1v2_len_sq * b1 - 2.0f * v1v2_dot_bv1 * v1v2_dot_delta;
+   F32 c2 = v1v2_len_sq * c1 + v1v2_dot_bv1 * v1v2_dot_bv1;
+
+   sweptCircleTestEdge(v1, v1v2, inBegin, inDelta, a1, b1, c1, a2, b2, c2, v1v2_dot_delta, v1v2_dot_bv1, v1v2_len_sq,
+                       upper_bound, outPoint, collision);
+}
+
+
+// Checks intersection between a polygon an moving circle at inBegin + t * inDelta with radius^2 = inA * t^2 + inB * t + inC, t in [0, 1]
+// Returns true when it does and returns the intersection position in outPoint and the intersection fraction (value for t) in outFraction
+bool SweptCircleEdgeVertexIntersect(const Point *inVertices, int inNumVertices, const Point &inBegin, const Point &inDelta, F32 inA, F32 inB, F32 inC, Point &outPoint, F32 &outFraction)
+{
+   // Loop through edges; edge i runs from vertex i to the vertex before it
+   F32 upper_bound = 1.0f;
+   bool collision = false;
+   S32 i = 0;
+
+#ifdef BF_GEOM_SSE2
+   const F32 a1 = inA - inDelta.lenSquared();
+   const __m128 a1v = _mm_set1_ps(a1);
+   const __m128 bx = _mm_set1_ps(inBegin.x);
+   const __m128 by = _mm_set1_ps(inBegin.y);
+   const __m128 dx = _mm_set1_ps(inDelta.x);
+   const __m128 dy = _mm_set1_ps(inDelta.y);
+   const __m128 two = _mm_set1_ps(2.0f);
+   const __m128 four = _mm_set1_ps(4.0f);
+   const __m128 zero = _mm_setzero_ps();
+
+   for(; i + 3 < inNumVertices; i += 4)
+   {
+      __m128 x1, y1, x2, y2;
+      loadVerts(inVertices, i, x1, y1);
+      loadPrevVerts(inVertices, inNumVertices, i, x2, y2);
+
+      // Coefficients of both quadratics, with the same arithmetic in the same order as the scalar version
+      __m128 bv1x = _mm_sub_ps(x1, bx);
+      __m128 bv1y = _mm_sub_ps(y1, by);
+      __m128 b1 = _mm_add_ps(_mm_set1_ps(inB), _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(dx, bv1x), _mm_mul_ps(dy, bv1y))));
+      __m128 c1 = _mm_sub_ps(_mm_set1_ps(inC), _mm_add_ps(_mm_mul_ps(bv1x, bv1x), _mm_mul_ps(bv1y, bv1y)));
+
+      __m128 ex = _mm_sub_ps(x2, x1);
+      __m128 ey = _mm_sub_ps(y2, y1);
+      __m128 dotDelta = _mm_add_ps(_mm_mul_ps(ex, dx), _mm_mul_ps(ey, dy));
+      __m128 dotBv1   = _mm_add_ps(_mm_mul_ps(ex, bv1x), _mm_mul_ps(ey, bv1y));
+      __m128 lenSq    = _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey));
+
+      __m128 a2 = _mm_add_ps(_mm_mul_ps(lenSq, a1v), _mm_mul_ps(dotDelta, dotDelta));
+      __m128 b2 = _mm_sub_ps(_mm_mul_ps(lenSq, b1), _mm_mul_ps(_mm_mul_ps(two, dotBv1), dotDelta));
+      __m128 c2 = _mm_add_ps(_mm_mul_ps(lenSq, c1), _mm_mul_ps(dotBv1, dotBv1));
+
+      // Most edges are nowhere near the circle's path; when neither quadratic has a real root,
+      // findLowestRootInInterval() would fail for both, so we can skip the edge entirely
+      __m128 det1 = _mm_sub_ps(_mm_mul_ps(b1, b1), _mm_mul_ps(_mm_mul_ps(four, a1v), c1));
+      __m128 det2 = _mm_sub_ps(_mm_mul_ps(b2, b2), _mm_mul_ps(_mm_mul_ps(four, a2), c2));
+
+      S32 noRoots = _mm_movemask_ps(_mm_and_ps(_mm_cmplt_ps(det1, zero), _mm_cmplt_ps(det2, zero)));
+      if(noRoots == 0xF)
+         continue;
+
+      F32 b1s[4], c1s[4], a2s[4], b2s[4], c2s[4], dotDeltas[4], dotBv1s[4], lenSqs[4];
+      _mm_storeu_ps(b1s, b1);
+      _mm_storeu_ps(c1s, c1);
+      _mm_storeu_ps(a2s, a2);
+      _mm_storeu_ps(b2s, b2);
+      _mm_storeu_ps(c2s, c2);
+      _mm_storeu_ps(dotDeltas, dotDelta);
+      _mm_storeu_ps(dotBv1s, dotBv1);
+      _mm_storeu_ps(lenSqs, lenSq);
+
+      // Solve in edge order, since each hit lowers upper_bound for the ones that follow
+      for(S32 j = 0; j < 4; j++)
+         if(!(noRoots & (1 << j)))
          {
-            Point p(*v1 + v1v2 * (f / v1v2_len_sq));
-            if(inDelta.dot(p - inBegin) > 0)
-            {
-               // We have a collision
-               collision = true;
-               upper_bound = t;
-               outPoint = p;
-            }
+            const Point &v1 = inVertices[i + j];
+            const Point &v2 = inVertices[i + j == 0 ? inNumVertices - 1 : i + j - 1];
+
+            sweptCircleTestEdge(v1, v2 - v1, inBegin, inDelta, a1, b1s[j], c1s[j], a2s[j], b2s[j], c2s[j],
+                                dotDeltas[j], dotBv1s[j], lenSqs[j], upper_bound, outPoint, collision);
          }
-      }
    }
+#endif
+
+   // Remaining edges
+   for(; i < inNumVertices; i++)
+      sweptCircleEdgeVertexIntersectEdge(inVertices[i], inVertices[i == 0 ? inNumVertices - 1 : i - 1], inBegin, inDelta,
+                                         inA, inB, inC, upper_bound, outPoint, collision);
+
+   // Check if we had a collision
+   if (!collision)
+      return false;
+   outFraction = upper_bound;
+   return true;
+}
+
+
+static bool SweptCircleEdgeVertexIntersectScalar(const Point *inVertices, int inNumVertices, const Point &inBegin, const Point &inDelta, F32 inA, F32 inB, F32 inC, Point &outPoint, F32 &outFraction)
+{
+   // Loop through edges
+   F32 upper_bound = 1.0f;
+   bool collision = false;
+   for (const Point *v1 = inVertices, *v2 = inVertices + inNumVertices - 1; v1 < inVertices + inNumVertices; v2 = v1, ++v1)
+      sweptCircleEdgeVertexIntersectEdge(*v1, *v2, inBegin, inDelta, inA, inB, inC, upper_bound, outPoint, collision);
 
    // Check if we had a collision
    if (!collision)
@@ -718,6 +1212,7 @@ bool SweptCircleEdgeVertexIntersect(const Point *inVertices, int inNumVertices,
    return true;
 }
 
+
 // Should work with any polygons, convex and concave
 bool PolygonSweptCircleIntersect(const Point *inVertices, int inNumVertices, const Point &inBegin, const Point &inDelta, F32 inRadius, Point &outPoint, F32 &outFraction)
 {
@@ -737,6 +1232,18 @@ bool PolygonSweptCircleIntersect(const Point *inVertices, int inNumVertices, con
 }
 
 
+bool PolygonSweptCircleIntersectScalar(const Point *inVertices, int inNumVertices, const Point &inBegin, const Point &inDelta, F32 inRadius, Point &outPoint, F32 &outFraction)
+{
+   if(polygonCircleIntersectScalar(inVertices, inNumVertices, inBegin, inRadius * inRadius, outPoint, (Point *)&inDelta))
+   {
+      outFraction = 0;
+      return true;
+   }
+
+   return SweptCircleEdgeVertexIntersectScalar(inVertices, inNumVertices, inBegin, inDelta, 0, 0, inRadius * inRadius, outPoint, outFraction);
+}
+
+
 static const float EPSILON=0.0000000001f;
 
 F32 area(const Vector<Point> &contour)
@@ -1043,7 +1550,7 @@ bool clipPolygonsAsTree(ClipType operation, const Vector<Vector<Point> > &subjec
    }
    catch(...)
    {
-      logprintf(LogConsumer::LogError, "Exception thrown by Clipper::AddPolygons");
+      WorkerPool::log(LogConsumer::LogError, "Exception thrown by Clipper::AddPolygons");
       return false;
    }
 
@@ -1124,7 +1631,7 @@ bool triangulate(const Vector<Vector<Point> > &input, Vector<Vector<Point> > &re
    }
    catch(...)
    {
-      logprintf(LogConsumer::LogError, "Exception thrown by Clipper::AddPolygons");
+      WorkerPool::log(LogConsumer::LogError, "Exception thrown by Clipper::AddPolygons");
       return false;
    }
 
@@ -1294,7 +1801,7 @@ bool mergePolys(const Vector<const Vector<Point> *> &inputPolygons, Vector<Vecto
    }
    catch(...)
    {
-      logprintf(LogConsumer::LogError, "clipper.AddPolygons, something went wrong");
+      WorkerPool::log(LogConsumer::LogError, "clipper.AddPolygons, something went wrong");
    }
 
    bool success = clipper.Execute(ctUnion, solution, pftNonZero, pftNonZero);
@@ -1322,13 +1829,283 @@ bool mergePolysToPolyTree(const Vector<Vector<Point> > &inputPolygons, PolyTree
    }
    catch(...)
    {
-      logprintf(LogConsumer::LogError, "clipper.AddPolygons, something went wrong");
+      WorkerPool::log(LogConsumer::LogError, "clipper.AddPolygons, something went wrong");
    }
 
    return clipper.Execute(ctUnion, solution, pftNonZero, pftNonZero);
 }
 
 
+////////////////////////////////////////
+////////////////////////////////////////
+// Batch versions of the Clipper and poly2tri wrappers.  Each group is handled on its own by one of the WorkerPool's
+// threads, and its results go in the same slot of the output.
+
+struct PolygonBatch
+{
+   const Vector<Vector<const Vector<Point> *> > *pointerInput;
+   const Vector<Vector<Vector<Point> > > *input;
+   const Vector<Vector<Vector<Point> > > *clip;
+   Vector<Vector<Vector<Point> > > *output;
+   Vector<U8> succeeded;         // Not bool; Vector<bool> packs its elements, so threads can't write them independently
+
+   ClipType operation;
+   F32 offset;
+   JoinType joinType;
+   bool merge;
+   bool forceTriangulate;
+
+   PolygonBatch(S32 groupCount, Vector<Vector<Vector<Point> > > &outputGroups)
+   {
+      pointerInput = NULL;
+      input = NULL;
+      clip = NULL;
+      output = &outputGroups;
+
+      operation = ctUnion;
+      offset = 0;
+      joinType = jtSquare;
+      merge = false;
+      forceTriangulate = false;
+
+      outputGroups.clear();
+      outputGroups.resize(groupCount);
+      succeeded.resize(groupCount);
+   }
+
+   bool run(WorkerPool::Job job)
+   {
+      WorkerPool::get()->run(succeeded.size(), job, this);
+
+      for(S32 i = 0; i < succeeded.size(); i++)
+         if(!succeeded[i])
+            return false;
+
+      return true;
+   }
+};
+
+
+static void mergeGroup(S32 index, void *context)
+{
+   PolygonBatch *batch = static_cast<PolygonBatch *>(context);
+   batch->succeeded[index] = mergePolys(batch->pointerInput->get(index), batch->output->get(index));
+}
+
+
+static void offsetGroup(S32 index, void *context)
+{
+   PolygonBatch *batch = static_cast<PolygonBatch *>(context);
+   offsetPolygons(batch->input->get(index), batch->output->get(index), batch->offset, batch->joinType);
+   batch->succeeded[index] = true;
+}
+
+
+static void clipGroup(S32 index, void *context)
+{
+   PolygonBatch *batch = static_cast<PolygonBatch *>(context);
+   batch->succeeded[index] = clipPolygons(batch->operation, batch->input->get(index), batch->clip->get(index),
+                                          batch->output->get(index), batch->merge, batch->forceTriangulate);
+}
+
+
+static void triangulateGroup(S32 index, void *context)
+{
+   PolygonBatch *batch = static_cast<PolygonBatch *>(context);
+   batch->succeeded[index] = triangulate(batch->input->get(index), batch->output->get(index));
+}
+
+
+static void polyganizeGroup(S32 index, void *context)
+{
+   PolygonBatch *batch = static_cast<PolygonBatch *>(context);
+   batch->succeeded[index] = polyganize(batch->input->get(index), batch->output->get(index));
+}
+
+
+bool mergePolysBatch(const Vector<Vector<const Vector<Point> *> > &inputGroups, Vector<Vector<Vector<Point> > > &outputGroups)
+{
+   PolygonBatch batch(inputGroups.size(), outputGroups);
+   batch.pointerInput = &inputGroups;
+
+   return batch.run(mergeGroup);
+}
+
+
+void offsetPolygonsBatch(const Vector<Vector<Vector<Point> > > &inputGroups, Vector<Vector<Vector<Point> > > &outputGroups,
+      const F32 offset, JoinType joinType)
+{
+   PolygonBatch batch(inputGroups.size(), outputGroups);
+   batch.input = &inputGroups;
+   batch.offset = offset;
+   batch.joinType = joinType;
+
+   batch.run(offsetGroup);
+}
+
+
+bool clipPolygonsBatch(ClipType operation, const Vector<Vector<Vector<Point> > > &subjectGroups,
+      const Vector<Vector<Vector<Point> > > &clipGroups, Vector<Vector<Vector<Point> > > &resultGroups,
+      bool merge, bool forceTriangulate)
+{
+   TNLAssert(subjectGroups.size() == clipGroups.size(), "Need one clip group for each subject group!");
+
+   PolygonBatch batch(subjectGroups.size(), resultGroups);
+   batch.input = &subjectGroups;
+   batch.clip = &clipGroups;
+   batch.operation = operation;
+   batch.merge = merge;
+   batch.forceTriangulate = forceTriangulate;
+
+   return batch.run(clipGroup);
+}
+
+
+bool triangulateBatch(const Vector<Vector<Vector<Point> > > &inputGroups, Vector<Vector<Vector<Point> > > &outputGroups)
+{
+   PolygonBatch batch(inputGroups.size(), outputGroups);
+   batch.input = &inputGroups;
+
+   return batch.run(triangulateGroup);
+}
+
+
+bool polyganizeBatch(const Vector<Vector<Vector<Point> > > &inputGroups, Vector<Vector<Vector<Point> > > &outputGroups)
+{
+   PolygonBatch batch(inputGroups.size(), outputGroups);
+   batch.input = &inputGroups;
+
+   return batch.run(polyganizeGroup);
+}
+
+
+struct PolygonBounds
+{
+   Rect rect;
+   S32 index;
+};
+
+
+static bool leftmostBoundsFirst(const PolygonBounds &a, const PolygonBounds &b)
+{
+   if(a.rect.min.x != b.rect.min.x)
+      return a.rect.min.x < b.rect.min.x;
+
+   return a.index < b.index;
+}
+
+
+// Returns the root of the group i belongs to, flattening the path as we go
+static S32 findPolygonGroup(Vector<S32> &parents, S32 i)
+{
+   while(parents[i] != i)
+   {
+      parents[i] = parents[parents[i]];
+      i = parents[i];
+   }
+
+   return i;
+}
+
+
+// Split polygons into groups such that no polygon's bounding box touches that of a polygon in another group, so
+// each group can be merged (or clipped, or triangulated) without regard to the others.  Groups are ordered by their
+// first polygon, and polygons keep their input order within a group, so the result doesn't depend on anything but
+// the input.
+void partitionPolygons(const Vector<const Vector<Point> *> &polygons, Vector<Vector<const Vector<Point> *> > &groups)
+{
+   groups.clear();
+
+   S32 count = polygons.size();
+
+   Vector<PolygonBounds> bounds;
+   bounds.resize(count);
+
+   Vector<S32> parents;
+   parents.resize(count);
+
+   for(S32 i = 0; i < count; i++)
+   {
+      bounds[i].rect = Rect(*polygons[i]);
+      bounds[i].index = i;
+      parents[i] = i;
+   }
+
+   // Sweep left to right, only comparing against boxes that haven't ended yet
+   bounds.sort(leftmostBoundsFirst);
+
+   Vector<S32> open;    // Indices into bounds
+   for(S32 i = 0; i < count; i++)
+   {
+      const Rect &rect = bounds[i].rect;
+
+      for(S32 j = 0; j < open.size(); j++)
+      {
+         const Rect &other = bounds[open[j]].rect;
+
+         if(other.max.x < rect.min.x)
+         {
+            open.erase_fast(j);
+            j--;
+            continue;
+         }
+
+         if(other.max.y >= rect.min.y && other.min.y <= rect.max.y)
+         {
+            S32 root = findPolygonGroup(parents, bounds[i].index);
+            S32 otherRoot = findPolygonGroup(parents, bounds[open[j]].index);
+            parents[max(root, otherRoot)] = min(root, otherRoot);
+         }
+      }
+
+      open.push_back(i);
+   }
+
+   // Roots are always the lowest index in their group, so visiting in input order creates groups in order
+   Vector<S32> groupIndex;
+   groupIndex.resize(count);
+
+   for(S32 i = 0; i < count; i++)
+   {
+      S32 root = findPolygonGroup(parents, i);
+
+      if(root == i)
+      {
+         groupIndex[i] = groups.size();
+         groups.push_back(Vector<const Vector<Point> *>());
+      }
+
+      groups[groupIndex[root]].push_back(polygons[i]);
+   }
+}
+
+
+// Gives the same polygons as mergePolys(), though not necessarily in the same order, by merging groups that can't
+// touch one another in parallel
+bool mergePolysInGroups(const Vector<const Vector<Point> *> &inputPolygons, Vector<Vector<Point> > &outputPolygons)
+{
+   Vector<Vector<const Vector<Point> *> > groups;
+   partitionPolygons(inputPolygons, groups);
+
+   if(groups.size() <= 1)
+      return mergePolys(inputPolygons, outputPolygons);
+
+   Vector<Vector<Vector<Point> > > mergedGroups;
+   bool success = mergePolysBatch(groups, mergedGroups);
+
+   if(success)
+   {
+      outputPolygons.clear();
+
+      for(S32 i = 0; i < mergedGroups.size(); i++)
+         for(S32 j = 0; j < mergedGroups[i].size(); j++)
+            outputPolygons.push_back(mergedGroups[i][j]);
+   }
+
+   return success;
+}
+
+
 // Convert a Polygons to a list of points in a-b b-c c-d d-a format
 void unpackPolygons(const Vector<Vector<Point> > &solution, Vector<Point> &lineSegmentPoints)
 {
@@ -1361,7 +2138,7 @@ void unpackPolygons(const Vector<Vector<Point> > &solution, Vector<Point> &lineS
 
 
 // This method offsets polygons and can square or miter any corners
-void offsetPolygons(Vector<const Vector<Point> *> &inputPolys, Vector<Vector<Point> > &outputPolys,
+void offsetPolygons(const Vector<const Vector<Point> *> &inputPolys, Vector<Vector<Point> > &outputPolys,
       const F32 offset, JoinType joinType)
 {
    Paths polygons = upscaleClipperPoints(inputPolys);
@@ -1379,7 +2156,7 @@ void offsetPolygons(Vector<const Vector<Point> *> &inputPolys, Vector<Vector<Poi
 
 
 // This method offsets and squares any acute corners, perfect for bot zones
-void offsetPolygons(Vector<Vector<Point> > &inputPolys, Vector<Vector<Point> > &outputPolys,
+void offsetPolygons(const Vector<Vector<Point> > &inputPolys, Vector<Vector<Point> > &outputPolys,
       const F32 offset, JoinType joinType)
 {
    Paths polygons = upscaleClipperPoints(inputPolys);
@@ -1499,9 +2276,87 @@ bool isWoundClockwise(const Vector<Point>& inputPoly)
 }
 
 
+// One polyline and its holes, triangulated independently of the others by processComplex()
+struct TriangulationJob
+{
+   const Path *contour;
+   const PolyNode *node;         // The node's children are the holes
+   Vector<Point> triangles;
+   bool success;
+};
+
+
+static void triangulateNode(S32 index, void *context)
+{
+   TriangulationJob &job = (*static_cast<Vector<TriangulationJob> *>(context))[index];
+
+   // Build up this polyline in poly2tri's format
+   Vector<p2t::Point*> polyline;
+   for(U32 j = 0; j < job.contour->size(); j++)
+      polyline.push_back(new p2t::Point(F64((*job.contour)[j].X), F64((*job.contour)[j].Y)));
+
+   // Set our polyline in poly2tri
+   p2t::CDT *cdt = new p2t::CDT(polyline.getStlVector());
+
+   Vector<Vector<p2t::Point*> > holesRegistry;     // Memory
+
+   for(U32 j = 0; j < job.node->Childs.size(); j++)
+   {
+      PolyNode *childNode = job.node->Childs[j];
+
+      Vector<p2t::Point*> hole;
+      for(U32 k = 0; k < childNode->Contour.size(); k++)
+         hole.push_back(new p2t::Point(F64(childNode->Contour[k].X), F64(childNode->Contour[k].Y)));
+
+      holesRegistry.push_back(hole);
+
+      // Add the holes for this polyline
+      cdt->AddHole(hole.getStlVector());
+   }
+
+   job.success = true;
+
+   try {
+      cdt->Triangulate();
+   }
+   catch(std::exception &ex)
+   {
+      WorkerPool::log(LogConsumer::LogError, string("Error creating bot zones: ") + ex.what() +
+                                             " ||| Please send the Bitfighter devs a copy of this level!");
+      job.success = false;
+   }
+
+   if(job.success)
+   {
+      // Copy our data to TNL::Point and to our output Vector
+      vector<p2t::Triangle*> currentOutput = cdt->GetTriangles();
+
+      for(U32 j = 0; j < currentOutput.size(); j++)
+      {
+         p2t::Triangle *currentTriangle = currentOutput[j];
+         job.triangles.push_back(Point(currentTriangle->GetPoint(0)->x * CLIPPER_SCALE_FACT_INVERSE, currentTriangle->GetPoint(0)->y * CLIPPER_SCALE_FACT_INVERSE));
+         job.triangles.push_back(Point(currentTriangle->GetPoint(1)->x * CLIPPER_SCALE_FACT_INVERSE, currentTriangle->GetPoint(1)->y * CLIPPER_SCALE_FACT_INVERSE));
+         job.triangles.push_back(Point(currentTriangle->GetPoint(2)->x * CLIPPER_SCALE_FACT_INVERSE, currentTriangle->GetPoint(2)->y * CLIPPER_SCALE_FACT_INVERSE));
+      }
+   }
+
+   // Clean up memory used with poly2tri; the worker goes first, as it refers to the points
+   delete cdt;
+
+   polyline.deleteAndClear();
+
+   for(S32 i = 0; i < holesRegistry.size(); i++)
+      holesRegistry[i].deleteAndClear();
+}
+
+
 // This uses poly2tri to triangulate.  poly2tri isn't very robust so clipper needs to do
 // the cleaning of points before getting here.
 //
+// Each polyline is triangulated with only its children as holes, so they don't depend on one another, and are farmed
+// out to the WorkerPool.  Results are assembled in tree order, so the output is the same no matter how many threads
+// did the work.
+//
 // For assistance with a special case crash, see this utility:
 //    http://javascript.poly2tri.googlecode.com/hg/index.html
 bool Triangulate::processComplex(Vector<Point> &outputTriangles, const Rect& bounds,
@@ -1518,15 +2373,9 @@ bool Triangulate::processComplex(Vector<Point> &outputTriangles, const Rect& bou
    outline.push_back(IntPoint(S64(maxx * CLIPPER_SCALE_FACT), S64(miny * CLIPPER_SCALE_FACT)));
 
 
-   // Keep track of memory for all the poly2tri objects we create
-   Vector<p2t::CDT*> cdtRegistry;
-   Vector<Vector<p2t::Point*> > holesRegistry;
-   Vector<Vector<p2t::Point*> > polylinesRegistry;
-
-
-   // Let's be tricky and add our outline to the root node (it should have none), it'll be
-   // our first Clipper hole
-   PolyNode *rootNode = NULL;
+   // Our outline stands in for the root node's contour (it should have none); it'll be our first Clipper hole.  We
+   // used to write it into the root node, but the tree belongs to our caller, who may be sharing it with other threads.
+   const PolyNode *rootNode = NULL;
 
    PolyNode tempNode;
    if(polyTree.Total() == 0)  // Polytree is empty with no root node, e.g. on an empty level
@@ -1534,10 +2383,10 @@ bool Triangulate::processComplex(Vector<Point> &outputTriangles, const Rect& bou
    else
       rootNode = polyTree.GetFirst()->Parent;
 
-   rootNode->Contour = outline;
+   // Now gather our polyline nodes; each will be triangulated with only its children holes
+   Vector<TriangulationJob> jobs;
 
-   // Now traverse our polyline nodes and triangulate them with only their children holes
-   PolyNode *currentNode = rootNode;
+   const PolyNode *currentNode = rootNode;
    while(currentNode != NULL)
    {
       // A Clipper hole is actually what we want to build zones for; they become our bounding
@@ -1545,80 +2394,29 @@ bool Triangulate::processComplex(Vector<Point> &outputTriangles, const Rect& bou
       if((!ignoreHoles && currentNode->IsHole()) ||
          (!ignoreFills && !currentNode->IsHole()))
       {
-         // Build up this polyline in poly2tri's format (downscale Clipper points)
-         Vector<p2t::Point*> polyline;
-         for(U32 j = 0; j < currentNode->Contour.size(); j++)
-            polyline.push_back(new p2t::Point(F64(currentNode->Contour[j].X), F64(currentNode->Contour[j].Y)));
-
-         polylinesRegistry.push_back(polyline);  // Memory
-
-         // Set our polyline in poly2tri
-         p2t::CDT* cdt = new p2t::CDT(polyline.getStlVector());
-         cdtRegistry.push_back(cdt);
-
-         for(U32 j = 0; j < currentNode->Childs.size(); j++)
-         {
-            PolyNode *childNode = currentNode->Childs[j];
-
-            Vector<p2t::Point*> hole;
-            for(U32 k = 0; k < childNode->Contour.size(); k++)
-               hole.push_back(new p2t::Point(F64(childNode->Contour[k].X), F64(childNode->Contour[k].Y)));
-
-            holesRegistry.push_back(hole);  // Memory
-
-            // Add the holes for this polyline
-            cdt->AddHole(hole.getStlVector());
-         }
-
-         try {
-            cdt->Triangulate();
-         }
-         catch(std::exception &ex)
-         {
-            string msg = string("Error creating bot zones: ") + ex.what() + " ||| Please send the Bitfighter devs a copy of this level!";
-            logprintf(msg.c_str());
-            return false;
-         }
+         TriangulationJob job;
+         job.contour = (currentNode == rootNode) ? &outline : &currentNode->Contour;
+         job.node = currentNode;
+         job.success = false;
 
-         // Add current output triangles to our total
-         vector<p2t::Triangle*> currentOutput = cdt->GetTriangles();
-
-         // Copy our data to TNL::Point and to our output Vector
-         p2t::Triangle *currentTriangle;
-         for(U32 j = 0; j < currentOutput.size(); j++)
-         {
-            currentTriangle = currentOutput[j];
-            outputTriangles.push_back(Point(currentTriangle->GetPoint(0)->x * CLIPPER_SCALE_FACT_INVERSE, currentTriangle->GetPoint(0)->y * CLIPPER_SCALE_FACT_INVERSE));
-            outputTriangles.push_back(Point(currentTriangle->GetPoint(1)->x * CLIPPER_SCALE_FACT_INVERSE, currentTriangle->GetPoint(1)->y * CLIPPER_SCALE_FACT_INVERSE));
-            outputTriangles.push_back(Point(currentTriangle->GetPoint(2)->x * CLIPPER_SCALE_FACT_INVERSE, currentTriangle->GetPoint(2)->y * CLIPPER_SCALE_FACT_INVERSE));
-         }
+         jobs.push_back(job);
       }
 
       currentNode = currentNode->GetNext();
    }
 
+   WorkerPool::get()->run(jobs.size(), triangulateNode, &jobs);
 
-   // Clean up memory used with poly2tri
-   //
-   // Clean-up workers
-   for(S32 i = 0; i < cdtRegistry.size(); i++)
-      delete cdtRegistry[i];
-
-   // Free the polylines
-   for(S32 i = 0; i < polylinesRegistry.size(); i++)
+   // Add each polyline's output triangles to our total
+   for(S32 i = 0; i < jobs.size(); i++)
    {
-      Vector<p2t::Point*> polyline = polylinesRegistry[i];
-      polyline.deleteAndClear();
-   }
+      if(!jobs[i].success)
+         return false;
 
-   // Free the holes
-   for(S32 i = 0; i < holesRegistry.size(); i++)
-   {
-      Vector<p2t::Point*> hole = holesRegistry[i];
-      hole.deleteAndClear();
+      for(S32 j = 0; j < jobs[i].triangles.size(); j++)
+         outputTriangles.push_back(jobs[i].triangles[j]);
    }
 
-
    // Make sure we have output data
    if(outputTriangles.size() == 0)
       return false;
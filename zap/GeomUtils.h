@@ -90,6 +90,15 @@ bool polygonIntersectsSegment(const Vector<Point> &points, const Point &start, c
 bool polygonIntersectsSegmentDetailed(const Point *poly, U32 vertexCount, bool format, const Point &start, const Point &end, float &collisionTime, Point &normal);
 bool circleIntersectsSegment(Point center, F32 radius, Point start, Point end, float &collisionTime);
 
+// Plain versions of the polygon tests above.  Where SSE2 is available, the regular versions test four edges at a time
+// and return exactly the same results; these are kept as a reference for testing.
+bool polygonContainsPointScalar(const Point *vertices, S32 vertexCount, const Point &point);
+bool polygonCircleIntersectScalar(const Point *inVertices, int inNumVertices, const Point &inCenter, F32 inRadiusSq, Point &outPoint, Point *ignoreVelocityEpsilon = NULL);
+bool PolygonSweptCircleIntersectScalar(const Point *inVertices, int inNumVertices, const Point &inBegin, const Point &inDelta, F32 inRadius, Point &outPoint, F32 &outFraction);
+bool polygonsIntersectScalar(const Vector<Point> &p1, const Vector<Point> &p2);
+bool polygonIntersectsSegmentScalar(const Vector<Point> &points, const Point &start, const Point &end);
+bool polygonIntersectsSegmentDetailedScalar(const Point *poly, U32 vertexCount, bool format, const Point &start, const Point &end, float &collisionTime, Point &normal);
+
 Point mean2d(const Vector<Point> &polyPoints);
 Point findCentroid(const Vector<Point> &polyPoints);
 F32 area(const Vector<Point> &polyPoints);
@@ -114,8 +123,8 @@ S32 findClosestPoint(const Point &point, const Vector<Point> &points);
 
 // Offset a complex polygon by a given amount
 void offsetPolygon(const Vector<Point> *inputPoly, Vector<Point> &outputPoly, const F32 offset, JoinType joinType = JoinType::jtSquare);
-void offsetPolygons(Vector<const Vector<Point> *> &inputPolys, Vector<Vector<Point> > &outputPolys, const F32 offset, JoinType joinType = JoinType::jtSquare);
-void offsetPolygons(Vector<Vector<Point> > &inputPolys, Vector<Vector<Point> > &outputPolys, const F32 offset, JoinType joinType = JoinType::jtSquare);
+void offsetPolygons(const Vector<const Vector<Point> *> &inputPolys, Vector<Vector<Point> > &outputPolys, const F32 offset, JoinType joinType = JoinType::jtSquare);
+void offsetPolygons(const Vector<Vector<Point> > &inputPolys, Vector<Vector<Point> > &outputPolys, const F32 offset, JoinType joinType = JoinType::jtSquare);
 
 // Convert a list of floats into a list of points, removing all collinear points
 Vector<Point> floatsToPoints(const Vector<F32> floats);
@@ -132,6 +141,23 @@ bool clipPolygonsAsTree(ClipType operation, const Vector<Vector<Point> > &subjec
 bool triangulate(const Vector<Vector<Point> > &input, Vector<Vector<Point> > &result);
 bool polyganize(const Vector<Vector<Point> > &input, Vector<Vector<Point> > &result);
 
+// Batch versions of the above: each group is processed independently on the WorkerPool, with results in the matching
+// slot of the output.  These are all safe to call from any thread.  Those that return bool fail if any group fails.
+bool mergePolysBatch(const Vector<Vector<const Vector<Point> *> > &inputGroups, Vector<Vector<Vector<Point> > > &outputGroups);
+void offsetPolygonsBatch(const Vector<Vector<Vector<Point> > > &inputGroups, Vector<Vector<Vector<Point> > > &outputGroups,
+      const F32 offset, JoinType joinType = JoinType::jtSquare);
+bool clipPolygonsBatch(ClipType operation, const Vector<Vector<Vector<Point> > > &subjectGroups,
+      const Vector<Vector<Vector<Point> > > &clipGroups, Vector<Vector<Vector<Point> > > &resultGroups,
+      bool merge, bool forceTriangulate = false);
+bool triangulateBatch(const Vector<Vector<Vector<Point> > > &inputGroups, Vector<Vector<Vector<Point> > > &outputGroups);
+bool polyganizeBatch(const Vector<Vector<Vector<Point> > > &inputGroups, Vector<Vector<Vector<Point> > > &outputGroups);
+
+// Split polygons into groups whose bounding boxes don't touch those of any other group
+void partitionPolygons(const Vector<const Vector<Point> *> &polygons, Vector<Vector<const Vector<Point> *> > &groups);
+
+// Like mergePolys, but merges independent groups of polygons in parallel
+bool mergePolysInGroups(const Vector<const Vector<Point> *> &inputPolygons, Vector<Vector<Point> > &outputPolygons);
+
 void trianglesToPolygons(const Vector<Point> &triangles, Vector<Vector<Point> > &result);
 void polyMeshToPolygons(const rcPolyMesh &mesh, Vector<Vector<Point> > &result);
 
@@ -0,0 +1,257 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LevelIndex.h"
+
+#include "WorkerPool.h"
+#include "stringUtils.h"
+
+#include "tnlLog.h"
+
+#include <stdio.h>
+
+namespace Zap
+{
+
+const char *LevelIndex::DefaultFilename = "levelindex.txt";
+
+// First line of the file; if it doesn't match, we ignore the file and start over
+static const char *IndexFileHeader = "# Bitfighter level index, version 1";
+
+
+// Constructor
+LevelIndex::LevelIndex(const string &filename)
+{
+   mFilename = filename;
+   mChanged = false;
+   mScanCount = 0;
+
+   load();
+}
+
+
+// Destructor
+LevelIndex::~LevelIndex()
+{
+   // Do nothing
+}
+
+
+// Each line holds one level: path, size, time, hash, min players, max players, gametype, script and level name,
+// separated by tabs.  None of these can contain tabs or newlines (we don't save the ones that do).
+void LevelIndex::load()
+{
+   if(mFilename == "" || !fileExists(mFilename))
+      return;
+
+   string contents = readFile(mFilename);
+
+   size_t pos = contents.find('\n');
+   if(pos == string::npos || contents.substr(0, pos) != IndexFileHeader)
+   {
+      logprintf(LogConsumer::LogWarning, "Ignoring level index %s; it is damaged or from another version", mFilename.c_str());
+      return;
+   }
+
+   const S32 FieldCount = 9;
+
+   while(pos < contents.size())
+   {
+      size_t lineEnd = contents.find('\n', pos + 1);
+      if(lineEnd == string::npos)
+         lineEnd = contents.size();
+
+      string fields[FieldCount];
+      S32 fieldCount = 0;
+      size_t fieldStart = pos + 1;
+
+      while(fieldCount < FieldCount)
+      {
+         size_t fieldEnd = contents.find('\t', fieldStart);
+         if(fieldEnd == string::npos || fieldEnd > lineEnd || fieldCount == FieldCount - 1)
+            fieldEnd = lineEnd;
+
+         fields[fieldCount++] = contents.substr(fieldStart, fieldEnd - fieldStart);
+
+         if(fieldEnd == lineEnd)
+            break;
+
+         fieldStart = fieldEnd + 1;
+      }
+
+      pos = lineEnd;
+
+      if(fieldCount != FieldCount)
+         continue;
+
+      Entry &entry = mEntries[fields[0]];
+
+      entry.size     = strtoull(fields[1].c_str(), NULL, 10);
+      entry.modTime  = strtoull(fields[2].c_str(), NULL, 10);
+      entry.hash     = fields[3];
+      entry.header.minPlayers     = atoi(fields[4].c_str());
+      entry.header.maxPlayers     = atoi(fields[5].c_str());
+      entry.header.gameTypeName   = fields[6];
+      entry.header.scriptFileName = fields[7];
+      entry.header.levelName      = fields[8];
+   }
+}
+
+
+static bool hasLineBreakOrTab(const string &str)
+{
+   return str.find_first_of("\t\r\n") != string::npos;
+}
+
+
+bool LevelIndex::save()
+{
+   if(mFilename == "" || !mChanged)
+      return true;
+
+   FILE *f = fopen(mFilename.c_str(), "wb");    // Binary, so Windows doesn't write \r\n; load() reads the file as is
+   if(!f)
+   {
+      logprintf(LogConsumer::LogWarning, "Could not save level index %s", mFilename.c_str());
+      return false;
+   }
+
+   fprintf(f, "%s\n", IndexFileHeader);
+
+   for(EntryMap::const_iterator it = mEntries.begin(); it != mEntries.end(); it++)
+   {
+      const Entry &entry = it->second;
+
+      if(hasLineBreakOrTab(it->first) || hasLineBreakOrTab(entry.header.gameTypeName) ||
+         hasLineBreakOrTab(entry.header.scriptFileName) || hasLineBreakOrTab(entry.header.levelName))
+         continue;
+
+      fprintf(f, "%s\t%llu\t%llu\t%s\t%d\t%d\t%s\t%s\t%s\n", it->first.c_str(), (unsigned long long)entry.size,
+              (unsigned long long)entry.modTime, entry.hash.c_str(), entry.header.minPlayers, entry.header.maxPlayers,
+              entry.header.gameTypeName.c_str(), entry.header.scriptFileName.c_str(), entry.header.levelName.c_str());
+   }
+
+   fclose(f);
+
+   mChanged = false;
+   return true;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+struct LevelIndexStat
+{
+   const Vector<string> *files;
+   Vector<U8> exists;
+   Vector<U64> sizes;
+   Vector<U64> modTimes;
+};
+
+
+static void statLevelJob(S32 index, void *context)
+{
+   LevelIndexStat *stat = static_cast<LevelIndexStat *>(context);
+   const string &file = stat->files->get(index);
+
+   stat->exists[index] = (file != "" && getFileSizeAndTime(file, stat->sizes[index], stat->modTimes[index]));
+}
+
+
+void LevelIndex::getLevelHeaders(const Vector<string> &files, Vector<LevelHeader> &headers, Vector<U8> &found)
+{
+   S32 count = files.size();
+
+   headers.clear();
+   headers.resize(count);
+   found.clear();
+   found.resize(count);
+
+   // First see which files have changed; this is cheap, but can still add up over a slow disk or network share
+   LevelIndexStat stat;
+   stat.files = &files;
+   stat.exists.resize(count);
+   stat.sizes.resize(count);
+   stat.modTimes.resize(count);
+
+   WorkerPool::get()->run(count, statLevelJob, &stat);
+
+   Vector<string> changedFiles;
+   Vector<S32> changedIndices;
+
+   for(S32 i = 0; i < count; i++)
+   {
+      if(!stat.exists[i])
+      {
+         if(mEntries.erase(files[i]) > 0)
+            mChanged = true;
+
+         continue;
+      }
+
+      EntryMap::const_iterator it = mEntries.find(files[i]);
+      if(it != mEntries.end() && it->second.size == stat.sizes[i] && it->second.modTime == stat.modTimes[i])
+      {
+         headers[i] = it->second.header;
+         found[i] = 1;
+      }
+      else
+      {
+         changedFiles.push_back(files[i]);
+         changedIndices.push_back(i);
+      }
+   }
+
+   // Then read the ones that have
+   Vector<LevelHeader> changedHeaders;
+   Vector<U8> changedFound;
+   Vector<string> hashes;
+   LevelSource::readLevelHeaders(changedFiles, changedHeaders, changedFound, hashes);
+
+   mScanCount = 0;
+
+   for(S32 i = 0; i < changedFiles.size(); i++)
+   {
+      S32 index = changedIndices[i];
+
+      if(!changedFound[i])
+      {
+         if(mEntries.erase(files[index]) > 0)
+            mChanged = true;
+
+         continue;
+      }
+
+      Entry &entry = mEntries[files[index]];
+
+      entry.size = stat.sizes[index];
+      entry.modTime = stat.modTimes[index];
+      entry.hash = hashes[i];
+      entry.header = changedHeaders[i];
+
+      headers[index] = changedHeaders[i];
+      found[index] = 1;
+
+      mChanged = true;
+      mScanCount++;
+   }
+}
+
+
+string LevelIndex::getHash(const string &file) const
+{
+   EntryMap::const_iterator it = mEntries.find(file);
+   return it == mEntries.end() ? "" : it->second.hash;
+}
+
+
+S32 LevelIndex::getScanCount() const
+{
+   return mScanCount;
+}
+
+
+};
@@ -0,0 +1,66 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _LEVEL_INDEX_H_
+#define _LEVEL_INDEX_H_
+
+#include "LevelSource.h"      // For LevelHeader
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+#include <string>
+#include <map>
+
+using namespace std;
+using namespace TNL;
+
+namespace Zap
+{
+
+// Remembers what we found in each level file (see LevelSource::readLevelHeader), along with the file's size, time and
+// hash, and saves it all in the ini folder.  Servers with big level folders can then start up by looking at only the
+// files that are new or have changed since last time, rather than opening every one.
+class LevelIndex
+{
+public:
+   static const char *DefaultFilename;
+
+private:
+   struct Entry
+   {
+      U64 size;
+      U64 modTime;
+      string hash;
+      LevelHeader header;
+   };
+
+   typedef map<string, Entry> EntryMap;
+
+   string mFilename;
+   EntryMap mEntries;         // By full path
+   bool mChanged;             // Do we have anything to save?
+   S32 mScanCount;
+
+   void load();
+
+public:
+   explicit LevelIndex(const string &filename);    // Constructor; pass "" for an index that is never saved
+   virtual ~LevelIndex();                          // Destructor
+
+   // Fills headers with what's in each of the files, reading only those we don't already know about (spread across the
+   // WorkerPool).  found[i] will be 0 if files[i] couldn't be read.
+   void getLevelHeaders(const Vector<string> &files, Vector<LevelHeader> &headers, Vector<U8> &found);
+
+   string getHash(const string &file) const;       // md5 of file as of the last time we read it, or "" if we haven't
+   S32 getScanCount() const;                       // Number of files actually read by the last getLevelHeaders()
+
+   bool save();                                    // Does nothing unless something has changed
+};
+
+
+};
+
+#endif
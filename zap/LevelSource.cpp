@@ -5,15 +5,21 @@
 
 #include "LevelSource.h"
 
+#include "BinaryLevel.h"
 #include "config.h"           // For FolderManager
 #include "gameType.h"
 #include "GameSettings.h"
+#include "LevelIndex.h"
+#include "MappedFile.h"
+#include "WorkerPool.h"
 
 #include "md5wrapper.h"
 #include "stringUtils.h"
 
 #include "tnlAssert.h"
 
+#include <set>
+
 
 namespace Zap
 {
@@ -78,6 +84,17 @@ void LevelInfo::ensureLevelInfoHasValidName()
 }
 
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+LevelHeader::LevelHeader()
+{
+   minPlayers = 0;
+   maxPlayers = 0;
+}
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
@@ -114,9 +131,26 @@ LevelInfo LevelSource::getLevelInfo(S32 index)
 // Parse through the chunk of data passed in and find parameters to populate levelInfo with
 // This is only used on the server to provide quick level information without having to load the level
 // (like with playlists or menus)
-// Warning: Mungs chunk!
-void LevelSource::getLevelInfoFromCodeChunk(char *chunk, S32 size, LevelInfo &levelInfo)
+void LevelSource::getLevelInfoFromCodeChunk(const char *chunk, S32 size, LevelInfo &levelInfo)
 {
+   LevelHeader header;
+   readLevelHeader(chunk, size, header);
+   applyLevelHeader(header, levelInfo);
+
+   levelInfo.ensureLevelInfoHasValidName();
+}
+
+
+// Does the actual work for getLevelInfoFromCodeChunk, but without touching anything that isn't thread-safe
+void LevelSource::readLevelHeader(const char *chunk, S32 size, LevelHeader &header)
+{
+   // Binary levels keep this stuff in their header, so no need to go looking for it
+   if(BinaryLevel::isBinaryLevel(chunk, (U32)size))
+   {
+      BinaryLevel::readLevelHeader(chunk, (U32)size, header);
+      return;
+   }
+
    S32 cur = 0;
    S32 startingCur = 0;
 
@@ -132,24 +166,12 @@ void LevelSource::getLevelInfoFromCodeChunk(char *chunk, S32 size, LevelInfo &le
       {
          if(cur - startingCur > 5)
          {
-            char c = chunk[cur];
-            chunk[cur] = 0;
-            Vector<string> list = parseString(&chunk[startingCur]);
-            chunk[cur] = c;
+            Vector<string> list = parseString(string(&chunk[startingCur], cur - startingCur));
 
             if(list.size() >= 1 && list[0].find("GameType") != string::npos)
             {
-               // validateGameType() will return a valid GameType string -- either what's passed in, or the default if something bogus was specified
-               TNL::Object *theObject = TNL::Object::create(GameType::validateGameType(list[0].c_str()));
-
-               GameType *gt = dynamic_cast<GameType *>(theObject); 
-               if(gt)
-               {
-                  levelInfo.mLevelType = gt->getGameTypeId();
-                  foundGameType = true;
-               }
-
-               delete theObject;
+               header.gameTypeName = list[0];
+               foundGameType = true;
             }
             else if(list.size() >= 2 && list[0] == "LevelName")
             {
@@ -159,23 +181,23 @@ void LevelSource::getLevelInfoFromCodeChunk(char *chunk, S32 size, LevelInfo &le
                for(S32 i = 2; i < list.size(); i++)   
                   levelName += " " + list[i];
 
-               levelInfo.mLevelName = levelName;
+               header.levelName = levelName;
 
                foundLevelName = true;
             }
             else if(list.size() >= 2 && list[0] == "MinPlayers")
             {
-               levelInfo.minRecPlayers = atoi(list[1].c_str());
+               header.minPlayers = atoi(list[1].c_str());
                foundMinPlayers = true;
             }
             else if(list.size() >= 2 && list[0] == "MaxPlayers")
             {
-               levelInfo.maxRecPlayers = atoi(list[1].c_str());
+               header.maxPlayers = atoi(list[1].c_str());
                foundMaxPlayers = true;
             }
             else if(list.size() >= 2 && list[0] == "Script")
             {
-               levelInfo.mScriptFileName = list[1];
+               header.scriptFileName = list[1];
                foundScriptFileName = true;
             }
          }
@@ -183,8 +205,96 @@ void LevelSource::getLevelInfoFromCodeChunk(char *chunk, S32 size, LevelInfo &le
       }
       cur++;
    }
+}
 
-   levelInfo.ensureLevelInfoHasValidName();
+
+// Only this much of a level is searched for its header; the fields we want are normally on the first few lines
+static const U32 HeaderChunkSize = 1024 * 4;
+
+// Reading levels is mostly waiting on the disk, and having more than a few reads going at once just makes it seek more
+static const S32 MaxConcurrentLevelReads = 4;
+
+struct LevelHeaderScan
+{
+   const Vector<string> *files;
+   Vector<LevelHeader> *headers;
+   Vector<U8> *found;
+   Vector<string> *hashes;
+};
+
+
+static void readLevelHeaderJob(S32 index, void *context)
+{
+   LevelHeaderScan *scan = static_cast<LevelHeaderScan *>(context);
+   const string &file = scan->files->get(index);
+
+   if(file == "")
+      return;
+
+   // We need the hash, so we have to read the whole thing anyway
+   MappedFile mappedFile(file);
+   if(!mappedFile.isOpen())
+      return;
+
+   // Binary levels are known by the hash of the text they were made from, which is what loading them reports
+   if(BinaryLevel::isBinaryLevel(mappedFile.getData(), mappedFile.getSize()))
+      scan->hashes->get(index) = BinaryLevelReader(mappedFile.getData(), mappedFile.getSize()).getHash();
+   else
+   {
+      md5stream hash;
+      hash.process(mappedFile.getData(), mappedFile.getSize());
+      scan->hashes->get(index) = hash.getHash();
+   }
+
+   LevelSource::readLevelHeader(mappedFile.getData(), (S32)min(mappedFile.getSize(), HeaderChunkSize),
+                                scan->headers->get(index));
+
+   scan->found->get(index) = 1;
+}
+
+
+// Reads the headers and md5s of a bunch of levels, several at a time.  Results come back in the same order as files,
+// and found[i] will be 0 if files[i] couldn't be read.
+void LevelSource::readLevelHeaders(const Vector<string> &files, Vector<LevelHeader> &headers, Vector<U8> &found,
+                                   Vector<string> &hashes)
+{
+   headers.clear();
+   headers.resize(files.size());
+   found.clear();
+   found.resize(files.size());
+   hashes.clear();
+   hashes.resize(files.size());
+
+   LevelHeaderScan scan;
+   scan.files = &files;
+   scan.headers = &headers;
+   scan.found = &found;
+   scan.hashes = &hashes;
+
+   WorkerPool::get()->run(files.size(), readLevelHeaderJob, &scan, MaxConcurrentLevelReads);
+}
+
+
+void LevelSource::applyLevelHeader(const LevelHeader &header, LevelInfo &levelInfo)
+{
+   if(header.gameTypeName != "")
+   {
+      // validateGameType() will return a valid GameType string -- either what's passed in, or the default if something bogus was specified
+      TNL::Object *theObject = TNL::Object::create(GameType::validateGameType(header.gameTypeName.c_str()));
+
+      GameType *gt = dynamic_cast<GameType *>(theObject); 
+      if(gt)
+         levelInfo.mLevelType = gt->getGameTypeId();
+
+      delete theObject;
+   }
+
+   if(header.levelName != "")
+      levelInfo.mLevelName = header.levelName;
+
+   levelInfo.minRecPlayers = header.minPlayers;
+   levelInfo.maxRecPlayers = header.maxPlayers;
+   levelInfo.mScriptFileName = header.scriptFileName;
 }
 
 
@@ -242,13 +352,21 @@ void LevelSource::remove(S32 index)
    mLevelInfos.erase(index);
 }
 
+// Like alphaSort, but names that differ only in case still come out in the same order every time
+static bool levelFileSort(const string &a, const string &b)
+{
+   S32 cmp = stricmp(a.c_str(), b.c_str());
+   return cmp != 0 ? cmp < 0 : a < b;
+}
+
+
 // static method
 Vector<string> LevelSource::findAllLevelFilesInFolder(const string &levelDir)
 {
    Vector<string> levelList;
 
    // Build our level list by looking at the filesystem 
-   const string extList[] = {"level"};
+   const string extList[] = {"level", BinaryLevel::Extension};
 
    if(!getFilesFromFolder(levelDir, levelList, extList, ARRAYSIZE(extList)))    // Returns true if error 
    {
@@ -256,7 +374,18 @@ Vector<string> LevelSource::findAllLevelFilesInFolder(const string &levelDir)
       return levelList;   
    }
 
-   levelList.sort(alphaSort);   // Just to be sure...
+   // A converted level usually sits next to the text version it came from; only use the faster-loading binary one
+   set<string> binaryLevels;
+
+   for(S32 i = 0; i < levelList.size(); i++)
+      if(extractExtension(levelList[i]) == BinaryLevel::Extension)
+         binaryLevels.insert(stripExtension(levelList[i]));
+
+   for(S32 i = 0; i < levelList.size(); i++)
+      if(extractExtension(levelList[i]) != BinaryLevel::Extension && binaryLevels.count(stripExtension(levelList[i])))
+         levelList.erase(i--);
+
+   levelList.sort(levelFileSort);   // Directory order varies from system to system, and from run to run
    return levelList;
 }
 
@@ -274,19 +403,31 @@ bool LevelSource::loadLevels(FolderManager *folderManager)
 }
 
 
+string LevelSource::getLevelHash(S32 index)
+{
+   return "";
+}
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
 
 MultiLevelSource::MultiLevelSource()
 {
-   // Do nothing
+   // No FolderManager means we're running tests; keep the index in memory
+   FolderManager *folderManager = GameSettings::getFolderManager();
+   string indexFile = (folderManager && folderManager->iniDir != "") ?
+                      joindir(folderManager->iniDir, LevelIndex::DefaultFilename) : "";
+
+   mLevelIndex = new LevelIndex(indexFile);     // Deleted in destructor
+   mPrefetched = false;
 }
 
 
 MultiLevelSource::~MultiLevelSource()
 {
-   // Do nothing
+   delete mLevelIndex;
 }
 
 
@@ -297,7 +438,7 @@ bool MultiLevelSource::loadLevels(FolderManager *folderManager)
 
    for(S32 i = 0; i < mLevelInfos.size(); i++)
    {
-      string filename = folderManager->findLevelFile(mLevelInfos[i].folder, mLevelInfos[i].filename);
+      string filename = findLevelFile(i);
 
       if(Parent::populateLevelInfoFromSource(filename, i))
          anyLoaded = true;
@@ -319,7 +460,7 @@ string MultiLevelSource::loadLevel(S32 index, Game *game, GridDatabase *gameObje
 
    LevelInfo *levelInfo = &mLevelInfos[index];
 
-   string filename = FolderManager::findLevelFile(levelInfo->folder, levelInfo->filename);
+   string filename = findLevelFile(index);
 
    if(filename == "")
    {
@@ -327,8 +468,10 @@ string MultiLevelSource::loadLevel(S32 index, Game *game, GridDatabase *gameObje
       return "";
    }
 
-   if(game->loadLevelFromFile(filename, gameObjectDatabase))
-      return Game::md5.getHashFromFile(filename);    // TODO: Combine this with the reading of the file we're doing anyway in initLevelFromFile()
+   string hash;
+
+   if(game->loadLevelFromFile(filename, gameObjectDatabase, &hash))
+      return hash;
    else
    {
       logprintf("Unable to process level file \"%s\".  Skipping...", levelInfo->filename.c_str());
@@ -337,6 +480,27 @@ string MultiLevelSource::loadLevel(S32 index, Game *game, GridDatabase *gameObje
 }
 
 
+string MultiLevelSource::findLevelFile(S32 index) const
+{
+   return FolderManager::findLevelFile(mLevelInfos[index].folder, mLevelInfos[index].filename);
+}
+
+
+// The level index has the hash of every level we've looked at; it only needs to look at the file again if it has changed
+string MultiLevelSource::getLevelHash(S32 index)
+{
+   Vector<string> files;
+   Vector<LevelHeader> headers;
+   Vector<U8> found;
+
+   files.push_back(findLevelFile(index));
+   mLevelIndex->getLevelHeaders(files, headers, found);
+   mLevelIndex->save();
+
+   return found[0] ? mLevelIndex->getHash(files[0]) : "";
+}
+
+
 // Returns a textual level descriptor good for logging and error messages and such
 string MultiLevelSource::getLevelFileDescriptor(S32 index) const
 {
@@ -344,29 +508,89 @@ string MultiLevelSource::getLevelFileDescriptor(S32 index) const
 }
 
 
+struct LevelFileSearch
+{
+   const MultiLevelSource *levelSource;
+   Vector<string> files;
+};
+
+
+static void findLevelFileJob(S32 index, void *context)
+{
+   LevelFileSearch *search = static_cast<LevelFileSearch *>(context);
+   search->files[index] = search->levelSource->findLevelFile(index);
+}
+
+
+// Gets the headers of all our levels in one go, so files can be read in parallel, and those that haven't changed since
+// the last time we ran can be skipped altogether
+void MultiLevelSource::prefetchLevelHeaders()
+{
+   if(mPrefetched)
+      return;
+
+   mPrefetched = true;
+
+   // Finding each file can take a few tries with different extensions, so spread that out too
+   LevelFileSearch search;
+   search.levelSource = this;
+   search.files.resize(mLevelInfos.size());
+
+   WorkerPool::get()->run(mLevelInfos.size(), findLevelFileJob, &search);
+
+   const Vector<string> &files = search.files;
+
+   Vector<LevelHeader> headers;
+   Vector<U8> found;
+   mLevelIndex->getLevelHeaders(files, headers, found);
+
+   for(S32 i = 0; i < files.size(); i++)
+      if(found[i])
+         mPrefetchedHeaders[files[i]] = headers[i];
+
+   mLevelIndex->save();
+}
+
+
 // Populates levelInfo with data from fullFilename -- returns true if successful, false otherwise
-// Reads 4kb of file and uses what it finds there to populate the levelInfo
+// Uses the first 4kb of the file, as found by prefetchLevelHeaders() or the level index
 bool MultiLevelSource::populateLevelInfoFromSource(const string &fullFilename, LevelInfo &levelInfo)
 {
-   FILE *f = fopen(fullFilename.c_str(), "rb");
-   if(f)
-   {
-      char data[1024 * 4];  // 4 kb should be enough to fit all parameters at the beginning of level; we don't need to read everything
-      S32 size = (S32)fread(data, 1, sizeof(data), f);
-      fclose(f);
+   prefetchLevelHeaders();
 
-       getLevelInfoFromCodeChunk(data, size, levelInfo);     // Fills levelInfo with data from file
+   LevelHeader header;
 
-      levelInfo.ensureLevelInfoHasValidName();
+   map<string, LevelHeader>::iterator it = mPrefetchedHeaders.find(fullFilename);
 
-      return true;
+   if(it != mPrefetchedHeaders.end())
+   {
+      header = it->second;
+      mPrefetchedHeaders.erase(it);    // If we're asked again, the file may have changed, so go back to the index
    }
    else
    {
-      logprintf(LogConsumer::LogWarning, "Could not load level %s [%s]... Skipping...",
-                                          levelInfo.filename.c_str(), fullFilename.c_str());
-      return false;
+      Vector<string> files;
+      Vector<LevelHeader> headers;
+      Vector<U8> found;
+
+      files.push_back(fullFilename);
+      mLevelIndex->getLevelHeaders(files, headers, found);
+      mLevelIndex->save();
+
+      if(!found[0])
+      {
+         logprintf(LogConsumer::LogWarning, "Could not load level %s [%s]... Skipping...",
+                                             levelInfo.filename.c_str(), fullFilename.c_str());
+         return false;
+      }
+
+      header = headers[0];
    }
+
+   applyLevelHeader(header, levelInfo);     // Fills levelInfo with data from file
+   levelInfo.ensureLevelInfoHasValidName();
+
+   return true;
 }
 
 
@@ -413,28 +637,10 @@ FileListLevelSource::~FileListLevelSource()
 }
 
 
-// Load specified level, put results in gameObjectDatabase.  Return md5 hash of level.
-string FileListLevelSource::loadLevel(S32 index, Game *game, GridDatabase *gameObjectDatabase)
+// Playlists always refer to levels in the level folder
+string FileListLevelSource::findLevelFile(S32 index) const
 {
-   TNLAssert(index >= 0 && index < mLevelInfos.size(), "Index out of bounds!");
-
-   LevelInfo *levelInfo = &mLevelInfos[index];
-
-   string filename = FolderManager::findLevelFile(GameSettings::getFolderManager()->levelDir, levelInfo->filename);
-
-   if(filename == "")
-   {
-      logprintf("Unable to find level file \"%s\".  Skipping...", levelInfo->filename.c_str());
-      return "";
-   }
-
-   if(game->loadLevelFromFile(filename, gameObjectDatabase))
-      return Game::md5.getHashFromFile(filename);   
-   else
-   {
-      logprintf("Unable to process level file \"%s\".  Skipping...", levelInfo->filename.c_str());
-      return "";
-   }
+   return FolderManager::findLevelFile(GameSettings::getFolderManager()->levelDir, mLevelInfos[index].filename);
 }
 
 
@@ -503,6 +709,12 @@ string StringLevelSource::loadLevel(S32 index, Game *game, GridDatabase *gameObj
 }
 
 
+string StringLevelSource::getLevelHash(S32 index)
+{
+   return Game::md5.getHashFromString(mLevelCode);
+}
+
+
 // Returns a textual level descriptor good for logging and error messages and such
 string StringLevelSource::getLevelFileDescriptor(S32 index) const
 {
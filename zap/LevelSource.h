@@ -14,6 +14,7 @@
 
 #include <string>
 #include <memory>
+#include <map>
 
 using namespace TNL;
 using namespace std;
@@ -51,6 +52,23 @@ public:
 };
 
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+// The handful of parameters we pick out of a level without loading it.  Unlike LevelInfo, this is plain data (no
+// StringTableEntries), so it can be filled in on a worker thread, and stored in the level index.
+struct LevelHeader
+{
+   string levelName;                // Empty if the level didn't specify one
+   string gameTypeName;             // First word of the GameType line, e.g. "CTFGameType"; empty if there wasn't one
+   S32 minPlayers;
+   S32 maxPlayers;
+   string scriptFileName;
+
+   LevelHeader();                   // Constructor
+};
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
@@ -90,10 +108,18 @@ public:
    virtual string getLevelFileDescriptor(S32 index) const = 0;
    virtual bool isEmptyLevelDirOk() const = 0;
 
+   // md5 of the level, if it can be found without loading the level; "" otherwise
+   virtual string getLevelHash(S32 index);
+
    bool populateLevelInfoFromSource(const string &sourceName, S32 levelInfoIndex);
 
    static Vector<string> findAllLevelFilesInFolder(const string &levelDir);
-   static void getLevelInfoFromCodeChunk(char *chunk, S32 size, LevelInfo &levelInfo);     // Populates levelInfo
+   static void getLevelInfoFromCodeChunk(const char *chunk, S32 size, LevelInfo &levelInfo);     // Populates levelInfo
+
+   static void readLevelHeader(const char *chunk, S32 size, LevelHeader &header);   // Thread-safe
+   static void readLevelHeaders(const Vector<string> &files, Vector<LevelHeader> &headers, Vector<U8> &found,
+                                Vector<string> &hashes);
+   static void applyLevelHeader(const LevelHeader &header, LevelInfo &levelInfo);
 };
 
 
@@ -101,18 +127,30 @@ public:
 ////////////////////////////////////////
 
 
+class LevelIndex;
+
 class MultiLevelSource : public LevelSource
 {
    typedef LevelSource Parent;
 
+private:
+   LevelIndex *mLevelIndex;
+   bool mPrefetched;
+   map<string, LevelHeader> mPrefetchedHeaders;    // By full filename; entries are removed as they're used
+
+   void prefetchLevelHeaders();
+
 public:
    MultiLevelSource();              // Constructor
    virtual ~MultiLevelSource();     // Destructor
 
+   virtual string findLevelFile(S32 index) const;     // Full path of the level's file, or "" if it can't be found; thread-safe
+
    bool loadLevels(FolderManager *folderManager);
    string loadLevel(S32 index, Game *game, GridDatabase *gameObjDatabase);
    string getLevelFileDescriptor(S32 index) const;
    bool isEmptyLevelDirOk() const;
+   string getLevelHash(S32 index);
 
    bool populateLevelInfoFromSource(const string &fullFilename, LevelInfo &levelInfo);
 };
@@ -148,7 +186,7 @@ public:
    FileListLevelSource(const Vector<string> &levelList, const string &folder);     // Constructor
    virtual ~FileListLevelSource();                                                                                                                // Destructor
 
-   string loadLevel(S32 index, Game *game, GridDatabase *gameObjDatabase);
+   string findLevelFile(S32 index) const;
 
    static Vector<string> findAllFilesInPlaylist(const string &fileName, const string &levelDir);
 };
@@ -173,6 +211,7 @@ public:
    string loadLevel(S32 index, Game *game, GridDatabase *gameObjDatabase);
    string getLevelFileDescriptor(S32 index) const;
    bool isEmptyLevelDirOk() const;
+   string getLevelHash(S32 index);
 
    bool populateLevelInfoFromSource(const string &fullFilename, LevelInfo &levelInfo);
 };
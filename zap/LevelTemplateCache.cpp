@@ -0,0 +1,234 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LevelTemplateCache.h"
+
+#include "BotNavMeshZone.h"
+#include "game.h"
+#include "gameType.h"
+
+namespace Zap
+{
+
+static U32 getPointBytes(const Vector<Point> *points)
+{
+   return points ? points->size() * sizeof(Point) : 0;
+}
+
+
+// Constructor
+LevelTemplate::LevelTemplate()
+{
+   mBotZonesBuilt = false;
+   mSize = sizeof(LevelTemplate);
+   mLastUsed = 0;
+}
+
+
+// Destructor
+LevelTemplate::~LevelTemplate()
+{
+   mBarriers.deleteAndClear();
+   mBotZones.deleteAndClear();
+}
+
+
+void LevelTemplate::addBarrier(const Barrier *barrier)
+{
+   mBarriers.push_back(barrier->clone());
+
+   mSize += sizeof(Barrier) + getPointBytes(&barrier->mPoints) + getPointBytes(&barrier->mOutline) +
+            getPointBytes(&barrier->mRenderFillGeometry) + getPointBytes(barrier->getOutline());
+}
+
+
+void LevelTemplate::addWallLine(const WallRec *wallRec)
+{
+   WallLine wallLine;
+   wallLine.wallRecIndex = -1;
+   wallLine.barrierEnd = mBarriers.size();
+
+   if(wallRec)
+   {
+      wallLine.wallRecIndex = mWallRecs.size();
+      mWallRecs.push_back(*wallRec);
+
+      mSize += sizeof(WallRec) + wallRec->verts.size() * sizeof(F32);
+   }
+
+   mWallLines.push_back(wallLine);
+   mSize += sizeof(WallLine);
+}
+
+
+void LevelTemplate::setBotZones(const Vector<BotNavMeshZone *> &zones, bool built)
+{
+   mBotZones.deleteAndClear();
+   mBotZonesBuilt = built;
+
+   // Visibility sets use a bit for each zone
+   U32 visibilityBytes = ((zones.size() + 31) / 32) * sizeof(U32);
+
+   for(S32 i = 0; i < zones.size(); i++)
+   {
+      mBotZones.push_back(zones[i]->clone());
+
+      mSize += sizeof(BotNavMeshZone) + getPointBytes(zones[i]->getOutline()) + getPointBytes(zones[i]->getFill()) +
+               zones[i]->mNeighbors.size() * sizeof(NeighboringZone) + visibilityBytes;
+   }
+}
+
+
+S32 LevelTemplate::getWallLineCount() const
+{
+   return mWallLines.size();
+}
+
+
+// Does what processing the index'th wall line of the level did, but with walls we've already built
+void LevelTemplate::addWallLineToGame(S32 index, Game *game) const
+{
+   TNLAssert(index >= 0 && index < mWallLines.size(), "Index out of bounds!");
+
+   const WallLine &wallLine = mWallLines[index];
+
+   if(wallLine.wallRecIndex >= 0)
+      game->getGameType()->addPrebuiltWall(mWallRecs[wallLine.wallRecIndex]);
+
+   S32 barrierStart = index == 0 ? 0 : mWallLines[index - 1].barrierEnd;
+
+   for(S32 i = barrierStart; i < wallLine.barrierEnd; i++)
+      mBarriers[i]->clone()->addToGame(game, game->getGameObjDatabase());
+}
+
+
+// Does what BotNavMeshZone::buildBotMeshZones() did, and returns what it returned
+bool LevelTemplate::addBotZonesToDatabase(GridDatabase *botZoneDatabase, Vector<BotNavMeshZone *> *allZones) const
+{
+   allZones->deleteAndClear();      // Also removes them from botZoneDatabase
+
+   allZones->resize(mBotZones.size());
+
+   for(S32 i = 0; i < mBotZones.size(); i++)
+   {
+      BotNavMeshZone *zone = mBotZones[i]->clone();
+      zone->addToZoneDatabase(botZoneDatabase);
+
+      allZones->get(i) = zone;
+   }
+
+   return mBotZonesBuilt;
+}
+
+
+U32 LevelTemplate::getSize() const
+{
+   return mSize;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+LevelTemplateCache::LevelTemplateCache(U32 budget)
+{
+   mBudget = budget;
+   mSize = 0;
+   mUseCounter = 0;
+}
+
+
+// Destructor
+LevelTemplateCache::~LevelTemplateCache()
+{
+   for(TemplateMap::iterator it = mTemplates.begin(); it != mTemplates.end(); it++)
+      delete it->second;
+}
+
+
+LevelTemplate *LevelTemplateCache::find(const string &hash)
+{
+   TemplateMap::iterator it = mTemplates.find(hash);
+
+   if(it == mTemplates.end())
+      return NULL;
+
+   it->second->mLastUsed = ++mUseCounter;
+   return it->second;
+}
+
+
+void LevelTemplateCache::add(const string &hash, LevelTemplate *levelTemplate)
+{
+   remove(hash);
+
+   // Don't bother if it would push everything else out, or if we don't know what level it's for
+   if(hash == "" || levelTemplate->getSize() > mBudget / 2)
+   {
+      delete levelTemplate;
+      return;
+   }
+
+   levelTemplate->mLastUsed = ++mUseCounter;
+
+   mTemplates[hash] = levelTemplate;
+   mSize += levelTemplate->getSize();
+
+   trim();
+}
+
+
+void LevelTemplateCache::remove(const string &hash)
+{
+   TemplateMap::iterator it = mTemplates.find(hash);
+
+   if(it == mTemplates.end())
+      return;
+
+   mSize -= it->second->getSize();
+   delete it->second;
+   mTemplates.erase(it);
+}
+
+
+// Drop least recently used templates until we're within budget
+void LevelTemplateCache::trim()
+{
+   while(mSize > mBudget && !mTemplates.empty())
+   {
+      TemplateMap::iterator oldest = mTemplates.begin();
+
+      for(TemplateMap::iterator it = mTemplates.begin(); it != mTemplates.end(); it++)
+         if(it->second->mLastUsed < oldest->second->mLastUsed)
+            oldest = it;
+
+      mSize -= oldest->second->getSize();
+      delete oldest->second;
+      mTemplates.erase(oldest);
+   }
+}
+
+
+void LevelTemplateCache::setBudget(U32 budget)
+{
+   mBudget = budget;
+   trim();
+}
+
+
+U32 LevelTemplateCache::getSize() const
+{
+   return mSize;
+}
+
+
+S32 LevelTemplateCache::getTemplateCount() const
+{
+   return (S32)mTemplates.size();
+}
+
+
+};
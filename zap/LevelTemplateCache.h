@@ -0,0 +1,106 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _LEVEL_TEMPLATE_CACHE_H_
+#define _LEVEL_TEMPLATE_CACHE_H_
+
+#include "barrier.h"          // For WallRec
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+#include <string>
+#include <map>
+
+using namespace std;
+using namespace TNL;
+
+namespace Zap
+{
+
+class BotNavMeshZone;
+class Game;
+class GridDatabase;
+
+// The walls and bot zones built for a level the last time it was played.  Building these is most of the work of
+// loading a level, and they come out the same every time for a given level file (as long as no levelgen gets a say),
+// so we keep copies of them around, and clone the copies into the game the next time the same level comes up.
+//
+// Walls are kept by level line, so they can be put back in exactly the order they were built, and anything that mounts
+// on them finds the same walls it would have found otherwise.
+class LevelTemplate
+{
+private:
+   struct WallLine
+   {
+      S32 wallRecIndex;       // Into mWallRecs, or -1 if the line didn't produce a wall
+      S32 barrierEnd;         // One past the last of this line's barriers in mBarriers; first is previous line's end
+   };
+
+   Vector<WallLine> mWallLines;
+   Vector<WallRec> mWallRecs;
+   Vector<Barrier *> mBarriers;
+
+   Vector<BotNavMeshZone *> mBotZones;
+   bool mBotZonesBuilt;       // False if zone building failed, which will happen again if we try
+
+   U32 mSize;                 // Rough number of bytes used by all the above
+   U32 mLastUsed;             // For finding the least recently used template
+
+   friend class LevelTemplateCache;
+
+public:
+   LevelTemplate();           // Constructor
+   virtual ~LevelTemplate();  // Destructor
+
+   // Recording, as the level is loaded
+   void addBarrier(const Barrier *barrier);
+   void addWallLine(const WallRec *wallRec);    // Call after each wall line is processed; wallRec may be NULL
+   void setBotZones(const Vector<BotNavMeshZone *> &zones, bool built);
+
+   // Playback
+   S32 getWallLineCount() const;
+   void addWallLineToGame(S32 index, Game *game) const;
+   bool addBotZonesToDatabase(GridDatabase *botZoneDatabase, Vector<BotNavMeshZone *> *allZones) const;
+
+   U32 getSize() const;
+};
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Holds on to LevelTemplates by level hash, throwing out the least recently used ones when we go over budget
+class LevelTemplateCache
+{
+private:
+   typedef map<string, LevelTemplate *> TemplateMap;
+
+   TemplateMap mTemplates;
+   U32 mBudget;               // In bytes; 0 means don't keep anything
+   U32 mSize;
+   U32 mUseCounter;
+
+   void trim();
+
+public:
+   explicit LevelTemplateCache(U32 budget);     // Constructor
+   virtual ~LevelTemplateCache();               // Destructor
+
+   LevelTemplate *find(const string &hash);     // Returns NULL if we don't have it
+
+   // Takes ownership of levelTemplate, which may get deleted right away if it doesn't fit
+   void add(const string &hash, LevelTemplate *levelTemplate);
+   void remove(const string &hash);
+
+   void setBudget(U32 budget);
+   U32 getSize() const;
+   S32 getTemplateCount() const;
+};
+
+
+};
+
+#endif
@@ -0,0 +1,217 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LevelValidationThread.h"
+
+#include "BfObject.h"
+#include "UIEditor.h"
+#include "gameType.h"
+#include "gridDB.h"
+
+namespace Zap
+{
+
+static const U8 CheckedTypes[] = {
+   ShipSpawnTypeNumber, SoccerBallItemTypeNumber, NexusTypeNumber, FlagTypeNumber, FlagSpawnTypeNumber, CoreTypeNumber
+};
+
+
+static bool TeamListToString(string &output, Vector<bool> teamVector)
+{
+   string teamList;
+   bool hasError = false;
+   char buf[16];
+
+   // Make sure each team has a spawn point
+   for(S32 i = 0; i < (S32)teamVector.size(); i++)
+      if(!teamVector[i])
+      {
+         dSprintf(buf, sizeof(buf), "%d", i+1);
+
+         if(!hasError)     // This is our first error
+         {
+            output = "team ";
+            teamList = buf;
+         }
+         else
+         {
+            output = "teams ";
+            teamList += ", ";
+            teamList += buf;
+         }
+         hasError = true;
+      }
+   if(hasError)
+   {
+      output += teamList;
+      return true;
+   }
+   return false;
+}
+
+
+// Constructor -- runs on the main thread
+LevelValidationThread::LevelValidationThread(EditorUserInterface *editor, U32 generation, const GameType *gameType, S32 teamCount,
+                                             const GridDatabase *database)
+{
+   mEditor = editor;
+   mGeneration = generation;
+
+   mGameTypeId = gameType->getGameTypeId();
+   mIsFlagGame = gameType->isFlagGame();
+   mHasLevelGen = gameType->getScriptName() != "";
+   mTeamCount = teamCount;
+
+   for(U32 i = 0; i < ARRAYSIZE(CheckedTypes); i++)
+   {
+      const Vector<DatabaseObject *> *objects = database->findObjects_fast(CheckedTypes[i]);
+
+      for(S32 j = 0; j < objects->size(); j++)
+      {
+         ItemInfo item;
+         item.typeNumber = CheckedTypes[i];
+         item.team = static_cast<BfObject *>(objects->get(j))->getTeam();
+
+         mItems.push_back(item);
+      }
+   }
+}
+
+
+// Destructor
+LevelValidationThread::~LevelValidationThread()
+{
+   // Do nothing
+}
+
+
+// Runs on the validation thread; only touches our own snapshot
+void LevelValidationThread::run()
+{
+   bool foundNeutralSpawn = false;
+   bool foundSoccerBall = false;
+   bool foundNexus = false;
+   bool foundFlags = false;
+   bool foundTeamFlags = false;
+   bool foundTeamFlagSpawns = false;
+
+   Vector<bool> foundSpawn;
+   Vector<bool> foundCore;
+
+   string teamList;
+
+   // First, catalog items in level
+   foundSpawn.resize(mTeamCount);
+   foundCore.resize(mTeamCount);
+
+   for(S32 i = 0; i < mTeamCount; i++)      // Initialize vectors
+   {
+      foundSpawn[i] = false;
+      foundCore[i] = false;
+   }
+
+   for(S32 i = 0; i < mItems.size(); i++)
+   {
+      const S32 team = mItems[i].team;
+
+      switch(mItems[i].typeNumber)
+      {
+         case ShipSpawnTypeNumber:
+            if(team == TEAM_NEUTRAL)
+               foundNeutralSpawn = true;
+            else if(team > TEAM_NEUTRAL && team < mTeamCount)
+               foundSpawn[team] = true;
+            break;
+
+         case SoccerBallItemTypeNumber:
+            foundSoccerBall = true;
+            break;
+
+         case NexusTypeNumber:
+            foundNexus = true;
+            break;
+
+         case FlagTypeNumber:
+            foundFlags = true;
+            if(team > TEAM_NEUTRAL)
+               foundTeamFlags = true;
+            break;
+
+         case FlagSpawnTypeNumber:
+            if(team >= 0)
+               foundTeamFlagSpawns = true;
+            break;
+
+         case CoreTypeNumber:
+            if(U32(team) < U32(foundCore.size()))
+               foundCore[team] = true;
+            break;
+      }
+   }
+
+   // "Unversal errors" -- levelgens can't (yet) change gametype
+
+   // Check for soccer ball in a a game other than SoccerGameType. Doesn't crash no more.
+   if(foundSoccerBall && mGameTypeId != SoccerGame)
+      mWarnings.push_back("WARNING: Soccer ball can only be used in soccer game.");
+
+   // Check for the nexus object in a non-hunter game. Does not affect gameplay in non-hunter game.
+   if(foundNexus && mGameTypeId != NexusGame)
+      mWarnings.push_back("WARNING: Nexus object can only be used in Nexus game.");
+
+   // Check for missing nexus object in a hunter game.  This cause mucho dolor!
+   if(!foundNexus && mGameTypeId == NexusGame)
+      mErrors.push_back("ERROR: Nexus game must have a Nexus.");
+
+   if(foundFlags && !mIsFlagGame)
+      mWarnings.push_back("WARNING: This game type does not use flags.");
+
+   // Check for team flag spawns on games with no team flags
+   if(foundTeamFlagSpawns && !foundTeamFlags)
+      mWarnings.push_back("WARNING: Found team flag spawns but no team flags.");
+
+   // Errors that may be corrected by levelgen -- script could add spawns
+   // Neutral spawns work for all; if there's one, then that will satisfy our need for spawns for all teams
+   if(!mHasLevelGen && !foundNeutralSpawn)
+   {
+      if(TeamListToString(teamList, foundSpawn))     // Compose error message
+         mErrors.push_back("ERROR: Need spawn point for " + teamList);
+   }
+
+   if(mGameTypeId == CoreGame)
+   {
+      if(TeamListToString(teamList, foundCore))      // Compose error message
+         mErrors.push_back("ERROR: Need Core for " + teamList);
+   }
+}
+
+
+// Back on the main thread
+void LevelValidationThread::finish()
+{
+   if(mEditor)
+      mEditor->onLevelValidated(*this);
+}
+
+
+U32 LevelValidationThread::getGeneration() const
+{
+   return mGeneration;
+}
+
+
+const Vector<string> &LevelValidationThread::getErrors() const
+{
+   return mErrors;
+}
+
+
+const Vector<string> &LevelValidationThread::getWarnings() const
+{
+   return mWarnings;
+}
+
+
+};
@@ -0,0 +1,67 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _LEVEL_VALIDATION_THREAD_H_
+#define _LEVEL_VALIDATION_THREAD_H_
+
+#include "GameTypesEnum.h"
+#include "../master/DatabaseAccessThread.h"
+
+#include "tnlVector.h"
+
+#include <string>
+
+using namespace std;
+using namespace TNL;
+
+namespace Zap
+{
+
+class EditorUserInterface;
+class GameType;
+class GridDatabase;
+
+// Checks an editor level for problems that will keep it from playing properly.  The constructor takes a snapshot of the
+// few things the checks look at, so run() can work on the editor's validation thread while the user keeps editing.
+// The database keeps lists of the types we check, so the snapshot only costs as much as the number of those items.
+// finish() hands the results back to the editor, which drops them if the level has changed in the meantime.
+class LevelValidationThread : public Master::ThreadEntry
+{
+private:
+   struct ItemInfo
+   {
+      U8 typeNumber;
+      S32 team;
+   };
+
+   EditorUserInterface *mEditor;
+   U32 mGeneration;              // Editor's count of level changes when we took our snapshot
+
+   GameTypeId mGameTypeId;
+   bool mIsFlagGame;
+   bool mHasLevelGen;            // Levelgen might add items we can't see, such as spawns
+   S32 mTeamCount;
+   Vector<ItemInfo> mItems;      // Only the types we check
+
+   Vector<string> mErrors;
+   Vector<string> mWarnings;
+
+public:
+   LevelValidationThread(EditorUserInterface *editor, U32 generation, const GameType *gameType, S32 teamCount,
+                         const GridDatabase *database);    // Constructor
+   virtual ~LevelValidationThread();                       // Destructor
+
+   void run();
+   void finish();
+
+   U32 getGeneration() const;
+   const Vector<string> &getErrors() const;
+   const Vector<string> &getWarnings() const;
+};
+
+
+};
+
+#endif
@@ -0,0 +1,336 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LuaProfiler.h"
+
+#include "stringUtils.h"
+
+#include "tnlLog.h"
+#include "tnlPlatform.h"
+
+extern "C" {
+#include <luajit.h>
+}
+
+#include <time.h>
+
+
+namespace Zap
+{
+
+LuaProfiler *LuaProfiler::mInstance = NULL;
+
+
+// Constructor
+LuaProfiler::LuaProfiler()
+{
+   mProfileAll = false;
+   mHookInstalled = false;
+   mSegmentStart = 0;
+}
+
+
+// Destructor
+LuaProfiler::~LuaProfiler()
+{
+   // Do nothing
+}
+
+
+// Provide access to the single LuaProfiler instance; lazily initialized
+LuaProfiler *LuaProfiler::get()
+{
+   if(!mInstance)
+      mInstance = new LuaProfiler();      // Deleted in shutdown()
+
+   return mInstance;
+}
+
+
+void LuaProfiler::shutdown()
+{
+   if(mInstance)
+   {
+      delete mInstance;
+      mInstance = NULL;
+   }
+}
+
+
+static string normalizeScriptName(const string &scriptName)
+{
+   return lcase(stripExtension(extractFilename(scriptName)));
+}
+
+
+bool LuaProfiler::isProfiled(const string &scriptName) const
+{
+   if(mProfileAll)
+      return true;
+
+   if(mProfiledScripts.size() == 0)
+      return false;
+
+   return mProfiledScripts.contains(normalizeScriptName(scriptName));
+}
+
+
+bool LuaProfiler::isActive() const
+{
+   return mProfileAll || mProfiledScripts.size() > 0;
+}
+
+
+// Install or remove our count hook depending on whether anything is being profiled
+void LuaProfiler::updateHook(lua_State *L)
+{
+   if(isActive() == mHookInstalled)
+      return;
+
+   if(isActive())
+   {
+      // The count hook is only checked in the interpreter, so throw away any compiled traces; otherwise
+      // hot loops that have already been compiled would never be sampled.
+      luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_FLUSH);
+      lua_sethook(L, hook, LUA_MASKCOUNT, INSTRUCTIONS_PER_SAMPLE);
+   }
+   else
+      lua_sethook(L, NULL, 0, 0);
+
+   mHookInstalled = isActive();
+}
+
+
+// Count the frames currently on the Lua stack
+static S32 getStackDepth(lua_State *L)
+{
+   lua_Debug ar;
+   S32 depth = 0;
+
+   while(lua_getstack(L, depth, &ar))
+      depth++;
+
+   return depth;
+}
+
+
+void LuaProfiler::enterScript(lua_State *L, const string &scriptName, const char *scriptId)
+{
+   // Nothing to do when we aren't profiling; exitScript() skips the matching call since our stack is empty.  Scripts
+   // already on the stack are still tracked, so it stays balanced if profiling is stopped partway through.
+   if(!mHookInstalled && mRunningScripts.size() == 0)
+      return;
+
+   S64 now = Platform::getHighPrecisionTimerValue();
+
+   // Charge time so far to whoever was running before us
+   if(mRunningScripts.size() > 0 && mRunningScripts.last().label != "")
+      mRunningScripts.last().pending += now - mSegmentStart;
+
+   RunningScript script;
+   script.pending = 0;
+   script.baseDepth = 0;
+
+   if(mHookInstalled && isProfiled(scriptName))
+   {
+      script.label = scriptName == "" ? string(scriptId) : extractFilename(scriptName);
+      script.baseDepth = getStackDepth(L);
+   }
+
+   mRunningScripts.push_back(script);
+   mSegmentStart = now;
+}
+
+
+void LuaProfiler::exitScript()
+{
+   if(mRunningScripts.size() == 0)
+      return;
+
+   S64 now = Platform::getHighPrecisionTimerValue();
+   RunningScript &script = mRunningScripts.last();
+
+   // Time since the last sample can't be attributed to a function, but it still belongs to the script
+   if(script.label != "")
+   {
+      script.pending += now - mSegmentStart;
+      mSamples[script.label] += U64(Platform::getHighPrecisionMilliseconds(script.pending) * 1000);
+   }
+
+   mRunningScripts.pop_back();
+   mSegmentStart = now;
+}
+
+
+// Record the current stack of the running script, weighted by the script time since the last sample
+void LuaProfiler::takeSample(lua_State *L)
+{
+   if(mRunningScripts.size() == 0 || mRunningScripts.last().label == "")
+      return;
+
+   RunningScript &script = mRunningScripts.last();
+
+   S64 now = Platform::getHighPrecisionTimerValue();
+   script.pending += now - mSegmentStart;
+   mSegmentStart = now;
+
+   // Walk the stack from the innermost frame out, stopping when we reach frames that belong to our caller
+   S32 frameCount = min(getStackDepth(L) - script.baseDepth, MAX_STACK_DEPTH);
+   Vector<string> frames;
+   lua_Debug ar;
+
+   for(S32 level = 0; level < frameCount && lua_getstack(L, level, &ar); level++)
+   {
+      lua_getinfo(L, "Snl", &ar);
+
+      string name;
+      if(ar.name)
+         name = ar.name;
+      else if(strcmp(ar.what, "main") == 0)
+         name = "(main chunk)";
+      else
+         name = "(anonymous)";
+
+      if(ar.currentline > 0)
+         name += " (" + string(ar.short_src) + ":" + itos(ar.currentline) + ")";
+      else
+         name += " (" + string(ar.short_src) + ")";
+
+      // Semicolons separate frames in the collapsed format
+      frames.push_back(replaceString(name, ";", ":"));
+   }
+
+   string stack = script.label;
+   for(S32 i = frames.size() - 1; i >= 0; i--)
+      stack += ";" + frames[i];
+
+   mSamples[stack] += U64(Platform::getHighPrecisionMilliseconds(script.pending) * 1000);
+   script.pending = 0;
+}
+
+
+// Our count hook, called every INSTRUCTIONS_PER_SAMPLE VM instructions
+void LuaProfiler::hook(lua_State *L, lua_Debug *ar)
+{
+   if(mInstance && ar->event == LUA_HOOKCOUNT)
+      mInstance->takeSample(L);
+}
+
+
+// Start profiling the named script if we aren't already, stop if we are.  "all" toggles all scripts.
+string LuaProfiler::toggle(lua_State *L, const string &scriptName)
+{
+   string name = normalizeScriptName(scriptName);
+   string msg;
+
+   if(name == "all")
+   {
+      mProfileAll = !mProfileAll;
+      mProfiledScripts.clear();
+      msg = mProfileAll ? "Profiling all scripts" : "Stopped profiling all scripts";
+   }
+   else if(mProfiledScripts.contains(name))
+   {
+      mProfiledScripts.erase(mProfiledScripts.getIndex(name));
+      msg = "Stopped profiling " + name;
+   }
+   else
+   {
+      mProfiledScripts.push_back(name);
+      msg = "Profiling " + name;
+   }
+
+   updateHook(L);
+   return msg;
+}
+
+
+void LuaProfiler::stopAll(lua_State *L)
+{
+   mProfileAll = false;
+   mProfiledScripts.clear();
+   updateHook(L);
+}
+
+
+// Write samples in the collapsed stack format used by flamegraph.pl: one line per stack, frames separated
+// by semicolons, followed by a space and the number of microseconds spent there.
+bool LuaProfiler::writeCollapsedStacks(const string &filename) const
+{
+   string output;
+
+   for(map<string, U64>::const_iterator it = mSamples.begin(); it != mSamples.end(); it++)
+      if(it->second > 0)
+         output += it->first + " " + itos(it->second) + "\n";
+
+   return writeFile(filename, output);
+}
+
+
+void LuaProfiler::clear()
+{
+   mSamples.clear();
+}
+
+
+S32 LuaProfiler::getStackCount() const
+{
+   return (S32)mSamples.size();
+}
+
+
+// Handle the /luaprofile admin command:
+//    /luaprofile <script>|all      Toggle profiling for a script (by filename) or for all scripts
+//    /luaprofile stop              Stop all profiling and write results
+//    /luaprofile write             Write results collected so far, and keep profiling
+//
+// Results are also written when the last profiled script is toggled off.  Returns a message for the admin.
+string LuaProfiler::processCommand(lua_State *L, const Vector<string> &args, const string &outputDir)
+{
+   if(!L)
+      return "!!! Lua is not running";
+
+   string arg = args.size() > 0 ? lcase(args[0]) : "";
+   string msg;
+
+   if(arg == "")
+      return "!!! Usage: /luaprofile <script name|all|stop|write>";
+
+   if(arg == "stop")
+   {
+      stopAll(L);
+      msg = "Stopped profiling";
+   }
+   else if(arg != "write")
+   {
+      msg = toggle(L, args[0]);
+
+      if(isActive())
+         return msg;
+   }
+
+   if(mSamples.size() == 0)
+      return msg == "" ? "No profile data collected" : msg;
+
+   char timestamp[32];
+   time_t now = time(NULL);
+   strftime(timestamp, sizeof(timestamp), "%Y%m%dT%H%M%S", localtime(&now));
+
+   makeSureFolderExists(outputDir);
+   string filename = joindir(outputDir, "luaprofile_" + string(timestamp) + ".txt");
+
+   if(!writeCollapsedStacks(filename))
+      return "!!! Could not write profile to " + filename;
+
+   logprintf("Wrote Lua profile (%d stacks) to %s", getStackCount(), filename.c_str());
+
+   if(!isActive())
+      clear();
+
+   return (msg == "" ? "" : msg + "; ") + "wrote profile to " + filename;
+}
+
+
+};
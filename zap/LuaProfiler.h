@@ -0,0 +1,83 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _LUA_PROFILER_H_
+#define _LUA_PROFILER_H_
+
+#include "LuaInc.h"
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+#include <map>
+#include <string>
+
+using namespace std;
+using namespace TNL;
+
+namespace Zap
+{
+
+// Sampling profiler for bots, levelgens, and other scripts.  Uses a Lua count hook to take a sample of the
+// running script's stack every thousand or so VM instructions, and weights each sample by the script time that
+// has elapsed since the previous one.  Time after the last sample in a call is charged to the script itself, so
+// per-script totals are exact even for handlers too short to be sampled.  Results are written as collapsed
+// stacks (one "frame;frame;frame micros" line per unique stack), which can be fed directly into flamegraph.pl.
+//
+// Profiling is toggled per script, by script filename (e.g. "s_bot"), or for all scripts at once.
+class LuaProfiler
+{
+private:
+   static const S32 INSTRUCTIONS_PER_SAMPLE = 1000;
+   static const S32 MAX_STACK_DEPTH = 64;
+
+   struct RunningScript {
+      string label;           // Root frame for samples, empty if this script is not being profiled
+      S32 baseDepth;          // Depth of the Lua stack when the script was entered; frames below this belong to our caller
+      S64 pending;            // Script time not yet attributed to a sample
+   };
+
+   Vector<RunningScript> mRunningScripts;    // Scripts can call into other scripts, e.g. with sendData()
+   Vector<string> mProfiledScripts;          // Lowercase script names without extension
+   bool mProfileAll;
+   bool mHookInstalled;
+
+   map<string, U64> mSamples;                // Collapsed stack => microseconds
+   S64 mSegmentStart;                        // When the innermost running script last started accumulating time
+
+   static LuaProfiler *mInstance;
+
+   bool isProfiled(const string &scriptName) const;
+   bool isActive() const;
+   void updateHook(lua_State *L);
+
+   void takeSample(lua_State *L);
+   static void hook(lua_State *L, lua_Debug *ar);
+
+public:
+   LuaProfiler();
+   virtual ~LuaProfiler();
+
+   static LuaProfiler *get();
+   static void shutdown();
+
+   // Called by LuaScriptRunner around every entry into a script
+   void enterScript(lua_State *L, const string &scriptName, const char *scriptId);
+   void exitScript();
+
+   string toggle(lua_State *L, const string &scriptName);   // Returns a status message
+   void stopAll(lua_State *L);
+
+   bool writeCollapsedStacks(const string &filename) const;
+   string processCommand(lua_State *L, const Vector<string> &args, const string &outputDir);    // Handles /luaprofile
+   void clear();
+
+   S32 getStackCount() const;
+};
+
+
+};
+
+#endif
@@ -5,6 +5,7 @@
 
 #include "LuaScriptRunner.h"   // Header
 #include "LuaModule.h"
+#include "LuaProfiler.h"
 #include "BfObject.h"
 #include "ship.h"
 #include "BotNavMeshZone.h"
@@ -107,6 +108,7 @@ void LuaScriptRunner::shutdown()
 {
    if(L)
    {
+      LuaProfiler::shutdown();
       lua_close(L);
       L = NULL;
    }
@@ -281,7 +283,11 @@ bool LuaScriptRunner::loadScript(bool cacheScript)
       // The script has been compiled, and the result is sitting on the stack.  The next step is to run it; this executes all the 
       // "loose" code and loads the functions into the current environment.  It does not directly execute any of the functions.
       // Any errors are handed off to the stack tracer we pushed onto the stack earlier.
-      if(lua_pcall(L, 0, 0, -2))      // Passing 0 args, expecting none back
+      LuaProfiler::get()->enterScript(L, mScriptName, getScriptId());
+      S32 err = lua_pcall(L, 0, 0, -2);      // Passing 0 args, expecting none back
+      LuaProfiler::get()->exitScript();
+
+      if(err)
       {
           // We can't load the script as requested.  Sorry!
          string msg = "Error starting script:\n" + string(lua_tostring(L, -1));
@@ -419,7 +425,9 @@ bool LuaScriptRunner::runCmd(const char* function, S32 argCount, S32 returnValue
       //    LUA_ERRRUN: a runtime error. (2)
       //    LUA_ERRMEM : memory allocation error.For such errors, Lua does not call the error handler function. (4)
       //    LUA_ERRERR : error while running the error handler function.  (5)
+      LuaProfiler::get()->enterScript(L, mScriptName, getScriptId());
       error = lua_pcall(L, argCount, returnValueCount, -2 - argCount);  // -- <<whatever>>, _stackTracer, <<return values>>
+      LuaProfiler::get()->exitScript();
       //dumpStack(L, "after pcall");
 
    }
@@ -523,12 +531,12 @@ bool LuaScriptRunner::configureNewLuaInstance(lua_State *L)
       // This allows the safe use of 'require' in our scripts
       setModulePath();
 
-      // Register all our classes in the global namespace... they will be copied below when we copy the environment
+      // Register all our classes in the global namespace... they will end up in the base environment below
       registerClasses();            // Perform class and global function registration once per lua_State
       registerLooseFunctions(L);    // Register some functions not associated with a particular class
 
       // Set scads of global vars in the Lua instance that mimic the use of the enums we use everywhere.
-      // These will be copied into the script's environment when we run createEnvironment.
+      // These will end up in the base environment that every script falls back on.
       setEnums(L);
       setGlobalObjectArrays(L);
 
@@ -547,6 +555,9 @@ bool LuaScriptRunner::configureNewLuaInstance(lua_State *L)
       // Only code executed before this point can access dangerous functions
       loadCompileRunHelper("sandbox.lua");
 
+      // Freeze the sandboxed globals into the base environment shared by all scripts
+      createBaseEnvironment(L);
+
       return true;
    }
    catch(LuaException &e)
@@ -622,10 +633,19 @@ bool LuaScriptRunner::prepareEnvironment()
 
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
-   lua_pushvalue(L, LUA_GLOBALSINDEX);                      // -- globalEnv
-   luaTableCopy(L);                                         // -- localEnvCopy
-   TNLAssert(!lua_isnoneornil(L, -1), "Failed to copy _G");
-   lua_setfield(L, LUA_REGISTRYINDEX, getScriptId());       // --
+   // Rather than copying all of _G for every script, give each script an empty table that falls back on the
+   // shared base environment for anything it hasn't defined itself.  Writes always land in the script's own table.
+   lua_newtable(L);                                                  // -- env
+   lua_getfield(L, LUA_REGISTRYINDEX, SCRIPT_ENV_METATABLE_KEY);     // -- env, metatable
+   TNLAssert(lua_istable(L, -1), "Base environment not created!");
+   lua_setmetatable(L, -2);                                          // -- env
+
+   // _G refers to the script's own environment, so scripts can't reach (or modify) the shared base
+   lua_pushliteral(L, "_G");                                         // -- env, "_G"
+   lua_pushvalue(L, -2);                                             // -- env, "_G", env
+   lua_rawset(L, -3);                                                // -- env
+
+   lua_setfield(L, LUA_REGISTRYINDEX, getScriptId());                // --
 
    // Make non-static Lua methods in this class available via "bf".  We have to
    // static_cast here because it is possible for two 'setSelf' methods to be
@@ -637,6 +657,103 @@ bool LuaScriptRunner::prepareEnvironment()
 }
 
 
+// Take a snapshot of the fully configured and sandboxed global table, and store it in the registry as the base
+// environment that all scripts fall back on.  Nothing reachable from Lua refers to the snapshot, so it is effectively
+// frozen: scripts (or modules loaded with require) can't alter what other scripts see.  Also builds the metatable
+// shared by all script environments.
+void LuaScriptRunner::createBaseEnvironment(lua_State *L)
+{
+   lua_pushvalue(L, LUA_GLOBALSINDEX);                         // -- _G
+   luaTableCopy(L);                                            // -- base
+   lua_pushliteral(L, "_G");                                   // -- base, "_G"
+   lua_pushnil(L);                                             // -- base, "_G", nil
+   lua_rawset(L, -3);                                          // -- base          (each env provides its own _G)
+
+   lua_createtable(L, 0, 2);                                   // -- base, mt
+   lua_pushvalue(L, -2);                                       // -- base, mt, base
+   lua_setfield(L, -2, "__index");                             // -- base, mt      (plain table, so lookups stay in the VM)
+   lua_pushvalue(L, -2);                                       // -- base, mt, base
+   lua_pushcclosure(L, environmentNewIndex, 1);                // -- base, mt, newindex
+   lua_setfield(L, -2, "__newindex");                          // -- base, mt
+
+   lua_setfield(L, LUA_REGISTRYINDEX, SCRIPT_ENV_METATABLE_KEY);  // -- base
+   lua_setfield(L, LUA_REGISTRYINDEX, SCRIPT_BASE_ENV_KEY);       // --
+}
+
+
+// Called when a script assigns a global not already in its environment.  The value is always stored in the script's own
+// table, but if it shadows something from the base environment, we remember the name so that it stays shadowed even
+// if the script later sets it to nil (e.g. "BfObject = nil" must hide BfObject from that script, not restore it).
+// Upvalue 1 is the base environment.
+S32 LuaScriptRunner::environmentNewIndex(lua_State *L)
+{
+                                                               // -- env, key, val
+   lua_pushvalue(L, 2);                                        // -- env, key, val, key
+   lua_rawget(L, lua_upvalueindex(1));                         // -- env, key, val, base[key]
+   bool shadowsBase = !lua_isnil(L, -1);
+   lua_pop(L, 1);                                              // -- env, key, val
+
+   if(shadowsBase)
+   {
+      lua_getmetatable(L, 1);                                  // -- env, key, val, mt
+      lua_pushliteral(L, "__hidden");                          // -- env, key, val, mt, "__hidden"
+      lua_rawget(L, -2);                                       // -- env, key, val, mt, hidden
+
+      if(lua_isnil(L, -1))
+      {
+         // First shadowed name for this env: switch from the shared metatable to a private one that consults hidden
+         lua_pop(L, 2);                                        // -- env, key, val
+         lua_newtable(L);                                      // -- env, key, val, hidden
+         lua_createtable(L, 0, 3);                             // -- env, key, val, hidden, mt
+
+         lua_pushvalue(L, -2);                                 // -- env, key, val, hidden, mt, hidden
+         lua_setfield(L, -2, "__hidden");                      // -- env, key, val, hidden, mt
+
+         lua_pushvalue(L, lua_upvalueindex(1));                // -- env, key, val, hidden, mt, base
+         lua_pushvalue(L, -3);                                 // -- env, key, val, hidden, mt, base, hidden
+         lua_pushcclosure(L, environmentIndex, 2);             // -- env, key, val, hidden, mt, index
+         lua_setfield(L, -2, "__index");                       // -- env, key, val, hidden, mt
+
+         lua_pushvalue(L, lua_upvalueindex(1));                // -- env, key, val, hidden, mt, base
+         lua_pushcclosure(L, environmentNewIndex, 1);          // -- env, key, val, hidden, mt, newindex
+         lua_setfield(L, -2, "__newindex");                    // -- env, key, val, hidden, mt
+
+         lua_setmetatable(L, 1);                               // -- env, key, val, hidden
+      }
+      else
+         lua_remove(L, -2);                                    // -- env, key, val, hidden
+
+      lua_pushvalue(L, 2);                                     // -- env, key, val, hidden, key
+      lua_pushboolean(L, true);                                // -- env, key, val, hidden, key, true
+      lua_rawset(L, -3);                                       // -- env, key, val, hidden
+      lua_pop(L, 1);                                           // -- env, key, val
+   }
+
+   lua_rawset(L, 1);                                           // -- env
+   return 0;
+}
+
+
+// Lookup for environments that have shadowed at least one base global.  Upvalue 1 is the base
+// environment, upvalue 2 is the set of names this environment has shadowed.
+S32 LuaScriptRunner::environmentIndex(lua_State *L)
+{
+                                                               // -- env, key
+   lua_pushvalue(L, 2);                                        // -- env, key, key
+   lua_rawget(L, lua_upvalueindex(2));                         // -- env, key, hidden[key]
+
+   if(lua_toboolean(L, -1))
+   {
+      lua_pushnil(L);                                          // -- env, key, true, nil
+      return 1;
+   }
+
+   lua_pop(L, 1);                                              // -- env, key
+   lua_rawget(L, lua_upvalueindex(1));                         // -- env, base[key]
+   return 1;
+}
+
+
 void LuaScriptRunner::killScript()
 {
    TNLAssert(false, "Not implemented for this class");
@@ -943,7 +1060,7 @@ void LuaScriptRunner::setEnums(lua_State *L)
 
    // Event handler events -- not sure if we need this one
    add_enum_to_lua(L, "Event",
-   #  define EVENT(value, luaEnumName, c, d) luaEnumName, true, EventManager::value,
+   #  define EVENT(value, luaEnumName, c, d, e) luaEnumName, true, EventManager::value,
          EVENT_TABLE
    #  undef EVENT
       (char*)NULL);
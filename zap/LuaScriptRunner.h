@@ -42,6 +42,8 @@ class MenuItem;
 #define ROBOT_HELPER_FUNCTIONS_KEY    "robot_helper_functions"
 #define LEVELGEN_HELPER_FUNCTIONS_KEY "levelgen_helper_functions"
 #define SCRIPT_TIMER_KEY "script_timer"
+#define SCRIPT_BASE_ENV_KEY "script_base_environment"
+#define SCRIPT_ENV_METATABLE_KEY "script_environment_metatable"
 
 class LuaScriptRunner
 {
@@ -65,6 +67,10 @@ private:
    static void setGlobalObjectArrays(lua_State *L);          // And some objects
    static void logErrorHandler(const char *msg, const char *prefix);
 
+   static void createBaseEnvironment(lua_State *L);          // Snapshot _G into the base all script environments fall back on
+   static S32 environmentIndex(lua_State *L);                // __index for environments that have shadowed a base global
+   static S32 environmentNewIndex(lua_State *L);             // __newindex for all script environments
+
 protected:
    enum ScriptType {
       ScriptTypeLevelgen,
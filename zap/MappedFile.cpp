@@ -0,0 +1,154 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "MappedFile.h"
+
+#include <stdio.h>
+
+#ifdef TNL_OS_WIN32
+#  include <windows.h>
+#else
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+namespace Zap
+{
+
+// Constructor
+MappedFile::MappedFile(const string &path)
+{
+   mData = NULL;
+   mSize = 0;
+   mMapped = false;
+
+#ifdef TNL_OS_WIN32
+   mFileHandle = INVALID_HANDLE_VALUE;
+   mMappingHandle = NULL;
+#endif
+
+   mOpen = map(path) || read(path);
+}
+
+
+// Destructor
+MappedFile::~MappedFile()
+{
+   if(!mMapped)
+      return;
+
+#ifdef TNL_OS_WIN32
+   UnmapViewOfFile(mData);
+   CloseHandle(mMappingHandle);
+   CloseHandle(mFileHandle);
+#else
+   munmap((void *)mData, mSize);
+#endif
+}
+
+
+// Returns false if the file couldn't be mapped, including when it's empty (which can't be mapped anywhere)
+bool MappedFile::map(const string &path)
+{
+#ifdef TNL_OS_WIN32
+   HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+   if(file == INVALID_HANDLE_VALUE)
+      return false;
+
+   LARGE_INTEGER size;
+   if(!GetFileSizeEx(file, &size) || size.QuadPart == 0 || size.HighPart != 0)
+   {
+      CloseHandle(file);
+      return false;
+   }
+
+   HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+   if(!mapping)
+   {
+      CloseHandle(file);
+      return false;
+   }
+
+   const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+   if(!data)
+   {
+      CloseHandle(mapping);
+      CloseHandle(file);
+      return false;
+   }
+
+   mFileHandle = file;
+   mMappingHandle = mapping;
+   mData = (const char *)data;
+   mSize = size.LowPart;
+#else
+   S32 file = open(path.c_str(), O_RDONLY);
+   if(file == -1)
+      return false;
+
+   struct stat info;
+   if(fstat(file, &info) != 0 || info.st_size == 0 || (U64)info.st_size > U32_MAX)
+   {
+      close(file);
+      return false;
+   }
+
+   void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+   close(file);         // The mapping keeps its own reference to the file
+
+   if(data == MAP_FAILED)
+      return false;
+
+   mData = (const char *)data;
+   mSize = (U32)info.st_size;
+#endif
+
+   mMapped = true;
+   return true;
+}
+
+
+bool MappedFile::read(const string &path)
+{
+   FILE *file = fopen(path.c_str(), "rb");
+   if(!file)
+      return false;
+
+   char buffer[1024 * 16];
+   size_t len;
+
+   while((len = fread(buffer, 1, sizeof(buffer), file)) > 0)
+      mBuffer.append(buffer, len);
+
+   fclose(file);
+
+   mData = mBuffer.data();
+   mSize = (U32)mBuffer.size();
+
+   return true;
+}
+
+
+bool MappedFile::isOpen() const
+{
+   return mOpen;
+}
+
+
+const char *MappedFile::getData() const
+{
+   return mData;
+}
+
+
+U32 MappedFile::getSize() const
+{
+   return mSize;
+}
+
+
+};
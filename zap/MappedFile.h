@@ -0,0 +1,56 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include "tnlTypes.h"
+
+#include <string>
+
+using namespace std;
+using namespace TNL;
+
+namespace Zap
+{
+
+// Read-only view of an entire file.  Where the OS supports it, the file is mapped into memory rather than read, so its
+// contents are only pulled from disk as they are touched, and never copied; elsewhere (or if mapping fails) we fall
+// back to reading the whole thing into a buffer.  Either way, the data stays valid until the MappedFile is destroyed.
+class MappedFile
+{
+private:
+   const char *mData;
+   U32 mSize;
+   bool mOpen;
+   bool mMapped;        // True if mData is a mapping, false if it points into mBuffer
+
+   string mBuffer;
+
+#ifdef TNL_OS_WIN32
+   void *mFileHandle;
+   void *mMappingHandle;
+#endif
+
+   bool map(const string &path);
+   bool read(const string &path);
+
+   // Not copyable
+   MappedFile(const MappedFile &);
+   MappedFile &operator=(const MappedFile &);
+
+public:
+   explicit MappedFile(const string &path);     // Constructor
+   virtual ~MappedFile();                       // Destructor
+
+   bool isOpen() const;                         // False if the file could not be opened
+   const char *getData() const;                 // Not null-terminated!
+   U32 getSize() const;
+};
+
+
+};
+
+#endif
@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "ObjectPool.h"
+
+#include "stringUtils.h"
+
+#include <string.h>
+
+namespace Zap
+{
+
+ObjectPoolStats *ObjectPoolStats::mFirst = NULL;
+
+
+// Constructor
+ObjectPoolStats::ObjectPoolStats(const char *name)
+{
+   mName = name;
+
+   mLiveCount = 0;
+   mPeakCount = 0;
+   mAllocCount = 0;
+   mNewSlotCount = 0;
+   mHeapAllocCount = 0;
+
+   mNext = mFirst;
+   mFirst = this;
+}
+
+
+// Destructor
+ObjectPoolStats::~ObjectPoolStats()
+{
+   // Do nothing
+}
+
+
+void ObjectPoolStats::noteAlloc(bool newSlot)
+{
+   mAllocCount++;
+
+   if(newSlot)
+      mNewSlotCount++;
+
+   mLiveCount++;
+
+   if(mLiveCount > mPeakCount)
+      mPeakCount = mLiveCount;
+}
+
+
+void ObjectPoolStats::noteFree()
+{
+   mLiveCount--;
+}
+
+
+const char *ObjectPoolStats::getName() const
+{
+   return mName;
+}
+
+
+U32 ObjectPoolStats::getLiveCount() const
+{
+   return mLiveCount;
+}
+
+
+U32 ObjectPoolStats::getPeakCount() const
+{
+   return mPeakCount;
+}
+
+
+U32 ObjectPoolStats::getAllocCount() const
+{
+   return mAllocCount;
+}
+
+
+U32 ObjectPoolStats::getNewSlotCount() const
+{
+   return mNewSlotCount;
+}
+
+
+U32 ObjectPoolStats::getHeapAllocCount() const
+{
+   return mHeapAllocCount;
+}
+
+
+ObjectPoolStats *ObjectPoolStats::findPool(const char *name)
+{
+   for(ObjectPoolStats *pool = mFirst; pool; pool = pool->mNext)
+      if(strcmp(pool->mName, name) == 0)
+         return pool;
+
+   return NULL;
+}
+
+
+void ObjectPoolStats::getStatLines(Vector<string> &lines)
+{
+   for(ObjectPoolStats *pool = mFirst; pool; pool = pool->mNext)
+      lines.push_back(string(pool->mName) + ": " + itos(pool->mLiveCount) + " live, " + itos(pool->mPeakCount) + " peak, " +
+                      itos(pool->mAllocCount) + " allocs, " + itos(pool->mNewSlotCount) + " slots, " +
+                      itos(pool->mHeapAllocCount) + " heap");
+}
+
+
+};
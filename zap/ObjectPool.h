@@ -0,0 +1,120 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _OBJECT_POOL_H_
+#define _OBJECT_POOL_H_
+
+#include "tnlTypes.h"
+#include "tnlDataChunker.h"
+#include "tnlVector.h"
+
+#include <string>
+
+using namespace std;
+using namespace TNL;
+
+namespace Zap
+{
+
+// Counters shared by all pools, so we can see how each one is doing.  Pools link themselves into a list when they are
+// constructed; since they are all statics that live until the program exits, they never need to unlink.
+class ObjectPoolStats
+{
+private:
+   static ObjectPoolStats *mFirst;
+   ObjectPoolStats *mNext;
+
+   const char *mName;
+
+protected:
+   U32 mLiveCount;         // Objects currently allocated from the pool
+   U32 mPeakCount;         // Highest mLiveCount has ever been
+   U32 mAllocCount;        // Total allocations served from the pool
+   U32 mNewSlotCount;      // Allocations that needed a never-used slot; these are the only ones that can hit malloc
+   U32 mHeapAllocCount;    // Allocations that were passed on to the heap because they didn't fit (i.e. subclasses)
+
+   void noteAlloc(bool newSlot);
+   void noteFree();
+
+public:
+   explicit ObjectPoolStats(const char *name);    // Constructor
+   virtual ~ObjectPoolStats();                    // Destructor
+
+   const char *getName() const;
+   U32 getLiveCount() const;
+   U32 getPeakCount() const;
+   U32 getAllocCount() const;
+   U32 getNewSlotCount() const;
+   U32 getHeapAllocCount() const;
+
+   static ObjectPoolStats *findPool(const char *name);
+
+   // One line per pool, suitable for logging or displaying to a developer
+   static void getStatLines(Vector<string> &lines);
+};
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Recycles memory for objects of one class that are created and destroyed at a high rate, such as projectiles.  Give the
+// class its own operator new and operator delete that call alloc() and free() on a static pool.  Memory comes from a
+// ClassChunker, so it is handed out in 16K pages and freed slots are reused before a new one is carved out.
+//
+// Subclasses inherit their parent's operator new, but are bigger than T; those go straight to the heap and are counted
+// separately.  Give a frequently created subclass its own pool.
+//
+// Not thread safe, and memory is never returned to the system; use only for objects created by the game thread.
+template <class T>
+class ObjectPool : public ObjectPoolStats
+{
+private:
+   // Uninitialized storage for one T; the ClassChunker "constructs" these, which does nothing
+   struct Slot
+   {
+      U64 storage[(sizeof(T) + sizeof(U64) - 1) / sizeof(U64)];
+   };
+
+   ClassChunker<Slot> mChunker;
+
+public:
+   explicit ObjectPool(const char *name) : ObjectPoolStats(name)
+   {
+      // Do nothing
+   }
+
+   void *alloc(size_t size)
+   {
+      if(size != sizeof(T))
+      {
+         mHeapAllocCount++;
+         return ::operator new(size);
+      }
+
+      // Every slot that has ever been used is either live or on the free list
+      noteAlloc(mLiveCount == mNewSlotCount);
+      return mChunker.alloc();
+   }
+
+   void free(void *ptr, size_t size)
+   {
+      if(!ptr)
+         return;
+
+      if(size != sizeof(T))
+      {
+         ::operator delete(ptr);
+         return;
+      }
+
+      noteFree();
+      mChunker.free(static_cast<Slot *>(ptr));
+   }
+};
+
+
+};
+
+#endif
@@ -16,7 +16,12 @@
 #include "Teleporter.h"
 #include "BanList.h"             // For banList kick duration
 #include "BotNavMeshZone.h"      // For zone clearing code
+#include "BotVisibilityCache.h"
+#include "TargetIndex.h"
+#include "TurretTargeting.h"
+#include "ExplosionResolver.h"
 #include "LevelSource.h"
+#include "LevelTemplateCache.h"
 #include "LevelDatabase.h"
 
 #include "gameObjectRender.h"
@@ -74,6 +79,16 @@ ServerGame::ServerGame(const Address &address, GameSettingsPtr settings, LevelSo
    mCurrentLevelIndex = 0;
 
    mBotZoneDatabase = new GridDatabase();    // Deleted in destructor
+   mBotVisibilityCache = new BotVisibilityCache(getGameObjDatabase());   // Deleted in destructor
+   mTargetIndex = new TargetIndex(getGameObjDatabase());                                   // Deleted in destructor
+   mTurretTargeting = new TurretTargeting(getGameObjDatabase(), mTargetIndex);             // Deleted in destructor
+
+   // Cache size is in megabytes; anything from 4096 up won't fit in a U32 of bytes, so just use as much as we can
+   U64 levelCacheBytes = U64(settings->getIniSettings()->levelCacheSize) * 1024 * 1024;
+   mLevelTemplateCache = new LevelTemplateCache(U32(min(levelCacheBytes, U64(U32_MAX))));   // Deleted in destructor
+   mLevelTemplate = NULL;
+   mNewLevelTemplate = NULL;
+   mWallLineIndex = 0;
 
    if(testMode)
       mInfoFlags |= TestModeFlag;
@@ -138,7 +153,12 @@ ServerGame::~ServerGame()
    instantiated = false;
 
    delete mGameInfo;
+   delete mBotVisibilityCache;
+   delete mTurretTargeting;
+   delete mTargetIndex;
    delete mBotZoneDatabase;
+   delete mNewLevelTemplate;
+   delete mLevelTemplateCache;
 
    GameManager::setHostingModePhase(GameManager::NotHosting);
 
@@ -432,7 +452,22 @@ StringTableEntry ServerGame::getCurrentLevelTypeName()
 
 bool ServerGame::processPseudoItem(S32 argc, const char **argv, const string &levelFileName, GridDatabase *database, S32 id, S32 lineNum)
 {
-   if(!stricmp(argv[0], "BarrierMaker"))
+   bool isWallItem = !stricmp(argv[0], "BarrierMaker");
+
+   if(!isWallItem && stricmp(argv[0], "BarrierMakerS") && stricmp(argv[0], "PolyWall"))
+      return false;
+
+   // If we've played this level before, we already have its walls
+   if(mLevelTemplate && mWallLineIndex < mLevelTemplate->getWallLineCount())
+   {
+      mLevelTemplate->addWallLineToGame(mWallLineIndex++, this);
+      return true;
+   }
+
+   const Vector<WallRec> *walls = getGameType()->getBarrierList();
+   S32 wallCount = walls->size();
+
+   if(isWallItem)
    {
       // Use WallItem's ProcessGeometry method to read the points; this will let us put us all our error handling
       // and geom processing in our place.
@@ -440,15 +475,16 @@ bool ServerGame::processPseudoItem(S32 argc, const char **argv, const string &le
       if(wallItem.processArguments(argc, argv, this))    // Returns true if wall was successfully processed
          addWallItem(&wallItem, NULL);
    }
-   else if(!stricmp(argv[0], "BarrierMakerS") || !stricmp(argv[0], "PolyWall"))
+   else
    {
       PolyWall polywall;
       if(polywall.processArguments(argc, argv, this))    // Returns true if wall was successfully processed
          addPolyWall(&polywall, NULL);
    }
 
-   else 
-      return false;
+   // Barriers were recorded by onObjectAdded() as they were built
+   if(mNewLevelTemplate)
+      mNewLevelTemplate->addWallLine(walls->size() > wallCount ? &walls->last() : NULL);
 
    return true;
 }
@@ -657,8 +693,20 @@ void ServerGame::cycleLevel(S32 nextLevel)
    triangulate = !isDedicated();
 #endif
 
-   mGameType->mBotZoneCreationFailed = !BotNavMeshZone::buildBotMeshZones(mBotZoneDatabase, getGameObjDatabase(), &mAllZones,
-                                                                          getWorldExtents(), triangulate);
+   if(mLevelTemplate)
+      mGameType->mBotZoneCreationFailed = !mLevelTemplate->addBotZonesToDatabase(mBotZoneDatabase, &mAllZones);
+   else
+      mGameType->mBotZoneCreationFailed = !BotNavMeshZone::buildBotMeshZones(mBotZoneDatabase, getGameObjDatabase(), &mAllZones,
+                                                                             getWorldExtents(), triangulate, getPremergedWalls());
+   if(mNewLevelTemplate)
+   {
+      mNewLevelTemplate->setBotZones(mAllZones, !mGameType->mBotZoneCreationFailed);
+      mLevelTemplateCache->add(mLevelFileHash, mNewLevelTemplate);     // Takes ownership
+      mNewLevelTemplate = NULL;
+   }
+
+   mLevelTemplate = NULL;
+
    if(mGameType->mBotZoneCreationFailed)
    {
       for(int i = 0; i < getClientCount(); i++)
@@ -1036,22 +1084,54 @@ inline string getPathFromFilename(const string &filename)
 }
 
 
-bool ServerGame::loadLevel()
+bool ServerGame::loadLevel(bool useLevelTemplate)
 {
    resetLevelInfo();    // Resets info about the level, not a LevelInfo...  In case you were wondering.
 
    mObjectsLoaded = 0;
    setLevelDatabaseId(LevelDatabase::NOT_IN_DATABASE);
 
+   delete mNewLevelTemplate;
+   mNewLevelTemplate = NULL;
+   mLevelTemplate = NULL;
+   mWallLineIndex = 0;
+
+   // A global levelgen can change the level every time it's played, so there's nothing worth keeping
+   string expectedHash;
+   if(useLevelTemplate && mSettings->getIniSettings()->globalLevelScript == "")
+      expectedHash = mLevelSource->getLevelHash(mCurrentLevelIndex);
+
+   if(expectedHash != "")
+   {
+      mLevelTemplate = mLevelTemplateCache->find(expectedHash);
+
+      if(!mLevelTemplate)
+         mNewLevelTemplate = new LevelTemplate();     // Handed to mLevelTemplateCache in cycleLevel(), or deleted
+   }
+
    mLevelFileHash = mLevelSource->loadLevel(mCurrentLevelIndex, this, getGameObjDatabase());
 
    // Empty hash means file was not loaded.  Danger Will Robinson!
    if(mLevelFileHash == "")
    {
       logprintf(LogConsumer::LogError, "Error: Cannot load %s", mLevelSource->getLevelFileDescriptor(mCurrentLevelIndex).c_str());
+
+      delete mNewLevelTemplate;
+      mNewLevelTemplate = NULL;
+      mLevelTemplate = NULL;
+
       return false;
    }
 
+   // File changed between our looking up its hash and loading it, so the walls we used may not be the right ones
+   if(mLevelTemplate && mLevelFileHash != expectedHash)
+   {
+      mLevelTemplateCache->remove(expectedHash);
+      cleanUp();
+
+      return loadLevel(false);
+   }
+
    // We should have a gameType by the time we get here... but in case we don't, we'll add a default one now
    if(!getGameType())
    {
@@ -1060,6 +1140,13 @@ bool ServerGame::loadLevel()
       gameType->addToGame(this, getGameObjDatabase());
    }
    
+   // Levels with their own levelgen are no more predictable than those run with a global one
+   if(getGameType() && getGameType()->getScriptName() != "")
+   {
+      delete mNewLevelTemplate;
+      mNewLevelTemplate = NULL;
+   }
+
    // Levelgens:
    // Run level's levelgen script (if any)
    runLevelGenScript(getGameType()->getScriptName());
@@ -1099,6 +1186,9 @@ void ServerGame::runLevelGenScript(const string &scriptName)
       return;
    }
 
+   // The script can add, remove or reshape walls, so we can't trust walls that were merged before it ran
+   clearPremergedWalls();
+
    // The script file will be the first argument, subsequent args will be passed on to the script -- 
    // will be deleted when level ends in ServerGame::cleanUp()
    LuaLevelGenerator *levelgen = new LuaLevelGenerator(this, fullname, *getGameType()->getScriptArgs());
@@ -1460,6 +1550,9 @@ void ServerGame::idle(U32 timeDelta)
    // Compute it here to save recomputing it for every robot and other method that relies on it.
    computeWorldObjectExtents();
 
+   // Whoever goes looking for a target first this tick will get a fresh snapshot
+   mTargetIndex->beginTick();
+
    U32 botControlTickElapsed = botControlTickTimer.getElapsed();
 
    if(botControlTickTimer.update(timeDelta))
@@ -1475,6 +1568,11 @@ void ServerGame::idle(U32 timeDelta)
    
    const Vector<DatabaseObject *> *gameObjects = mGameObjDatabase->findObjects_fast();
 
+   // Explosions set off while objects idle are resolved together once everyone has moved
+   getExplosionResolver()->beginBatch();
+
+   mTurretTargeting->beginTick();
+
    // Visit each game object, handling moves and running its idle method
    for(S32 i = gameObjects->size() - 1; i >= 0; i--)
    {
@@ -1492,9 +1590,15 @@ void ServerGame::idle(U32 timeDelta)
       obj->idle(BfObject::ServerIdleMainLoop);
    }
 
+   getExplosionResolver()->endBatch();
+
    if(mGameType)
       mGameType->idle(BfObject::ServerIdleMainLoop, timeDelta);
 
+   // Deliver this tick's events to scripts handling them in batches; do it before the delete list is
+   // processed so the objects involved are still around
+   EventManager::get()->fireBatchedEvents();
+
    processDeleteList(timeDelta);
 
    // Load a new level if the time is out on the current one
@@ -1949,6 +2053,44 @@ const Vector<BotNavMeshZone *> *ServerGame::getBotZones() const
 }
 
 
+// Quick check based on the zone visibility sets computed when the zones were built.  True means a ship anywhere in one
+// zone can fly straight to anywhere in the other; false only means we don't know.
+bool ServerGame::zoneCanSeeZone(U16 zone1, U16 zone2) const
+{
+   if(zone1 >= mAllZones.size() || zone2 >= mAllZones.size())
+      return false;
+
+   return mAllZones[zone1]->canSeeZone(zone2);
+}
+
+
+// Shared by all bots; remembers answers to wall-only visibility questions
+BotVisibilityCache *ServerGame::getBotVisibilityCache() const
+{
+   return mBotVisibilityCache;
+}
+
+
+// Snapshot of everything seekers, turrets, and bots might want to shoot at, taken once per tick
+TargetIndex *ServerGame::getTargetIndex() const
+{
+   return mTargetIndex;
+}
+
+
+// Shared by all turrets; finds potential targets for each cluster of turrets once per tick
+TurretTargeting *ServerGame::getTurretTargeting() const
+{
+   return mTurretTargeting;
+}
+
+
+LevelTemplateCache *ServerGame::getLevelTemplateCache() const
+{
+   return mLevelTemplateCache;
+}
+
+
 // Returns ID of zone containing specified point
 U16 ServerGame::findZoneContaining(const Point &p) const
 {
@@ -1983,8 +2125,15 @@ void ServerGame::setGameType(GameType *gameType)
 
 void ServerGame::onObjectAdded(BfObject *obj)
 {
+   if(mNewLevelTemplate && obj->getObjectTypeNumber() == BarrierTypeNumber)
+      mNewLevelTemplate->addBarrier(static_cast<Barrier *>(obj));
+
    if(mGameRecorderServer && obj->isGhostable())
       mGameRecorderServer->objectLocalScopeAlways(obj);
+
+   // Let seekers, turrets, and bots see new targets without waiting for the next tick
+   if(isTurretTargetType(obj->getObjectTypeNumber()))
+      mTargetIndex->invalidate();
 }
 
 
@@ -30,6 +30,11 @@ class ItemSpawn;
 struct LevelInfo;
 
 class GameRecorderServer;
+class BotVisibilityCache;
+class TargetIndex;
+class TurretTargeting;
+class LevelTemplate;
+class LevelTemplateCache;
 
 static const string UploadPrefix = "upload_";
 static const string DownloadPrefix = "download_";
@@ -105,7 +110,7 @@ private:
    bool onlyClientIs(GameConnection *client);
 
    void cleanUp();
-   bool loadLevel();                                  // Load the level pointed to by mCurrentLevelIndex
+   bool loadLevel(bool useLevelTemplate = true);      // Load the level pointed to by mCurrentLevelIndex
    void runLevelGenScript(const string &scriptName);  // Run any levelgens specified by the level or in the INI
 
    AbstractTeam *getNewTeam();
@@ -119,6 +124,14 @@ private:
 
    GridDatabase *mBotZoneDatabase;
    Vector<BotNavMeshZone *> mAllZones;
+   BotVisibilityCache *mBotVisibilityCache;
+   TargetIndex *mTargetIndex;
+   TurretTargeting *mTurretTargeting;
+
+   LevelTemplateCache *mLevelTemplateCache;
+   LevelTemplate *mLevelTemplate;         // Walls and zones we're reusing for the level being loaded; owned by mLevelTemplateCache
+   LevelTemplate *mNewLevelTemplate;      // Walls and zones we're keeping from the level being loaded, for next time
+   S32 mWallLineIndex;                    // Next of mLevelTemplate's wall lines to use
    
 public:
    ServerGame(const Address &address, GameSettingsPtr settings, LevelSourcePtr levelSource, bool testMode, bool dedicated, bool hostOnServer = false);    // Constructor
@@ -265,6 +278,11 @@ public:
    GridDatabase *getBotZoneDatabase() const;
    const Vector<BotNavMeshZone *> *getBotZones() const;
    U16 findZoneContaining(const Point &p) const;
+   bool zoneCanSeeZone(U16 zone1, U16 zone2) const;
+   BotVisibilityCache *getBotVisibilityCache() const;
+   TargetIndex *getTargetIndex() const;
+   TurretTargeting *getTurretTargeting() const;
+   LevelTemplateCache *getLevelTemplateCache() const;
 
    void setGameType(GameType *gameType);
    void onObjectAdded(BfObject *obj);
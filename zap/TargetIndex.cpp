@@ -0,0 +1,230 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "TargetIndex.h"
+
+#include "gridDB.h"
+#include "ship.h"
+
+#include <math.h>
+
+namespace Zap
+{
+
+// Constructor
+TargetIndex::TargetIndex(GridDatabase *database)
+{
+   mDatabase = database;
+   mBuilt = false;
+
+   mBuildCount = 0;
+}
+
+
+// Destructor
+TargetIndex::~TargetIndex()
+{
+   // Do nothing
+}
+
+
+// Forget last tick's snapshot; it will be rebuilt the next time someone asks for a target
+void TargetIndex::beginTick()
+{
+   mBuilt = false;
+}
+
+
+// Something we'd want to know about has appeared since the snapshot was taken
+void TargetIndex::invalidate()
+{
+   mBuilt = false;
+}
+
+
+U32 TargetIndex::getFlags(BfObject *object)
+{
+   if(!isShipType(object->getObjectTypeNumber()))
+      return VisibleFlag | VisibleToSensorFlag | AliveFlag;
+
+   Ship *ship = static_cast<Ship *>(object);
+   U32 flags = ShipFlag;
+
+   if(ship->isVisible(false))
+      flags |= VisibleFlag;
+   if(ship->isVisible(true))
+      flags |= VisibleToSensorFlag;
+   if(!ship->mHasExploded)
+      flags |= AliveFlag;
+
+   return flags;
+}
+
+
+void TargetIndex::build()
+{
+   mBuilt = true;
+   mBuildCount++;
+
+   mX.clear();
+   mY.clear();
+   mMinX.clear();
+   mMinY.clear();
+   mMaxX.clear();
+   mMaxY.clear();
+   mTeam.clear();
+   mFlags.clear();
+   mObjects.clear();
+
+   const Vector<DatabaseObject *> *objects = mDatabase->findObjects_fast();
+
+   for(S32 i = 0; i < objects->size(); i++)
+   {
+      U8 type = objects->get(i)->getObjectTypeNumber();
+
+      // Turrets shoot at a few things besides ships; seekers and bots only want the ships
+      if(!isTurretTargetType(type))
+         continue;
+
+      BfObject *object = static_cast<BfObject *>(objects->get(i));
+      const Rect &extent = object->getExtent();
+
+      mX.push_back(object->getPos().x);
+      mY.push_back(object->getPos().y);
+      mMinX.push_back(extent.min.x);
+      mMinY.push_back(extent.min.y);
+      mMaxX.push_back(extent.max.x);
+      mMaxY.push_back(extent.max.y);
+      mTeam.push_back(object->getTeam());
+      mFlags.push_back(getFlags(object));
+      mObjects.push_back(object);
+   }
+
+   mScratch.resize(mObjects.size());
+}
+
+
+S32 TargetIndex::getTargetCount()
+{
+   if(!mBuilt)
+      build();
+
+   return mObjects.size();
+}
+
+
+void TargetIndex::findInRect(const Rect &rect, S32 excludeTeam, Vector<DatabaseObject *> &fillVector)
+{
+   if(!mBuilt)
+      build();
+
+   for(S32 i = 0; i < mObjects.size(); i++)
+   {
+      if(mTeam[i] == excludeTeam || !mObjects[i])
+         continue;
+
+      if(mMaxX[i] >= rect.min.x && mMinX[i] <= rect.max.x && mMaxY[i] >= rect.min.y && mMinY[i] <= rect.max.y)
+         fillVector.push_back(mObjects[i].getPointer());
+   }
+}
+
+
+struct TargetDistance
+{
+   F32 distSq;
+   S32 index;
+};
+
+
+static bool closestTargetFirst(const TargetDistance &a, const TargetDistance &b)
+{
+   if(a.distSq != b.distSq)
+      return a.distSq < b.distSq;
+
+   return a.index < b.index;
+}
+
+
+void TargetIndex::findClosest(const Point &pos, const Point &range, U8 requiredFlags, F32 facingAngle, F32 coneAngle,
+                              Vector<BfObject *> &fillVector)
+{
+   if(!mBuilt)
+      build();
+
+   S32 count = mObjects.size();
+
+   if(count == 0)
+      return;
+
+   // A target is in the cone if the angle between it and our facing is at most half the cone angle; comparing the dot
+   // product against the cosine of that angle avoids calling atan2 for every target.  With no cone, let everything pass.
+   F32 dirX = cos(facingAngle);
+   F32 dirY = sin(facingAngle);
+   F32 minCos = coneAngle >= FloatTau ? -2.f : cos(coneAngle * 0.5f);
+
+   const F32 *x = mX.address();
+   const F32 *y = mY.address();
+   const F32 *minX = mMinX.address();
+   const F32 *minY = mMinY.address();
+   const F32 *maxX = mMaxX.address();
+   const F32 *maxY = mMaxY.address();
+   const U32 *flags = mFlags.address();
+   F32 *distSq = mScratch.address();
+
+   // Copies, so the compiler knows our stores to distSq can't change them
+   F32 posX = pos.x;
+   F32 posY = pos.y;
+
+   F32 left   = posX - range.x;
+   F32 right  = posX + range.x;
+   F32 top    = posY - range.y;
+   F32 bottom = posY + range.y;
+
+   // Comparing dot * |dot| with minCos * |minCos| * lenSq is the same test as dot >= minCos * sqrt(lenSq), without the sqrt
+   F32 signedMinCosSq = minCos * fabs(minCos);
+
+   // Visibility and death can change during the tick, so those are checked on the live objects below
+   U32 snapshotFlags = requiredFlags & ShipFlag;
+
+   // No branches or calls, so the compiler can do several targets at once; rejected targets get F32_MAX
+   for(S32 i = 0; i < count; i++)
+   {
+      F32 dx = x[i] - posX;
+      F32 dy = y[i] - posY;
+      F32 lenSq = dx * dx + dy * dy;
+      F32 dot = dx * dirX + dy * dirY;
+
+      S32 accept = (maxX[i] >= left) & (minX[i] <= right) & (maxY[i] >= top) & (minY[i] <= bottom) &
+                   (dot * fabs(dot) >= signedMinCosSq * lenSq) & ((flags[i] & snapshotFlags) == snapshotFlags);
+
+      distSq[i] = accept ? lenSq : F32_MAX;
+   }
+
+   static Vector<TargetDistance> found;
+   found.clear();
+
+   for(S32 i = 0; i < count; i++)
+      if(distSq[i] != F32_MAX && mObjects[i] && (getFlags(mObjects[i]) & requiredFlags) == requiredFlags)
+      {
+         TargetDistance target;
+         target.distSq = distSq[i];
+         target.index = i;
+         found.push_back(target);
+      }
+
+   found.sort(closestTargetFirst);
+
+   for(S32 i = 0; i < found.size(); i++)
+      fillVector.push_back(mObjects[found[i].index].getPointer());
+}
+
+
+U32 TargetIndex::getBuildCount() const
+{
+   return mBuildCount;
+}
+
+
+};
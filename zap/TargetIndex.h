@@ -0,0 +1,89 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _TARGET_INDEX_H_
+#define _TARGET_INDEX_H_
+
+#include "Rect.h"
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+#include "tnlNetBase.h"    // For SafePtr
+
+using namespace TNL;
+
+namespace Zap
+{
+
+class BfObject;
+class DatabaseObject;
+class GridDatabase;
+
+// Seekers, turrets, and bots all spend a lot of time asking "what's the closest thing I could shoot at?"  There are
+// rarely more than a few dozen candidates, so rather than have each of them search the database, the first one to ask
+// each tick has us copy every potential target's position, extent, team, and visibility into a set of flat arrays, which
+// can be scanned in one tight pass (at -O3, GCC vectorizes the range and cone tests in findClosest()).
+//
+// Positions and extents are a snapshot from the moment the index was built.  Visibility and whether a ship is alive can
+// change during the tick, so findClosest() checks those on the live objects, and ServerGame calls invalidate() when a new
+// target is added, so a ship that spawns mid-tick is seen right away.  Call beginTick() at the start of each tick to
+// throw out the old snapshot.
+class TargetIndex
+{
+public:
+   enum TargetFlags {
+      ShipFlag            = BIT(0),    // Ship or robot
+      VisibleFlag         = BIT(1),    // Not cloaked
+      VisibleToSensorFlag = BIT(2),    // Visible to a ship that has the sensor module
+      AliveFlag           = BIT(3),    // Ships that have exploded but haven't been cleaned up yet won't have this
+   };
+
+private:
+   GridDatabase *mDatabase;
+   bool mBuilt;
+
+   // One entry in each of these for each target
+   Vector<F32> mX;
+   Vector<F32> mY;
+   Vector<F32> mMinX;         // Extents, for searches that work like database queries
+   Vector<F32> mMinY;
+   Vector<F32> mMaxX;
+   Vector<F32> mMaxY;
+   Vector<S32> mTeam;
+   Vector<U32> mFlags;
+   Vector<SafePtr<BfObject> > mObjects;
+
+   Vector<F32> mScratch;      // Per-target results of the current search
+
+   U32 mBuildCount;
+
+   void build();
+   static U32 getFlags(BfObject *object);
+
+public:
+   explicit TargetIndex(GridDatabase *database);   // Constructor
+   virtual ~TargetIndex();                         // Destructor
+
+   void beginTick();
+   void invalidate();
+
+   S32 getTargetCount();
+
+   // Targets with extents overlapping rect, not on the specified team
+   void findInRect(const Rect &rect, S32 excludeTeam, Vector<DatabaseObject *> &fillVector);
+
+   // Targets whose extents come within range.x horizontally and range.y vertically of pos, that have all the
+   // requiredFlags right now, and, if coneAngle is less than a full circle, lie within the cone centered on facingAngle.
+   // Results are ordered closest first.
+   void findClosest(const Point &pos, const Point &range, U8 requiredFlags, F32 facingAngle, F32 coneAngle,
+                    Vector<BfObject *> &fillVector);
+
+   U32 getBuildCount() const;                      // Number of snapshots taken so far
+};
+
+
+};
+
+#endif
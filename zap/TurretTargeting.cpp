@@ -0,0 +1,162 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "TurretTargeting.h"
+
+#include "TargetIndex.h"
+#include "EngineeredItem.h"
+#include "gridDB.h"
+
+namespace Zap
+{
+
+// Constructor
+TurretTargeting::TurretTargeting(GridDatabase *database, TargetIndex *targetIndex)
+{
+   mDatabase = database;
+   mTargetIndex = targetIndex;
+   mBuilt = false;
+
+   mQueryCount = 0;
+}
+
+
+// Destructor
+TurretTargeting::~TurretTargeting()
+{
+   // Do nothing
+}
+
+
+// Forget last tick's clusters; objects have moved, and some may have been deleted
+void TurretTargeting::beginTick()
+{
+   mClusters.clear();
+   mBuilt = false;
+}
+
+
+// Returns the root of the group i belongs to, flattening the path as we go
+static S32 findGroup(Vector<S32> &parents, S32 i)
+{
+   while(parents[i] != i)
+   {
+      parents[i] = parents[parents[i]];
+      i = parents[i];
+   }
+
+   return i;
+}
+
+
+void TurretTargeting::buildClusters()
+{
+   mBuilt = true;
+
+   const Vector<DatabaseObject *> *turretList = mDatabase->findObjects_fast(TurretTypeNumber);
+
+   static Vector<Turret *> turrets;
+   static Vector<Rect> rects;
+   turrets.clear();
+   rects.clear();
+
+   for(S32 i = 0; i < turretList->size(); i++)
+   {
+      Turret *turret = static_cast<Turret *>(turretList->get(i));
+
+      if(turret->isDeleted() || !turret->isEnabled())      // Dead turrets don't shoot
+         continue;
+
+      turrets.push_back(turret);
+      rects.push_back(turret->getPerceptionRect());
+   }
+
+   // Group turrets on the same team whose perception areas overlap
+   Vector<S32> parents;
+   parents.resize(turrets.size());
+   for(S32 i = 0; i < turrets.size(); i++)
+      parents[i] = i;
+
+   for(S32 i = 0; i < turrets.size(); i++)
+      for(S32 j = i + 1; j < turrets.size(); j++)
+         if(turrets[i]->getTeam() == turrets[j]->getTeam() && rects[i].intersects(rects[j]))
+         {
+            S32 rootI = findGroup(parents, i);
+            S32 rootJ = findGroup(parents, j);
+            parents[max(rootI, rootJ)] = min(rootI, rootJ);
+         }
+
+   for(S32 i = 0; i < turrets.size(); i++)
+   {
+      if(findGroup(parents, i) != i)
+         continue;
+
+      Rect rect = rects[i];
+      for(S32 j = i + 1; j < turrets.size(); j++)
+         if(findGroup(parents, j) == i)
+            rect.unionRect(rects[j]);
+
+      addCluster(turrets[i]->getTeam(), rect);
+   }
+}
+
+
+// Search once for everything the cluster's turrets might shoot at.  Nobody shoots at their own team, so don't make
+// every turret skip over its teammates.
+S32 TurretTargeting::addCluster(S32 team, const Rect &rect)
+{
+   mClusters.push_back(Cluster());
+   Cluster &cluster = mClusters.last();
+
+   cluster.team = team;
+   cluster.rect = rect;
+
+   mTargetIndex->findInRect(rect, team, cluster.targets);
+   mQueryCount++;
+
+   return mClusters.size() - 1;
+}
+
+
+void TurretTargeting::findPotentialTargets(Turret *turret, Vector<DatabaseObject *> &targets)
+{
+   if(!mBuilt)
+      buildClusters();
+
+   Rect rect = turret->getPerceptionRect();
+   S32 team = turret->getTeam();
+
+   S32 index = -1;
+   for(S32 i = 0; i < mClusters.size(); i++)
+      if(mClusters[i].team == team && mClusters[i].rect.contains(rect.min) && mClusters[i].rect.contains(rect.max))
+      {
+         index = i;
+         break;
+      }
+
+   // A turret repaired or built since the clusters were made won't be in one yet; give it its own
+   if(index == -1)
+      index = addCluster(team, rect);
+
+   const Vector<DatabaseObject *> &clusterTargets = mClusters[index].targets;
+
+   for(S32 i = 0; i < clusterTargets.size(); i++)
+   {
+      DatabaseObject *target = clusterTargets[i];
+
+      // Drop things deleted since the cluster was built (their type number changes), and anything outside our area
+      if(isTurretTargetType(target->getObjectTypeNumber()) && rect.intersects(target->getExtent()))
+         targets.push_back(target);
+   }
+}
+
+
+U32 TurretTargeting::getQueryCount() const
+{
+   return mQueryCount;
+}
+
+
+};
@@ -0,0 +1,68 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _TURRET_TARGETING_H_
+#define _TURRET_TARGETING_H_
+
+#include "Rect.h"
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+using namespace TNL;
+
+namespace Zap
+{
+
+class GridDatabase;
+class DatabaseObject;
+class Turret;
+class TargetIndex;
+
+// Turrets tend to be built in groups, and every one of them used to search the database for targets every tick, each
+// asking about almost the same patch of the map as its neighbors.  Instead, the first turret to look for targets each
+// tick has us gather the team's turrets into clusters whose perception areas overlap, and run one search of the
+// TargetIndex per cluster.  Each turret then picks through its cluster's list, dropping anything outside its own
+// perception area.
+//
+// Clusters only hold things that might be targeted by someone on the cluster's team; anything that can change during a
+// tick (visibility, whether an item is mounted, whether the object has been deleted) is still checked by each turret.
+// The lists are rebuilt every tick, so call beginTick() before any turret idles.
+class TurretTargeting
+{
+private:
+   struct Cluster
+   {
+      S32 team;
+      Rect rect;                          // Covers the perception area of every turret in the cluster
+      Vector<DatabaseObject *> targets;
+   };
+
+   GridDatabase *mDatabase;
+   TargetIndex *mTargetIndex;
+   Vector<Cluster> mClusters;
+   bool mBuilt;
+
+   U32 mQueryCount;
+
+   void buildClusters();
+   S32 addCluster(S32 team, const Rect &rect);
+
+public:
+   TurretTargeting(GridDatabase *database, TargetIndex *targetIndex);   // Constructor
+   virtual ~TurretTargeting();                                          // Destructor
+
+   void beginTick();
+
+   // Everything in turret's perception area that it might want to shoot at
+   void findPotentialTargets(Turret *turret, Vector<DatabaseObject *> &targets);
+
+   U32 getQueryCount() const;                          // Cluster searches run so far
+};
+
+
+};
+
+#endif
@@ -39,6 +39,7 @@
 #include "Colors.h"
 #include "Intervals.h"
 #include "EditorTeam.h"
+#include "EditorUndoJournal.h"
 
 #include "gameLoader.h"          // For LevelLoadException def
 #include "LevelSource.h"
@@ -46,6 +47,7 @@
 
 #include "luaLevelGenerator.h"
 #include "LevelDatabaseUploadThread.h"
+#include "LevelValidationThread.h"
 #include "HttpRequest.h"
 #include "gameObjectRender.h"
 #include "SystemFunctions.h"
@@ -145,7 +147,7 @@ EditorUserInterface::EditorUserInterface(ClientGame *game) : Parent(game)
 
    mLastUndoStateWasBarrierWidthChange = false;
 
-   mUndoItems.resize(UNDO_STATES);     // Create slots for all our undos... also creates a ton of empty dbs.  Maybe we should be using pointers?
+   mUndoJournal = new EditorUndoJournal(UNDO_STATES);    // Deleted in destructor
    mAutoScrollWithMouse = false;
    mAutoScrollWithMouseReady = false;
 
@@ -154,6 +156,10 @@ EditorUserInterface::EditorUserInterface(ClientGame *game) : Parent(game)
    mPreviewMode = false;
    mNormalizedScreenshotMode = false;
 
+   mValidationGeneration = 0;
+   mValidationInFlight = false;
+   mValidationThread = new Master::DatabaseAccessThread();    // Deleted in destructor
+
    mSaveMsgTimer.setPeriod(FIVE_SECONDS);    
 
    mGridSize = game->getSettings()->getIniSettings()->mSettings.getVal<U32>("EditorGridSize");
@@ -176,13 +182,6 @@ F32 EditorUserInterface::getGridSize() const
 }
 
 
-void EditorUserInterface::setDatabase(shared_ptr<GridDatabase> database)
-{
-   TNLAssert(database.get(), "Database should not be NULL!");
-   mEditorDatabase = dynamic_pointer_cast<GridDatabase>(database);
-}
-
-
 // Really quitting... no going back!
 void EditorUserInterface::onQuitted()
 {
@@ -289,10 +288,12 @@ EditorUserInterface::~EditorUserInterface()
    mClipboard.clear();
 
    delete mNewItem.getPointer();
+   delete mUndoJournal;
+   delete mValidationThread;
 }
 
 
-// Removes most recent undo state from stack --> won't actually delete items on stack until we need the slot, or we quit
+// Removes most recent undo state from stack --> journal will step back over it when the slot is next saved
 void EditorUserInterface::deleteUndoState()
 {
    mLastUndoIndex--;
@@ -318,11 +319,8 @@ void EditorUserInterface::saveUndoState(bool forceSelectionOfTargetObject)
    }
 
 
-   GridDatabase *newDB = new GridDatabase();    // Make a copy
-
-   newDB->copyObjects(getDatabase());
-
-   mUndoItems[mLastUndoIndex % UNDO_STATES] = shared_ptr<GridDatabase>(newDB);  
+   // Journal only keeps copies of objects that changed since the previous state
+   mUndoJournal->saveState(getDatabase(), mLastUndoIndex, mFirstUndoIndex);
 
    mLastUndoIndex++;
    mLastRedoIndex = mLastUndoIndex;
@@ -382,11 +380,7 @@ void EditorUserInterface::undo(bool addToRedoStack)
 
    mLastUndoIndex--;
 
-   setDatabase(mUndoItems[mLastUndoIndex % UNDO_STATES]);
-   GridDatabase *database = getDatabase();
-   mLoadTarget = database;
-
-   rebuildEverything(database);    // Well, rebuild segments from walls at least
+   restoreUndoState();
 
    onSelectionChanged();
 
@@ -425,9 +419,7 @@ void EditorUserInterface::redo()
          }
       }
 
-      setDatabase(mUndoItems[mLastUndoIndex % UNDO_STATES]);
-      GridDatabase *database = mUndoItems[mLastUndoIndex % UNDO_STATES].get();
-      mLoadTarget = database;
+      restoreUndoState();
 
       // Act II:
       if(selectedItem != NONE)
@@ -438,12 +430,10 @@ void EditorUserInterface::redo()
 
          if(obj)
             obj->setSelected(true);
-      }
 
+         getDatabase()->getWallSegmentManager()->rebuildSelectedOutline();
+      }
 
-      TNLAssert(mUndoItems[mLastUndoIndex % UNDO_STATES], "null!");
-
-      rebuildEverything(database);  // Needed?  Yes, for now, but theoretically no, because we should be restoring everything fully reconstituted...
       onSelectionChanged();
       validateLevel();
 
@@ -452,6 +442,24 @@ void EditorUserInterface::redo()
 }
 
 
+// Swap in the objects that differ between what we have now and the state at mLastUndoIndex, then tidy up the walls around them
+void EditorUserInterface::restoreUndoState()
+{
+   GridDatabase *database = getDatabase();
+   mLoadTarget = database;
+
+   mUndoJournal->restoreState(database, mLastUndoIndex);
+
+   WallSegmentManager *wallSegmentManager = database->getWallSegmentManager();
+   wallSegmentManager->rebuildEdges();          // Only walls near the ones we swapped need new edges
+   wallSegmentManager->rebuildSelectedOutline();
+   resnapAllEngineeredItems(database, false);
+
+   setNeedToSave(mAllUndoneUndoLevel != mLastUndoIndex);
+   autoSave();
+}
+
+
 // Find specified object in specified database
 BfObject *EditorUserInterface::findObjBySerialNumber(const GridDatabase *database, S32 serialNumber) const
 {
@@ -511,6 +519,8 @@ bool EditorUserInterface::undoAvailable()
 // Wipe undo/redo history
 void EditorUserInterface::clearUndoHistory()
 {
+   mUndoJournal->clear();
+
    mFirstUndoIndex = 0;
    mLastUndoIndex = 1;
    mLastRedoIndex = 1;
@@ -954,155 +964,52 @@ void EditorUserInterface::showUploadErrorMessage(S32 errorCode, const string &er
 }
 
 
-static bool TeamListToString(string &output, Vector<bool> teamVector)
+// Check the level on our validation thread.  Calls that come in while a check is running are folded into one more check
+// once it finishes, so a burst of edits costs at most two.
+void EditorUserInterface::validateLevel()
 {
-   string teamList;
-   bool hasError = false;
-   char buf[16];
-
-   // Make sure each team has a spawn point
-   for(S32 i = 0; i < (S32)teamVector.size(); i++)
-      if(!teamVector[i])
-      {
-         dSprintf(buf, sizeof(buf), "%d", i+1);
-
-         if(!hasError)     // This is our first error
-         {
-            output = "team ";
-            teamList = buf;
-         }
-         else
-         {
-            output = "teams ";
-            teamList += ", ";
-            teamList += buf;
-         }
-         hasError = true;
-      }
-   if(hasError)
-   {
-      output += teamList;
-      return true;
-   }
-   return false;
-}
+   mValidationGeneration++;
 
+   if(mValidationInFlight)
+      return;
 
-static bool hasTeamFlags(GridDatabase *database)
-{
-   const Vector<DatabaseObject *> *flags = database->findObjects_fast(FlagTypeNumber);
+   mValidationInFlight = true;
 
-   for(S32 i = 0; i < flags->size(); i++)
-      if(static_cast<FlagItem *>(flags->get(i))->getTeam() > TEAM_NEUTRAL)
-         return true;
+   RefPtr<LevelValidationThread> validationThread;
+   validationThread = new LevelValidationThread(this, mValidationGeneration, getGame()->getGameType(), getTeamCount(), 
+                                                getDatabase());
 
-   return false;     
+   if(!mValidationThread->addEntry(validationThread))
+      mValidationInFlight = false;     // Queue is full; the next change will try again
 }
 
 
-static bool hasTeamSpawns(GridDatabase *database)
+// For when we need to know right away, such as before testing the level
+void EditorUserInterface::validateLevelNow()
 {
-   fillVector.clear();
-   database->findObjects(FlagSpawnTypeNumber, fillVector);
+   mValidationGeneration++;
 
-   for(S32 i = 0; i < fillVector.size(); i++)
-      if(dynamic_cast<FlagSpawn *>(fillVector[i])->getTeam() >= 0)
-         return true;
+   LevelValidationThread validationThread(NULL, mValidationGeneration, getGame()->getGameType(), getTeamCount(), getDatabase());
+   validationThread.run();
 
-   return false;
+   mLevelErrorMsgs = validationThread.getErrors();
+   mLevelWarnings = validationThread.getWarnings();
 }
 
 
-void EditorUserInterface::validateLevel()
+// Called on the main thread when a LevelValidationThread is done
+void EditorUserInterface::onLevelValidated(const LevelValidationThread &validation)
 {
-   mLevelErrorMsgs.clear();
-   mLevelWarnings.clear();
-
-   bool foundNeutralSpawn = false;
-
-   Vector<bool> foundSpawn;
-
-   string teamList;
-
-   // First, catalog items in level
-   S32 teamCount = getTeamCount();
-   foundSpawn.resize(teamCount);
-
-   for(S32 i = 0; i < teamCount; i++)      // Initialize vector
-      foundSpawn[i] = false;
-
-   GridDatabase *gridDatabase = getDatabase();
-      
-   fillVector.clear();
-   gridDatabase->findObjects(ShipSpawnTypeNumber, fillVector);
-
-   for(S32 i = 0; i < fillVector.size(); i++)
-   {
-      Spawn *spawn = static_cast<Spawn *>(fillVector[i]);
-      const S32 team = spawn->getTeam();
-
-      if(team == TEAM_NEUTRAL)
-         foundNeutralSpawn = true;
-      else if(team > TEAM_NEUTRAL && team < teamCount)
-         foundSpawn[team] = true;
-   }
-
-   bool foundSoccerBall = gridDatabase->hasObjectOfType(SoccerBallItemTypeNumber);
-   bool foundNexus      = gridDatabase->hasObjectOfType(NexusTypeNumber);
-   bool foundFlags      = gridDatabase->hasObjectOfType(FlagTypeNumber);
+   mValidationInFlight = false;
 
-   bool foundTeamFlags      = hasTeamFlags (gridDatabase);
-   bool foundTeamFlagSpawns = hasTeamSpawns(gridDatabase);
-
-   // "Unversal errors" -- levelgens can't (yet) change gametype
-
-   GameType *gameType = getGame()->getGameType();
-
-   // Check for soccer ball in a a game other than SoccerGameType. Doesn't crash no more.
-   if(foundSoccerBall && gameType->getGameTypeId() != SoccerGame)
-      mLevelWarnings.push_back("WARNING: Soccer ball can only be used in soccer game.");
-
-   // Check for the nexus object in a non-hunter game. Does not affect gameplay in non-hunter game.
-   if(foundNexus && gameType->getGameTypeId() != NexusGame)
-      mLevelWarnings.push_back("WARNING: Nexus object can only be used in Nexus game.");
-
-   // Check for missing nexus object in a hunter game.  This cause mucho dolor!
-   if(!foundNexus && gameType->getGameTypeId() == NexusGame)
-      mLevelErrorMsgs.push_back("ERROR: Nexus game must have a Nexus.");
-
-   if(foundFlags && !gameType->isFlagGame())
-      mLevelWarnings.push_back("WARNING: This game type does not use flags.");
-
-   // Check for team flag spawns on games with no team flags
-   if(foundTeamFlagSpawns && !foundTeamFlags)
-      mLevelWarnings.push_back("WARNING: Found team flag spawns but no team flags.");
-
-   // Errors that may be corrected by levelgen -- script could add spawns
-   // Neutral spawns work for all; if there's one, then that will satisfy our need for spawns for all teams
-   if(getGame()->getGameType()->getScriptName() == "" && !foundNeutralSpawn)
+   if(validation.getGeneration() != mValidationGeneration)     // Level changed while we were checking; results are stale
    {
-      if(TeamListToString(teamList, foundSpawn))     // Compose error message
-         mLevelErrorMsgs.push_back("ERROR: Need spawn point for " + teamList);
+      validateLevel();
+      return;
    }
 
-
-   if(gameType->getGameTypeId() == CoreGame)
-   {
-      for(S32 i = 0; i < teamCount; i++)      // Initialize vector
-         foundSpawn[i] = false;
-
-      fillVector.clear();
-      gridDatabase->findObjects(CoreTypeNumber, fillVector);
-      for(S32 i = 0; i < fillVector.size(); i++)
-      {
-         CoreItem *core = static_cast<CoreItem *>(fillVector[i]);
-         const S32 team = core->getTeam();
-         if(U32(team)< U32(foundSpawn.size()))
-            foundSpawn[team] = true;
-      }
-      if(TeamListToString(teamList, foundSpawn))     // Compose error message
-         mLevelErrorMsgs.push_back("ERROR: Need Core for " + teamList);
-   }
+   mLevelErrorMsgs = validation.getErrors();
+   mLevelWarnings = validation.getWarnings();
 }
 
 
@@ -1443,8 +1350,6 @@ Point EditorUserInterface::snapPoint(GridDatabase *database, Point const &p, boo
    if(mouseOnDock() && !snapWhileOnDock) 
       return p;      // No snapping!
 
-   const Vector<DatabaseObject *> *objList = getDatabase()->findObjects_fast();
-
    Point snapPoint(p);
 
    WallSegmentManager *wallSegmentManager = database->getWallSegmentManager();
@@ -1469,29 +1374,11 @@ Point EditorUserInterface::snapPoint(GridDatabase *database, Point const &p, boo
       // Where will we be snapping things?
       bool snapToWallCorners = getSnapToWallCorners();
 
-      // Now look for other things we might want to snap to
-      for(S32 i = 0; i < objList->size(); i++)
-      {
-         BfObject *obj = static_cast<BfObject *>(objList->get(i));
-
-         // Don't snap to selected items or items with selected verts (keeps us from snapping to ourselves, which is usually trouble)
-         if(obj->isSelected() || obj->anyVertsSelected())    
-            continue;
-
-         for(S32 j = 0; j < obj->getVertCount(); j++)
-         {
-            F32 dist = obj->getVert(j).distSquared(p);
-            if(dist < minDist)
-            {
-               minDist = dist;
-               snapPoint.set(obj->getVert(j));
-            }
-         }
-      }
+      checkVertsForSnap(p, database, minDist, snapPoint);
 
       // Search for a corner to snap to - by using wall edges, we'll also look for intersections between segments
       if(snapToWallCorners)   
-         checkCornersForSnap(p, wallSegmentManager->getWallEdgeDatabase()->findObjects_fast(), minDist, snapPoint);
+         checkCornersForSnap(p, wallSegmentManager->getWallEdgeDatabase(), minDist, snapPoint);
    }
 
    return snapPoint;
@@ -1629,20 +1516,73 @@ static bool checkPoint(const Point &clickPoint, const Point &point, F32 &minDist
 }
 
 
-S32 EditorUserInterface::checkCornersForSnap(const Point &clickPoint, const Vector<DatabaseObject *> *edges, F32 &minDist, Point &snapPoint)
+// Only vertices closer than minDist can beat what we have, and objects' extents cover all their vertices, so we can let the
+// database's buckets narrow things down to the objects near clickPoint.  snapPoint() gets called every frame, so it matters on
+// big levels.  Returns true if we found a vertex closer than minDist.
+bool EditorUserInterface::checkVertsForSnap(const Point &clickPoint, const GridDatabase *database, F32 &minDist, Point &snapPoint)
 {
-   const Point *vert;
+   Vector<DatabaseObject *> objects;
+   database->findObjects((TestFunc)isAnyObjectType, objects, Rect(clickPoint, sqrt(minDist)));
 
-   for(S32 i = 0; i < edges->size(); i++)
-      for(S32 j = 0; j < 1; j++)
-      {
-         WallEdge *edge = static_cast<WallEdge *>(edges->get(i));
-         vert = (j == 0) ? edge->getStart() : edge->getEnd();
-         if(checkPoint(clickPoint, *vert, minDist, snapPoint))
-            return i;
-      }
+   bool found = false;
 
-   return NONE;
+   for(S32 i = 0; i < objects.size(); i++)
+   {
+      BfObject *obj = static_cast<BfObject *>(objects[i]);
+
+      // Don't snap to selected items or items with selected verts (keeps us from snapping to ourselves, which is usually trouble)
+      if(obj->isSelected() || obj->anyVertsSelected())    
+         continue;
+
+      for(S32 j = 0; j < obj->getVertCount(); j++)
+         if(checkPoint(clickPoint, obj->getVert(j), minDist, snapPoint))
+            found = true;
+   }
+
+   return found;
+}
+
+
+// Edges are chained around each wall outline, so checking the start of each one covers every corner.  Like snapPoint(), we only
+// look at edges that come within minDist of clickPoint.  Returns true if we found a corner closer than minDist.
+bool EditorUserInterface::checkCornersForSnap(const Point &clickPoint, const GridDatabase *wallEdgeDatabase, F32 &minDist, Point &snapPoint)
+{
+   Vector<DatabaseObject *> edges;
+   wallEdgeDatabase->findObjects((TestFunc)isAnyObjectType, edges, Rect(clickPoint, sqrt(minDist)));
+
+   bool found = false;
+
+   for(S32 i = 0; i < edges.size(); i++)
+   {
+      WallEdge *edge = static_cast<WallEdge *>(edges[i]);
+
+      if(checkPoint(clickPoint, *edge->getStart(), minDist, snapPoint))
+         found = true;
+   }
+
+   return found;
+}
+
+
+// Find objects with all their vertices inside rect, for rubberband selection.  Anything like that must overlap rect, so we only
+// need to check what the database's buckets turn up.
+void EditorUserInterface::findObjectsInsideRect(const GridDatabase *database, const Rect &rect, Vector<DatabaseObject *> &fillVector)
+{
+   Vector<DatabaseObject *> objects;
+   database->findObjects((TestFunc)isAnyObjectType, objects, rect);
+
+   for(S32 i = 0; i < objects.size(); i++)
+   {
+      BfObject *obj = static_cast<BfObject *>(objects[i]);
+
+      S32 j;
+      for(j = 0; j < obj->getVertCount(); j++)
+         if(!rect.contains(obj->getVert(j)))
+            break;
+
+      if(j == obj->getVertCount())
+         fillVector.push_back(obj);
+   }
 }
 
 
@@ -3738,7 +3678,9 @@ void EditorUserInterface::doneDeleteingWalls()
 {
    WallSegmentManager *wallSegmentManager = mLoadTarget->getWallSegmentManager();
 
-   wallSegmentManager->recomputeAllWallGeometry(mLoadTarget);   // Recompute wall edges
+   // Segments of deleted walls are already gone, so only the walls they were touching need new edges
+   wallSegmentManager->rebuildEdges();
+   wallSegmentManager->rebuildSelectedOutline();
    resnapAllEngineeredItems(mLoadTarget, false);
 }
 
@@ -4711,23 +4653,12 @@ void EditorUserInterface::onKeyUp(InputCode inputCode)
 
             fillVector.clear();
 
-            getDatabase()->findObjects(fillVector);
-
+            // Entire item needs to be surrounded to be included in the selection
+            findObjectsInsideRect(getDatabase(), r, fillVector);
 
             for(S32 i = 0; i < fillVector.size(); i++)
-            {
-               BfObject *obj = dynamic_cast<BfObject *>(fillVector[i]);
+               static_cast<BfObject *>(fillVector[i])->setSelected(true);
 
-               // Make sure that all vertices of an item are inside the selection box; basically means that the entire 
-               // item needs to be surrounded to be included in the selection
-               S32 j;
-
-               for(j = 0; j < obj->getVertCount(); j++)
-                  if(!r.contains(obj->getVert(j)))
-                     break;
-               if(j == obj->getVertCount())
-                  obj->setSelected(true);
-            }
             mDragSelecting = false;
             onSelectionChanged();
          }
@@ -4917,6 +4848,8 @@ void EditorUserInterface::idle(U32 timeDelta)
    mSaveMsgTimer.update(timeDelta);
    mWarnMsgTimer.update(timeDelta);
 
+   mValidationThread->idle();          // Deliver any finished level checks
+
    // Process the messageBoxQueue
    if(mMessageBoxQueue.size() > 0)
    {
@@ -5116,7 +5049,7 @@ void EditorUserInterface::testLevel()
       gameTypeError = true;
 
    // With all the map loading error fixes, game should never crash!
-   validateLevel();
+   validateLevelNow();
    if(mLevelErrorMsgs.size() || mLevelWarnings.size() || gameTypeError)
    {
       ErrorMessageUserInterface *ui = getUIManager()->getUI<ErrorMessageUserInterface>();
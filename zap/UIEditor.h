@@ -27,13 +27,20 @@
 
 using namespace std;
 
+namespace Master
+{
+   class DatabaseAccessThread;
+}
+
 namespace Zap
 {
 
 class DatabaseObject;
 class EditorAttributeMenuUI;
 class EditorTeam;
+class EditorUndoJournal;
 class GameType;
+class LevelValidationThread;
 class LuaLevelGenerator;
 class PluginMenuUI;
 class SimpleTextEntryMenuUI;
@@ -119,15 +126,13 @@ private:
 
    SymbolString mLingeringMessage;
 
-   Vector<shared_ptr<GridDatabase> > mUndoItems;  // Undo/redo history 
+   EditorUndoJournal *mUndoJournal;             // Undo/redo history
    Point mMoveOrigin;                           // Point representing where items were moved "from" for figuring out how far they moved
    Point mSnapDelta;                            // For tracking how far from the snap point our cursor is
    Vector<Point> mMoveOrigins;
 
    shared_ptr<GridDatabase> mEditorDatabase;
 
-   void setDatabase(shared_ptr<GridDatabase> database);
-
    Vector<shared_ptr<BfObject> > mDockItems;    // Items sitting in the dock
 
    Vector<Vector<string> > mMessageBoxQueue;
@@ -149,6 +154,7 @@ private:
    bool undoAvailable();               // Is an undo state available?
    void undo(bool addToRedoStack);     // Restore mItems to latest undo state
    void redo();                        // Redo latest undo
+   void restoreUndoState();            // Bring objects back to the state at mLastUndoIndex
 
    Vector<shared_ptr<BfObject> > mClipboard;    // Items on clipboard
 
@@ -204,6 +210,9 @@ private:
    shared_ptr<EditorPlugin> mPluginRunner;
 
    Vector<string> mLevelErrorMsgs, mLevelWarnings;
+   U32 mValidationGeneration;          // Bumped whenever the level needs revalidating
+   bool mValidationInFlight;           // True while a LevelValidationThread is working on the level
+   Master::DatabaseAccessThread *mValidationThread;   // Only for validation, so it never waits behind a slow download
    Vector<PluginInfo> mPluginInfos;
 
    bool mUp, mDown, mLeft, mRight, mIn, mOut;
@@ -418,7 +427,9 @@ public:
    void rotateSelection(F32 angle, bool useOrigin); // Rotate selecton by angle
    void setSelectionId(S32 id);
 
-   void validateLevel();               // Check level for things that will make the game crash!
+   void validateLevel();               // Check level for things that will make the game crash!  Results arrive later.
+   void validateLevelNow();            // Same, but wait for the results
+   void onLevelValidated(const LevelValidationThread &validation);
    void validateTeams();               // Check that each item has a valid team (and fix any errors found)
    void validateTeams(const Vector<DatabaseObject *> *dbObjects);
 
@@ -454,7 +465,9 @@ public:
    void onBeforeRunScriptFromConsole();
    void onAfterRunScriptFromConsole();
 
-   S32 checkCornersForSnap(const Point &clickPoint,  const Vector<DatabaseObject *> *edges, F32 &minDist, Point &snapPoint);
+   static bool checkVertsForSnap(const Point &clickPoint, const GridDatabase *database, F32 &minDist, Point &snapPoint);
+   static bool checkCornersForSnap(const Point &clickPoint, const GridDatabase *wallEdgeDatabase, F32 &minDist, Point &snapPoint);
+   static void findObjectsInsideRect(const GridDatabase *database, const Rect &rect, Vector<DatabaseObject *> &fillVector);
 
    void deleteItem(S32 itemIndex, bool batchMode = false);
 
@@ -0,0 +1,280 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "WallEdgeIndex.h"
+
+#include "gridDB.h"
+#include "BfObject.h"      // For isWallType()
+#include "GeomUtils.h"
+
+#include <math.h>
+
+namespace Zap
+{
+
+// Constructor
+WallEdgeIndex::WallEdgeIndex()
+{
+   mQueryId = 0;
+   mCellSize = CellSize;
+   mCols = 0;
+   mRows = 0;
+   mGeometryVersion = 0;
+   mBuilt = false;
+}
+
+
+// Destructor
+WallEdgeIndex::~WallEdgeIndex()
+{
+   // Do nothing
+}
+
+
+bool WallEdgeIndex::isCurrent(U32 geometryVersion) const
+{
+   return mBuilt && mGeometryVersion == geometryVersion;
+}
+
+
+void WallEdgeIndex::getCell(const Point &p, S32 &col, S32 &row) const
+{
+   col = S32(floor((p.x - mBounds.min.x) / mCellSize));
+   row = S32(floor((p.y - mBounds.min.y) / mCellSize));
+
+   col = max(0, min(mCols - 1, col));
+   row = max(0, min(mRows - 1, row));
+}
+
+
+void WallEdgeIndex::rebuild(const GridDatabase *database, U32 geometryVersion)
+{
+   mEdgePoints.clear();
+   mEdgeOwners.clear();
+   mCellStarts.clear();
+   mCellEdges.clear();
+
+   mGeometryVersion = geometryVersion;
+   mBuilt = true;
+
+   Vector<DatabaseObject *> walls;
+   database->findObjects((TestFunc)isWallType, walls);
+
+   // Edge k of each outline runs from vertex k - 1 to vertex k, same as polygonIntersectsSegmentDetailed()
+   for(S32 i = 0; i < walls.size(); i++)
+   {
+      const Vector<Point> *poly = walls[i]->getCollisionPoly();
+
+      if(!poly || poly->size() == 0)
+         continue;
+
+      for(S32 j = 0; j < poly->size(); j++)
+      {
+         mEdgePoints.push_back(poly->get(j == 0 ? poly->size() - 1 : j - 1));
+         mEdgePoints.push_back(poly->get(j));
+         mEdgeOwners.push_back(walls[i]);
+      }
+   }
+
+   mEdgeQueryIds.resize(mEdgeOwners.size());
+   for(S32 i = 0; i < mEdgeQueryIds.size(); i++)
+      mEdgeQueryIds[i] = 0;
+
+   if(mEdgeOwners.size() == 0)
+      return;
+
+   // Pad things out a little so intersections that land right on a cell border, give or take some rounding,
+   // will be found in the cells on both sides
+   const Point Margin(1, 1);
+
+   mBounds.set(mEdgePoints);
+   mBounds.expand(Margin);
+
+   mCellSize = max(F32(CellSize), max(mBounds.getWidth(), mBounds.getHeight()) / MaxCellsPerSide);
+   mCols = max(1, S32(ceil(mBounds.getWidth()  / mCellSize)));
+   mRows = max(1, S32(ceil(mBounds.getHeight() / mCellSize)));
+
+   // Count the edges that overlap each cell, then fill them in; edges go in by index, so cells list them in wall order
+   Vector<S32> counts;
+   counts.resize(mCols * mRows);
+   for(S32 i = 0; i < counts.size(); i++)
+      counts[i] = 0;
+
+   for(S32 pass = 0; pass < 2; pass++)
+   {
+      for(S32 i = 0; i < mEdgeOwners.size(); i++)
+      {
+         Rect edgeRect(mEdgePoints[i * 2], mEdgePoints[i * 2 + 1]);
+         edgeRect.expand(Margin);
+
+         S32 minCol, minRow, maxCol, maxRow;
+         getCell(edgeRect.min, minCol, minRow);
+         getCell(edgeRect.max, maxCol, maxRow);
+
+         for(S32 row = minRow; row <= maxRow; row++)
+            for(S32 col = minCol; col <= maxCol; col++)
+            {
+               S32 cell = row * mCols + col;
+
+               if(pass == 0)
+                  counts[cell]++;
+               else
+                  mCellEdges[mCellStarts[cell] + counts[cell]++] = i;
+            }
+      }
+
+      if(pass == 0)
+      {
+         mCellStarts.resize(counts.size() + 1);
+         mCellStarts[0] = 0;
+         for(S32 i = 0; i < counts.size(); i++)
+         {
+            mCellStarts[i + 1] = mCellStarts[i] + counts[i];
+            counts[i] = 0;
+         }
+
+         mCellEdges.resize(mCellStarts.last());
+      }
+   }
+}
+
+
+// Walk the ray through the grid a cell at a time (Amanatides & Woo), testing the edges in each cell.  Once we have a hit
+// that comes before the ray leaves the current cell, nothing in a later cell can beat it.
+DatabaseObject *WallEdgeIndex::findObjectLOS(const Point &rayStart, const Point &rayEnd, F32 &collisionTime, Point &surfaceNormal)
+{
+   collisionTime = 1;
+
+   if(mEdgeOwners.size() == 0)
+      return NULL;
+
+   Point dp = rayEnd - rayStart;
+
+   // Clip the ray to our bounds; all edges are inside, so there's nothing to find elsewhere
+   F32 tEnter = 0;
+   F32 tLeave = 1;
+
+   const F32 starts[2] = { rayStart.x, rayStart.y };
+   const F32 deltas[2] = { dp.x, dp.y };
+   const F32 mins[2]   = { mBounds.min.x, mBounds.min.y };
+   const F32 maxes[2]  = { mBounds.max.x, mBounds.max.y };
+
+   for(S32 i = 0; i < 2; i++)
+   {
+      if(deltas[i] == 0)
+      {
+         if(starts[i] < mins[i] || starts[i] > maxes[i])
+            return NULL;
+         continue;
+      }
+
+      F32 t1 = (mins[i]  - starts[i]) / deltas[i];
+      F32 t2 = (maxes[i] - starts[i]) / deltas[i];
+      if(t1 > t2)
+         swap(t1, t2);
+
+      tEnter = max(tEnter, t1);
+      tLeave = min(tLeave, t2);
+   }
+
+   if(tEnter > tLeave)
+      return NULL;
+
+   S32 col, row;
+   getCell(rayStart + dp * tEnter, col, row);
+
+   S32 stepCol = dp.x > 0 ? 1 : -1;
+   S32 stepRow = dp.y > 0 ? 1 : -1;
+
+   // Ray time at which we cross into the next column/row, and how much time it takes to cross a whole cell
+   F32 tNextCol = F32_MAX, tNextRow = F32_MAX;
+   F32 tDeltaCol = F32_MAX, tDeltaRow = F32_MAX;
+
+   if(dp.x != 0)
+   {
+      F32 border = mBounds.min.x + (col + (stepCol > 0 ? 1 : 0)) * mCellSize;
+      tNextCol = (border - rayStart.x) / dp.x;
+      tDeltaCol = mCellSize / fabs(dp.x);
+   }
+
+   if(dp.y != 0)
+   {
+      F32 border = mBounds.min.y + (row + (stepRow > 0 ? 1 : 0)) * mCellSize;
+      tNextRow = (border - rayStart.y) / dp.y;
+      tDeltaRow = mCellSize / fabs(dp.y);
+   }
+
+   mQueryId++;
+   if(mQueryId == 0)    // Wrapped around; make sure stale ids can't match
+   {
+      for(S32 i = 0; i < mEdgeQueryIds.size(); i++)
+         mEdgeQueryIds[i] = 0;
+      mQueryId = 1;
+   }
+
+   DatabaseObject *retObject = NULL;
+
+   while(true)
+   {
+      S32 cell = row * mCols + col;
+
+      for(S32 i = mCellStarts[cell]; i < mCellStarts[cell + 1]; i++)
+      {
+         S32 edge = mCellEdges[i];
+
+         if(mEdgeQueryIds[edge] == mQueryId)
+            continue;
+
+         mEdgeQueryIds[edge] = mQueryId;
+
+         if(!mEdgeOwners[edge]->isCollisionEnabled())
+            continue;
+
+         F32 ct;
+         Point normal;
+
+         if(polygonIntersectsSegmentDetailed(&mEdgePoints[edge * 2], 2, false, rayStart, rayEnd, ct, normal) &&
+               ct < collisionTime)
+         {
+            collisionTime = ct;
+            retObject = mEdgeOwners[edge];
+            surfaceNormal = normal;
+         }
+      }
+
+      F32 tExit = min(tNextCol, tNextRow);
+
+      if(tExit >= tLeave || (retObject && collisionTime <= tExit))
+         break;
+
+      if(tNextCol < tNextRow)
+      {
+         col += stepCol;
+         tNextCol += tDeltaCol;
+      }
+      else
+      {
+         row += stepRow;
+         tNextRow += tDeltaRow;
+      }
+
+      if(col < 0 || col >= mCols || row < 0 || row >= mRows)
+         break;
+   }
+
+   if(retObject)
+      surfaceNormal.normalize();
+
+   return retObject;
+}
+
+
+S32 WallEdgeIndex::getEdgeCount() const
+{
+   return mEdgeOwners.size();
+}
+
+
+};
@@ -0,0 +1,72 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _WALL_EDGE_INDEX_H_
+#define _WALL_EDGE_INDEX_H_
+
+#include "Point.h"
+#include "Rect.h"
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+using namespace TNL;
+
+namespace Zap
+{
+
+class GridDatabase;
+class DatabaseObject;
+
+// Fine-grained uniform grid over the individual edges of every wall in a database, for answering wall-only line-of-sight
+// queries.  The regular database hands back every wall whose extent touches the bounding box of the ray, and each of
+// those gets its entire outline tested; for the long rays bots and turrets cast across a map, that can be most of the
+// walls in the level.  Here we walk the ray through the grid cell by cell and stop at the first cell that contains a hit.
+//
+// The index is built from the walls' collision polygons (on the server, walls are never merged), remembers which wall
+// each edge came from, and uses the same segment test as GridDatabase::findObjectLOS(), so results are the same.
+// It is rebuilt only when the database's geometry version changes, i.e. when a wall is added, removed, or moved.
+class WallEdgeIndex
+{
+private:
+   static const S32 CellSize = 128;
+   static const S32 MaxCellsPerSide = 256;   // Cells grow for really big levels
+
+   Vector<Point> mEdgePoints;                // Two per edge, ordered as polygonIntersectsSegmentDetailed() visits them
+   Vector<DatabaseObject *> mEdgeOwners;     // Wall each edge belongs to
+
+   Vector<S32> mCellStarts;                  // Edges in cell i are mCellEdges[mCellStarts[i]] .. mCellEdges[mCellStarts[i + 1] - 1]
+   Vector<S32> mCellEdges;
+
+   Vector<U32> mEdgeQueryIds;                // So an edge that spans several cells is only tested once per query
+   U32 mQueryId;
+
+   Rect mBounds;
+   F32 mCellSize;
+   S32 mCols;
+   S32 mRows;
+
+   U32 mGeometryVersion;
+   bool mBuilt;
+
+   void getCell(const Point &p, S32 &col, S32 &row) const;
+
+public:
+   WallEdgeIndex();              // Constructor
+   virtual ~WallEdgeIndex();     // Destructor
+
+   bool isCurrent(U32 geometryVersion) const;
+   void rebuild(const GridDatabase *database, U32 geometryVersion);
+
+   // Same as GridDatabase::findObjectLOS((TestFunc)isWallType, ...) in A-B-C-D format
+   DatabaseObject *findObjectLOS(const Point &rayStart, const Point &rayEnd, F32 &collisionTime, Point &surfaceNormal);
+
+   S32 getEdgeCount() const;
+};
+
+
+};
+
+#endif
@@ -18,6 +18,9 @@ namespace Zap
 // Statics
 bool WallSegmentManager::mBatchUpdatingGeom = false;
 
+// Marks segments that have been gathered into a cluster by rebuildEdges(), but not yet given their new group
+static const U32 PendingEdgeGroup = U32_MAX;
+
 
 // Constructor
 WallSegmentManager::WallSegmentManager()
@@ -25,6 +28,8 @@ WallSegmentManager::WallSegmentManager()
    // These deleted in the destructor
    mWallSegmentDatabase = new GridDatabase(false);      
    mWallEdgeDatabase    = new GridDatabase(false);
+
+   mNextEdgeGroupId = WallSegment::NoEdgeGroup + 1;
 }
 
 
@@ -80,7 +85,7 @@ void WallSegmentManager::onWallGeomChanged(GridDatabase *editorDatabase, BfObjec
 // This variant only resnaps engineered items that were attached to a segment that moved
 void WallSegmentManager::finishedChangingWalls(GridDatabase *editorObjectDatabase, S32 changedWallSerialNumber)
 {
-   rebuildEdges();         // Rebuild all edges for all walls
+   rebuildEdges();         // Rebuild edges of any walls that have changed
 
    // This block is a modified version of updateAllMountedItems that homes in on a particular segment
    // First, find any items directly mounted on our wall, and update their location.  Because we don't know where the wall _was_, we 
@@ -110,7 +115,7 @@ void WallSegmentManager::finishedChangingWalls(GridDatabase *editorObjectDatabas
 
 void WallSegmentManager::finishedChangingWalls(GridDatabase *editorDatabase)
 {
-   rebuildEdges();         // Rebuild all edges for all walls
+   rebuildEdges();         // Rebuild edges of any walls that have changed
    updateAllMountedItems(editorDatabase);
    rebuildSelectedOutline();
 }
@@ -126,34 +131,170 @@ void WallSegmentManager::recomputeAllWallGeometry(GridDatabase *gameDatabase)
 }
 
 
-// Take geometry from all wall segments, and run them through clipper to generate new edge geometry.  Then use the results to create
-// a bunch of WallEdge objects, which will be stored in mWallEdgeDatabase for future reference.  The two key things to understand here
-// are that 1) it's all-or-nothing: all edges need to be recomputed at once; there is no way to do a partial rebuild.  And 2) the edges
-// cannot be associated with their source segment, so we'll need to rely on other tricks to find an associated wall when needed.
+// Take geometry from wall segments, and run them through clipper to generate new edge geometry.  Then use the results to create
+// a bunch of WallEdge objects, which will be stored in mWallEdgeDatabase for future reference.  The key things to understand here
+// are that 1) segments whose extents overlap must be merged together, so we work with clusters of touching segments, and only
+// reclip the clusters that contain new segments, or were touching segments that have since been deleted.  Everything else keeps
+// the edges it already has.  And 2) the edges cannot be associated with their source segment, so we'll need to rely on other
+// tricks to find an associated wall when needed.
 void WallSegmentManager::rebuildEdges()
 {
-   // Data flow in this method: wallSegments -> wallEdgePoints -> wallEdges
+   // Data flow in this method: wallSegments -> clusters -> edge groups -> wallEdgePoints & wallEdges
+
+   Vector<WallSegment *> seeds;     // Segments whose clusters need to be rebuilt
+
+   const Vector<DatabaseObject *> *segments = mWallSegmentDatabase->findObjects_fast();
+   for(S32 i = 0; i < segments->size(); i++)
+   {
+      WallSegment *segment = static_cast<WallSegment *>(segments->get(i));
+      if(segment->getEdgeGroup() == WallSegment::NoEdgeGroup)
+         seeds.push_back(segment);
+   }
+
+   Vector<DatabaseObject *> found;
+   for(S32 i = 0; i < mRemovedSegmentExtents.size(); i++)
+   {
+      Rect queryRect = mRemovedSegmentExtents[i];
+      queryRect.expand(Point(1, 1));
+
+      found.clear();
+      mWallSegmentDatabase->findObjects(WallSegmentTypeNumber, found, queryRect);
+
+      for(S32 j = 0; j < found.size(); j++)
+         if(mRemovedSegmentExtents[i].intersectsOrBorders(found[j]->getExtent()))
+            seeds.push_back(static_cast<WallSegment *>(found[j]));
+   }
+
+   Vector<U32> oldGroups = mRemovedSegmentGroups;
+   Vector<Vector<WallSegment *> > clusters;
+
+   for(S32 i = 0; i < seeds.size(); i++)
+   {
+      if(seeds[i]->getEdgeGroup() == PendingEdgeGroup)      // Already in a cluster
+         continue;
+
+      clusters.push_back(Vector<WallSegment *>());
+      findTouchingSegments(seeds[i], clusters.last(), oldGroups);
+   }
+
+   bool changed = oldGroups.size() > 0 || clusters.size() > 0;
+
+   mRemovedSegmentExtents.clear();
+   mRemovedSegmentGroups.clear();
+
+   for(S32 i = 0; i < oldGroups.size(); i++)
+      removeEdgeGroup(oldGroups[i]);
+
+   // Run clipper on each cluster (in parallel), giving us the outline of each
+   Vector<Vector<const Vector<Point> *> > inputGroups;
+   inputGroups.resize(clusters.size());
+
+   for(S32 i = 0; i < clusters.size(); i++)
+      for(S32 j = 0; j < clusters[i].size(); j++)
+         inputGroups[i].push_back(clusters[i][j]->getCorners());
+
+   Vector<Vector<Vector<Point> > > mergedGroups;
+   mergePolysBatch(inputGroups, mergedGroups);
+
+   for(S32 i = 0; i < clusters.size(); i++)
+   {
+      U32 id = mNextEdgeGroupId++;
+      EdgeGroup &group = mEdgeGroups[id];
+
+      unpackPolygons(mergedGroups[i], group.edgePoints);
+
+      // Create a WallEdge object from the clipped wall geometry.  We'll add it to the WallEdgeDatabase, which will 
+      // delete the object when it is ulitmately removed.
+      for(S32 j = 0; j < group.edgePoints.size(); j += 2)
+      {
+         WallEdge *newEdge = new WallEdge(group.edgePoints[j], group.edgePoints[j + 1]);   // Create the edge object
+         newEdge->addToDatabase(mWallEdgeDatabase);                                        // And add it to the database
+         group.edges.push_back(newEdge);
+      }
+
+      for(S32 j = 0; j < clusters[i].size(); j++)
+         clusters[i][j]->setEdgeGroup(id);
+   }
+
+   if(!changed)
+      return;
 
+   // Rendering wants all the edges in one list
    mWallEdgePoints.clear();
 
-   // Run clipper --> fills mWallEdgePoints from mWallSegments
-   clipAllWallEdges(mWallSegmentDatabase->findObjects_fast(), mWallEdgePoints);    
-   mWallEdgeDatabase->removeEverythingFromDatabase();  //XXXX <---- THIS CAUSES THE CRASH
+   for(EdgeGroupMap::const_iterator it = mEdgeGroups.begin(); it != mEdgeGroups.end(); it++)
+      for(S32 i = 0; i < it->second.edgePoints.size(); i++)
+         mWallEdgePoints.push_back(it->second.edgePoints[i]);
+}
+
+
+// Fills cluster with segment and everything it touches, and everything they touch, and so on.  Groups the segments
+// were in before are added to oldGroups.
+void WallSegmentManager::findTouchingSegments(WallSegment *segment, Vector<WallSegment *> &cluster, Vector<U32> &oldGroups)
+{
+   if(segment->getEdgeGroup() != WallSegment::NoEdgeGroup)
+      oldGroups.push_back(segment->getEdgeGroup());
 
-   // Create a WallEdge object from the clipped wall geometry.  We'll add it to the WallEdgeDatabase, which will 
-   // delete the object when it is ulitmately removed.
-   for(S32 i = 0; i < mWallEdgePoints.size(); i+=2)
+   segment->setEdgeGroup(PendingEdgeGroup);
+   cluster.push_back(segment);
+
+   Vector<DatabaseObject *> found;
+
+   for(S32 i = 0; i < cluster.size(); i++)
    {
-      WallEdge *newEdge = new WallEdge(mWallEdgePoints[i], mWallEdgePoints[i+1]);   // Create the edge object
-      newEdge->addToDatabase(mWallEdgeDatabase);                                    // And add it to the database
+      Rect extent = cluster[i]->getExtent();
+      Rect queryRect = extent;
+      queryRect.expand(Point(1, 1));
+
+      found.clear();
+      mWallSegmentDatabase->findObjects(WallSegmentTypeNumber, found, queryRect);
+
+      for(S32 j = 0; j < found.size(); j++)
+      {
+         WallSegment *other = static_cast<WallSegment *>(found[j]);
+
+         if(other->getEdgeGroup() == PendingEdgeGroup || !extent.intersectsOrBorders(other->getExtent()))
+            continue;
+
+         if(other->getEdgeGroup() != WallSegment::NoEdgeGroup)
+            oldGroups.push_back(other->getEdgeGroup());
+
+         other->setEdgeGroup(PendingEdgeGroup);
+         cluster.push_back(other);
+      }
    }
 }
 
 
-// Delete all segments, then find all walls and build a new set of segments
+void WallSegmentManager::removeEdgeGroup(U32 id)
+{
+   EdgeGroupMap::iterator it = mEdgeGroups.find(id);
+
+   if(it == mEdgeGroups.end())      // Already gone
+      return;
+
+   for(S32 i = 0; i < it->second.edges.size(); i++)
+      mWallEdgeDatabase->removeFromDatabase(it->second.edges[i], true);
+
+   mEdgeGroups.erase(it);
+}
+
+
+void WallSegmentManager::clearEdgeGroups()
+{
+   mWallEdgeDatabase->removeEverythingFromDatabase();
+   mEdgeGroups.clear();
+
+   mRemovedSegmentExtents.clear();
+   mRemovedSegmentGroups.clear();
+}
+
+
+// Delete all segments, then find all walls and build a new set of segments; rebuildEdges() will need to be run separately
 void WallSegmentManager::buildAllWallSegmentEdgesAndPoints(GridDatabase *database)
 {
    mWallSegmentDatabase->removeEverythingFromDatabase();
+   clearEdgeGroups();      // All segments are new, so every edge will be rebuilt
 
    fillVector.clear();
    database->findObjects((TestFunc)isWallType, fillVector);
@@ -254,7 +395,7 @@ void WallSegmentManager::clipAllWallEdges(const Vector<DatabaseObject *> *wallSe
       inputPolygons.push_back(wallSegment->getCorners());
    }
 
-   mergePolys(inputPolygons, solution);      // Merged wall segments are placed in solution
+   mergePolysInGroups(inputPolygons, solution);      // Merged wall segments are placed in solution
 
    unpackPolygons(solution, wallEdges);
 }
@@ -289,7 +430,7 @@ void WallSegmentManager::computeWallSegmentIntersections(GridDatabase *gameObjDa
 
 void WallSegmentManager::clear()
 {
-   mWallEdgeDatabase->removeEverythingFromDatabase();
+   clearEdgeGroups();
    mWallSegmentDatabase->removeEverythingFromDatabase();
 
    mWallEdgePoints.clear();
@@ -366,7 +507,14 @@ void WallSegmentManager::deleteSegments(S32 owner)
    {
       WallSegment *wallSegment = static_cast<WallSegment *>(mWallSegmentDatabase->getObjectByIndex(i));
       if(wallSegment->getOwner() == owner)
+      {
          toBeDeleted.push_back(wallSegment);
+
+         // So rebuildEdges() knows what needs reclipping
+         mRemovedSegmentExtents.push_back(wallSegment->getExtent());
+         if(wallSegment->getEdgeGroup() != WallSegment::NoEdgeGroup)
+            mRemovedSegmentGroups.push_back(wallSegment->getEdgeGroup());
+      }
    }
 
    for(S32 i = 0; i < toBeDeleted.size(); i++)
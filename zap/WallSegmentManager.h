@@ -7,10 +7,13 @@
 #define _WALL_SEGMENT_MANAGER_H_
 
 #include "Point.h"
+#include "Rect.h"
 
 #include "tnlVector.h"
 #include "tnlNetObject.h"
 
+#include <map>
+
 namespace Zap
 {
 
@@ -25,13 +28,30 @@ class BfObject;
 class WallSegmentManager
 {
 private:
+   // The merged outline of a cluster of wall segments whose extents overlap.  Clusters can't touch one another, so
+   // each can be clipped on its own, and only the clusters near a changed wall ever need clipping again.
+   struct EdgeGroup
+   {
+      Vector<Point> edgePoints;
+      Vector<WallEdge *> edges;     // In mWallEdgeDatabase
+   };
+
+   typedef std::map<U32, EdgeGroup> EdgeGroupMap;
+
    GridDatabase *mWallSegmentDatabase;
    GridDatabase *mWallEdgeDatabase;
 
+   EdgeGroupMap mEdgeGroups;           // By id; WallSegments know which group they belong to
+   U32 mNextEdgeGroupId;
+   Vector<Rect> mRemovedSegmentExtents;   // Where segments were deleted since the last rebuildEdges()
+   Vector<U32> mRemovedSegmentGroups;     // And the groups they were in
+
    static bool mBatchUpdatingGeom;     
 
-   void rebuildEdges();
    void buildWallSegmentEdgesAndPoints(GridDatabase *gameDatabase, DatabaseObject *object, const Vector<DatabaseObject *> &engrObjects);
+   void findTouchingSegments(WallSegment *segment, Vector<WallSegment *> &cluster, Vector<U32> &oldGroups);
+   void removeEdgeGroup(U32 id);
+   void clearEdgeGroups();
 
 public:
    WallSegmentManager();   // Constructor
@@ -51,6 +71,8 @@ public:
    void finishedChangingWalls(GridDatabase *editorDatabase,  S32 changedWallSerialNumber);
    void finishedChangingWalls(GridDatabase *editorDatabase);
 
+   void rebuildEdges();                         // Reclip the edges of walls that have changed since last time
+
    Vector<Point> mWallEdgePoints;               // For rendering
    Vector<Point> mSelectedWallEdgePoints;       // Also for rendering
 
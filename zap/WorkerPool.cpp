@@ -0,0 +1,269 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "WorkerPool.h"
+
+#if !defined(TNL_OS_WIN32) && !defined(TNL_NO_THREADS)
+#  include <unistd.h>      // For sysconf()
+#endif
+
+namespace Zap
+{
+
+WorkerPool *WorkerPool::mWorkerPool = NULL;
+
+
+// Constructor
+WorkerPool::WorkerThread::WorkerThread(WorkerPool *pool)
+{
+   mPool = pool;
+}
+
+
+U32 WorkerPool::WorkerThread::run()
+{
+   mPool->workerLoop();
+   return 0;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+WorkerPool::WorkerPool(S32 threadCount)
+{
+   mJob = NULL;
+   mContext = NULL;
+   mJobCount = 0;
+   mNextJob = 0;
+   mJobsRemaining = 0;
+   mWorkerSlots = 0;
+   mShuttingDown = false;
+   mEnabled = true;
+
+   for(S32 i = 0; i < threadCount; i++)
+   {
+      WorkerThread *thread = new WorkerThread(this);     // Deleted in destructor
+
+      if(!thread->start())
+      {
+         logprintf(LogConsumer::LogWarning, "Could not start worker thread; continuing with %d", mThreads.size());
+         delete thread;
+         break;
+      }
+
+      mThreads.push_back(thread);
+   }
+}
+
+
+// Destructor
+WorkerPool::~WorkerPool()
+{
+   mLock.lock();
+   mShuttingDown = true;
+   mLock.unlock();
+
+   mWorkReady.increment(mThreads.size());
+
+   for(S32 i = 0; i < mThreads.size(); i++)
+      mThreadExited.wait();
+
+   mThreads.deleteAndClear();
+}
+
+
+// Create the single WorkerPool instance.  Call once at startup, before anything might use the pool; creating it on
+// first use would race if two threads got there at the same time.
+void WorkerPool::init()
+{
+   TNLAssert(!mWorkerPool, "WorkerPool already initialized!");
+
+   if(!mWorkerPool)
+      mWorkerPool = new WorkerPool(getDefaultThreadCount());    // Deleted in shutdown()
+}
+
+
+// Provide access to the single WorkerPool instance
+WorkerPool *WorkerPool::get()
+{
+   TNLAssert(mWorkerPool, "Call WorkerPool::init() first!");
+   return mWorkerPool;
+}
+
+
+void WorkerPool::shutdown()
+{
+   if(mWorkerPool)
+   {
+      delete mWorkerPool;
+      mWorkerPool = NULL;
+   }
+}
+
+
+S32 WorkerPool::getDefaultThreadCount()
+{
+#if defined(TNL_NO_THREADS)
+   return 0;
+#else
+#  if defined(TNL_OS_WIN32)
+   SYSTEM_INFO systemInfo;
+   GetSystemInfo(&systemInfo);
+   S32 cpuCount = (S32)systemInfo.dwNumberOfProcessors;
+#  else
+   S32 cpuCount = (S32)sysconf(_SC_NPROCESSORS_ONLN);
+#  endif
+
+   return max(0, min(cpuCount - 1, MAX_WORKER_THREADS));
+#endif
+}
+
+
+bool WorkerPool::runNextJob()
+{
+   mLock.lock();
+   S32 index = mNextJob < mJobCount ? mNextJob++ : -1;
+   Job job = mJob;
+   void *context = mContext;
+   mLock.unlock();
+
+   if(index == -1)
+      return false;
+
+   job(index, context);
+
+   mLock.lock();
+   mJobsRemaining--;
+   bool lastJob = (mJobsRemaining == 0);
+   mLock.unlock();
+
+   if(lastJob)
+      mBatchDone.increment();
+
+   return true;
+}
+
+
+void WorkerPool::workerLoop()
+{
+   mIsWorkerThread.set(this);
+
+   while(true)
+   {
+      mWorkReady.wait();
+
+      // A worker that was woken for an earlier batch can turn up during a later one, so each claims one of the batch's
+      // slots before joining in, which keeps us within the batch's maxConcurrency
+      mLock.lock();
+      bool shuttingDown = mShuttingDown;
+      bool joinIn = (mWorkerSlots > 0);
+      if(joinIn)
+         mWorkerSlots--;
+      mLock.unlock();
+
+      if(shuttingDown)
+         break;
+
+      // A worker that wakes after the others have taken every job (or even after the batch is over) finds nothing
+      // to do here and goes back to waiting
+      if(joinIn)
+         while(runNextJob())
+            ;
+   }
+
+   mThreadExited.increment();
+}
+
+
+void WorkerPool::run(S32 jobCount, Job job, void *context, S32 maxConcurrency)
+{
+   // Workers to wake; the caller makes one more
+   S32 workerCount = maxConcurrency < 0 ? mThreads.size() : min(mThreads.size(), maxConcurrency - 1);
+
+   // With nobody to share the work with, or when a job is itself trying to farm out work, or when another thread is
+   // already using the pool, just do it all here
+   if(jobCount <= 1 || workerCount <= 0 || !mEnabled || mIsWorkerThread.get() || !mRunLock.tryLock())
+   {
+      for(S32 i = 0; i < jobCount; i++)
+         job(i, context);
+
+      return;
+   }
+
+   mLock.lock();
+   mJob = job;
+   mContext = context;
+   mJobCount = jobCount;
+   mNextJob = 0;
+   mJobsRemaining = jobCount;
+   mWorkerSlots = workerCount;
+   mLock.unlock();
+
+   mWorkReady.increment(workerCount);
+
+   // Pitch in while we wait
+   while(runNextJob())
+      ;
+
+   mBatchDone.wait();
+
+   mRunLock.unlock();
+
+   flushDeferredMessages();
+}
+
+
+S32 WorkerPool::getThreadCount() const
+{
+   return mThreads.size();
+}
+
+
+void WorkerPool::setEnabled(bool enabled)
+{
+   mEnabled = enabled;
+}
+
+
+bool WorkerPool::isEnabled() const
+{
+   return mEnabled;
+}
+
+
+void WorkerPool::flushDeferredMessages()
+{
+   mLock.lock();
+   Vector<DeferredMessage> messages = mDeferredMessages;
+   mDeferredMessages.clear();
+   mLock.unlock();
+
+   for(S32 i = 0; i < messages.size(); i++)
+      logprintf(messages[i].type, "%s", messages[i].message.c_str());
+}
+
+
+void WorkerPool::log(LogConsumer::MsgType type, const string &message)
+{
+   if(mWorkerPool && mWorkerPool->mIsWorkerThread.get())
+   {
+      DeferredMessage deferred;
+      deferred.type = type;
+      deferred.message = message;
+
+      mWorkerPool->mLock.lock();
+      mWorkerPool->mDeferredMessages.push_back(deferred);
+      mWorkerPool->mLock.unlock();
+
+      return;
+   }
+
+   logprintf(type, "%s", message.c_str());
+}
+
+
+};
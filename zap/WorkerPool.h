@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _WORKER_POOL_H_
+#define _WORKER_POOL_H_
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+#include "tnlThread.h"
+#include "tnlLog.h"
+
+#include <string>
+
+using namespace std;
+using namespace TNL;
+
+namespace Zap
+{
+
+// A small set of threads for splitting up work that is easy to cut into independent pieces, such as merging or
+// triangulating groups of polygons that don't touch one another.  run() hands out job indices to the workers and to the
+// calling thread, and returns when every job has finished, so callers never have to deal with the threads themselves.
+//
+// Jobs must not touch anything shared without protecting it, and that includes logprintf(), which formats into a
+// static buffer.  Use WorkerPool::log() instead; messages from workers are held until the batch is done and then logged
+// from the calling thread, in the order they were written.
+class WorkerPool
+{
+public:
+   typedef void (*Job)(S32 index, void *context);
+
+private:
+   static const S32 MAX_WORKER_THREADS = 7;
+
+   class WorkerThread : public Thread
+   {
+   private:
+      WorkerPool *mPool;
+
+   public:
+      explicit WorkerThread(WorkerPool *pool);
+      U32 run();
+   };
+
+   struct DeferredMessage
+   {
+      LogConsumer::MsgType type;
+      string message;
+   };
+
+   static WorkerPool *mWorkerPool;
+
+   Vector<WorkerThread *> mThreads;
+   ThreadStorage mIsWorkerThread;   // Set on each worker, so we can tell where we're being called from
+
+   Mutex mRunLock;                  // Only one thread can be handing out work at a time
+   Mutex mLock;                     // Protects everything below
+   Semaphore mWorkReady;            // Incremented once per worker when a batch starts, or when we shut down
+   Semaphore mBatchDone;            // Incremented when the last job of a batch finishes
+   Semaphore mThreadExited;
+
+   Job mJob;
+   void *mContext;
+   S32 mJobCount;
+   S32 mNextJob;
+   S32 mJobsRemaining;
+   S32 mWorkerSlots;                // Number of workers still allowed to join the current batch
+   bool mShuttingDown;
+   bool mEnabled;
+
+   Vector<DeferredMessage> mDeferredMessages;
+
+   bool runNextJob();               // Returns false when there is nothing left to do
+   void workerLoop();
+   void flushDeferredMessages();
+
+public:
+   explicit WorkerPool(S32 threadCount);  // Constructor
+   virtual ~WorkerPool();                 // Destructor
+
+   static void init();                    // Create the single WorkerPool instance
+   static WorkerPool *get();              // Provide access to it
+   static void shutdown();
+
+   static S32 getDefaultThreadCount();    // One less than the number of CPUs, so the caller has one to itself
+
+   // Calls job(i, context) for each i in [0, jobCount), and returns when all have finished.  Jobs may run in any order.
+   // maxConcurrency limits how many threads (counting the caller) work on the batch at once, for jobs that are mostly
+   // waiting on the disk; -1 means use them all.
+   void run(S32 jobCount, Job job, void *context, S32 maxConcurrency = -1);
+
+   S32 getThreadCount() const;
+
+   // When disabled, run() does all the work on the calling thread; handy for benchmarks and debugging
+   void setEnabled(bool enabled);
+   bool isEnabled() const;
+
+   // Thread-safe replacement for logprintf()
+   static void log(LogConsumer::MsgType type, const string &message);
+};
+
+
+};
+
+#endif
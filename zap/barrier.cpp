@@ -202,6 +202,16 @@ namespace Zap
    }
 
 
+   // Lets us put the same wall in another game without building its outline and fill all over again
+   Barrier *Barrier::clone() const
+   {
+      Barrier *barrier = new Barrier(*this);
+      barrier->mGame = NULL;
+
+      return barrier;
+   }
+
+
    // Processes mPoints and fills polyPoints 
    const Vector<Point> *Barrier::getCollisionPoly() const
    {
@@ -270,7 +280,7 @@ namespace Zap
          inputPolygons.push_back(static_cast<Barrier *>(barriers[i])->getCollisionPoly());
       }
 
-      return mergePolys(inputPolygons, solution);
+      return mergePolysInGroups(inputPolygons, solution);
    }
 
 
@@ -936,6 +946,7 @@ namespace Zap
       mOwner = owner;
       invalid = false;
       mSelected = false;
+      mEdgeGroup = NoEdgeGroup;
    }
 
 
@@ -955,6 +966,18 @@ namespace Zap
    }
 
 
+   U32 WallSegment::getEdgeGroup() const
+   {
+      return mEdgeGroup;
+   }
+
+
+   void WallSegment::setEdgeGroup(U32 edgeGroup)
+   {
+      mEdgeGroup = edgeGroup;
+   }
+
+
    void WallSegment::invalidate()
    {
       invalid = true;
@@ -35,6 +35,8 @@ public:
    // Factory method
    static Barrier *createBarrier(Vector<Point> &points, F32 width, bool solid);
 
+   Barrier *clone() const;    // Copy has all the geometry, but isn't in any game
+
 
    Vector<Point> mPoints;  // The points of the barrier, might represent outline of a Polywall or the spine of an old-style BarrierMaker
    Vector<Point> mOutline; // The collision/rendering outline of the Barrier
@@ -246,6 +248,7 @@ private:
 
   void init(GridDatabase *database, S32 owner);
   bool invalid;              // A flag for marking segments in need of processing
+   U32 mEdgeGroup;            // Which of WallSegmentManager's edge groups we were merged into; NoEdgeGroup if not yet
 
    Vector<Point> mEdges;    
    Vector<Point> mCorners;
@@ -256,9 +259,14 @@ public:
    WallSegment(GridDatabase *gridDatabase, const Vector<Point> &points, S32 owner = -1);                        // PolyWall 
    virtual ~WallSegment();
 
+   static const U32 NoEdgeGroup = 0;
+
    S32 getOwner();
    void invalidate();
 
+   U32 getEdgeGroup() const;
+   void setEdgeGroup(U32 edgeGroup);
+
    bool isSelected();
    void setSelected(bool selected);
 
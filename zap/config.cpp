@@ -130,6 +130,7 @@ IniSettings::IniSettings()
    allowLevelgenUpload = true;
 
    enableGameRecording = false;
+   levelCacheSize = 32;
 
    voteEnable = false;     // Voting disabled by default
    voteLength = 12;
@@ -684,6 +685,7 @@ static void loadHostConfiguration(CIniFile *ini, IniSettings *iniSettings)
    iniSettings->globalLevelScript  = ini->GetValue(section, "GlobalLevelScript", iniSettings->globalLevelScript);
 
    iniSettings->enableGameRecording = ini->GetValueYN(section, "GameRecording", iniSettings->enableGameRecording);
+   iniSettings->levelCacheSize      = (U32) max(ini->GetValueI(section, "LevelCacheSize", S32(iniSettings->levelCacheSize)), 0);
 }
 
 
@@ -1779,6 +1781,7 @@ static void writeHost(CIniFile *ini, IniSettings *iniSettings)
       addComment(" LogStats - Save game stats locally to built-in sqlite database (saves the same stats as are sent to the master)");
       addComment(" DefaultRobotScript - If user adds a robot, this script is used if none is specified");
       addComment(" GlobalLevelScript - Specify a levelgen that will get run on every level");
+      addComment(" LevelCacheSize - Megabytes of memory used to keep walls and bot zones from levels already played, so they load faster next time (0 to disable)");
       addComment(" MySqlStatsDatabaseCredentials - If MySql integration has been compiled in (which it probably hasn't been), you can specify the");
       addComment("                                 database server, database name, login, and password as a comma delimeted list");
       addComment(" VoteLength - number of seconds the voting will last, zero will disable voting.");
@@ -1829,6 +1832,7 @@ static void writeHost(CIniFile *ini, IniSettings *iniSettings)
    ini->SetValue  (section, "GlobalLevelScript", iniSettings->globalLevelScript);
 
    ini->setValueYN(section, "GameRecording", iniSettings->enableGameRecording);
+   ini->SetValueI (section, "LevelCacheSize", S32(iniSettings->levelCacheSize));
 #ifdef BF_WRITE_TO_MYSQL
    if(iniSettings->mySqlStatsDatabaseServer == "" && iniSettings->mySqlStatsDatabaseName == "" && iniSettings->mySqlStatsDatabaseUser == "" && iniSettings->mySqlStatsDatabasePassword == "")
       ini->SetValue  (section, "MySqlStatsDatabaseCredentials", "server, dbname, login, password");
@@ -2276,7 +2280,7 @@ string FolderManager::findLevelFile(const string &leveldir, const string &filena
    folders.push_back(leveldir);
 
 #endif
-   const char *extensions[] = { ".level", "" };
+   const char *extensions[] = { ".level", ".blevel", "" };
 
    return checkName(filename, folders, extensions);
 }
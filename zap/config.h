@@ -224,6 +224,7 @@ public:
    bool allowTeamChanging;
    bool enableGameRecording;
    bool kickIdlePlayers;
+   U32 levelCacheSize;              // Megabytes of walls and bot zones kept from levels already played
 
    S32 connectionSpeed;
 
@@ -5,6 +5,7 @@
 
 #include "game.h"
 
+#include "ExplosionResolver.h"
 #include "GameManager.h"
 
 #include "gameType.h"
@@ -18,8 +19,9 @@
 #include "gameLoader.h"          // Parent class
 
 #include "md5wrapper.h"
+#include "MappedFile.h"
+#include "BinaryLevel.h"
 
-#include <sstream>
 
 #include "../master/DatabaseAccessThread.h"
 
@@ -74,6 +76,7 @@ Game::Game(const Address &theBindAddress, GameSettingsPtr settings) : mGameObjDa
    mLegacyGridSize = 1.f;              // Default to 1 unless we detect LevelFormat is missing or there's a GridSize parameter
    mLevelFormat = CurrentLevelFormat;  // Default to current format version
    mHasLevelFormat = false;
+   mPremergedWallBarrierCount = -1;
 
    mLevelDatabaseId = 0;
    mSettings = settings;
@@ -99,6 +102,8 @@ Game::Game(const Address &theBindAddress, GameSettingsPtr settings) : mGameObjDa
    mObjectsLoaded = 0;
 
    mSecondaryThread = new Master::DatabaseAccessThread();
+
+   mExplosionResolver = new ExplosionResolver(this);     // Deleted in destructor
 }
 
 
@@ -108,6 +113,7 @@ Game::~Game()
    if(mNameToAddressThread)
       delete mNameToAddressThread;
    delete mSecondaryThread;
+   delete mExplosionResolver;
 }
 
 
@@ -595,64 +601,104 @@ void Game::resetLevelInfo()
    mLevelFormat = CurrentLevelFormat;
    mHasLevelFormat = false;
    mLevelLoadTriggeredWarnings.clear();
+
+   clearPremergedWalls();
 }
 
 
-// Each line of the file is handled separately by processLevelLoadLine in game.cpp or UIEditor.cpp
+void Game::loadLevelFromString(const string &contents, GridDatabase *database, const string &filename)
+{
+   loadLevelFromBuffer(contents.data(), (U32)contents.size(), database, filename);
+}
+
 
-void Game::parseLevelLine(const char *line, GridDatabase *database, const string &levelFileName, S32 lineNum)
+// Parse level code straight out of a buffer (which need not be null-terminated, so can be a mapped file).  If hash is
+// provided, each line is fed to it as it's parsed, so we can get the level's md5 without another pass over the data.
+//
+// Each line of the file is handled separately by processLevelLoadLine in game.cpp or UIEditor.cpp
+void Game::loadLevelFromBuffer(const char *data, U32 size, GridDatabase *database, const string &filename, md5stream *hash)
 {
-   Vector<string> args = parseString(string(line));
-   U32 argc = args.size();
-   S32 id = 0;
-   const char **argv = new const char *[argc];
+   LevelTokenizer tokenizer(data, size);
 
-   if(argc >= 1)
+   while(tokenizer.nextLine())
    {
-      std::size_t pos = args[0].find("!");
-      if(pos != string::npos)
+      if(hash)
+         hash->process(tokenizer.getLine(), tokenizer.getLineBytes());
+
+      try
       {
-         id = atoi(args[0].substr(pos + 1, args[0].size() - pos - 1).c_str());
-         args[0] = args[0].substr(0, pos);
+         processLevelLoadLine(tokenizer.getArgc(), tokenizer.getId(), tokenizer.getArgv(), database, filename,
+                              tokenizer.getLineNum());
+      }
+      catch(LevelLoadException &e)
+      {
+         logprintf("Level Error: Can't parse %s: %s", string(tokenizer.getLine(), tokenizer.getLineLength()).c_str(), e.what());
       }
    }
+}
 
-   for(U32 i = 0; i < argc; i++)
-      argv[i] = args[i].c_str();
 
-   try
+// Load a level made by the -convertlevel command; binary levels carry their own hash, so we never need the text
+bool Game::loadBinaryLevel(const char *data, U32 size, GridDatabase *database, const string &filename, string *hash)
+{
+   BinaryLevelReader reader(data, size);
+
+   if(!reader.isValid())
    {
-      processLevelLoadLine(argc, id, (const char **) argv, database, levelFileName, lineNum);
+      logprintf(LogConsumer::LogError, "Binary level file %s is damaged or from a newer version", filename.c_str());
+      return false;
    }
-   catch(LevelLoadException &e)
+
+   while(reader.nextLine())
    {
-      logprintf("Level Error: Can't parse %s: %s", line, e.what());  // TODO: fix "line" variable having hundreds of level lines
-   }
+      try
+      {
+         processLevelLoadLine(reader.getArgc(), reader.getId(), reader.getArgv(), database, filename, reader.getLineNum());
+      }
+      catch(LevelLoadException &e)
+      {
+         string line;
+         for(U32 i = 0; i < reader.getArgc(); i++)
+            line += (i == 0 ? "" : " ") + string(reader.getArgv()[i]);
 
-   delete[] argv;
-}
+         logprintf("Level Error: Can't parse %s: %s", line.c_str(), e.what());
+      }
+   }
 
+   if(!reader.isValid())
+   {
+      logprintf(LogConsumer::LogError, "Binary level file %s is damaged after line %d", filename.c_str(), reader.getLineNum());
+      return false;
+   }
 
-void Game::loadLevelFromString(const string &contents, GridDatabase *database, const string &filename)
-{
-   istringstream iss(contents);
-   string line;
-   S32 lineNum = 1;
-   while(std::getline(iss, line))
+   if(reader.getMergedWallBarrierCount() >= 0)
    {
-      parseLevelLine(line.c_str(), database, filename, lineNum);
-      lineNum++;
+      mPremergedWalls = reader.getMergedWalls();
+      mPremergedWallBarrierCount = reader.getMergedWallBarrierCount();
    }
+
+   if(hash)
+      *hash = reader.getHash();
+
+   return true;
 }
 
 
-bool Game::loadLevelFromFile(const string &filename, GridDatabase *database)
+// Reads filename only once, even when we want its hash
+bool Game::loadLevelFromFile(const string &filename, GridDatabase *database, string *hash)
 {
-   string contents = readFile(filename);
-   if(contents == "")
+   MappedFile file(filename);
+   if(!file.isOpen() || file.getSize() == 0)
       return false;
 
-   loadLevelFromString(contents, database, filename);
+   if(BinaryLevel::isBinaryLevel(file.getData(), file.getSize()))
+      return loadBinaryLevel(file.getData(), file.getSize(), database, filename, hash);
+
+   md5stream levelHash;
+   loadLevelFromBuffer(file.getData(), file.getSize(), database, filename, hash ? &levelHash : NULL);
+
+   if(hash)
+      *hash = levelHash.getHash();
 
 #ifdef SAM_ONLY
    // In case the level crash the game trying to load, want to know which file is the problem. 
@@ -663,6 +709,30 @@ bool Game::loadLevelFromFile(const string &filename, GridDatabase *database)
 }
 
 
+// Walls merged ahead of time by the -convertlevel command, or NULL if the level didn't come with any, or they no longer
+// match the barriers in the level (a levelgen may have added some, for example)
+const Vector<Vector<Point> > *Game::getPremergedWalls() const
+{
+   if(mPremergedWallBarrierCount < 0)
+      return NULL;
+
+   Vector<DatabaseObject *> barriers;
+   mGameObjDatabase->findObjects(BarrierTypeNumber, barriers);
+
+   if(barriers.size() != mPremergedWallBarrierCount)
+      return NULL;
+
+   return &mPremergedWalls;
+}
+
+
+void Game::clearPremergedWalls()
+{
+   mPremergedWalls.clear();
+   mPremergedWallBarrierCount = -1;
+}
+
+
 // Process a single line of a level file, loaded in gameLoader.cpp
 // argc is the number of parameters on the line, argv is the params themselves
 // Used by ServerGame and the editor
@@ -1617,6 +1687,12 @@ Master::DatabaseAccessThread *Game::getSecondaryThread()
 }
 
 
+ExplosionResolver *Game::getExplosionResolver() const
+{
+   return mExplosionResolver;
+}
+
+
 };
 
 
@@ -106,6 +106,7 @@ class GameConnection;
 class Ship;
 struct UserInterfaceData;
 class WallSegmentManager;
+class ExplosionResolver;
 class Robot;
 
 class AbstractTeam;
@@ -178,6 +179,9 @@ private:
 
    static const U32 CurrentLevelFormat;
 
+   Vector<Vector<Point> > mPremergedWalls;   // Barriers merged by the -convertlevel command, when loading binary levels
+   S32 mPremergedWallBarrierCount;           // Number of barriers they were merged from, or -1 if we have none
+
    U32 mTimeUnconnectedToMaster;          // Time that we've been disconnected to the master
    bool mHaveTriedToConnectToMaster;
 
@@ -198,6 +202,8 @@ private:
    NameToAddressThread *mNameToAddressThread;
    Master::DatabaseAccessThread *mSecondaryThread;
 
+   ExplosionResolver *mExplosionResolver;
+
 protected:
    U32 mNextMasterTryTime;
 
@@ -347,8 +353,12 @@ public:
 
 
    void loadLevelFromString(const string &contents, GridDatabase *database, const string& filename = "");
-   bool loadLevelFromFile(const string &filename, GridDatabase *database);
-   void parseLevelLine(const char *line, GridDatabase *database, const string &levelFileName, S32 lineNum);
+   void loadLevelFromBuffer(const char *data, U32 size, GridDatabase *database, const string &filename = "", md5stream *hash = NULL);
+   bool loadLevelFromFile(const string &filename, GridDatabase *database, string *hash = NULL);
+   bool loadBinaryLevel(const char *data, U32 size, GridDatabase *database, const string &filename, string *hash);
+
+   const Vector<Vector<Point> > *getPremergedWalls() const;
+   void clearPremergedWalls();
 
    void processLevelLoadLine(U32 argc, S32 id, const char **argv, GridDatabase *database, const string &levelFileName, S32 lineNum);
    bool processLevelParam(S32 argc, const char **argv, S32 lineNum);
@@ -491,6 +501,8 @@ public:
    virtual F32 getObjectiveArrowHighlightAlpha() const;
 
     Master::DatabaseAccessThread *getSecondaryThread();
+
+   ExplosionResolver *getExplosionResolver() const;
 };
 
 
@@ -14,6 +14,8 @@
 #include "gameNetInterface.h"
 #include "gameType.h"
 #include "LevelSource.h"
+#include "BinaryLevel.h"
+#include "MappedFile.h"
 
 #include "SoundSystemEnums.h"
 #include "GameRecorder.h"
@@ -1831,57 +1833,50 @@ TNL_IMPLEMENT_RPC(GameConnection, s2cSetFilename, (string filename), (filename),
    mFileName = filename;
 }
 
+// Binary levels are only a faster way for a server to load its own levels; the other end saves what we send as a .level
+// file, and may open it in the editor, so it always gets the text
+static bool readLevelAsText(const char *filename, string &text)
+{
+   MappedFile file(filename);
+
+   if(!file.isOpen() || file.getSize() == 0)
+      return false;
+
+   if(BinaryLevel::isBinaryLevel(file.getData(), file.getSize()))
+      return BinaryLevel::decode(file.getData(), file.getSize(), text);
+
+   text.assign(file.getData(), file.getSize());
+   return true;
+}
+
+
 bool GameConnection::TransferLevelFile(const char *filename)
 {
    BitStream s;
    const U32 partsSize = 512;   // max 1023, limited by ByteBufferSizeBitSize value of 10
 
-   FILE *f = fopen(filename, "rb");
+   string levelText;
+   FILE *f;
 
-   if(f)
+   if(readLevelAsText(filename, levelText))
    {
-      U32 size = partsSize;
-      const U32 DATAARRAYSIZE = 8192;
-      U8 *data = new U8[DATAARRAYSIZE];
+      U32 size = U32(levelText.size());
+      const U8 *data = (const U8 *)levelText.c_str();
       U32 totalTransferSize = 0;
-      size = U32(fread(data, 1, DATAARRAYSIZE, f));
 
       mPendingTransferData.resize(0);
 
-      if(size <= 0 || size > DATAARRAYSIZE)
-      {
-         fclose(f);
-         delete[] data;
-         return false;
-      }
-
       LevelInfo levelInfo;
-      LevelSource::getLevelInfoFromCodeChunk((char*)data, size, levelInfo);
+      LevelSource::getLevelInfoFromCodeChunk(levelText.c_str(), size, levelInfo);
 
 
       for(U32 i=0; i<size; i+=partsSize)
       {
-         ByteBuffer *bytebuffer = new ByteBuffer(&data[i], min(partsSize, size-i));
+         ByteBuffer *bytebuffer = new ByteBuffer((U8 *)&data[i], min(partsSize, size-i));
          bytebuffer->takeOwnership();
          mPendingTransferData.push_back(bytebuffer);
          totalTransferSize += bytebuffer->getBufferSize();
       }
-      delete[] data;
-
-      size = (size == DATAARRAYSIZE ? partsSize : 0);
-      while(size == partsSize)
-      {
-         ByteBuffer *bytebuffer = new ByteBuffer(512);
-
-         size = (U32)fread(bytebuffer->getBuffer(), 1, bytebuffer->getBufferSize(), f);
-
-         if(size != partsSize)
-            bytebuffer->resize(size);
-
-         mPendingTransferData.push_back(bytebuffer);
-         totalTransferSize += size;
-      }
-      fclose(f);
 
       U32 pendingleveltransfer = mPendingTransferData.size();
 
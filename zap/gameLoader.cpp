@@ -17,6 +17,8 @@
 #include <sstream>
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #  ifdef TNL_OS_WIN32
 #     include "../other/dirent.h"        // Need local copy for Windows builds
@@ -56,5 +58,158 @@ const char *LevelLoadException::what() const throw ()
 }
 
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+LevelTokenizer::LevelTokenizer(const char *data, U32 size)
+{
+   mData = data;
+   mSize = size;
+   mPos = 0;
+
+   mLine = NULL;
+   mLineLength = 0;
+   mLineBytes = 0;
+   mLineNum = 0;
+
+   mId = 0;
+}
+
+
+bool LevelTokenizer::nextLine()
+{
+   if(mPos >= mSize)
+      return false;
+
+   const char *start = mData + mPos;
+   const char *newline = (const char *)memchr(start, '\n', mSize - mPos);
+
+   mLine = start;
+   mLineLength = newline ? U32(newline - start) : mSize - mPos;
+   mLineBytes = newline ? mLineLength + 1 : mLineLength;
+
+   mPos += mLineBytes;
+   mLineNum++;
+
+   tokenize();
+
+   return true;
+}
+
+
+// Same characters stringstream treats as whitespace
+static inline bool isWhitespace(char c)
+{
+   return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+
+void LevelTokenizer::tokenize()
+{
+   mArgv.clear();
+   mId = 0;
+
+   mLineBuffer.resize(mLineLength + 1);     // Room for a terminator after the last word
+   memcpy(mLineBuffer.address(), mLine, mLineLength);
+
+   char *pos = mLineBuffer.address();
+   char *end = pos + mLineLength;
+
+   while(true)
+   {
+      while(pos < end && isWhitespace(*pos))
+         pos++;
+
+      if(pos >= end)
+         break;
+
+      char *wordStart = pos;
+
+      while(pos < end && !isWhitespace(*pos))
+         pos++;
+
+      char *wordEnd = pos;
+
+      if(*wordStart == '"')
+      {
+         // If the word doesn't close its own quotes, it runs through the next quote (or the end of the line)
+         if(wordEnd[-1] != '"')
+         {
+            char *closingQuote = (char *)memchr(wordEnd, '"', end - wordEnd);
+            wordEnd = closingQuote ? closingQuote : end;
+            pos = closingQuote ? closingQuote + 1 : end;
+         }
+
+         // Now remove the quotes
+         while(wordStart < wordEnd && *wordStart == '"')
+            wordStart++;
+         while(wordEnd > wordStart && wordEnd[-1] == '"')
+            wordEnd--;
+      }
+
+      *wordEnd = '\0';
+
+      if(pos == wordEnd)      // We just overwrote the whitespace after the word; move past it
+         pos++;
+
+      mArgv.push_back(wordStart);
+   }
+
+   // Split the id off the first word, e.g. "Turret!4"
+   if(mArgv.size() > 0)
+   {
+      char *bang = strchr(const_cast<char *>(mArgv[0]), '!');
+      if(bang)
+      {
+         mId = atoi(bang + 1);
+         *bang = '\0';
+      }
+   }
+}
+
+
+const char *LevelTokenizer::getLine() const
+{
+   return mLine;
+}
+
+
+U32 LevelTokenizer::getLineLength() const
+{
+   return mLineLength;
+}
+
+
+U32 LevelTokenizer::getLineBytes() const
+{
+   return mLineBytes;
+}
+
+
+S32 LevelTokenizer::getLineNum() const
+{
+   return mLineNum;
+}
+
+
+U32 LevelTokenizer::getArgc() const
+{
+   return mArgv.size();
+}
+
+
+const char **LevelTokenizer::getArgv()
+{
+   return mArgv.address();
+}
+
+
+S32 LevelTokenizer::getId() const
+{
+   return mId;
+}
+
+
 };
 
@@ -33,6 +33,51 @@ struct LevelLoadException : public std::exception
 };
 
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Splits level code into lines, and each line into the words that processLevelLoadLine() expects, following the same
+// rules as parseString(): words are separated by whitespace, and double quotes group several words into one.  Any
+// "!id" suffix on the first word is split off and returned by getId().
+//
+// Loading a level used to allocate a string for every word and an argv array for every line.  Here, each line is
+// copied into a buffer that is reused from line to line and carved up in place, so after the first few lines, nothing
+// gets allocated at all.  (The level data itself can't be carved up, as it may be a read-only mapped file.)  The
+// pointers returned by getArgv() are only good until the next call to nextLine().
+class LevelTokenizer
+{
+private:
+   const char *mData;
+   U32 mSize;
+   U32 mPos;
+
+   const char *mLine;
+   U32 mLineLength;           // Not counting the newline
+   U32 mLineBytes;            // Including the newline, if there is one
+   S32 mLineNum;
+
+   Vector<char> mLineBuffer;
+   Vector<const char *> mArgv;
+   S32 mId;
+
+   void tokenize();
+
+public:
+   LevelTokenizer(const char *data, U32 size);     // Constructor
+
+   bool nextLine();           // Advance to the next line; returns false when there are no more
+
+   const char *getLine() const;                    // Current line, as it appears in the data; not null-terminated
+   U32 getLineLength() const;
+   U32 getLineBytes() const;
+   S32 getLineNum() const;                         // First line is 1
+
+   U32 getArgc() const;
+   const char **getArgv();
+   S32 getId() const;
+};
+
+
 };
 
 #endif
@@ -13,6 +13,7 @@
 #include "GameRecorder.h"     // Needed, despite resharper
 #include "GeomUtils.h"
 #include "IniFile.h"          // For CIniFile
+#include "LuaProfiler.h"
 #include "ServerGame.h"
 #include "robot.h"
 #include "Spawn.h"
@@ -1126,6 +1127,12 @@ bool GameType::addWall(const WallRec &wall, Game *game)
 }
 
 
+void GameType::addPrebuiltWall(const WallRec &wall)
+{
+   mWalls.push_back(wall);              // So clients hear about it
+}
+
+
 // Runs on server, after level has been loaded from a file.  Can be overridden, but isn't.
 void GameType::onLevelLoaded()
 {
@@ -2702,6 +2709,24 @@ void GameType::processServerCommand(ClientInfo *clientInfo, const char *cmd, Vec
       else
          clientInfo->getConnection()->s2cDisplayErrorMessage("!!! Need admin");
    }
+   else if(stricmp(cmd, "luaprofile") == 0)
+   {
+      if(clientInfo->isAdmin())
+      {
+         Vector<string> profileArgs;
+         for(S32 i = 0; i < args.size(); i++)
+            profileArgs.push_back(args[i].getString());
+
+         string msg = LuaProfiler::get()->processCommand(LuaScriptRunner::getL(), profileArgs, 
+                                                         GameSettings::getFolderManager()->logDir);
+         if(msg.substr(0, 3) == "!!!")
+            clientInfo->getConnection()->s2cDisplayErrorMessage(msg.c_str());
+         else
+            clientInfo->getConnection()->s2cDisplayMessage(0, 0, msg.c_str());
+      }
+      else
+         clientInfo->getConnection()->s2cDisplayErrorMessage("!!! Need admin");
+   }
    else
       clientInfo->getConnection()->s2cDisplayErrorMessage("!!! Invalid Command");
 }
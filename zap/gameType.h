@@ -178,6 +178,7 @@ public:
    S32 getSecondLeadingPlayer() const;
 
    bool addWall(const WallRec &barrier, Game *game);
+   void addPrebuiltWall(const WallRec &barrier);      // For walls whose Barriers have already been added to the game
 
    virtual bool isFlagGame() const; // Does game use flags?
    virtual S32 getFlagCount();      // Return the number of game-significant flags
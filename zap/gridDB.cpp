@@ -6,6 +6,7 @@
 #include "gridDB.h"
 #include "moveObject.h"    // For def of ActualState
 #include "WallSegmentManager.h"
+#include "WallEdgeIndex.h"
 #include "GeomUtils.h"
 
 #include "tnlLog.h"
@@ -41,6 +42,9 @@ GridDatabase::GridDatabase(bool createWallSegmentManager)
       mWallSegmentManager = NULL;
 
    mDatabaseId = getNextId();
+   mGeometryVersion = 0;
+   mZoneVersion = 0;
+   mWallEdgeIndex = NULL;
 }
 
 
@@ -64,6 +68,8 @@ GridDatabase::~GridDatabase()
    if(mWallSegmentManager)
       delete mWallSegmentManager;
 
+   delete mWallEdgeIndex;
+
    mCountGridDatabase--;
 
    if(mCountGridDatabase == 0)
@@ -105,6 +111,7 @@ void GridDatabase::copyObjects(const GridDatabase *source)
    mGoalZones .reserve(source->mGoalZones.size());
    mFlags     .reserve(source->mFlags.size());
    mSpyBugs   .reserve(source->mSpyBugs.size());
+   mTurrets   .reserve(source->mTurrets.size());
 
 
    for(S32 i = 0; i < source->mAllObjects.size(); i++)
@@ -148,13 +155,11 @@ void GridDatabase::addToDatabase(DatabaseObject *theObject)
    // Add the object to our non-spatial "database" as well
    mAllObjects.push_back(theObject);
 
-   U8 type = theObject->getObjectTypeNumber();
-   if(type == GoalZoneTypeNumber)
-      mGoalZones.push_back(theObject);
-   else if(type == FlagTypeNumber)
-      mFlags.push_back(theObject);
-   else if(type == SpyBugTypeNumber)
-      mSpyBugs.push_back(theObject);
+   Vector<DatabaseObject *> *typeList = getTypeList(theObject->getObjectTypeNumber());
+   if(typeList)
+      typeList->push_back(theObject);
+
+   noteChangedObject(theObject);
    
    //sortObjects(mAllObjects);  // problem: Barriers in-game don't have mGeometry (it is NULL)
 }
@@ -190,8 +195,16 @@ void GridDatabase::removeEverythingFromDatabase()
    mGoalZones.clear();
    mFlags.clear();
    mSpyBugs.clear();
+   mTurrets.clear();
+   mShipSpawns.clear();
+   mFlagSpawns.clear();
+   mCores.clear();
+   mNexuses.clear();
+   mSoccerBalls.clear();
 
    mAllObjects.deleteAndClear();
+   mGeometryVersion++;
+   mZoneVersion++;
    
    if(mWallSegmentManager)
       mWallSegmentManager->clear();
@@ -243,14 +256,11 @@ void GridDatabase::removeFromDatabase(DatabaseObject *object, bool deleteObject)
       }
 
 
-   U8 type = object->getObjectTypeNumber();
+   Vector<DatabaseObject *> *typeList = getTypeList(object->getObjectTypeNumber());
+   if(typeList)
+      eraseObject_fast(typeList, object);
 
-   if(type == GoalZoneTypeNumber)
-      eraseObject_fast(&mGoalZones, object);
-   else if(type == FlagTypeNumber)
-      eraseObject_fast(&mFlags, object);
-   else if(type == SpyBugTypeNumber)
-      eraseObject_fast(&mSpyBugs, object);
+   noteChangedObject(object);
 
    if(deleteObject)
       delete object;      
@@ -276,17 +286,44 @@ const Vector<DatabaseObject *> *GridDatabase::findObjects_fast() const
 // Faster than above, but results can't be modified, and only works with selected types at the moment
 const Vector<DatabaseObject *> *GridDatabase::findObjects_fast(U8 typeNumber) const
 {
-   if(typeNumber == GoalZoneTypeNumber)
-      return &mGoalZones;
+   const Vector<DatabaseObject *> *typeList = getTypeList(typeNumber);
+
+   TNLAssert(typeList, "This type not currently supported!  Sorry dude!");
+   return typeList;
+}
+
 
-   if(typeNumber == FlagTypeNumber)
-      return &mFlags;
+Vector<DatabaseObject *> *GridDatabase::getTypeList(U8 typeNumber)
+{
+   switch(typeNumber)
+   {
+      case GoalZoneTypeNumber:
+         return &mGoalZones;
+      case FlagTypeNumber:
+         return &mFlags;
+      case SpyBugTypeNumber:
+         return &mSpyBugs;
+      case TurretTypeNumber:
+         return &mTurrets;
+      case ShipSpawnTypeNumber:
+         return &mShipSpawns;
+      case FlagSpawnTypeNumber:
+         return &mFlagSpawns;
+      case CoreTypeNumber:
+         return &mCores;
+      case NexusTypeNumber:
+         return &mNexuses;
+      case SoccerBallItemTypeNumber:
+         return &mSoccerBalls;
+      default:
+         return NULL;
+   }
+}
 
-   if(typeNumber == SpyBugTypeNumber)
-      return &mSpyBugs;
 
-   TNLAssert(false, "This type not currently supported!  Sorry dude!");
-   return NULL;  // this line gets rid of compile warning "Not all control paths return a value"
+const Vector<DatabaseObject *> *GridDatabase::getTypeList(U8 typeNumber) const
+{
+   return const_cast<GridDatabase *>(this)->getTypeList(typeNumber);
 }
 
 
@@ -349,7 +386,6 @@ void GridDatabase::findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVect
    //      fillVector.push_back(mSpyBugs[i]);
    //   return;
    //}
-
    for(S32 i = 0; i < mAllObjects.size(); i++)
       if(mAllObjects[i]->getObjectTypeNumber() == typeNumber)
          fillVector.push_back(mAllObjects[i]);
@@ -650,6 +686,17 @@ DatabaseObject *GridDatabase::findObjectLOS(TestFunc testFunc, U32 stateIndex, b
                                             const Point &rayStart, const Point &rayEnd, 
                                             float &collisionTime, Point &surfaceNormal) const
 {
+   // Wall-only queries are common (bots, turrets, explosions, forcefields) and can be answered by our edge index,
+   // which doesn't need to test every wall near the ray
+   if(testFunc == (TestFunc)isWallType && format)
+   {
+      mWallEdgeIndexLock.lock();
+      DatabaseObject *object = getWallEdgeIndex()->findObjectLOS(rayStart, rayEnd, collisionTime, surfaceNormal);
+      mWallEdgeIndexLock.unlock();
+
+      return object;
+   }
+
    Rect queryRect(rayStart, rayEnd);
 
    static Vector<DatabaseObject *> fillVector;  // Use local here, most callers expect our global fillVector to be left unchanged
@@ -657,51 +704,22 @@ DatabaseObject *GridDatabase::findObjectLOS(TestFunc testFunc, U32 stateIndex, b
 
    findObjects(testFunc, fillVector, queryRect);
 
-   Point collisionPoint;
-
    collisionTime = 1;
    DatabaseObject *retObject = NULL;
 
-   Point center;
-   Rect rect;
-
    for(S32 i = 0; i < fillVector.size(); i++)
    {
       if(!fillVector[i]->isCollisionEnabled())     // Skip collision-disabled objects
          continue;
 
-      const Vector<Point> *poly = fillVector[i]->getCollisionPoly();
-
-      F32 radius;
       float ct;
+      Point normal;
 
-      if(poly)
-      {
-         if(poly->size() == 0)    // This can happen in the editor when a wall segment is completely hidden by another
-            continue;
-
-         Point normal;
-         if(polygonIntersectsSegmentDetailed(&poly->get(0), poly->size(), format, rayStart, rayEnd, ct, normal))
-         {
-            if(ct < collisionTime)
-            {
-               collisionTime = ct;
-               retObject = fillVector[i];
-               surfaceNormal = normal;
-            }
-         }
-      }
-      else if(fillVector[i]->getCollisionCircle(stateIndex, center, radius))
+      if(objectIntersectsRay(fillVector[i], stateIndex, format, rayStart, rayEnd, ct, normal) && ct < collisionTime)
       {
-         if(circleIntersectsSegment(center, radius, rayStart, rayEnd, ct))
-         {
-            if(ct < collisionTime)
-            {
-               collisionTime = ct;
-               surfaceNormal = (rayStart + (rayEnd - rayStart) * ct) - center;
-               retObject = fillVector[i];
-            }
-         }
+         collisionTime = ct;
+         retObject = fillVector[i];
+         surfaceNormal = normal;
       }
    }
 
@@ -713,6 +731,69 @@ DatabaseObject *GridDatabase::findObjectLOS(TestFunc testFunc, U32 stateIndex, b
 }
 
 
+void GridDatabase::findAllObjectsLOS(TestFunc testFunc, U32 stateIndex, const Point &rayStart, const Point &rayEnd,
+                                     Vector<LOSHit> &hits) const
+{
+   hits.clear();
+
+   Rect queryRect(rayStart, rayEnd);
+
+   static Vector<DatabaseObject *> fillVector;
+   fillVector.clear();
+
+   findObjects(testFunc, fillVector, queryRect);
+
+   for(S32 i = 0; i < fillVector.size(); i++)
+   {
+      if(!fillVector[i]->isCollisionEnabled())     // Skip collision-disabled objects
+         continue;
+
+      LOSHit hit;
+      if(!objectIntersectsRay(fillVector[i], stateIndex, true, rayStart, rayEnd, hit.collisionTime, hit.normal) ||
+            hit.collisionTime >= 1)
+         continue;
+
+      hit.object = fillVector[i];
+      hit.normal.normalize();
+
+      // Keep hits sorted by time; objects hit at the same time stay in the order findObjectLOS() would pick them
+      S32 pos = hits.size();
+      while(pos > 0 && hits[pos - 1].collisionTime > hit.collisionTime)
+         pos--;
+
+      hits.insert(pos, hit);
+   }
+}
+
+
+// Does the ray hit the object?  If so, returns when, and the (unnormalized) surface normal where it hit.
+bool GridDatabase::objectIntersectsRay(const DatabaseObject *object, U32 stateIndex, bool format, const Point &rayStart,
+                                       const Point &rayEnd, F32 &collisionTime, Point &surfaceNormal)
+{
+   const Vector<Point> *poly = object->getCollisionPoly();
+
+   if(poly)
+   {
+      if(poly->size() == 0)    // This can happen in the editor when a wall segment is completely hidden by another
+         return false;
+
+      return polygonIntersectsSegmentDetailed(&poly->get(0), poly->size(), format, rayStart, rayEnd, collisionTime, surfaceNormal);
+   }
+
+   Point center;
+   F32 radius;
+
+   if(object->getCollisionCircle(stateIndex, center, radius) &&
+         circleIntersectsSegment(center, radius, rayStart, rayEnd, collisionTime))
+   {
+      surfaceNormal = (rayStart + (rayEnd - rayStart) * collisionTime) - center;
+      return true;
+   }
+
+   return false;
+}
+
+
 DatabaseObject *GridDatabase::findObjectLOS(TestFunc testFunc, U32 stateIndex,
                                             const Point &rayStart, const Point &rayEnd,
                                             float &collisionTime, Point &surfaceNormal) const
@@ -721,6 +802,46 @@ DatabaseObject *GridDatabase::findObjectLOS(TestFunc testFunc, U32 stateIndex,
 }
 
 
+// Walls and zones almost never change once a level is running, so results of queries against them can be cached.
+// Keep version numbers so those caches can tell when their results have gone stale.
+void GridDatabase::noteChangedObject(const DatabaseObject *object)
+{
+   U8 type = object->getObjectTypeNumber();
+
+   if(isWallType(type) || type == BotNavMeshZoneTypeNumber)
+      mGeometryVersion++;
+
+   else if(isZoneType(type))
+      mZoneVersion++;
+}
+
+
+U32 GridDatabase::getGeometryVersion() const
+{
+   return mGeometryVersion;
+}
+
+
+U32 GridDatabase::getZoneVersion() const
+{
+   return mZoneVersion;
+}
+
+
+// Returns the edge index, rebuilding it first if walls have changed since it was last used.  Caller must hold
+// mWallEdgeIndexLock.
+WallEdgeIndex *GridDatabase::getWallEdgeIndex() const
+{
+   if(!mWallEdgeIndex)
+      mWallEdgeIndex = new WallEdgeIndex();     // Deleted in destructor
+
+   if(!mWallEdgeIndex->isCurrent(mGeometryVersion))
+      mWallEdgeIndex->rebuild(this, mGeometryVersion);
+
+   return mWallEdgeIndex;
+}
+
+
 bool GridDatabase::pointCanSeePoint(const Point &point1, const Point &point2)
 {
    F32 time;
@@ -764,30 +885,19 @@ S32 GridDatabase::getObjectCount() const
 // Return count of objects of specified type.  Only supports certain types at the moment.
 S32 GridDatabase::getObjectCount(U8 typeNumber) const
 {
-   if(typeNumber == GoalZoneTypeNumber)
-      return mGoalZones.size();
+   const Vector<DatabaseObject *> *typeList = getTypeList(typeNumber);
 
-   if(typeNumber == FlagTypeNumber)
-      return mFlags.size();
-
-   if(typeNumber == SpyBugTypeNumber)
-      return mSpyBugs.size();
-
-   TNLAssert(false, "Unsupported type!");
-   return 0;
+   TNLAssert(typeList, "Unsupported type!");
+   return typeList ? typeList->size() : 0;
 }
 
 
 bool GridDatabase::hasObjectOfType(U8 typeNumber) const
 {
-   if(typeNumber == GoalZoneTypeNumber)
-      return mGoalZones.size() > 0;
+   const Vector<DatabaseObject *> *typeList = getTypeList(typeNumber);
 
-   if(typeNumber == FlagTypeNumber)
-      return mFlags.size() > 0;
-
-   if(typeNumber == SpyBugTypeNumber)
-      return mSpyBugs.size() > 0;
+   if(typeList)
+      return typeList->size() > 0;
 
    for(S32 i = 0; i < mAllObjects.size(); i++)
       if(mAllObjects[i]->getObjectTypeNumber() == typeNumber)
@@ -902,6 +1012,13 @@ void DatabaseObject::setExtent(const Rect &extents)
 
    if(gridDB)
    {
+      // Only walls and zones have versions that caches depend on.  They can change shape without changing extent, so
+      // don't assume nothing happened just because the extent is the same.
+      U8 type = getObjectTypeNumber();
+
+      if(isWallType(type) || isZoneType(type))
+         gridDB->noteChangedObject(this);
+
       // Remove from the extents database for current extents...
       //gridDB->removeFromDatabase(this, mExtent);    // old extent
       // ...and re-add for the new extent
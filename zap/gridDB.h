@@ -10,6 +10,7 @@
 
 #include "tnlTypes.h"
 #include "tnlDataChunker.h"
+#include "tnlThread.h"
 #include "tnlVector.h"
 
 #include "Rect.h"
@@ -97,7 +98,17 @@ public:
 ////////////////////////////////////////
 ////////////////////////////////////////
 
+// One object found along a ray by findAllObjectsLOS()
+struct LOSHit
+{
+   DatabaseObject *object;
+   F32 collisionTime;
+   Point normal;
+};
+
+
 class WallSegmentManager;
+class WallEdgeIndex;
 class GoalZone;
 class BfObject;
 
@@ -114,6 +125,22 @@ private:
    Vector<DatabaseObject *> mGoalZones;
    Vector<DatabaseObject *> mFlags;
    Vector<DatabaseObject *> mSpyBugs;
+   Vector<DatabaseObject *> mTurrets;
+   Vector<DatabaseObject *> mShipSpawns;        // These five are for the editor's level checks
+   Vector<DatabaseObject *> mFlagSpawns;
+   Vector<DatabaseObject *> mCores;
+   Vector<DatabaseObject *> mNexuses;
+   Vector<DatabaseObject *> mSoccerBalls;
+
+   Vector<DatabaseObject *> *getTypeList(U8 typeNumber);               // Our list for objects of typeNumber, or NULL if we don't keep one
+   const Vector<DatabaseObject *> *getTypeList(U8 typeNumber) const;
+
+   U32 mGeometryVersion;               // See getGeometryVersion()
+   U32 mZoneVersion;                   // See getZoneVersion()
+   mutable WallEdgeIndex *mWallEdgeIndex;    // Built on demand for wall-only LOS queries
+   mutable Mutex mWallEdgeIndexLock;         // Index rebuilds itself and keeps per-query scratch, so one user at a time
+
+   WallEdgeIndex *getWallEdgeIndex() const;
 
    void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const;
    void findObjects(Vector<U8> typeNumbers, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const;
@@ -121,6 +148,9 @@ private:
 
    void fillBins(const Rect &extents, IntRect &bins) const;    // Helper function -- translates extents into bins to search
 
+   static bool objectIntersectsRay(const DatabaseObject *object, U32 stateIndex, bool format, const Point &rayStart,
+                                   const Point &rayEnd, F32 &collisionTime, Point &surfaceNormal);
+
 public:
    enum {
       BucketRowCount = 16,    // Number of buckets per grid row, and number of rows; should be power of 2
@@ -147,12 +177,15 @@ public:
    DatabaseObject *findObjectLOS(TestFunc testFunc, U32 stateIndex, const Point &rayStart, const Point &rayEnd,
                                  float &collisionTime, Point &surfaceNormal) const;
 
+   // Finds every object along the ray, ordered by collision time, so the caller can pass over ones it wants to ignore
+   void findAllObjectsLOS(TestFunc testFunc, U32 stateIndex, const Point &rayStart, const Point &rayEnd, Vector<LOSHit> &hits) const;
+
    bool pointCanSeePoint(const Point &point1, const Point &point2);
    void computeSelectionMinMax(Point &min, Point &max);
 
    void findObjects(Vector<DatabaseObject *> &fillVector) const;     // Returns all objects in the database
    const Vector<DatabaseObject *> *findObjects_fast() const;         // Faster than above, but results can't be modified
-   const Vector<DatabaseObject *> *findObjects_fast(U8 typeNumber) const;   // Currently only works with goalZones, may be expanded in the future
+   const Vector<DatabaseObject *> *findObjects_fast(U8 typeNumber) const;   // Only works with types listed in getTypeList()
 
    void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector) const;
    void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
@@ -185,6 +218,10 @@ public:
    virtual void removeFromDatabase(DatabaseObject *theObject, bool deleteObject);
    virtual void removeEverythingFromDatabase();
 
+   void noteChangedObject(const DatabaseObject *object);
+   U32 getGeometryVersion() const;                      // Changes whenever a wall or bot zone is added, removed, or moved
+   U32 getZoneVersion() const;                          // Changes whenever a zone ships can be in is added, removed, or moved
+
    S32 getObjectCount() const;                          // Return the number of objects currently in the database
    S32 getObjectCount(U8 typeNumber) const;             // Return the number of objects currently in the database of specified type
    bool hasObjectOfType(U8 typeNumber) const;
@@ -125,6 +125,7 @@ using namespace TNL;
 #include "BotNavMeshZone.h"
 #include "ship.h"
 #include "LevelSource.h"
+#include "WorkerPool.h"
 
 #include <math.h>
 #include <stdarg.h>
@@ -307,14 +308,23 @@ void loadAnotherLevelOrStartHosting()
 
    if(GameManager::getHostingModePhase() == GameManager::LoadingLevels)
    {
-      string levelName = GameManager::getServerGame()->loadNextLevelInfo();
+      // Level info usually comes straight from the level index, so handle as many levels as we can in a few ms,
+      // rather than one per tick
+      const U32 MaxLoadTimePerTick = 20;
+      U32 startTime = Platform::getRealMilliseconds();
+
+      do
+      {
+         string levelName = GameManager::getServerGame()->loadNextLevelInfo();
 
 #ifndef ZAP_DEDICATED
-      const Vector<ClientGame *> *clientGames = GameManager::getClientGames();
-      // Notify any client UIs on the hosting machine that the server has loaded a level
-      for(S32 i = 0; i < clientGames->size(); i++)
-         clientGames->get(i)->getUIManager()->serverLoadedLevel(levelName);
+         const Vector<ClientGame *> *clientGames = GameManager::getClientGames();
+         // Notify any client UIs on the hosting machine that the server has loaded a level
+         for(S32 i = 0; i < clientGames->size(); i++)
+            clientGames->get(i)->getUIManager()->serverLoadedLevel(levelName);
 #endif
+      } while(GameManager::getHostingModePhase() == GameManager::LoadingLevels &&
+              Platform::getRealMilliseconds() - startTime < MaxLoadTimePerTick);
    }
 
    else if(GameManager::getHostingModePhase() == GameManager::DoneLoadingLevels)
@@ -486,6 +496,7 @@ void shutdownBitfighter()
    EventManager::shutdown();
    LuaScriptRunner::shutdown();
    SoundSystem::shutdown();
+   WorkerPool::shutdown();
 
    if(!settings->isDedicatedServer())
    {
@@ -1213,6 +1224,8 @@ int main(int argc, char **argv)
 
    setupLogging(settings->getIniSettings());    // Turns various logging options on and off
 
+   WorkerPool::init();                          // Start worker threads before anything can ask for them
+
    Ship::computeMaxFireDelay();                 // Look over weapon info and get some ranges, which we'll need before we start sending data
 
    settings->runCmdLineDirectives();            // If we specified a directive on the cmd line, like -help, attend to that now
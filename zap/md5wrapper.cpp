@@ -180,6 +180,45 @@ std::string md5wrapper::getHashFromFile(std::string filename)
 	return convToString(digest);
 }
 
+
+//---------md5stream--------------------------
+
+struct md5stream::State
+{
+   hash_state md;
+};
+
+
+// Constructor
+md5stream::md5stream()
+{
+   mState = new State();
+   md5_init(&mState->md);
+}
+
+
+// Destructor
+md5stream::~md5stream()
+{
+   delete mState;
+}
+
+
+void md5stream::process(const char *data, unsigned int length)
+{
+   md5_process(&mState->md, (const unsigned char *)data, length);
+}
+
+
+std::string md5stream::getHash()
+{
+   unsigned char digest[16];
+   md5_done(&mState->md, digest);
+
+   md5wrapper wrapper;
+   return wrapper.convToString(digest);
+}
+
 /*
  * EOF
  */
@@ -38,6 +38,8 @@ class md5wrapper
 		 */
 		std::string convToString(unsigned char *bytes);
 
+		friend class md5stream;
+
 
 	public:
 		//constructor
@@ -67,5 +69,32 @@ class md5wrapper
 };
 
 
+/*
+ * builds a MD5 hash a piece at a time, for
+ * hashing data while it is being read for
+ * something else; the result is the same as
+ * hashing all the pieces joined together
+ */
+class md5stream
+{
+	private:
+		struct State;
+		State *mState;			// Deleted in destructor
+
+		// Not copyable
+		md5stream(const md5stream &);
+		md5stream &operator=(const md5stream &);
+
+	public:
+		md5stream();
+		virtual ~md5stream();
+
+		void process(const char *data, unsigned int length);
+
+		// Finishes the hash; call only once
+		std::string getHash();
+};
+
+
 //include protection
 #endif // MD5WRAPPER_H
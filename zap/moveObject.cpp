@@ -71,6 +71,8 @@ MoveObject::MoveObject(const Point &pos, F32 radius, F32 mass) : Parent(radius)
    mInterpolating = false;
    mHitLimit = 16;
    mZones1IsCurrent = true;
+   mZoneCheckDistance = -1;
+   mZoneCheckVersion = 0;
 
    LUAW_CONSTRUCTOR_INITIALIZATIONS;
 }
@@ -116,6 +118,8 @@ void MoveObject::idle(BfObject::IdleCallPath path)
 void MoveObject::onAddedToGame(Game *game)
 {
    Parent::onAddedToGame(game);
+
+   mZoneCheckDistance = -1;     // Zone versions from any database we were in before mean nothing here
     
 #ifndef ZAP_DEDICATED
    if(isGhost())     // Client only
@@ -331,13 +335,31 @@ const F32 velocityEpsilon = 0.00001f;
 // Apply mMoveState info to an object to compute it's new position.  Used for ships et. al.
 // isBeingDisplaced is true when the object is being pushed by something else, which will only happen in a collision
 // Remember: stateIndex will be one of 0-ActualState, 1-RenderState, or 2-LastProcessState
-F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector<SafePtr<MoveObject> > displacerList)
+F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced)
+{
+   Vector<SafePtr<MoveObject> > displacerList;
+   return move(moveTime, stateIndex, isBeingDisplaced, displacerList);
+}
+
+
+// displacerList holds the objects that are (recursively) pushing us.  Anything we add to it is removed before we return,
+// so it can be shared by the whole chain of displacements rather than copied at each level.
+F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector<SafePtr<MoveObject> > &displacerList)
 {
    U32 tryCount = 0;
    const U32 TRY_COUNT_MAX = 8;
    Vector<SafePtr<BfObject> > disabledList;
    F32 moveTimeStart = moveTime;
 
+   S32 displacerCount = displacerList.size();
+
+   // After our first collision, we'll gather everything we could reach at our current speed in one query, and reuse
+   // that for the rest of our sub-steps.  Anything that might add, remove, or move objects invalidates it.
+   Vector<DatabaseObject *> nearbyObjects;
+   Rect nearbyExtent;
+   bool nearbyObjectsValid = false;
+   bool firstPass = true;
+
    static Point origPos;   // Reusable container
    origPos = getPos(stateIndex);
 
@@ -352,7 +374,37 @@ F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector
       F32 collisionTime = moveTime;
       static Point collisionPoint, newPos;     // Reusable containers
 
-      BfObject *objectHit = findFirstCollision(stateIndex, collisionTime, collisionPoint);
+      BfObject *objectHit;
+
+      if(firstPass)     // Most moves don't hit anything, so only look where we're going
+      {
+         objectHit = findFirstCollision(stateIndex, collisionTime, collisionPoint);
+         firstPass = false;
+      }
+      else
+      {
+         Rect sweptExtent = getSweptExtent(stateIndex, moveTime);
+
+         if(!nearbyObjectsValid || !nearbyExtent.contains(sweptExtent.min) || !nearbyExtent.contains(sweptExtent.max))
+         {
+            // Cover any direction we might bounce off in, at our current speed
+            nearbyExtent.set(getPos(stateIndex), getVel(stateIndex).len() * moveTime + mRadius);
+            nearbyExtent.unionRect(sweptExtent);
+
+            nearbyObjects.clear();
+            findObjects(collideTypes(), nearbyObjects, nearbyExtent);
+            nearbyObjectsValid = true;
+         }
+
+         fillVector.clear();
+
+         for(S32 i = 0; i < nearbyObjects.size(); i++)
+            if(nearbyObjects[i]->getExtent().intersects(sweptExtent))
+               fillVector.push_back(nearbyObjects[i]);
+
+         objectHit = findFirstCollision(stateIndex, collisionTime, collisionPoint, fillVector);
+      }
+
       if(!objectHit)    // No collision (or if isBeingDisplaced is true, we haven't been pushed into another object)
       {
          newPos = getPos(stateIndex) + getVel(stateIndex) * moveTime;   // Move to desired destination
@@ -370,6 +422,7 @@ F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector
          disabledList.push_back(objectHit);
          objectHit->disableCollision();
          tryCount--;   // Don't count as tryCount
+         nearbyObjectsValid = false;
       }
       else if(objectHit->isMoveObject())     // Collided with a MoveObject (including a ship)
       {
@@ -416,6 +469,7 @@ F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector
                // Move the displaced object a tiny bit, true -> isBeingDisplaced
                moveObjectThatWasHit->move(t + displaceEpsilon, stateIndex, true, displacerList); 
                mHitLimit--;
+               nearbyObjectsValid = false;
             }
          }
       }
@@ -432,6 +486,8 @@ F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector
    if(tryCount == TRY_COUNT_MAX && moveTime > moveTimeStart * 0.98f)
       setVel(stateIndex, Point(0,0));  // prevents some overload by not trying to move anymore
 
+   displacerList.resize(displacerCount);
+
    return (getPos(stateIndex) - origPos).len();    // Return distance traveled during this move
 }
 
@@ -448,33 +504,51 @@ TestFunc MoveObject::collideTypes()
 }
 
 
-static S32 QSORT_CALLBACK sortBarriersFirst(DatabaseObject **a, DatabaseObject **b)
+// Area we could touch while moving at our current velocity for the specified time
+Rect MoveObject::getSweptExtent(U32 stateIndex, F32 time) const
 {
-   return ((*b)->getObjectTypeNumber() == BarrierTypeNumber ? 1 : 0) - ((*a)->getObjectTypeNumber() == BarrierTypeNumber ? 1 : 0);
+   Rect extent(getPos(stateIndex), getPos(stateIndex) + getVel(stateIndex) * time);
+   extent.expand(Point(mRadius, mRadius));
+
+   return extent;
 }
 
 
 BfObject *MoveObject::findFirstCollision(U32 stateIndex, F32 &collisionTime, Point &collisionPoint)
 {
-   // Check for collisions against other objects
-   Point delta = getVel(stateIndex) * collisionTime;
+   fillVector.clear();
 
-   Rect queryRect(getPos(stateIndex), getPos(stateIndex) + delta);
-   queryRect.expand(Point(mRadius, mRadius));
+   findObjects(collideTypes(), fillVector, getSweptExtent(stateIndex, collisionTime));   // Free CPU for finding only the ones we care about
 
-   fillVector.clear();
+   return findFirstCollision(stateIndex, collisionTime, collisionPoint, fillVector);
+}
 
-   findObjects(collideTypes(), fillVector, queryRect);   // Free CPU for finding only the ones we care about
 
-   fillVector.sort(sortBarriersFirst);  // Sort to do Barriers::Collide first, to prevent picking up flag (FlagItem::Collide) through Barriers, especially when client does /maxfps 10
+// Check for collisions against a list of candidate objects; candidates will be reordered
+BfObject *MoveObject::findFirstCollision(U32 stateIndex, F32 &collisionTime, Point &collisionPoint,
+                                         Vector<DatabaseObject *> &candidates)
+{
+   Point delta = getVel(stateIndex) * collisionTime;
+
+   // Do Barriers::Collide first, to prevent picking up flag (FlagItem::Collide) through Barriers, especially when client
+   // does /maxfps 10.  A single partitioning pass is all the ordering we need.
+   S32 barrierCount = 0;
+   for(S32 i = 0; i < candidates.size(); i++)
+      if(candidates[i]->getObjectTypeNumber() == BarrierTypeNumber)
+      {
+         DatabaseObject *barrier = candidates[i];
+         candidates[i] = candidates[barrierCount];
+         candidates[barrierCount] = barrier;
+         barrierCount++;
+      }
 
    F32 collisionFraction;
 
    BfObject *collisionObject = NULL;
 
-   for(S32 i = 0; i < fillVector.size(); i++)
+   for(S32 i = 0; i < candidates.size(); i++)
    {
-      BfObject *foundObject = static_cast<BfObject *>(fillVector[i]);
+      BfObject *foundObject = static_cast<BfObject *>(candidates[i]);
 
       if(!foundObject->isCollisionEnabled())
          continue;
@@ -571,6 +645,14 @@ BfObject *MoveObject::findFirstCollision(U32 stateIndex, F32 &collisionTime, Poi
 // Server only
 void MoveObject::checkForZones()
 {
+   GridDatabase *database = getDatabase();
+   Point pos = getActualPos();
+
+   // If we can't have reached a zone edge since we last looked, and nobody has changed any zones, nothing has changed
+   if(database && mZoneCheckDistance > 0 && mZoneCheckVersion == database->getZoneVersion() &&
+         pos.distSquared(mZoneCheckPos) < sq(mZoneCheckDistance))
+      return;
+
    Vector<SafePtr<Zone> > &currZoneList = getCurrZoneList();
    Vector<SafePtr<Zone> > &prevZoneList = getPrevZoneList();
 
@@ -585,6 +667,53 @@ void MoveObject::checkForZones()
       // Zone can sometimes disappear if removed from the game via Lua, check if valid first
       if(prevZoneList[i].isValid() && !currZoneList.contains(prevZoneList[i]))
          onLeftZone(prevZoneList[i].getPointer());
+
+   if(database)
+   {
+      mZoneCheckPos = pos;
+      mZoneCheckDistance = getZoneEdgeClearance(pos);
+      mZoneCheckVersion = database->getZoneVersion();
+   }
+}
+
+
+// Returns how far we could move from pos, in any direction, without the results of getZonesObjectIsIn() changing.
+// That can only happen when we cross a zone edge, but polygonContainsPoint() truncates its math to ints, which makes
+// edges a bit fuzzy; the fuzzy band is narrower than 1 / the length of the edge, so we pad our margin by that much.
+F32 MoveObject::getZoneEdgeClearance(const Point &pos)
+{
+   Rect rect(pos, pos);
+   rect.expand(Point(MaxZoneCheckDistance, MaxZoneCheckDistance));
+
+   fillVector.clear();
+   findObjects((TestFunc)isZoneType, fillVector, rect);    // Zones outside this rect are farther away than our max
+
+   F32 clearance = F32(MaxZoneCheckDistance);
+
+   for(S32 i = 0; i < fillVector.size(); i++)
+   {
+      const Vector<Point> *polyPoints = fillVector[i]->getCollisionPoly();
+
+      for(S32 j = 0; j < polyPoints->size(); j++)
+      {
+         const Point &v1 = polyPoints->get(j == 0 ? polyPoints->size() - 1 : j - 1);
+         const Point &v2 = polyPoints->get(j);
+
+         Point edge = v2 - v1;
+         F32 lenSq = edge.lenSquared();
+
+         if(lenSq == 0)    // Zero-length edges never count toward containment
+            continue;
+
+         // Closest point on the edge to pos
+         F32 fraction = max(0.f, min(1.f, (pos - v1).dot(edge) / lenSq));
+         F32 dist = (v1 + edge * fraction).distanceTo(pos);
+
+         clearance = min(clearance, dist - 1 - 1 / sqrt(lenSq));
+      }
+   }
+
+   return clearance;
 }
 
 
@@ -607,6 +736,7 @@ void MoveObject::getZonesObjectIsIn(Vector<SafePtr<Zone> > &zoneList)
 {
    // Use this boolean as a cheap way of making the current zone list be the previous out without copying
    mZones1IsCurrent = !mZones1IsCurrent;
+   mZoneCheckDistance = -1;   // Lists have been switched around, so checkForZones() can't trust them to be current
 
    zoneList.clear();
 
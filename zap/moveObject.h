@@ -63,8 +63,17 @@ private:
    Vector<SafePtr<Zone> > mZones2;
    bool mZones1IsCurrent;        // "Pointer" to one of the above
 
+   // Zones can't change until the object crosses a zone edge, so we only check again once it has moved far enough
+   // that it might have, or zones have been changed
+   static const S32 MaxZoneCheckDistance = 128;
+
+   Point mZoneCheckPos;          // Where we last looked for zones...
+   F32 mZoneCheckDistance;       // ...how far we can get from there before looking again (< 0 means look next time)...
+   U32 mZoneCheckVersion;        // ...and the zone version of the database when we looked
+
    Vector<SafePtr<Zone> > &getCurrZoneList();                  // Get list of zones object is currently in
    Vector<SafePtr<Zone> > &getPrevZoneList();                  // Get list of zones object was in last tick
+   F32 getZoneEdgeClearance(const Point &pos);
 
 protected:
    enum {
@@ -147,13 +156,16 @@ public:
 
    virtual void playCollisionSound(U32 stateIndex, MoveObject *moveObjectThatWasHit, F32 velocity);
 
-   F32 move(F32 time, U32 stateIndex, bool displacing = false, Vector<SafePtr<MoveObject> > = Vector<SafePtr<MoveObject> >());
+   F32 move(F32 time, U32 stateIndex, bool displacing = false);
+   F32 move(F32 time, U32 stateIndex, bool displacing, Vector<SafePtr<MoveObject> > &displacerList);
    virtual bool collide(BfObject *otherObject);
 
    // CollideTypes is used to improve speed on findFirstCollision
    virtual TestFunc collideTypes();
 
+   Rect getSweptExtent(U32 stateIndex, F32 time) const;
    BfObject *findFirstCollision(U32 stateIndex, F32 &collisionTime, Point &collisionPoint);
+   BfObject *findFirstCollision(U32 stateIndex, F32 &collisionTime, Point &collisionPoint, Vector<DatabaseObject *> &candidates);
    void computeCollisionResponseMoveObject(U32 stateIndex, MoveObject *objHit);
    void computeCollisionResponseBarrier(U32 stateIndex, Point &collisionPoint);
    F32 computeMinSeperationTime(U32 stateIndex, MoveObject *contactObject, Point intendedPos);
@@ -6,6 +6,8 @@
 #include "projectile.h"
 #include "ship.h"
 #include "game.h"
+#include "ServerGame.h"
+#include "TargetIndex.h"
 #include "gameConnection.h"
 
 #ifndef ZAP_DEDICATED
@@ -17,6 +19,7 @@
 
 #include "stringUtils.h"
 #include "MathUtils.h"
+#include "ObjectPool.h"
 
 
 namespace Zap 
@@ -113,6 +116,20 @@ Projectile::~Projectile()
 }
 
 
+static ObjectPool<Projectile> projectilePool("Projectile");
+
+void *Projectile::operator new(size_t size)
+{
+   return projectilePool.alloc(size);
+}
+
+
+void Projectile::operator delete(void *ptr, size_t size)
+{
+   projectilePool.free(ptr, size);
+}
+
+
 U32 Projectile::packUpdate(GhostConnection *connection, U32 updateMask, BitStream *stream)
 {
    if(stream->writeFlag(updateMask & PositionMask))
@@ -262,47 +279,37 @@ void Projectile::idle(BfObject::IdleCallPath path)
          // Calculate where projectile will be at the end of the current interval
          Point endPos = startPos + (mVelocity * .001f) * timeLeft;    // mVelocity in units/sec, timeLeft in ms
 
-         // Check for collision along projected route of movement
-         static Vector<BfObject *> disabledList;
-
-         Rect queryRect(startPos, endPos);     // Bounding box of our travels
-
-         disabledList.clear();
-
+         // Find everything along our projected route of movement, in the order we would hit it.  We only need to
+         // search once: things that don't want to be collided with (i.e. whose collide methods return false) are
+         // simply passed over, rather than having their collisions disabled so we can search again.
+         static Vector<LOSHit> hits;
+         findAllObjectsLOS((TestFunc)isWeaponCollideableType, RenderState, startPos, endPos, hits);
 
          // Don't collide with shooter during first 500ms of life
-         if(mShooter.isValid() && objAge < 500 && !mBounced)
-         {
-            disabledList.push_back(mShooter);
-            mShooter->disableCollision();
-         }
+         bool ignoreShooter = mShooter.isValid() && objAge < 500 && !mBounced;
 
-         BfObject *hitObject;
+         BfObject *hitObject = NULL;
 
-         F32 collisionTime;
+         F32 collisionTime = 1;
          Point surfNormal;
 
-         // Do the search
-         while(true)  
+         for(S32 i = 0; i < hits.size(); i++)
          {
-            hitObject = findObjectLOS((TestFunc)isWeaponCollideableType, RenderState, startPos, endPos, collisionTime, surfNormal);
+            BfObject *candidate = static_cast<BfObject *>(hits[i].object);
 
-            if((!hitObject || hitObject->collide(this)))
-               break;
+            if(ignoreShooter && candidate == mShooter.getPointer())
+               continue;
 
-            // Disable collisions with things that don't want to be
-            // collided with (i.e. whose collide methods return false)
-            disabledList.push_back(hitObject);
-            hitObject->disableCollision();
+            if(candidate->collide(this))
+            {
+               // hitObject contains the first thing that the projectile hit
+               hitObject = candidate;
+               collisionTime = hits[i].collisionTime;
+               surfNormal = hits[i].normal;
+               break;
+            }
          }
 
-         // Re-enable collison flag for ship and items in our path that don't want to be collided with
-         // Note that if we hit an object that does want to be collided with, it won't be in disabledList
-         // and thus collisions will not have been disabled, and thus don't need to be re-enabled.
-         // Our collision detection is done, and hitObject contains the first thing that the projectile hit.
-         for(S32 i = 0; i < disabledList.size(); i++)
-            disabledList[i]->enableCollision();
-
          // This logic lets the Railgun go through ships. It assumes that the
          // object search will return the same order of objects during this time frame
          //
@@ -661,6 +668,20 @@ Burst::~Burst()
 }
 
 
+static ObjectPool<Burst> burstPool("Burst");
+
+void *Burst::operator new(size_t size)
+{
+   return burstPool.alloc(size);
+}
+
+
+void Burst::operator delete(void *ptr, size_t size)
+{
+   burstPool.free(ptr, size);
+}
+
+
 // Runs on client and server
 void Burst::idle(IdleCallPath path)
 {
@@ -808,11 +829,7 @@ void Burst::explode(const Point &pos)
    damageInfo.damageType           = DamageTypeArea;
    damageInfo.damageSelfMultiplier = WeaponInfo::getWeaponInfo(mWeaponType).damageSelfMultiplier;
 
-   S32 hits = radiusDamage(pos, InnerBlastRadius, OuterBlastRadius, (TestFunc)isRadiusDamageAffectableType, damageInfo);
-
-   if(getOwner())
-      for(S32 i = 0; i < hits; i++)
-         getOwner()->getStatistics()->countHit(mWeaponType);
+   radiusDamage(pos, InnerBlastRadius, OuterBlastRadius, (TestFunc)isRadiusDamageAffectableType, damageInfo, 2000, mWeaponType);
 
    disableCollision();
    deleteObject(100);
@@ -921,6 +938,20 @@ Mine::~Mine()
 }
 
 
+static ObjectPool<Mine> minePool("Mine");
+
+void *Mine::operator new(size_t size)
+{
+   return minePool.alloc(size);
+}
+
+
+void Mine::operator delete(void *ptr, size_t size)
+{
+   minePool.free(ptr, size);
+}
+
+
 void Mine::initialize(const Point &pos)
 {
    mObjectTypeNumber = MineTypeNumber;
@@ -1483,6 +1514,20 @@ Seeker::~Seeker()
 }
 
 
+static ObjectPool<Seeker> seekerPool("Seeker");
+
+void *Seeker::operator new(size_t size)
+{
+   return seekerPool.alloc(size);
+}
+
+
+void Seeker::operator delete(void *ptr, size_t size)
+{
+   seekerPool.free(ptr, size);
+}
+
+
 void Seeker::initialize(const Point &pos, const Point &vel, F32 angle, BfObject *shooter)
 {
    mObjectTypeNumber = SeekerTypeNumber;
@@ -1654,21 +1699,24 @@ void Seeker::idle(IdleCallPath path)
 // Will consider targets within TargetAcquisitionRadius in a outward cone with spread TargetSearchAngle
 void Seeker::acquireTarget()
 {
-   F32 ourAngle = getActualAngle();
-
    // Used for wall detection
    static Vector<DatabaseObject *> localFillVector;
 
-   Rect queryRect(getPos(), TargetAcquisitionRadius);
-   fillVector.clear();
-   findObjects(isSeekerTarget, fillVector, queryRect);
+   // Ships in range and in our "cone of vision", closest first
+   static Vector<BfObject *> targets;
+   targets.clear();
 
-   F32 closest = F32_MAX;
+   Point range((F32)TargetAcquisitionRadius, (F32)TargetAcquisitionRadius);
+   static_cast<ServerGame *>(getGame())->getTargetIndex()->findClosest(getPos(), range, TargetIndex::ShipFlag,
+                                                                         getActualAngle(), TargetSearchAngle, targets);
 
-   for(S32 i = 0; i < fillVector.size(); i++)
+   for(S32 i = 0; i < targets.size(); i++)
    {
-      TNLAssert(dynamic_cast<BfObject *>(fillVector[i]), "Not a BfObject");
-      BfObject *foundObject = static_cast<BfObject *>(fillVector[i]);
+      BfObject *foundObject = targets[i];
+
+      // Skip anything deleted since the index was built
+      if(!isSeekerTarget(foundObject->getObjectTypeNumber()))
+         continue;
 
       // Don't target self
       //if(mShooter == foundObject)
@@ -1679,22 +1727,6 @@ void Seeker::acquireTarget()
       if(!getGame()->objectCanDamageObject(this, foundObject))
          continue;
 
-      Point delta = foundObject->getPos() - getPos();
-      F32 distanceSq = delta.lenSquared();
-
-      //// Only acquire an object within a circle radius instead of query rect
-      //if(distanceSq > TargetAcquisitionRadius * TargetAcquisitionRadius)
-      //   continue;
-
-      // This target is not the closest
-      if(distanceSq > closest)
-         continue;
-
-      // See if object is within our "cone of vision"
-      F32 ang = normalizeAngle(getPos().angleTo(foundObject->getPos()) - ourAngle);
-      if(ang > TargetSearchAngle * 0.5f || ang < -TargetSearchAngle * 0.5f)
-         continue;
-
       // Finally make sure there are no collideable objects in the way (like walls, forcefields)
       localFillVector.clear();
       findObjects((TestFunc)isCollideableType, localFillVector, Rect(getPos(), foundObject->getPos()));
@@ -1702,9 +1734,9 @@ void Seeker::acquireTarget()
       F32 dummy;
       bool wallInTheWay = false;
 
-      for(S32 i = 0; i < localFillVector.size(); i++)
+      for(S32 j = 0; j < localFillVector.size(); j++)
       {
-         BfObject *collideObject = static_cast<BfObject *>(localFillVector[i]);
+         BfObject *collideObject = static_cast<BfObject *>(localFillVector[j]);
 
          if(collideObject->collide(this) &&   // Test forcefield up or down
                objectIntersectsSegment(collideObject, getPos(), foundObject->getPos(), dummy))
@@ -1717,8 +1749,9 @@ void Seeker::acquireTarget()
       if(wallInTheWay)
          continue;
 
-      closest = distanceSq;
+      // Since they're in order, the first one we can get to is the closest
       mAcquiredTarget = foundObject;
+      break;
    }
 }
 
@@ -1840,11 +1873,8 @@ void Seeker::handleCollision(BfObject *hitObject, Point collisionPoint)
       damageInfo.damagingObject = this;
       damageInfo.damageSelfMultiplier = WeaponInfo::getWeaponInfo(mWeaponType).damageSelfMultiplier;
 
-      S32 hits = radiusDamage(collisionPoint, InnerBlastRadius, OuterBlastRadius, (TestFunc)isRadiusDamageAffectableType, damageInfo, 200);
-
-      if(getOwner())
-         for(S32 i = 0; i < hits; i++)
-            getOwner()->getStatistics()->countHit(mWeaponType);
+      radiusDamage(collisionPoint, InnerBlastRadius, OuterBlastRadius, (TestFunc)isRadiusDamageAffectableType, damageInfo, 200,
+                   mWeaponType);
    }
 
    mTimeRemaining = 0;
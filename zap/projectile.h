@@ -66,6 +66,9 @@ public:
    explicit Projectile(lua_State *L = NULL);                                            // Combined Lua / C++ default constructor -- only used in Lua at the moment
    virtual ~Projectile();                                                               // Destructor
 
+   static void *operator new(size_t size);        // Allocated from a pool; see ObjectPool.h
+   static void operator delete(void *ptr, size_t size);
+
    U32 packUpdate(GhostConnection *connection, U32 updateMask, BitStream *stream);
    void unpackUpdate(GhostConnection *connection, BitStream *stream);
 
@@ -123,6 +126,9 @@ public:
    explicit Burst(lua_State *L = NULL);                                                     // Combined Lua / C++ default constructor
    virtual ~Burst();                                                                        // Destructor
 
+   static void *operator new(size_t size);        // Allocated from a pool; see ObjectPool.h
+   static void operator delete(void *ptr, size_t size);
+
    enum Constants
    {
       FirstFreeMask = MoveItem::FirstFreeMask,
@@ -192,6 +198,9 @@ public:
    explicit Mine(lua_State *L = NULL);       // Combined Lua / C++ default constructor -- used in Lua and editor
    virtual ~Mine();                          // Destructor
 
+   static void *operator new(size_t size);        // Allocated from a pool; see ObjectPool.h
+   static void operator delete(void *ptr, size_t size);
+
    Mine *clone() const;
 
    bool collide(BfObject *otherObj);
@@ -338,6 +347,9 @@ public:
    explicit Seeker(lua_State *L = NULL);                                        // Combined Lua / C++ default constructor
    virtual ~Seeker();                                                           // Destructor
 
+   static void *operator new(size_t size);        // Allocated from a pool; see ObjectPool.h
+   static void operator delete(void *ptr, size_t size);
+
    WeaponType mWeaponType;
    SeekerStyle mStyle;
 
@@ -14,6 +14,8 @@
 #include "GeomUtils.h"
 
 #include "ServerGame.h"
+#include "BotVisibilityCache.h"
+#include "TargetIndex.h"
 #include "GameManager.h"
 
 
@@ -501,38 +503,12 @@ F32 Robot::getAnglePt(Point point)
 
 bool Robot::canSeePoint(Point point, bool wallOnly)
 {
-   Point difference = point - getActualPos();
+   // Walls don't move, so wall-only answers can be shared between bots and across ticks
+   if(wallOnly)
+      return static_cast<ServerGame *>(getGame())->getBotVisibilityCache()->canSeePoint(getActualPos(), point, mRadius);
 
-   Point crossVector(difference.y, -difference.x);  // Create a point whose vector from 0,0 is perpenticular to the original vector
-   crossVector.normalize(mRadius);                  // reduce point so the vector has length of ship radius
-
-   // Edge points of ship
-   Point shipEdge1 = getActualPos() + crossVector;
-   Point shipEdge2 = getActualPos() - crossVector;
-
-   // Edge points of point
-   Point pointEdge1 = point + crossVector;
-   Point pointEdge2 = point - crossVector;
-
-   Vector<Point> thisPoints;
-   thisPoints.push_back(shipEdge1);
-   thisPoints.push_back(shipEdge2);
-   thisPoints.push_back(pointEdge2);
-   thisPoints.push_back(pointEdge1);
-
-   Rect queryRect(thisPoints);
-
-   fillVector.clear();
-   mGame->getGameObjDatabase()->findObjects(wallOnly ? (TestFunc)isWallType : (TestFunc)isCollideableType, fillVector, queryRect);
-
-   for(S32 i = 0; i < fillVector.size(); i++)
-   {
-      const Vector<Point> *otherPoints = fillVector[i]->getCollisionPoly();
-      if(otherPoints && polygonsIntersect(thisPoints, *otherPoints))
-         return false;
-   }
-
-   return true;
+   return BotVisibilityCache::isSweptPathClear(mGame->getGameObjDatabase(), (TestFunc)isCollideableType,
+                                               getActualPos(), point, mRadius);
 }
 
 
@@ -618,48 +594,11 @@ Robot *Robot::clone() const
 // Another helper function: returns id of closest zone to a given point
 U16 Robot::findClosestZone(const Point &point)
 {
-   U16 closestZone = U16_MAX;
-
-   // First, do a quick search for zone based on the buffer; should be 99% of the cases
-
-   // Search radius is just slightly larger than twice the zone buffers added to objects like barriers
-   S32 searchRadius = 2 * BotNavMeshZone::BufferRadius + 1;
-
-   Vector<DatabaseObject*> objects;
-   Rect rect = Rect(point.x + searchRadius, point.y + searchRadius, point.x - searchRadius, point.y - searchRadius);
-
-   getGame()->getBotZoneDatabase()->findObjects(BotNavMeshZoneTypeNumber, objects, rect);
-
-   for(S32 i = 0; i < objects.size(); i++)
-   {
-      BotNavMeshZone *zone = static_cast<BotNavMeshZone *>(objects[i]);
-      Point center = zone->getCenter();
-
-      if(getGame()->getGameObjDatabase()->pointCanSeePoint(center, point))  // This is an expensive test
-      {
-         closestZone = zone->getZoneId();
-         break;
-      }
-   }
-
-   // Target must be outside extents of the map, find nearest zone if a straight line was drawn
-   if(closestZone == U16_MAX)
-   {
-      Point extentsCenter = getGame()->getWorldExtents()->getCenter();
-
-      F32 collisionTimeIgnore;
-      Point surfaceNormalIgnore;
-
-      DatabaseObject* object = getGame()->getBotZoneDatabase()->findObjectLOS(BotNavMeshZoneTypeNumber,
-            ActualState, point, extentsCenter, collisionTimeIgnore, surfaceNormalIgnore);
-
-      BotNavMeshZone *zone = static_cast<BotNavMeshZone *>(object);
-
-      if (zone != NULL)
-         closestZone = zone->getZoneId();
-   }
+   TNLAssert(getGame()->isServer(), "Not a ServerGame");
 
-   return closestZone;
+   return BotVisibilityCache::computeClosestZone(getGame()->getGameObjDatabase(),
+                                                 static_cast<ServerGame *>(getGame())->getBotZoneDatabase(),
+                                                 point, getGame()->getWorldExtents()->getCenter());
 }
 
 //// Lua methods
@@ -806,9 +745,14 @@ S32 Robot::lua_getWaypoint(lua_State *L)
    checkArgList(L, functionArgs, "Robot", "getWaypoint");
 
    Point target = getPointOrXY(L, 1);
+   ServerGame *serverGame = static_cast<ServerGame *>(getGame());
+
+   U16 currentZone = getCurrentZone();                           // Zone we're in
+   U16 targetZone = serverGame->findZoneContaining(target);      // Where we're going  ===> returns zone id
 
-   // If we can see the target, go there directly
-   if(canSeePoint(target, true))
+   // If we can see the target, go there directly.  When our zones have a clear view of each other, we know we can
+   // without the expensive check.
+   if(serverGame->zoneCanSeeZone(currentZone, targetZone) || canSeePoint(target, true))
    {
       flightPlan.clear();
       return returnPoint(L, target);
@@ -816,8 +760,6 @@ S32 Robot::lua_getWaypoint(lua_State *L)
 
    // TODO: cache destination point; if it hasn't moved, then skip ahead.
 
-   U16 targetZone = static_cast<ServerGame *>(getGame())->findZoneContaining(target); // Where we're going  ===> returns zone id
-
    if(targetZone == U16_MAX)       // Our target is off the map.  See if it's visible from any of our zones, and, if so, go there
    {
       targetZone = findClosestZone(target);
@@ -873,8 +815,6 @@ S32 Robot::lua_getWaypoint(lua_State *L)
    // We need to calculate a new flightplan
    flightPlan.clear();
 
-   U16 currentZone = getCurrentZone();     // Zone we're in
-
    if(currentZone == U16_MAX)      // We don't really know where we are... bad news!  Let's find closest visible zone and go that way.
       currentZone = findClosestZone(getActualPos());
 
@@ -907,7 +847,7 @@ S32 Robot::lua_getWaypoint(lua_State *L)
    // check cache for path first
    pair<S32,S32> pathIndex = pair<S32,S32>(currentZone, targetZone);
 
-   const Vector<BotNavMeshZone *> *zones = static_cast<ServerGame *>(getGame())->getBotZones();  // Our pre-cached list of nav zones
+   const Vector<BotNavMeshZone *> *zones = serverGame->getBotZones();  // Our pre-cached list of nav zones
 
    if(getGame()->getGameType()->cachedBotFlightPlans.find(pathIndex) == getGame()->getGameType()->cachedBotFlightPlans.end())
    {
@@ -947,53 +887,45 @@ S32 Robot::lua_findClosestEnemy(lua_State *L)
 {
    S32 profile = checkArgList(L, functionArgs, "Robot", "findClosestEnemy");
 
-   Point pos = getActualPos();
-   Rect queryRect(pos, pos);
-   bool useRange = true;
+   Point range;
 
    if(profile == 0)           // Args: None
-      queryRect.expand(getGame()->computePlayerVisArea(this));  
+      range = getGame()->computePlayerVisArea(this);
    else                       // Args: Range
    {
-      F32 range = getFloat(L, 1);
-      if(range == -1)
-         useRange = false;
-        else
-         queryRect.expand(Point(range, range));
+      F32 dist = getFloat(L, 1);
+      if(dist == -1)
+         range.set(F32_MAX, F32_MAX);
+      else
+         range.set(dist, dist);
    }
 
+   bool hasSensor = hasModule(ModuleSensor);
+   U8 requiredFlags = TargetIndex::ShipFlag | TargetIndex::AliveFlag |
+                      (hasSensor ? TargetIndex::VisibleToSensorFlag : TargetIndex::VisibleFlag);
 
-   F32 minDist = F32_MAX;
-   Ship *closest = NULL;
-
-   fillVector.clear();
+   // Ships we can see, closest first
+   static Vector<BfObject *> ships;
+   ships.clear();
+   static_cast<ServerGame *>(getGame())->getTargetIndex()->findClosest(getActualPos(), range, requiredFlags, 0, FloatTau, ships);
 
-   if(useRange)
-      getGame()->getGameObjDatabase()->findObjects((TestFunc)isShipType, fillVector, queryRect);   
-   else
-      getGame()->getGameObjDatabase()->findObjects((TestFunc)isShipType, fillVector);   
+   Ship *closest = NULL;
 
-   for(S32 i = 0; i < fillVector.size(); i++)
+   for(S32 i = 0; i < ships.size(); i++)
    {
       // Ignore self 
-      if(fillVector[i] == this) 
+      if(ships[i] == this) 
          continue;
 
-      // Ignore ship/robot if it's dead or cloaked
-      Ship *ship = static_cast<Ship *>(fillVector[i]);
-      if(ship->mHasExploded || !ship->isVisible(hasModule(ModuleSensor)))
-         continue;
+      // Index has already checked that it's alive and not cloaked
+      Ship *ship = static_cast<Ship *>(ships[i]);
 
       // Ignore ships on same team during team games
       if(ship->getTeam() == getTeam() && getGame()->getGameType()->isTeamGame())
          continue;
 
-      F32 dist = ship->getActualPos().distSquared(getActualPos());
-      if(dist < minDist)
-      {
-         minDist = dist;
-         closest = ship;
-      }
+      closest = ship;
+      break;
    }
 
    return returnShip(L, closest);    // Handles closest == NULL
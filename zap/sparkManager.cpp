@@ -14,6 +14,7 @@
 #include "RenderUtils.h"
 #include "MathUtils.h"
 #include "FontManager.h"
+#include "ObjectPool.h"
 
 #include "tnlRandom.h"
 
@@ -27,8 +28,15 @@ struct FxManager::TeleporterEffect
    S32 time;
    U32 type;
    TeleporterEffect *nextEffect;
+
+   static ObjectPool<TeleporterEffect> mPool;
+
+   static void *operator new(size_t size)             { return mPool.alloc(size); }
+   static void operator delete(void *ptr, size_t size) { mPool.free(ptr, size);    }
 };
 
+ObjectPool<FxManager::TeleporterEffect> FxManager::TeleporterEffect::mPool("TeleporterEffect");
+
 FxManager::FxManager()
 {
    for(U32 i = 0; i < SparkTypeCount; i++)
@@ -421,6 +429,7 @@ FxTrail::FxTrail(U32 dropFrequency, U32 len)
 {
    mDropFreq = dropFrequency;
    mLength   = len;
+   mNodes.reserve(len);    // Trails are created with every projectile; grow once, not node by node
    registerTrail();
 }
 
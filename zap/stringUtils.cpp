@@ -479,6 +479,25 @@ bool fileExists(const string &path)
 }
 
 
+// modTime is only good for telling whether the file has changed; it's in seconds on some systems, and finer on others
+bool getFileSizeAndTime(const string &path, U64 &size, U64 &modTime)
+{
+   struct stat st;
+   if(stat(path.c_str(), &st) != 0)
+      return false;
+
+   size = (U64)st.st_size;
+
+#ifdef TNL_OS_LINUX
+   modTime = (U64)st.st_mtim.tv_sec * 1000000000 + (U64)st.st_mtim.tv_nsec;
+#else
+   modTime = (U64)st.st_mtime;
+#endif
+
+   return true;
+}
+
+
 // Checks if specified folder exists; creates it if not
 bool makeSureFolderExists(const string &folder)
 {